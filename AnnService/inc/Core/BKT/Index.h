@@ -84,8 +84,14 @@ namespace SPTAG
             int m_iNumberOfInitialDynamicPivots;
             int m_iNumberOfOtherDynamicPivots;
             int m_iHashTableExp;
+            int m_iEpochVisitedLimit;
+            int m_iHugePageMode;
+            int m_iNumaPlacement;
         public:
             static thread_local std::shared_ptr<COMMON::WorkSpace> m_workspace;
+
+            // Visited set size passed to WorkSpace::Reset: the sample count for small enough indexes, else 0 (hash table)
+            inline SizeType VisitedSize() const { return (m_iEpochVisitedLimit > 0 && m_pSamples.R() <= m_iEpochVisitedLimit) ? m_pSamples.R() : 0; }
         public:
             Index()
             {
@@ -154,8 +160,10 @@ namespace SPTAG
 
             ErrorCode BuildIndex(const void* p_data, SizeType p_vectorNum, DimensionType p_dimension, bool p_normalized = false, bool p_shareOwnership = false);
             ErrorCode SearchIndex(QueryResult &p_query, bool p_searchDeleted = false) const;
+            ErrorCode SearchIndexWithBudget(QueryResult& p_query, int p_maxCheck, bool p_searchDeleted = false) const;
             ErrorCode RefineSearchIndex(QueryResult &p_query, bool p_searchDeleted = false) const;
             ErrorCode SearchTree(QueryResult &p_query) const;
+            ErrorCode RangeSearch(const void* p_vector, float p_radius, int p_maxResults, std::vector<BasicResult>& p_results) const;
             ErrorCode AddIndex(const void* p_data, SizeType p_vectorNum, DimensionType p_dimension, std::shared_ptr<MetadataSet> p_metadataSet, bool p_withMetaIndex = false, bool p_normalized = false);
             ErrorCode AddIndexIdx(SizeType begin, SizeType end);
             ErrorCode AddIndexId(const void* p_data, SizeType p_vectorNum, DimensionType p_dimension, int& beginHead, int& endHead);
@@ -169,6 +177,7 @@ namespace SPTAG
 
             ErrorCode RefineIndex(const std::vector<std::shared_ptr<Helper::DiskIO>>& p_indexStreams, IAbortOperation* p_abort);
             ErrorCode RefineIndex(std::shared_ptr<VectorIndex>& p_newIndex);
+            ErrorCode ReorderForLocality(std::vector<SizeType>& p_newToOld);
 
         private:
             void SearchIndex(COMMON::QueryResultSet<T> &p_query, COMMON::WorkSpace &p_space, bool p_searchDeleted, bool p_searchDuplicated, std::function<bool(const ByteArray&)> filterFunc = nullptr) const;
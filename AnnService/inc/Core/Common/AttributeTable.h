@@ -0,0 +1,184 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_COMMON_ATTRIBUTETABLE_H_
+#define _SPTAG_COMMON_ATTRIBUTETABLE_H_
+
+#include "Dataset.h"
+#include "inc/Helper/StringConvert.h"
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace SPTAG
+{
+    namespace COMMON
+    {
+        // Integer attribute columns (tenant, category, enum tags, ...) of every vector, keyed by VID.
+        // Rows that were never set hold -1 in every column. The table is optional and only allocated
+        // once columns are initialized or loaded.
+        class AttributeTable
+        {
+        private:
+            std::shared_ptr<Dataset<std::int32_t>> m_data;
+
+        public:
+            void Initialize(SizeType size, DimensionType columns, SizeType blockSize, SizeType capacity)
+            {
+                m_data.reset(new Dataset<std::int32_t>(size, columns, blockSize, capacity));
+                m_data->SetName("attributeTable");
+            }
+
+            inline bool Available() const { return m_data != nullptr; }
+
+            inline SizeType R() const { return m_data ? m_data->R() : 0; }
+
+            inline DimensionType C() const { return m_data ? m_data->C() : 0; }
+
+            inline const std::int32_t* Row(SizeType key) const
+            {
+                return (key < R()) ? (*m_data)[key] : nullptr;
+            }
+
+            // Sets the attributes of VIDs [begin, begin + num), growing the table as needed.
+            ErrorCode Set(SizeType begin, SizeType num, const std::int32_t* values)
+            {
+                if (!m_data) return ErrorCode::EmptyIndex;
+                if (begin + num > m_data->R()) {
+                    ErrorCode ret = m_data->AddBatch(begin + num - m_data->R());
+                    if (ret != ErrorCode::Success) return ret;
+                }
+                DimensionType cols = m_data->C();
+                for (SizeType i = 0; i < num; i++) {
+                    std::copy(values + ((size_t)i) * cols, values + ((size_t)i + 1) * cols, (*m_data)[begin + i]);
+                }
+                return ErrorCode::Success;
+            }
+
+            inline ErrorCode Save(const std::string& filename) const
+            {
+                if (!m_data) return ErrorCode::Success;
+                return m_data->Save(filename);
+            }
+
+            // Same layout as Dataset::Save. The header is read here so that a missing or truncated file
+            // leaves the table unallocated.
+            ErrorCode Load(const std::string& filename, SizeType blockSize, SizeType capacity)
+            {
+                LOG(Helper::LogLevel::LL_Info, "Load attributeTable From %s\n", filename.c_str());
+                auto ptr = f_createIO();
+                if (ptr == nullptr || !ptr->Initialize(filename.c_str(), std::ios::binary | std::ios::in)) return ErrorCode::FailedOpenFile;
+
+                SizeType rows;
+                DimensionType cols;
+                IOBINARY(ptr, ReadBinary, sizeof(SizeType), (char*)&rows);
+                IOBINARY(ptr, ReadBinary, sizeof(DimensionType), (char*)&cols);
+                auto data = std::make_shared<Dataset<std::int32_t>>(rows, cols, blockSize, capacity);
+                data->SetName("attributeTable");
+                for (SizeType i = 0; i < rows; i++) {
+                    IOBINARY(ptr, ReadBinary, sizeof(std::int32_t) * cols, (char*)((*data)[i]));
+                }
+                m_data = std::move(data);
+                return ErrorCode::Success;
+            }
+        };
+
+        // Conjunction of per-column clauses. Each clause accepts a set of values or an inclusive range.
+        // Text form: clauses separated by '&', "col=v1|v2|..." or "col=lo:hi", e.g. "0=17&2=3:9".
+        class AttributeFilter
+        {
+        private:
+            struct Clause
+            {
+                DimensionType m_column;
+                std::vector<std::int32_t> m_values;
+                std::int32_t m_low;
+                std::int32_t m_high;
+            };
+
+            std::vector<Clause> m_clauses;
+
+        public:
+            inline bool Empty() const { return m_clauses.empty(); }
+
+            void AddValues(DimensionType p_column, std::vector<std::int32_t> p_values)
+            {
+                std::sort(p_values.begin(), p_values.end());
+                m_clauses.push_back({ p_column, std::move(p_values), 0, -1 });
+            }
+
+            void AddRange(DimensionType p_column, std::int32_t p_low, std::int32_t p_high)
+            {
+                m_clauses.push_back({ p_column, std::vector<std::int32_t>(), p_low, p_high });
+            }
+
+            inline bool Match(const std::int32_t* p_row) const
+            {
+                if (p_row == nullptr) return false;
+                for (const Clause& clause : m_clauses) {
+                    std::int32_t value = p_row[clause.m_column];
+                    if (clause.m_values.empty()) {
+                        if (value < clause.m_low || value > clause.m_high) return false;
+                    }
+                    else if (!std::binary_search(clause.m_values.begin(), clause.m_values.end(), value)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            // Fraction of the table matching the filter, estimated on up to p_sampleNum evenly spaced rows.
+            float Selectivity(const AttributeTable& p_table, SizeType p_sampleNum = 1024) const
+            {
+                if (m_clauses.empty() || p_table.R() == 0) return 1.0f;
+                SizeType step = (std::max)((SizeType)1, p_table.R() / p_sampleNum);
+                SizeType sampled = 0, matched = 0;
+                for (SizeType i = 0; i < p_table.R(); i += step, sampled++) {
+                    if (Match(p_table.Row(i))) matched++;
+                }
+                return (float)matched / sampled;
+            }
+
+            ErrorCode Parse(const std::string& p_expression, DimensionType p_columns)
+            {
+                m_clauses.clear();
+                std::stringstream clauses(p_expression);
+                std::string clause;
+                while (std::getline(clauses, clause, '&')) {
+                    if (clause.empty()) continue;
+                    auto eq = clause.find('=');
+                    if (eq == std::string::npos) return ErrorCode::Fail;
+                    int column;
+                    if (!Helper::Convert::ConvertStringTo<int>(clause.substr(0, eq).c_str(), column) || column < 0 || column >= p_columns) return ErrorCode::Fail;
+
+                    std::string rhs = clause.substr(eq + 1);
+                    auto colon = rhs.find(':');
+                    if (colon != std::string::npos) {
+                        std::int32_t low, high;
+                        if (!Helper::Convert::ConvertStringTo<std::int32_t>(rhs.substr(0, colon).c_str(), low) ||
+                            !Helper::Convert::ConvertStringTo<std::int32_t>(rhs.substr(colon + 1).c_str(), high)) return ErrorCode::Fail;
+                        AddRange(column, low, high);
+                        continue;
+                    }
+
+                    std::vector<std::int32_t> values;
+                    std::stringstream items(rhs);
+                    std::string item;
+                    while (std::getline(items, item, '|')) {
+                        std::int32_t value;
+                        if (!Helper::Convert::ConvertStringTo<std::int32_t>(item.c_str(), value)) return ErrorCode::Fail;
+                        values.push_back(value);
+                    }
+                    if (values.empty()) return ErrorCode::Fail;
+                    AddValues(column, std::move(values));
+                }
+                return ErrorCode::Success;
+            }
+        };
+    }
+}
+
+#endif // _SPTAG_COMMON_ATTRIBUTETABLE_H_
@@ -621,6 +621,58 @@ break;
                 }
             }
 
+            // Sample ids of the first tree in depth-first cluster order, followed by the ids it does not cover,
+            // so that consecutive ids end up close to each other in space.
+            void LocalityOrder(SizeType p_count, std::vector<SizeType>& p_newToOld) const
+            {
+                std::shared_lock<std::shared_timed_mutex> lock(*m_lock);
+                p_newToOld.clear();
+                p_newToOld.reserve(p_count);
+                std::vector<bool> placed(p_count, false);
+                auto place = [&](SizeType id) {
+                    if (id >= 0 && id < p_count && !placed[id]) {
+                        placed[id] = true;
+                        p_newToOld.push_back(id);
+                    }
+                };
+
+                if (!m_pTreeStart.empty()) {
+                    std::stack<SizeType> ss;
+                    ss.push(m_pTreeStart[0]);
+                    while (!ss.empty()) {
+                        SizeType index = ss.top(); ss.pop();
+                        const BKTNode& node = m_pTreeRoots[index];
+                        // The root of a clustered tree stores the sample count instead of an id
+                        if (index != m_pTreeStart[0] || node.childStart < 0) place(node.centerid);
+                        if (node.childEnd <= 0) continue;
+                        SizeType begin = (node.childStart < 0) ? -node.childStart : node.childStart;
+                        for (SizeType c = node.childEnd - 1; c >= begin; c--) ss.push(c);
+                    }
+                }
+                for (SizeType id = 0; id < p_count; id++) place(id);
+            }
+
+            // Rewrites the sample ids stored in the trees after the samples were renumbered.
+            void RemapIDs(const std::vector<SizeType>& p_oldToNew)
+            {
+                std::unique_lock<std::shared_timed_mutex> lock(*m_lock);
+                std::vector<bool> isRoot(m_pTreeRoots.size(), false);
+                for (SizeType start : m_pTreeStart) isRoot[start] = true;
+                auto remap = [&](SizeType id) { return (id >= 0 && id < (SizeType)p_oldToNew.size()) ? p_oldToNew[id] : id; };
+                for (size_t i = 0; i < m_pTreeRoots.size(); i++) {
+                    BKTNode& node = m_pTreeRoots[i];
+                    if (isRoot[i] && node.childStart >= 0) continue;
+                    node.centerid = remap(node.centerid);
+                }
+
+                std::unordered_map<SizeType, SizeType> sampleMap;
+                for (const auto& iter : m_pSampleCenterMap) {
+                    if (iter.first >= 0) sampleMap[remap(iter.first)] = remap(iter.second);
+                    else sampleMap[-1 - remap(-1 - iter.first)] = iter.second;
+                }
+                m_pSampleCenterMap.swap(sampleMap);
+            }
+
             inline std::uint64_t BufferSize() const
             {
                 return sizeof(int) + sizeof(SizeType) * m_iTreeNumber +
@@ -4,6 +4,8 @@
 #ifndef _SPTAG_COMMON_DATASET_H_
 #define _SPTAG_COMMON_DATASET_H_
 
+#include "PageAllocator.h"
+
 namespace SPTAG
 {
     namespace COMMON
@@ -228,6 +230,7 @@ namespace SPTAG
 
             DimensionType colStart = 0;
             DimensionType mycols = 0;
+            PagePolicy pagePolicy;
 
         public:
             Dataset() {}
@@ -238,16 +241,16 @@ namespace SPTAG
             }
             ~Dataset()
             {
-                if (ownData) ALIGN_FREE(data);
-                for (char* ptr : *incBlocks) ALIGN_FREE(ptr);
+                if (ownData) PageAllocator::Free(data);
+                for (char* ptr : *incBlocks) PageAllocator::Free(ptr);
                 incBlocks->clear();
             }
 
             void Initialize(SizeType rows_, DimensionType cols_, SizeType rowsInBlock_, SizeType capacity_, const void* data_ = nullptr, bool shareOwnership_ = true, std::shared_ptr<std::vector<char*>> incBlocks_ = nullptr, int colStart_ = 0, int rowEnd_ = -1)
             {
                 if (data != nullptr) {
-                    if (ownData) ALIGN_FREE(data);
-                    for (char* ptr : *incBlocks) ALIGN_FREE(ptr);
+                    if (ownData) PageAllocator::Free(data);
+                    for (char* ptr : *incBlocks) PageAllocator::Free(ptr);
                     incBlocks->clear();
                 }
 
@@ -255,10 +258,11 @@ namespace SPTAG
                 if (rowEnd_ >= colStart_) cols = rowEnd_;
                 else cols = cols_ * sizeof(T);
                 data = (char*)data_;
+                ownData = false;
                 if (data_ == nullptr || !shareOwnership_)
                 {
                     ownData = true;
-                    data = (char*)ALIGN_ALLOC(((size_t)rows) * cols);
+                    data = (char*)PageAllocator::Allocate(((size_t)rows) * cols, pagePolicy);
                     if (data_ != nullptr) memcpy(data, data_, ((size_t)rows) * cols);
                     else std::memset(data, -1, ((size_t)rows) * cols);
                 }
@@ -275,6 +279,10 @@ namespace SPTAG
 
             bool IsReady() const { return data != nullptr; }
 
+            // Applies to the rows and blocks allocated from now on
+            void SetPagePolicy(const PagePolicy& policy_) { pagePolicy = policy_; }
+            const PagePolicy& GetPagePolicy() const { return pagePolicy; }
+
             void SetName(const std::string& name_) { name = name_; }
             const std::string& Name() const { return name; }
 
@@ -322,6 +330,17 @@ namespace SPTAG
 
 #undef GETITEM
 
+            // Reorders the rows so that row i holds the old row p_newToOld[i]. Column views share their rows
+            // with the owning dataset and are left alone.
+            void Permute(const std::vector<SizeType>& p_newToOld)
+            {
+                if (colStart != 0) return;
+                SizeType n = (SizeType)p_newToOld.size();
+                std::vector<char> buffer(((size_t)n) * cols);
+                for (SizeType i = 0; i < n; i++) std::memcpy(buffer.data() + ((size_t)i) * cols, (const char*)At(p_newToOld[i]), cols);
+                for (SizeType i = 0; i < n; i++) std::memcpy((char*)At(i), buffer.data() + ((size_t)i) * cols, cols);
+            }
+
             ErrorCode AddBatch(SizeType num, const T* pData = nullptr)
             {
                 if (colStart != 0) return ErrorCode::Success;
@@ -331,7 +350,7 @@ namespace SPTAG
                 while (written < num) {
                     SizeType curBlockIdx = ((incRows + written) >> rowsInBlockEx);
                     if (curBlockIdx >= (SizeType)(incBlocks->size())) {
-                        char* newBlock = (char*)ALIGN_ALLOC(((size_t)rowsInBlock + 1) * cols);
+                        char* newBlock = (char*)PageAllocator::Allocate(((size_t)rowsInBlock + 1) * cols, pagePolicy);
                         if (newBlock == nullptr) return ErrorCode::MemoryOverFlow;
                         std::memset(newBlock, -1, ((size_t)rowsInBlock + 1) * cols);
                         incBlocks->push_back(newBlock);
@@ -452,7 +471,7 @@ namespace SPTAG
             DimensionType totalC = ALIGN_ROUND(sizeof(T) * VC + sizeof(SizeType) * pNeighborhoodSize);
 
             LOG(Helper::LogLevel::LL_Info, "OPT TotalC: %d\n", totalC);
-            char* data = (char*)ALIGN_ALLOC(((size_t)totalC) * VR);
+            char* data = (char*)PageAllocator::Allocate(((size_t)totalC) * VR, pVectors.GetPagePolicy());
             std::shared_ptr<std::vector<char*>> incBlocks(new std::vector<char*>());
 
             pVectors.Initialize(VR, VC, blockSize, capacity, data, true, incBlocks, 0, totalC);
@@ -19,6 +19,9 @@ namespace SPTAG
         template<typename T>
         inline DistanceCalcReturn<T> DistanceCalcSelector(SPTAG::DistCalcMethod p_method);
 
+        using SQDistanceCalcReturn = float(*)(const float*, const std::uint8_t*, const float*, DimensionType);
+        inline SQDistanceCalcReturn SQDistanceCalcSelector(SPTAG::DistCalcMethod p_method, int p_bits);
+
         class DistanceUtils
         {
         public:
@@ -94,6 +97,25 @@ namespace SPTAG
             static float ComputeCosineDistance_AVX(const float* pX, const float* pY, DimensionType length);
             static float ComputeCosineDistance_AVX512(const float* pX, const float* pY, DimensionType length);
 
+            // Asymmetric distances between a float query and scalar quantized codes, decoded as code * pStep.
+            // L2 expects the query shifted by the per-dimension minimum; DotProduct returns the raw sum.
+            // SQ4 packs dimension 2i in the low nibble and 2i + 1 in the high nibble of byte i.
+            static float ComputeSQ8L2Distance(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length);
+            static float ComputeSQ8L2Distance_AVX(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length);
+            static float ComputeSQ8L2Distance_AVX512(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length);
+
+            static float ComputeSQ8DotProduct(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length);
+            static float ComputeSQ8DotProduct_AVX(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length);
+            static float ComputeSQ8DotProduct_AVX512(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length);
+
+            static float ComputeSQ4L2Distance(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length);
+            static float ComputeSQ4L2Distance_AVX(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length);
+            static float ComputeSQ4L2Distance_AVX512(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length);
+
+            static float ComputeSQ4DotProduct(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length);
+            static float ComputeSQ4DotProduct_AVX(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length);
+            static float ComputeSQ4DotProduct_AVX512(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length);
+
 
             template<typename T>
             static inline float ComputeDistance(const T* p1, const T* p2, DimensionType length, SPTAG::DistCalcMethod distCalcMethod)
@@ -161,6 +183,23 @@ namespace SPTAG
             }
             return nullptr;
         }
+
+        inline SQDistanceCalcReturn SQDistanceCalcSelector(SPTAG::DistCalcMethod p_method, int p_bits)
+        {
+            bool isL2 = (p_method == SPTAG::DistCalcMethod::L2);
+            if (InstructionSet::AVX512())
+            {
+                if (p_bits == 4) return isL2 ? &(DistanceUtils::ComputeSQ4L2Distance_AVX512) : &(DistanceUtils::ComputeSQ4DotProduct_AVX512);
+                return isL2 ? &(DistanceUtils::ComputeSQ8L2Distance_AVX512) : &(DistanceUtils::ComputeSQ8DotProduct_AVX512);
+            }
+            else if (InstructionSet::AVX2())
+            {
+                if (p_bits == 4) return isL2 ? &(DistanceUtils::ComputeSQ4L2Distance_AVX) : &(DistanceUtils::ComputeSQ4DotProduct_AVX);
+                return isL2 ? &(DistanceUtils::ComputeSQ8L2Distance_AVX) : &(DistanceUtils::ComputeSQ8DotProduct_AVX);
+            }
+            if (p_bits == 4) return isL2 ? &(DistanceUtils::ComputeSQ4L2Distance) : &(DistanceUtils::ComputeSQ4DotProduct);
+            return isL2 ? &(DistanceUtils::ComputeSQ8L2Distance) : &(DistanceUtils::ComputeSQ8DotProduct);
+        }
     }
 }
 
@@ -59,6 +59,19 @@ namespace SPTAG
 
             virtual float* GetL2DistanceTables() = 0;
 
+            // 4-bit fast scan hooks, implemented by PQQuantizer with 16 centroids per subvector
+            virtual bool GetEnableFastScan() const { return false; }
+
+            virtual SizeType FastScanBlockSize() const { return 0; }
+
+            virtual SizeType FastScanTableSize() const { return 0; }
+
+            virtual void PackFastScanCodes(const std::uint8_t* codes, SizeType count, std::uint8_t* blocks) const {}
+
+            virtual void ComputeFastScanTableFromTarget(const std::uint8_t* target, std::uint8_t* table, float& scale, float& bias) const {}
+
+            virtual void FastScanDistances(const std::uint8_t* blocks, SizeType count, const std::uint8_t* table, float scale, float bias, float* distances) const {}
+
             template<typename T>
             T* GetCodebooks();
         };
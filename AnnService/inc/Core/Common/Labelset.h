@@ -5,41 +5,46 @@
 #define _SPTAG_COMMON_LABELSET_H_
 
 #include <atomic>
-#include "Dataset.h"
+#include <string>
+#include <vector>
+#include "PackedBitmap.h"
 
 namespace SPTAG
 {
     namespace COMMON
     {
+        // Packed set of vector ids (the deleted ids of the graph indexes). The file layout is the original
+        // byte per vector with 1 meaning contained.
         class Labelset
         {
         private:
             std::atomic<SizeType> m_inserted;
-            Dataset<std::int8_t> m_data;
+            PackedBitmap m_data;
+            std::string m_name;
             
         public:
             Labelset() 
             {
                 m_inserted = 0;
-                m_data.SetName("DeleteID");
+                m_name = "DeleteID";
             }
 
             void Initialize(SizeType size, SizeType blockSize, SizeType capacity)
             {
-                m_data.Initialize(size, 1, blockSize, capacity);
+                m_inserted = 0;
+                m_data.Initialize(size, blockSize, capacity);
             }
 
             inline size_t Count() const { return m_inserted.load(); }
 
             inline bool Contains(const SizeType& key) const
             {
-                return *m_data[key] == 1;
+                return m_data.Test(key);
             }
 
             inline bool Insert(const SizeType& key)
             {
-                char oldvalue = InterlockedExchange8((char*)m_data[key], 1);
-                if (oldvalue == 1) return false;
+                if (!m_data.Set(key)) return false;
                 m_inserted++;
                 return true;
             }
@@ -48,12 +53,24 @@ namespace SPTAG
             {
                 SizeType deleted = m_inserted.load();
                 IOBINARY(output, WriteBinary, sizeof(SizeType), (char*)&deleted);
-                return m_data.Save(output);
+
+                SizeType rows = m_data.R();
+                DimensionType cols = 1;
+                IOBINARY(output, WriteBinary, sizeof(SizeType), (char*)&rows);
+                IOBINARY(output, WriteBinary, sizeof(DimensionType), (char*)&cols);
+                std::vector<std::int8_t> buffer((std::min)(rows, (SizeType)(1 << 20)));
+                for (SizeType begin = 0; begin < rows; begin += (SizeType)buffer.size()) {
+                    SizeType num = (std::min)((SizeType)buffer.size(), rows - begin);
+                    for (SizeType i = 0; i < num; i++) buffer[i] = Contains(begin + i) ? 1 : -1;
+                    IOBINARY(output, WriteBinary, num, (char*)buffer.data());
+                }
+                LOG(Helper::LogLevel::LL_Info, "Save %s (%d,%d) Finish!\n", m_name.c_str(), rows, cols);
+                return ErrorCode::Success;
             }
 
             inline ErrorCode Save(std::string filename)
             {
-                LOG(Helper::LogLevel::LL_Info, "Save %s To %s\n", m_data.Name().c_str(), filename.c_str());
+                LOG(Helper::LogLevel::LL_Info, "Save %s To %s\n", m_name.c_str(), filename.c_str());
                 auto ptr = f_createIO();
                 if (ptr == nullptr || !ptr->Initialize(filename.c_str(), std::ios::binary | std::ios::out)) return ErrorCode::FailedCreateFile;
                 return Save(ptr);
@@ -61,15 +78,27 @@ namespace SPTAG
 
             inline ErrorCode Load(std::shared_ptr<Helper::DiskIO> input, SizeType blockSize, SizeType capacity)
             {
-                SizeType deleted;
+                SizeType deleted, rows;
+                DimensionType cols;
                 IOBINARY(input, ReadBinary, sizeof(SizeType), (char*)&deleted);
+                IOBINARY(input, ReadBinary, sizeof(SizeType), (char*)&rows);
+                IOBINARY(input, ReadBinary, sizeof(DimensionType), (char*)&cols);
+
+                Initialize(rows, blockSize, capacity);
+                std::vector<std::int8_t> buffer((std::min)(rows, (SizeType)(1 << 20)));
+                for (SizeType begin = 0; begin < rows; begin += (SizeType)buffer.size()) {
+                    SizeType num = (std::min)((SizeType)buffer.size(), rows - begin);
+                    IOBINARY(input, ReadBinary, num, (char*)buffer.data());
+                    for (SizeType i = 0; i < num; i++) if (buffer[i] == 1) m_data.Set(begin + i);
+                }
                 m_inserted = deleted;
-                return m_data.Load(input, blockSize, capacity);
+                LOG(Helper::LogLevel::LL_Info, "Load %s (%d,%d) Finish!\n", m_name.c_str(), rows, cols);
+                return ErrorCode::Success;
             }
 
             inline ErrorCode Load(std::string filename, SizeType blockSize, SizeType capacity)
             {
-                LOG(Helper::LogLevel::LL_Info, "Load %s From %s\n", m_data.Name().c_str(), filename.c_str());
+                LOG(Helper::LogLevel::LL_Info, "Load %s From %s\n", m_name.c_str(), filename.c_str());
                 auto ptr = f_createIO();
                 if (ptr == nullptr || !ptr->Initialize(filename.c_str(), std::ios::binary | std::ios::in)) return ErrorCode::FailedOpenFile;
                 return Load(ptr, blockSize, capacity);
@@ -77,8 +106,13 @@ namespace SPTAG
 
             inline ErrorCode Load(char* pmemoryFile, SizeType blockSize, SizeType capacity)
             {
-                m_inserted = *((SizeType*)pmemoryFile);
-                return m_data.Load(pmemoryFile + sizeof(SizeType), blockSize, capacity);
+                SizeType deleted = *((SizeType*)pmemoryFile);
+                SizeType rows = *((SizeType*)(pmemoryFile + sizeof(SizeType)));
+                const std::int8_t* values = (const std::int8_t*)(pmemoryFile + 2 * sizeof(SizeType) + sizeof(DimensionType));
+                Initialize(rows, blockSize, capacity);
+                for (SizeType i = 0; i < rows; i++) if (values[i] == 1) m_data.Set(i);
+                m_inserted = deleted;
+                return ErrorCode::Success;
             }
 
             inline ErrorCode AddBatch(SizeType num)
@@ -88,7 +122,7 @@ namespace SPTAG
 
             inline std::uint64_t BufferSize() const 
             {
-                return m_data.BufferSize() + sizeof(SizeType);
+                return sizeof(SizeType) + sizeof(SizeType) + sizeof(DimensionType) + sizeof(std::int8_t) * m_data.R();
             }
 
             inline void SetR(SizeType num)
@@ -100,6 +134,17 @@ namespace SPTAG
             {
                 return m_data.R();
             }
+
+            // Renumbers the ids: p_newToOld[i] is the old id now stored as i.
+            void Permute(const std::vector<SizeType>& p_newToOld)
+            {
+                std::vector<SizeType> contained;
+                for (SizeType i = 0; i < (SizeType)p_newToOld.size(); i++) {
+                    if (Contains(p_newToOld[i])) contained.push_back(i);
+                }
+                for (SizeType i = 0; i < (SizeType)p_newToOld.size(); i++) m_data.Reset(i);
+                for (SizeType i : contained) m_data.Set(i);
+            }
         };
     }
 }
@@ -639,8 +639,24 @@ break;
 
             inline SizeType R() const { return m_iGraphSize; }
 
+            // Moves node p_newToOld[i] to row i and rewrites the neighbor ids. Entries below -1 point at tree
+            // nodes, which keep their positions.
+            void Permute(const std::vector<SizeType>& p_newToOld, const std::vector<SizeType>& p_oldToNew)
+            {
+                m_pNeighborhoodGraph.Permute(p_newToOld);
+                SizeType n = (SizeType)p_newToOld.size();
+                for (SizeType i = 0; i < n; i++) {
+                    SizeType* nodes = m_pNeighborhoodGraph[i];
+                    for (DimensionType j = 0; j < m_pNeighborhoodGraph.C(); j++) {
+                        if (nodes[j] >= 0 && nodes[j] < n) nodes[j] = p_oldToNew[nodes[j]];
+                    }
+                }
+            }
+
             inline std::string Type() const { return m_pNeighborhoodGraph.Name(); }
 
+            inline void SetPagePolicy(const PagePolicy& p_policy) { m_pNeighborhoodGraph.SetPagePolicy(p_policy); }
+
             static std::shared_ptr<NeighborhoodGraph> CreateInstance(std::string type);
 
         protected:
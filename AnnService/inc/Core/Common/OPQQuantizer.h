@@ -24,7 +24,7 @@ namespace SPTAG
 
             OPQQuantizer();
 
-            OPQQuantizer(DimensionType NumSubvectors, SizeType KsPerSubvector, DimensionType DimPerSubvector, bool EnableADC, std::unique_ptr<T[]>&& Codebooks, std::unique_ptr<OPQMatrixType[]>&& OPQMatrix);
+            OPQQuantizer(DimensionType NumSubvectors, SizeType KsPerSubvector, DimensionType DimPerSubvector, bool EnableADC, std::unique_ptr<OPQMatrixType[]>&& Codebooks, std::unique_ptr<OPQMatrixType[]>&& OPQMatrix);
 
             virtual void QuantizeVector(const void* vec, std::uint8_t* vecout) const;
 
@@ -78,7 +78,7 @@ namespace SPTAG
         }
 
         template <typename T>
-        OPQQuantizer<T>::OPQQuantizer(DimensionType NumSubvectors, SizeType KsPerSubvector, DimensionType DimPerSubvector, bool EnableADC, std::unique_ptr<T[]>&& Codebooks, std::unique_ptr<OPQMatrixType[]>&& OPQMatrix) : m_OPQMatrix(std::move(OPQMatrix)), PQQuantizer<T>::PQQuantizer(NumSubvectors, KsPerSubvector, DimPerSubvector, EnableADC, std::move(Codebooks)), m_matrixDim(NumSubvectors * DimPerSubvector)
+        OPQQuantizer<T>::OPQQuantizer(DimensionType NumSubvectors, SizeType KsPerSubvector, DimensionType DimPerSubvector, bool EnableADC, std::unique_ptr<OPQMatrixType[]>&& Codebooks, std::unique_ptr<OPQMatrixType[]>&& OPQMatrix) : PQQuantizer<OPQMatrixType>::PQQuantizer(NumSubvectors, KsPerSubvector, DimPerSubvector, EnableADC, std::move(Codebooks)), m_matrixDim(NumSubvectors * DimPerSubvector), m_OPQMatrix(std::move(OPQMatrix))
         {
             m_InitMatrixTranspose();
         }
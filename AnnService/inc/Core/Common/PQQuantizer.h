@@ -6,7 +6,9 @@
 
 #include "CommonUtils.h"
 #include "DistanceUtils.h"
+#include "SIMDUtils.h"
 #include "IQuantizer.h"
+#include "inc/Core/SearchResult.h"
 #include <iostream>
 #include <fstream>
 #include <limits>
@@ -78,6 +80,28 @@ namespace SPTAG
 
             T* GetCodebooks();
 
+            // 4-bit fast scan, available when KsPerSubvector is 16. Codes are repacked into blocks of
+            // SIMDUtils::FastScanBatch vectors and scored with uint8 lookup tables held in registers.
+            virtual bool GetEnableFastScan() const;
+
+            virtual SizeType FastScanBlockSize() const;
+
+            virtual SizeType FastScanTableSize() const;
+
+            virtual void PackFastScanCodes(const std::uint8_t* codes, SizeType count, std::uint8_t* blocks) const;
+
+            void UnpackFastScanCode(const std::uint8_t* blocks, SizeType idx, std::uint8_t* code) const;
+
+            void ComputeFastScanTable(const void* vec, std::uint8_t* table, float& scale, float& bias) const;
+
+            // Same table built from the QuantizeVector output of the query (ADC table or query code)
+            virtual void ComputeFastScanTableFromTarget(const std::uint8_t* target, std::uint8_t* table, float& scale, float& bias) const;
+
+            virtual void FastScanDistances(const std::uint8_t* blocks, SizeType count, const std::uint8_t* table, float scale, float bias, float* distances) const;
+
+            void FastScanSearch(const void* vec, const std::uint8_t* blocks, SizeType count, int k, int rerankNum,
+                std::vector<BasicResult>& results, const std::function<float(SizeType)>& exactDistance = nullptr) const;
+
         protected:
             DimensionType m_NumSubvectors;
             SizeType m_KsPerSubvector;
@@ -87,6 +111,7 @@ namespace SPTAG
 
             inline SizeType m_DistIndexCalc(SizeType i, SizeType j, SizeType k) const;
             void InitializeDistanceTables();
+            void QuantizeFastScanTable(std::vector<float>& ADCtable, std::uint8_t* table, float& scale, float& bias) const;
 
             std::unique_ptr<T[]> m_codebooks;
             std::unique_ptr<const float[]> m_L2DistanceTables;
@@ -356,6 +381,184 @@ namespace SPTAG
         T* PQQuantizer<T>::GetCodebooks() {
           return (T*)(m_codebooks.get());
         }
+
+        template <typename T>
+        bool PQQuantizer<T>::GetEnableFastScan() const
+        {
+            return m_KsPerSubvector == 16;
+        }
+
+        template <typename T>
+        SizeType PQQuantizer<T>::FastScanBlockSize() const
+        {
+            return SIMDUtils::FastScanBlockSize(m_NumSubvectors);
+        }
+
+        template <typename T>
+        SizeType PQQuantizer<T>::FastScanTableSize() const
+        {
+            return ((m_NumSubvectors + 1) >> 1) * 32;
+        }
+
+        template <typename T>
+        void PQQuantizer<T>::PackFastScanCodes(const std::uint8_t* codes, SizeType count, std::uint8_t* blocks) const
+            // blocks must hold ceil(count / FastScanBatch) * FastScanBlockSize() bytes, missing tail codes are zero
+        {
+            SizeType blockNum = (count + SIMDUtils::FastScanBatch - 1) / SIMDUtils::FastScanBatch;
+            memset(blocks, 0, blockNum * FastScanBlockSize());
+            for (SizeType idx = 0; idx < count; idx++) {
+                std::uint8_t* block = blocks + (idx / SIMDUtils::FastScanBatch) * FastScanBlockSize();
+                int pos = idx % SIMDUtils::FastScanBatch;
+                int shift = (pos < 16) ? 0 : 4;
+                const std::uint8_t* code = codes + (size_t)idx * m_NumSubvectors;
+                for (int i = 0; i < m_NumSubvectors; i++) {
+                    block[i * 16 + (pos & 15)] |= (std::uint8_t)((code[i] & 0x0f) << shift);
+                }
+            }
+        }
+
+        template <typename T>
+        void PQQuantizer<T>::UnpackFastScanCode(const std::uint8_t* blocks, SizeType idx, std::uint8_t* code) const
+        {
+            const std::uint8_t* block = blocks + (idx / SIMDUtils::FastScanBatch) * FastScanBlockSize();
+            int pos = idx % SIMDUtils::FastScanBatch;
+            int shift = (pos < 16) ? 0 : 4;
+            for (int i = 0; i < m_NumSubvectors; i++) {
+                code[i] = (block[i * 16 + (pos & 15)] >> shift) & 0x0f;
+            }
+        }
+
+        template <typename T>
+        void PQQuantizer<T>::ComputeFastScanTable(const void* vec, std::uint8_t* table, float& scale, float& bias) const
+            // distance ~= bias + (sum of table entries) / scale, each entry is off by at most 0.5 / scale
+        {
+            std::vector<float> ADCtable(m_NumSubvectors * m_KsPerSubvector);
+            auto distCalc = DistanceCalcSelector<T>(DistCalcMethod::L2);
+            const T* subvec = (const T*)vec;
+            const T* subcodebooks = m_codebooks.get();
+            for (int i = 0; i < m_NumSubvectors; i++) {
+                for (int j = 0; j < m_KsPerSubvector; j++) {
+                    ADCtable[i * m_KsPerSubvector + j] = distCalc(subvec, subcodebooks, m_DimPerSubvector);
+                    subcodebooks += m_DimPerSubvector;
+                }
+                subvec += m_DimPerSubvector;
+            }
+            QuantizeFastScanTable(ADCtable, table, scale, bias);
+        }
+
+        template <typename T>
+        void PQQuantizer<T>::ComputeFastScanTableFromTarget(const std::uint8_t* target, std::uint8_t* table, float& scale, float& bias) const
+        {
+            std::vector<float> ADCtable(m_NumSubvectors * m_KsPerSubvector);
+            if (GetEnableADC()) {
+                memcpy(ADCtable.data(), target, sizeof(float) * ADCtable.size());
+            }
+            else {
+                for (int i = 0; i < m_NumSubvectors; i++) {
+                    for (int j = 0; j < m_KsPerSubvector; j++) {
+                        ADCtable[i * m_KsPerSubvector + j] = m_L2DistanceTables[m_DistIndexCalc(i, target[i], j)];
+                    }
+                }
+            }
+            QuantizeFastScanTable(ADCtable, table, scale, bias);
+        }
+
+        template <typename T>
+        void PQQuantizer<T>::QuantizeFastScanTable(std::vector<float>& ADCtable, std::uint8_t* table, float& scale, float& bias) const
+        {
+            float maxRange = 0, sumRange = 0;
+            bias = 0;
+            for (int i = 0; i < m_NumSubvectors; i++) {
+                float* row = ADCtable.data() + i * m_KsPerSubvector;
+                float minDist = *std::min_element(row, row + m_KsPerSubvector);
+                float range = *std::max_element(row, row + m_KsPerSubvector) - minDist;
+                for (int j = 0; j < m_KsPerSubvector; j++) row[j] -= minDist;
+                bias += minDist;
+                maxRange = max(maxRange, range);
+                sumRange += range;
+            }
+
+            // rounding adds up to 0.5 per subvector, so the uint16 budget keeps one unit per subvector
+            // as headroom and the accumulated sum can never saturate
+            scale = (maxRange > 0) ? min(255.0f / maxRange, (65535.0f - m_NumSubvectors) / sumRange) : 1.0f;
+            memset(table, 0, FastScanTableSize());
+            for (int i = 0; i < m_NumSubvectors; i++) {
+                for (int j = 0; j < m_KsPerSubvector; j++) {
+                    table[i * 16 + j] = (std::uint8_t)min(255.0f, std::floor(ADCtable[i * m_KsPerSubvector + j] * scale + 0.5f));
+                }
+            }
+        }
+
+        template <typename T>
+        void PQQuantizer<T>::FastScanDistances(const std::uint8_t* blocks, SizeType count, const std::uint8_t* table, float scale, float bias, float* distances) const
+        {
+            std::uint16_t accu[SIMDUtils::FastScanBatch];
+            DimensionType numPairs = (m_NumSubvectors + 1) >> 1;
+            float invScale = 1.0f / scale;
+            for (SizeType start = 0; start < count; start += SIMDUtils::FastScanBatch) {
+                SIMDUtils::ComputeFastScan(blocks, table, numPairs, accu);
+                int num = (int)min((SizeType)SIMDUtils::FastScanBatch, count - start);
+                for (int j = 0; j < num; j++) distances[start + j] = bias + accu[j] * invScale;
+                blocks += FastScanBlockSize();
+            }
+        }
+
+        template <typename T>
+        void PQQuantizer<T>::FastScanSearch(const void* vec, const std::uint8_t* blocks, SizeType count, int k, int rerankNum,
+            std::vector<BasicResult>& results, const std::function<float(SizeType)>& exactDistance) const
+            // approximate scores pick the rerankNum best candidates, which are rescored with exactDistance
+            // (full vectors held by the caller) or, when absent, with the float ADC table
+        {
+            results.clear();
+            if (count <= 0 || k <= 0) return;
+
+            std::vector<std::uint8_t> table(FastScanTableSize());
+            float scale, bias;
+            ComputeFastScanTable(vec, table.data(), scale, bias);
+
+            std::vector<float> approx(count);
+            FastScanDistances(blocks, count, table.data(), scale, bias, approx.data());
+
+            std::vector<SizeType> candidates(count);
+            for (SizeType i = 0; i < count; i++) candidates[i] = i;
+            SizeType keep = min(count, (SizeType)max(k, rerankNum));
+            if (keep < count) {
+                std::nth_element(candidates.begin(), candidates.begin() + keep, candidates.end(),
+                    [&approx](SizeType a, SizeType b) { return approx[a] < approx[b]; });
+                candidates.resize(keep);
+            }
+
+            std::vector<float> ADCtable;
+            std::vector<std::uint8_t> code(m_NumSubvectors);
+            if (!exactDistance) {
+                ADCtable.resize(m_NumSubvectors * m_KsPerSubvector);
+                auto distCalc = DistanceCalcSelector<T>(DistCalcMethod::L2);
+                const T* subvec = (const T*)vec;
+                const T* subcodebooks = m_codebooks.get();
+                for (int i = 0; i < m_NumSubvectors; i++) {
+                    for (int j = 0; j < m_KsPerSubvector; j++) {
+                        ADCtable[i * m_KsPerSubvector + j] = distCalc(subvec, subcodebooks, m_DimPerSubvector);
+                        subcodebooks += m_DimPerSubvector;
+                    }
+                    subvec += m_DimPerSubvector;
+                }
+            }
+
+            results.reserve(keep);
+            for (SizeType idx : candidates) {
+                float dist = 0;
+                if (exactDistance) {
+                    dist = exactDistance(idx);
+                }
+                else {
+                    UnpackFastScanCode(blocks, idx, code.data());
+                    for (int i = 0; i < m_NumSubvectors; i++) dist += ADCtable[i * m_KsPerSubvector + code[i]];
+                }
+                results.emplace_back(idx, dist);
+            }
+            std::sort(results.begin(), results.end(), [](const BasicResult& a, const BasicResult& b) { return a.Dist < b.Dist; });
+            if (results.size() > (size_t)k) results.resize(k);
+        }
     }
 }
 
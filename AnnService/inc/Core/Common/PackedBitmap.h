@@ -0,0 +1,114 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_COMMON_PACKEDBITMAP_H_
+#define _SPTAG_COMMON_PACKEDBITMAP_H_
+
+#include "inc/Core/Common.h"
+#include "SIMDUtils.h"
+
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace SPTAG
+{
+    namespace COMMON
+    {
+        // One bit per row, allocated in blocks of rowsInBlock rows like Dataset so that rows can be appended
+        // while readers hold on to existing blocks. The block table is reserved for the full capacity up front
+        // and never reallocates, so Test and Set are lock-free.
+        class PackedBitmap
+        {
+        private:
+            SizeType m_rows = 0;
+            SizeType m_maxRows = 0;
+            SizeType m_capacity = 0;
+            SizeType m_rowsInBlockEx = 0;
+            SizeType m_rowsInBlock = 0;
+            SizeType m_wordsInBlock = 0;
+            std::vector<std::unique_ptr<std::atomic<std::uint64_t>[]>> m_blocks;
+            // The same blocks as plain words for the gathers of Filter; lock-free 64-bit atomics share the
+            // layout of std::uint64_t and aligned 64-bit loads are atomic on x86, like the relaxed loads of Test.
+            std::vector<const std::uint64_t*> m_blockWords;
+
+            inline std::atomic<std::uint64_t>& Word(SizeType key) const
+            {
+                return m_blocks[key >> m_rowsInBlockEx][(key & m_rowsInBlock) >> 6];
+            }
+
+            inline ErrorCode Reserve(SizeType rows)
+            {
+                while ((((std::int64_t)m_blocks.size()) << m_rowsInBlockEx) < rows) {
+                    if (m_blocks.size() == m_blocks.capacity()) return ErrorCode::MemoryOverFlow;
+                    m_blocks.emplace_back(new std::atomic<std::uint64_t>[m_wordsInBlock]());
+                    m_blockWords.push_back(reinterpret_cast<const std::uint64_t*>(m_blocks.back().get()));
+                }
+                return ErrorCode::Success;
+            }
+
+        public:
+            void Initialize(SizeType size, SizeType blockSize, SizeType capacity)
+            {
+                m_rowsInBlockEx = static_cast<SizeType>(ceil(log2(blockSize)));
+                m_rowsInBlock = (1 << m_rowsInBlockEx) - 1;
+                m_wordsInBlock = (m_rowsInBlock >> 6) + 1;
+                m_capacity = (std::max)(size, capacity);
+                m_blocks.clear();
+                m_blocks.reserve((static_cast<std::int64_t>(m_capacity) + m_rowsInBlock) >> m_rowsInBlockEx);
+                m_blockWords.clear();
+                m_blockWords.reserve(m_blocks.capacity());
+                Reserve(size);
+                m_rows = m_maxRows = size;
+            }
+
+            inline SizeType R() const { return m_rows; }
+
+            inline SizeType RowsInBlockEx() const { return m_rowsInBlockEx; }
+
+            inline bool Test(SizeType key) const
+            {
+                return (Word(key).load(std::memory_order_relaxed) >> (key & 63)) & 1;
+            }
+
+            // Returns false if the bit was already set.
+            inline bool Set(SizeType key)
+            {
+                std::uint64_t bit = ((std::uint64_t)1) << (key & 63);
+                return (Word(key).fetch_or(bit) & bit) == 0;
+            }
+
+            inline void Reset(SizeType key)
+            {
+                Word(key).fetch_and(~(((std::uint64_t)1) << (key & 63)));
+            }
+
+            // p_mask[i] = 1 when the bit of p_keys[i] is clear, so a posting scan can drop set rows in one pass.
+            inline void Filter(const SizeType* p_keys, int p_num, std::uint8_t* p_mask) const
+            {
+                SIMDUtils::FilterBits(m_blockWords.data(), m_rowsInBlockEx, p_keys, p_num, p_mask);
+            }
+
+            // New rows start cleared, including rows given back by an earlier SetR.
+            ErrorCode AddBatch(SizeType num)
+            {
+                if (m_rows > m_capacity - num) return ErrorCode::MemoryOverFlow;
+                ErrorCode ret = Reserve(m_rows + num);
+                if (ret != ErrorCode::Success) return ret;
+                for (SizeType i = m_rows; i < (std::min)(m_rows + num, m_maxRows); i++) Reset(i);
+                m_rows += num;
+                m_maxRows = (std::max)(m_maxRows, m_rows);
+                return ErrorCode::Success;
+            }
+
+            void SetR(SizeType num)
+            {
+                if (num > m_rows) AddBatch(num - m_rows);
+                else m_rows = num;
+            }
+        };
+    }
+}
+
+#endif // _SPTAG_COMMON_PACKEDBITMAP_H_
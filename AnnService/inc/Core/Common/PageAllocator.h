@@ -0,0 +1,71 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_COMMON_PAGEALLOCATOR_H_
+#define _SPTAG_COMMON_PAGEALLOCATOR_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace SPTAG
+{
+    namespace COMMON
+    {
+        enum class HugePageMode : int
+        {
+            None = 0,
+            // Anonymous mappings aligned to 2MB and advised for transparent huge pages
+            Transparent = 1,
+            // Explicit hugetlb pages, falling back to transparent ones when the pool is empty
+            Huge2MB = 2,
+            Huge1GB = 3,
+        };
+
+        enum class NumaPlacement : int
+        {
+            // First touch, usually the node of the allocating thread
+            Default = 0,
+            // Pages spread round-robin over all nodes
+            Interleave = 1,
+            // Pages bound to the node of the allocating thread
+            Local = 2,
+        };
+
+        // Page size and NUMA placement of the rows and blocks of one Dataset
+        struct PagePolicy
+        {
+            HugePageMode m_mode = HugePageMode::None;
+            NumaPlacement m_placement = NumaPlacement::Default;
+        };
+
+        // Allocator for Dataset rows and blocks. Large allocations are mapped with the page size and NUMA
+        // placement of the caller's policy, small ones and failed mappings use the aligned heap. Every
+        // allocation carries a small header, so Free must only see pointers from Allocate.
+        class PageAllocator
+        {
+        public:
+            struct Stats
+            {
+                std::uint64_t m_heapBytes = 0;
+                std::uint64_t m_transparentBytes = 0;
+                std::uint64_t m_huge2MBBytes = 0;
+                std::uint64_t m_huge1GBBytes = 0;
+                std::uint64_t m_fallbacks = 0;
+            };
+
+            // Returns 32-byte aligned memory for p_size bytes, nullptr when out of memory
+            static void* Allocate(std::size_t p_size, const PagePolicy& p_policy = PagePolicy());
+
+            static void Free(void* p_ptr);
+
+            // Bytes currently held by each kind of page, over the whole process
+            static Stats GetStats();
+
+            // Logs GetStats and, on Linux, the anonymous huge pages the kernel actually backs the process with
+            static void LogStats();
+        };
+    }
+}
+
+#endif // _SPTAG_COMMON_PAGEALLOCATOR_H_
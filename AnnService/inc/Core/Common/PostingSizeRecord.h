@@ -15,16 +15,27 @@ namespace SPTAG
         {
         private:
             Dataset<int> m_data;
+            // Upper bound of the head-to-member distance of each posting. New rows are memset to -1,
+            // which reads as NaN and means the bound is unknown.
+            Dataset<float> m_radius;
+            // Dead entries of each posting seen by its last scan or rewrite (low 32 bits) and the deletion mark
+            // at that time (high 32 bits), one word so scans and the GC planner never see a torn pair.
+            // Kept in memory only; after a load every posting starts clean.
+            Dataset<std::uint64_t> m_dead;
             
         public:
             PostingSizeRecord() 
             {
                 m_data.SetName("PostingSizeRecord");
+                m_radius.SetName("PostingRadiusRecord");
+                m_dead.SetName("PostingDeadRecord");
             }
 
             void Initialize(SizeType size, SizeType blockSize, SizeType capacity)
             {
                 m_data.Initialize(size, 1, blockSize, capacity);
+                m_radius.Initialize(size, 1, blockSize, capacity);
+                m_dead.Initialize(size, 1, blockSize, capacity);
             }
 
             inline int GetSize(const SizeType& headID)
@@ -53,6 +64,49 @@ namespace SPTAG
                 }
             }
             
+            inline float GetRadius(const SizeType& headID)
+            {
+                float radius = *m_radius[headID];
+                return (radius == radius) ? radius : MaxDist;
+            }
+
+            inline void UpdateRadius(const SizeType& headID, float radius)
+            {
+                *m_radius[headID] = (std::max)(radius, 0.0f);
+            }
+
+            // Grows the bound after an append. Non-negative floats order like their bit patterns, and the
+            // unknown (all ones) pattern is larger than any of them, so it is never overwritten.
+            inline void ExtendRadius(const SizeType& headID, float radius)
+            {
+                if (radius < 0) radius = 0;
+                unsigned newBits;
+                memcpy(&newBits, &radius, sizeof(unsigned));
+                while (true) {
+                    unsigned oldBits = *((unsigned*)m_radius[headID]);
+                    if (oldBits >= newBits) return;
+                    if (InterlockedCompareExchange((unsigned*)m_radius[headID], newBits, oldBits) == oldBits) return;
+                }
+            }
+
+            // Reads the dead count and its mark in one aligned 64-bit load.
+            inline int GetDead(const SizeType& headID, std::uint32_t& mark)
+            {
+                std::uint64_t record = *((volatile std::uint64_t*)m_dead[headID]);
+                mark = (std::uint32_t)(record >> 32);
+                return (int)(std::uint32_t)record;
+            }
+
+            // Concurrent scans of one posting race to store their counts; whichever lands last wins whole.
+            inline void UpdateDead(const SizeType& headID, int dead, std::uint32_t mark)
+            {
+                std::uint64_t newRecord = ((std::uint64_t)mark << 32) | (std::uint32_t)dead;
+                while (true) {
+                    std::uint64_t oldRecord = *((volatile std::uint64_t*)m_dead[headID]);
+                    if (InterlockedCompareExchange((unsigned long long*)m_dead[headID], (unsigned long long)newRecord, (unsigned long long)oldRecord) == oldRecord) return;
+                }
+            }
+
             inline SizeType GetPostingNum()
             {
                 return m_data.R();
@@ -71,9 +125,34 @@ namespace SPTAG
                 return Save(ptr);
             }
 
+            inline ErrorCode SaveRadius(const std::string& filename)
+            {
+                LOG(Helper::LogLevel::LL_Info, "Save %s To %s\n", m_radius.Name().c_str(), filename.c_str());
+                auto ptr = f_createIO();
+                if (ptr == nullptr || !ptr->Initialize(filename.c_str(), std::ios::binary | std::ios::out)) return ErrorCode::FailedCreateFile;
+                return m_radius.Save(ptr);
+            }
+
+            // Indexes saved before radii were tracked have no radius file; their bounds stay unknown.
+            inline ErrorCode LoadRadius(const std::string& filename, SizeType blockSize, SizeType capacity)
+            {
+                LOG(Helper::LogLevel::LL_Info, "Load %s From %s\n", m_radius.Name().c_str(), filename.c_str());
+                auto ptr = f_createIO();
+                if (ptr == nullptr || !ptr->Initialize(filename.c_str(), std::ios::binary | std::ios::in)) return ErrorCode::FailedOpenFile;
+                COMMON::Dataset<float> radius;
+                ErrorCode ret = radius.Load(ptr, blockSize, capacity);
+                if (ret != ErrorCode::Success) return ret;
+                for (SizeType i = 0; i < radius.R() && i < m_radius.R(); i++) *m_radius[i] = *radius[i];
+                return ErrorCode::Success;
+            }
+
             inline ErrorCode Load(std::shared_ptr<Helper::DiskIO> input, SizeType blockSize, SizeType capacity)
             {
-                return m_data.Load(input, blockSize, capacity);
+                ErrorCode ret = m_data.Load(input, blockSize, capacity);
+                if (ret != ErrorCode::Success) return ret;
+                m_radius.Initialize(m_data.R(), 1, blockSize, capacity);
+                m_dead.Initialize(m_data.R(), 1, blockSize, capacity);
+                return ErrorCode::Success;
             }
 
             inline ErrorCode Load(const std::string& filename, SizeType blockSize, SizeType capacity)
@@ -86,12 +165,20 @@ namespace SPTAG
 
             inline ErrorCode Load(char* pmemoryFile, SizeType blockSize, SizeType capacity)
             {
-                return m_data.Load(pmemoryFile + sizeof(SizeType), blockSize, capacity);
+                ErrorCode ret = m_data.Load(pmemoryFile + sizeof(SizeType), blockSize, capacity);
+                if (ret != ErrorCode::Success) return ret;
+                m_radius.Initialize(m_data.R(), 1, blockSize, capacity);
+                m_dead.Initialize(m_data.R(), 1, blockSize, capacity);
+                return ErrorCode::Success;
             }
 
             inline ErrorCode AddBatch(SizeType num)
             {
-                return m_data.AddBatch(num);
+                ErrorCode ret = m_data.AddBatch(num);
+                if (ret != ErrorCode::Success) return ret;
+                ret = m_radius.AddBatch(num);
+                if (ret != ErrorCode::Success) return ret;
+                return m_dead.AddBatch(num);
             }
 
             inline std::uint64_t BufferSize() const 
@@ -102,6 +189,8 @@ namespace SPTAG
             inline void SetR(SizeType num)
             {
                 m_data.SetR(num);
+                m_radius.SetR(num);
+                m_dead.SetR(num);
             }
         };
     }
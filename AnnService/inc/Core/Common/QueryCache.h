@@ -0,0 +1,175 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_COMMON_QUERYCACHE_H_
+#define _SPTAG_COMMON_QUERYCACHE_H_
+
+#include "inc/Core/Common.h"
+#include "inc/Core/SearchResult.h"
+#include "DistanceUtils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace SPTAG
+{
+    namespace COMMON
+    {
+        // Result cache for repeated and near-duplicate queries. Queries are bucketed by a random hyperplane
+        // (SimHash) signature, and a cached entry is returned when its query is within the distance tolerance,
+        // was stored under the current update epoch and is younger than the TTL. Bumping the epoch on every
+        // update invalidates the whole cache in O(1); stale entries are dropped lazily.
+        template <typename T>
+        class QueryCache
+        {
+        private:
+            struct Entry
+            {
+                std::vector<T> m_query;
+                std::vector<BasicResult> m_results;
+                std::uint64_t m_epoch;
+                std::chrono::steady_clock::time_point m_time;
+            };
+
+            struct Shard
+            {
+                std::mutex m_lock;
+                std::unordered_map<std::uint64_t, std::vector<Entry>> m_buckets;
+                size_t m_size = 0;
+            };
+
+            static const int c_shards = 64;
+            static const int c_bucketEntries = 4;
+
+            DimensionType m_dim = 0;
+            int m_hashBits = 0;
+            size_t m_shardCapacity = 0;
+            std::chrono::milliseconds m_ttl{ 0 };
+            float m_tolerance = 0;
+            DistCalcMethod m_distCalcMethod = DistCalcMethod::L2;
+            std::vector<float> m_hyperplanes;
+            std::unique_ptr<Shard[]> m_shards;
+
+            std::atomic<std::uint64_t> m_lookups{ 0 };
+            std::atomic<std::uint64_t> m_hits{ 0 };
+
+            inline bool Alive(const Entry& p_entry, std::uint64_t p_epoch, std::chrono::steady_clock::time_point p_now) const
+            {
+                return p_entry.m_epoch == p_epoch && p_now - p_entry.m_time < m_ttl;
+            }
+
+        public:
+            void Initialize(DimensionType p_dim, int p_hashBits, int p_capacity, int p_ttlMs, float p_tolerance, DistCalcMethod p_distCalcMethod)
+            {
+                m_dim = p_dim;
+                m_hashBits = (std::max)(1, (std::min)(p_hashBits, 64));
+                m_shardCapacity = (std::max)(1, p_capacity / c_shards);
+                m_ttl = std::chrono::milliseconds(p_ttlMs);
+                m_tolerance = p_tolerance;
+                m_distCalcMethod = p_distCalcMethod;
+
+                std::mt19937 rg(12345);
+                std::normal_distribution<float> normal(0.0f, 1.0f);
+                m_hyperplanes.resize((size_t)m_hashBits * m_dim);
+                for (float& v : m_hyperplanes) v = normal(rg);
+                m_shards.reset(new Shard[c_shards]);
+            }
+
+            inline bool Available() const { return m_shards != nullptr; }
+
+            std::uint64_t Hash(const T* p_query) const
+            {
+                std::uint64_t key = 0;
+                const float* plane = m_hyperplanes.data();
+                for (int b = 0; b < m_hashBits; b++, plane += m_dim) {
+                    float proj = 0;
+                    for (DimensionType i = 0; i < m_dim; i++) proj += plane[i] * (float)p_query[i];
+                    if (proj > 0) key |= ((std::uint64_t)1) << b;
+                }
+                return key;
+            }
+
+            // Copies the first p_resultNum cached results into p_results on a hit.
+            bool Lookup(const T* p_query, std::uint64_t p_epoch, int p_resultNum, BasicResult* p_results)
+            {
+                m_lookups++;
+                std::uint64_t key = Hash(p_query);
+                Shard& shard = m_shards[key % c_shards];
+                auto now = std::chrono::steady_clock::now();
+
+                std::lock_guard<std::mutex> lock(shard.m_lock);
+                auto iter = shard.m_buckets.find(key);
+                if (iter == shard.m_buckets.end()) return false;
+                for (const Entry& entry : iter->second) {
+                    if (!Alive(entry, p_epoch, now) || (int)entry.m_results.size() < p_resultNum) continue;
+                    if (DistanceUtils::ComputeDistance(p_query, entry.m_query.data(), m_dim, m_distCalcMethod) > m_tolerance) continue;
+                    for (int i = 0; i < p_resultNum; i++) {
+                        p_results[i].VID = entry.m_results[i].VID;
+                        p_results[i].Dist = entry.m_results[i].Dist;
+                    }
+                    m_hits++;
+                    return true;
+                }
+                return false;
+            }
+
+            void Insert(const T* p_query, std::uint64_t p_epoch, int p_resultNum, const BasicResult* p_results)
+            {
+                std::uint64_t key = Hash(p_query);
+                Shard& shard = m_shards[key % c_shards];
+                auto now = std::chrono::steady_clock::now();
+
+                Entry entry;
+                entry.m_query.assign(p_query, p_query + m_dim);
+                entry.m_results.reserve(p_resultNum);
+                for (int i = 0; i < p_resultNum; i++) entry.m_results.emplace_back(p_results[i].VID, p_results[i].Dist);
+                entry.m_epoch = p_epoch;
+                entry.m_time = now;
+
+                std::lock_guard<std::mutex> lock(shard.m_lock);
+                if (shard.m_size >= m_shardCapacity) {
+                    for (auto iter = shard.m_buckets.begin(); iter != shard.m_buckets.end();) {
+                        auto& entries = iter->second;
+                        size_t before = entries.size();
+                        entries.erase(std::remove_if(entries.begin(), entries.end(), [&](const Entry& e) { return !Alive(e, p_epoch, now); }), entries.end());
+                        shard.m_size -= before - entries.size();
+                        if (entries.empty()) iter = shard.m_buckets.erase(iter);
+                        else ++iter;
+                    }
+                    // Evict a quarter of the shard at once so the sweep above is amortized over many inserts.
+                    while (shard.m_size > m_shardCapacity * 3 / 4 && !shard.m_buckets.empty()) {
+                        auto victim = shard.m_buckets.begin();
+                        shard.m_size -= victim->second.size();
+                        shard.m_buckets.erase(victim);
+                    }
+                }
+
+                auto& entries = shard.m_buckets[key];
+                if (entries.size() >= c_bucketEntries) {
+                    entries.erase(entries.begin());
+                    shard.m_size--;
+                }
+                entries.emplace_back(std::move(entry));
+                shard.m_size++;
+            }
+
+            inline std::uint64_t GetLookupCount() const { return m_lookups.load(); }
+
+            inline std::uint64_t GetHitCount() const { return m_hits.load(); }
+
+            inline double HitRate() const
+            {
+                std::uint64_t lookups = m_lookups.load();
+                return (lookups == 0) ? 0.0 : (double)m_hits.load() / lookups;
+            }
+        };
+    }
+}
+
+#endif // _SPTAG_COMMON_QUERYCACHE_H_
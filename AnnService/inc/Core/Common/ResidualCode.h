@@ -0,0 +1,142 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_COMMON_RESIDUALCODE_H_
+#define _SPTAG_COMMON_RESIDUALCODE_H_
+
+#include "inc/Core/Common.h"
+#include "CommonUtils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace SPTAG
+{
+    namespace COMMON
+    {
+        // Scalar quantized residual of a vector to its posting head: [float scale][levels], where the vector
+        // is reconstructed as head + scale * level. Levels are signed, one byte each for 8 bits, or two per
+        // byte (dimension 2i in the low nibble, offset by 8) for 4 bits. The scale is chosen per vector from
+        // the largest residual component, so no training is needed and entries can move between heads.
+        class ResidualCode
+        {
+        public:
+            static inline int CodeSize(DimensionType p_dim, int p_bits)
+            {
+                return (int)sizeof(float) + ((p_bits == 4) ? ((p_dim + 1) >> 1) : p_dim);
+            }
+
+            static inline int MaxLevel(int p_bits)
+            {
+                return (p_bits == 4) ? 7 : 127;
+            }
+
+            static inline int Level(const std::uint8_t* p_levels, DimensionType p_i, int p_bits)
+            {
+                if (p_bits == 4) return ((p_levels[p_i >> 1] >> ((p_i & 1) << 2)) & 0xF) - 8;
+                return (int)(std::int8_t)p_levels[p_i];
+            }
+
+            template <typename T>
+            static void Encode(const T* p_vec, const T* p_head, DimensionType p_dim, int p_bits, std::uint8_t* p_code)
+            {
+                float maxAbs = 0;
+                for (DimensionType i = 0; i < p_dim; i++) maxAbs = (std::max)(maxAbs, std::fabs((float)p_vec[i] - (float)p_head[i]));
+
+                int maxLevel = MaxLevel(p_bits);
+                float scale = maxAbs / maxLevel;
+                float invScale = (scale > 0) ? 1.0f / scale : 0.0f;
+                memcpy(p_code, &scale, sizeof(float));
+
+                std::uint8_t* levels = p_code + sizeof(float);
+                memset(levels, 0, CodeSize(p_dim, p_bits) - sizeof(float));
+                for (DimensionType i = 0; i < p_dim; i++)
+                {
+                    int level = (int)std::lround(((float)p_vec[i] - (float)p_head[i]) * invScale);
+                    level = (std::max)(-maxLevel, (std::min)(maxLevel, level));
+                    if (p_bits == 4) levels[i >> 1] |= (std::uint8_t)((level + 8) << ((i & 1) << 2));
+                    else levels[i] = (std::uint8_t)(std::int8_t)level;
+                }
+            }
+
+            template <typename T>
+            static void Decode(const std::uint8_t* p_code, const T* p_head, DimensionType p_dim, int p_bits, T* p_vec)
+            {
+                float scale;
+                memcpy(&scale, p_code, sizeof(float));
+                const std::uint8_t* levels = p_code + sizeof(float);
+                for (DimensionType i = 0; i < p_dim; i++)
+                {
+                    float value = (float)p_head[i] + scale * Level(levels, i, p_bits);
+                    if (GetEnumValueType<T>() != VectorValueType::Float)
+                    {
+                        value = std::round(value);
+                        value = (std::max)((float)(std::numeric_limits<T>::lowest)(), (std::min)((float)(std::numeric_limits<T>::max)(), value));
+                    }
+                    p_vec[i] = (T)value;
+                }
+            }
+
+            // Per-head query table, computed once before scanning a posting. For L2 the table is the query
+            // residual q - h and the returned bias is |q - h|^2; for Cosine the table is the query itself and
+            // the bias is base^2 - <q, h>, matching DistanceUtils::ComputeCosineDistance.
+            template <typename T>
+            static float PrepareQuery(const T* p_query, const T* p_head, DimensionType p_dim, DistCalcMethod p_method, float* p_table)
+            {
+                float bias = 0;
+                if (p_method == DistCalcMethod::L2)
+                {
+                    for (DimensionType i = 0; i < p_dim; i++)
+                    {
+                        p_table[i] = (float)p_query[i] - (float)p_head[i];
+                        bias += p_table[i] * p_table[i];
+                    }
+                    return bias;
+                }
+
+                for (DimensionType i = 0; i < p_dim; i++)
+                {
+                    p_table[i] = (float)p_query[i];
+                    bias += p_table[i] * (float)p_head[i];
+                }
+                int base = Utils::GetBase<T>();
+                return (float)base * base - bias;
+            }
+
+            static float Distance(const float* p_table, float p_bias, const std::uint8_t* p_code, DimensionType p_dim, int p_bits, DistCalcMethod p_method)
+            {
+                float scale;
+                memcpy(&scale, p_code, sizeof(float));
+                const std::uint8_t* levels = p_code + sizeof(float);
+
+                float dot = 0, norm = 0;
+                if (p_bits == 4)
+                {
+                    for (DimensionType i = 0; i < p_dim; i++)
+                    {
+                        float level = (float)Level(levels, i, 4);
+                        dot += p_table[i] * level;
+                        norm += level * level;
+                    }
+                }
+                else
+                {
+                    const std::int8_t* signedLevels = reinterpret_cast<const std::int8_t*>(levels);
+                    for (DimensionType i = 0; i < p_dim; i++)
+                    {
+                        float level = (float)signedLevels[i];
+                        dot += p_table[i] * level;
+                        norm += level * level;
+                    }
+                }
+
+                if (p_method == DistCalcMethod::L2) return p_bias - 2 * scale * dot + scale * scale * norm;
+                return p_bias - scale * dot;
+            }
+        };
+    }
+}
+
+#endif // _SPTAG_COMMON_RESIDUALCODE_H_
@@ -19,6 +19,15 @@ namespace SPTAG
         template<typename T>
         inline SumCalcReturn<T> SumCalcSelector();
 
+        using FastScanReturn = void(*)(const std::uint8_t*, const std::uint8_t*, DimensionType, std::uint16_t*);
+        inline FastScanReturn FastScanSelector();
+
+        using FilterByBoundReturn = int(*)(float*, SizeType*, int, float);
+        inline FilterByBoundReturn FilterByBoundSelector();
+
+        using FilterBitsReturn = void(*)(const std::uint64_t* const*, SizeType, const SizeType*, int, std::uint8_t*);
+        inline FilterBitsReturn FilterBitsSelector();
+
         class SIMDUtils
         {
         public:
@@ -53,6 +62,50 @@ namespace SPTAG
                 auto func = SumCalcSelector<T>();
                 return func(p1, p2, length);
             }
+
+            // 4-bit PQ fast scan over one block of FastScanBatch codes.
+            // Block layout: for every pair of subvectors 32 bytes, 16 for each subvector, where byte j holds
+            // the code of vector j in the low nibble and the code of vector j + 16 in the high nibble.
+            // Table layout: 16 uint8 entries per subvector, subvectors padded to an even count.
+            // Output: FastScanBatch uint16 accumulated distances, saturated at 65535.
+            static const int FastScanBatch = 32;
+
+            static inline int FastScanBlockSize(DimensionType numSubvectors) { return ((numSubvectors + 1) >> 1) * 32; }
+
+            static void ComputeFastScan_Naive(const std::uint8_t* pCodes, const std::uint8_t* pTable, DimensionType numPairs, std::uint16_t* pOut);
+            static void ComputeFastScan_AVX(const std::uint8_t* pCodes, const std::uint8_t* pTable, DimensionType numPairs, std::uint16_t* pOut);
+            static void ComputeFastScan_AVX512(const std::uint8_t* pCodes, const std::uint8_t* pTable, DimensionType numPairs, std::uint16_t* pOut);
+
+            static inline void ComputeFastScan(const std::uint8_t* pCodes, const std::uint8_t* pTable, DimensionType numPairs, std::uint16_t* pOut)
+            {
+                static FastScanReturn func = FastScanSelector();
+                return func(pCodes, pTable, numPairs, pOut);
+            }
+
+            // Moves the entries with pDists[i] <= bound to the front of both arrays, keeping their order,
+            // and returns how many there are.
+            static int FilterByBound_Naive(float* pDists, SizeType* pIDs, int length, float bound);
+            static int FilterByBound_AVX(float* pDists, SizeType* pIDs, int length, float bound);
+            static int FilterByBound_AVX512(float* pDists, SizeType* pIDs, int length, float bound);
+
+            static inline int FilterByBound(float* pDists, SizeType* pIDs, int length, float bound)
+            {
+                static FilterByBoundReturn func = FilterByBoundSelector();
+                return func(pDists, pIDs, length, bound);
+            }
+
+            // pMask[i] = 1 when bit pKeys[i] is clear in a bitmap held as blocks of 2^rowsInBlockEx bits,
+            // pBlocks[b] pointing to the 64-bit words of block b. The SIMD versions gather the block pointers
+            // and then the words, so a posting's deletion check costs no per-key branch or dependent load chain.
+            static void FilterBits_Naive(const std::uint64_t* const* pBlocks, SizeType rowsInBlockEx, const SizeType* pKeys, int length, std::uint8_t* pMask);
+            static void FilterBits_AVX(const std::uint64_t* const* pBlocks, SizeType rowsInBlockEx, const SizeType* pKeys, int length, std::uint8_t* pMask);
+            static void FilterBits_AVX512(const std::uint64_t* const* pBlocks, SizeType rowsInBlockEx, const SizeType* pKeys, int length, std::uint8_t* pMask);
+
+            static inline void FilterBits(const std::uint64_t* const* pBlocks, SizeType rowsInBlockEx, const SizeType* pKeys, int length, std::uint8_t* pMask)
+            {
+                static FilterBitsReturn func = FilterBitsSelector();
+                return func(pBlocks, rowsInBlockEx, pKeys, length, pMask);
+            }
         };
 
         template<typename T>
@@ -73,6 +126,45 @@ namespace SPTAG
             }
             return &(SIMDUtils::ComputeSum_Naive);
         }
+
+        inline FastScanReturn FastScanSelector()
+        {
+            if (InstructionSet::AVX512())
+            {
+                return &(SIMDUtils::ComputeFastScan_AVX512);
+            }
+            if (InstructionSet::AVX2())
+            {
+                return &(SIMDUtils::ComputeFastScan_AVX);
+            }
+            return &(SIMDUtils::ComputeFastScan_Naive);
+        }
+
+        inline FilterByBoundReturn FilterByBoundSelector()
+        {
+            if (InstructionSet::AVX512())
+            {
+                return &(SIMDUtils::FilterByBound_AVX512);
+            }
+            if (InstructionSet::AVX2())
+            {
+                return &(SIMDUtils::FilterByBound_AVX);
+            }
+            return &(SIMDUtils::FilterByBound_Naive);
+        }
+
+        inline FilterBitsReturn FilterBitsSelector()
+        {
+            if (InstructionSet::AVX512())
+            {
+                return &(SIMDUtils::FilterBits_AVX512);
+            }
+            if (InstructionSet::AVX2())
+            {
+                return &(SIMDUtils::FilterBits_AVX);
+            }
+            return &(SIMDUtils::FilterBits_Naive);
+        }
     }
 }
 
@@ -0,0 +1,325 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_COMMON_SCALARQUANTIZER_H_
+#define _SPTAG_COMMON_SCALARQUANTIZER_H_
+
+#include "CommonUtils.h"
+#include "DistanceUtils.h"
+#include "IQuantizer.h"
+#include <limits>
+#include <memory>
+#include <cmath>
+#include <cstring>
+
+namespace SPTAG
+{
+    namespace COMMON
+    {
+        // Per-dimension min/max scalar quantizer with 8 or 4 bits per dimension.
+        // With ADC the query is kept in float as [query - min][query][sum(query * min)] and
+        // compared against codes without any lookup table.
+        template <typename T>
+        class ScalarQuantizer : public IQuantizer
+        {
+        public:
+            ScalarQuantizer();
+
+            ScalarQuantizer(DimensionType Dim, int Bits, bool EnableADC, std::unique_ptr<float[]>&& Min, std::unique_ptr<float[]>&& Max);
+
+            ~ScalarQuantizer();
+
+            virtual float L2Distance(const std::uint8_t* pX, const std::uint8_t* pY) const;
+
+            virtual float CosineDistance(const std::uint8_t* pX, const std::uint8_t* pY) const;
+
+            virtual void QuantizeVector(const void* vec, std::uint8_t* vecout) const;
+
+            virtual SizeType QuantizeSize() const;
+
+            virtual void ReconstructVector(const std::uint8_t* qvec, void* vecout) const;
+
+            virtual SizeType ReconstructSize() const;
+
+            virtual DimensionType ReconstructDim() const;
+
+            virtual std::uint64_t BufferSize() const;
+
+            virtual ErrorCode SaveQuantizer(std::shared_ptr<Helper::DiskIO> p_out) const;
+
+            virtual ErrorCode LoadQuantizer(std::shared_ptr<Helper::DiskIO> p_in);
+
+            virtual ErrorCode LoadQuantizer(std::uint8_t* raw_bytes);
+
+            virtual DimensionType GetNumSubvectors() const;
+
+            virtual int GetBase() const;
+
+            virtual bool GetEnableADC() const;
+
+            virtual void SetEnableADC(bool enableADC);
+
+            int GetBits() const;
+
+            VectorValueType GetReconstructType() const
+            {
+                return GetEnumValueType<T>();
+            }
+
+            QuantizerType GetQuantizerType() const
+            {
+                return QuantizerType::ScalarQuantizer;
+            }
+
+            float* GetL2DistanceTables();
+
+        protected:
+            DimensionType m_Dim;
+            int m_Bits;
+            bool m_EnableADC;
+
+            std::unique_ptr<float[]> m_Min;
+            std::unique_ptr<float[]> m_Step;
+
+            SQDistanceCalcReturn m_fL2;
+            SQDistanceCalcReturn m_fDot;
+
+            inline int GetCode(const std::uint8_t* qvec, DimensionType i) const;
+            void InitializeDistanceFunctions();
+        };
+
+        template <typename T>
+        ScalarQuantizer<T>::ScalarQuantizer() : m_Dim(0), m_Bits(8), m_EnableADC(false), m_fL2(nullptr), m_fDot(nullptr)
+        {
+        }
+
+        template <typename T>
+        ScalarQuantizer<T>::ScalarQuantizer(DimensionType Dim, int Bits, bool EnableADC, std::unique_ptr<float[]>&& Min, std::unique_ptr<float[]>&& Max) : m_Dim(Dim), m_Bits(Bits), m_EnableADC(EnableADC), m_Min(std::move(Min))
+        {
+            float levels = (float)((1 << m_Bits) - 1);
+            m_Step = std::make_unique<float[]>(m_Dim);
+            for (DimensionType i = 0; i < m_Dim; i++) {
+                m_Step[i] = (Max[i] - m_Min[i]) / levels;
+            }
+            InitializeDistanceFunctions();
+        }
+
+        template <typename T>
+        ScalarQuantizer<T>::~ScalarQuantizer()
+        {}
+
+        template <typename T>
+        inline int ScalarQuantizer<T>::GetCode(const std::uint8_t* qvec, DimensionType i) const
+        {
+            if (m_Bits == 4) return (qvec[i >> 1] >> ((i & 1) << 2)) & 0x0f;
+            return qvec[i];
+        }
+
+        template <typename T>
+        float ScalarQuantizer<T>::L2Distance(const std::uint8_t* pX, const std::uint8_t* pY) const
+            // pX must be the float query produced by QuantizeVector for ADC
+        {
+            if (GetEnableADC()) {
+                return m_fL2((const float*)pX, pY, m_Step.get(), m_Dim);
+            }
+
+            float out = 0;
+            for (DimensionType i = 0; i < m_Dim; i++) {
+                float diff = (GetCode(pX, i) - GetCode(pY, i)) * m_Step[i];
+                out += diff * diff;
+            }
+            return out;
+        }
+
+        template <typename T>
+        float ScalarQuantizer<T>::CosineDistance(const std::uint8_t* pX, const std::uint8_t* pY) const
+            // pX must be the float query produced by QuantizeVector for ADC
+        {
+            int base = GetBase();
+            if (GetEnableADC()) {
+                const float* query = (const float*)pX;
+                return base * base - (query[2 * m_Dim] + m_fDot(query + m_Dim, pY, m_Step.get(), m_Dim));
+            }
+
+            float out = 0;
+            for (DimensionType i = 0; i < m_Dim; i++) {
+                out += (m_Min[i] + GetCode(pX, i) * m_Step[i]) * (m_Min[i] + GetCode(pY, i) * m_Step[i]);
+            }
+            return base * base - out;
+        }
+
+        template <typename T>
+        void ScalarQuantizer<T>::QuantizeVector(const void* vec, std::uint8_t* vecout) const
+        {
+            const T* pvec = (const T*)vec;
+            if (GetEnableADC())
+            {
+                float* query = (float*)vecout;
+                float bias = 0;
+                for (DimensionType i = 0; i < m_Dim; i++) {
+                    query[i] = (float)pvec[i] - m_Min[i];
+                    query[m_Dim + i] = (float)pvec[i];
+                    bias += (float)pvec[i] * m_Min[i];
+                }
+                query[2 * m_Dim] = bias;
+            }
+            else
+            {
+                int maxCode = (1 << m_Bits) - 1;
+                if (m_Bits == 4) memset(vecout, 0, GetNumSubvectors());
+                for (DimensionType i = 0; i < m_Dim; i++) {
+                    int code = 0;
+                    if (m_Step[i] > 0) {
+                        code = (int)std::floor(((float)pvec[i] - m_Min[i]) / m_Step[i] + 0.5f);
+                        code = max(0, min(maxCode, code));
+                    }
+                    if (m_Bits == 4) vecout[i >> 1] |= (std::uint8_t)(code << ((i & 1) << 2));
+                    else vecout[i] = (std::uint8_t)code;
+                }
+            }
+        }
+
+        template <typename T>
+        SizeType ScalarQuantizer<T>::QuantizeSize() const
+        {
+            if (GetEnableADC())
+            {
+                return sizeof(float) * (2 * m_Dim + 1);
+            }
+            else
+            {
+                return GetNumSubvectors();
+            }
+        }
+
+        template <typename T>
+        void ScalarQuantizer<T>::ReconstructVector(const std::uint8_t* qvec, void* vecout) const
+        {
+            T* out = (T*)vecout;
+            for (DimensionType i = 0; i < m_Dim; i++) {
+                out[i] = (T)(m_Min[i] + GetCode(qvec, i) * m_Step[i]);
+            }
+        }
+
+        template <typename T>
+        SizeType ScalarQuantizer<T>::ReconstructSize() const
+        {
+            return sizeof(T) * ReconstructDim();
+        }
+
+        template <typename T>
+        DimensionType ScalarQuantizer<T>::ReconstructDim() const
+        {
+            return m_Dim;
+        }
+
+        template <typename T>
+        std::uint64_t ScalarQuantizer<T>::BufferSize() const
+        {
+            return sizeof(float) * m_Dim * 2 + sizeof(DimensionType) + sizeof(int) + sizeof(VectorValueType) + sizeof(QuantizerType);
+        }
+
+        template <typename T>
+        ErrorCode ScalarQuantizer<T>::SaveQuantizer(std::shared_ptr<Helper::DiskIO> p_out) const
+        {
+            QuantizerType qtype = QuantizerType::ScalarQuantizer;
+            VectorValueType rtype = GetEnumValueType<T>();
+            IOBINARY(p_out, WriteBinary, sizeof(QuantizerType), (char*)&qtype);
+            IOBINARY(p_out, WriteBinary, sizeof(VectorValueType), (char*)&rtype);
+            IOBINARY(p_out, WriteBinary, sizeof(DimensionType), (char*)&m_Dim);
+            IOBINARY(p_out, WriteBinary, sizeof(int), (char*)&m_Bits);
+            IOBINARY(p_out, WriteBinary, sizeof(float) * m_Dim, (char*)m_Min.get());
+            IOBINARY(p_out, WriteBinary, sizeof(float) * m_Dim, (char*)m_Step.get());
+            LOG(Helper::LogLevel::LL_Info, "Saving quantizer: Dim:%d Bits:%d\n", m_Dim, m_Bits);
+            return ErrorCode::Success;
+        }
+
+        template <typename T>
+        ErrorCode ScalarQuantizer<T>::LoadQuantizer(std::shared_ptr<Helper::DiskIO> p_in)
+        {
+            LOG(Helper::LogLevel::LL_Info, "Loading Quantizer.\n");
+            IOBINARY(p_in, ReadBinary, sizeof(DimensionType), (char*)&m_Dim);
+            IOBINARY(p_in, ReadBinary, sizeof(int), (char*)&m_Bits);
+            if (m_Bits != 8 && m_Bits != 4) {
+                LOG(Helper::LogLevel::LL_Error, "Unsupported scalar quantizer bits:%d\n", m_Bits);
+                return ErrorCode::FailedParseValue;
+            }
+            m_Min = std::make_unique<float[]>(m_Dim);
+            m_Step = std::make_unique<float[]>(m_Dim);
+            IOBINARY(p_in, ReadBinary, sizeof(float) * m_Dim, (char*)m_Min.get());
+            IOBINARY(p_in, ReadBinary, sizeof(float) * m_Dim, (char*)m_Step.get());
+
+            InitializeDistanceFunctions();
+            LOG(Helper::LogLevel::LL_Info, "Loaded quantizer: Dim:%d Bits:%d\n", m_Dim, m_Bits);
+            return ErrorCode::Success;
+        }
+
+        template <typename T>
+        ErrorCode ScalarQuantizer<T>::LoadQuantizer(std::uint8_t* raw_bytes)
+        {
+            LOG(Helper::LogLevel::LL_Info, "Loading Quantizer.\n");
+            m_Dim = *(DimensionType*)raw_bytes;
+            raw_bytes += sizeof(DimensionType);
+            m_Bits = *(int*)raw_bytes;
+            raw_bytes += sizeof(int);
+            if (m_Bits != 8 && m_Bits != 4) {
+                LOG(Helper::LogLevel::LL_Error, "Unsupported scalar quantizer bits:%d\n", m_Bits);
+                return ErrorCode::FailedParseValue;
+            }
+            m_Min = std::make_unique<float[]>(m_Dim);
+            m_Step = std::make_unique<float[]>(m_Dim);
+            std::memcpy(m_Min.get(), raw_bytes, sizeof(float) * m_Dim);
+            raw_bytes += sizeof(float) * m_Dim;
+            std::memcpy(m_Step.get(), raw_bytes, sizeof(float) * m_Dim);
+
+            InitializeDistanceFunctions();
+            LOG(Helper::LogLevel::LL_Info, "Loaded quantizer: Dim:%d Bits:%d\n", m_Dim, m_Bits);
+            return ErrorCode::Success;
+        }
+
+        template <typename T>
+        DimensionType ScalarQuantizer<T>::GetNumSubvectors() const
+        {
+            return (m_Bits == 4) ? ((m_Dim + 1) >> 1) : m_Dim;
+        }
+
+        template <typename T>
+        int ScalarQuantizer<T>::GetBase() const
+        {
+            return COMMON::Utils::GetBase<T>();
+        }
+
+        template <typename T>
+        bool ScalarQuantizer<T>::GetEnableADC() const
+        {
+            return m_EnableADC;
+        }
+
+        template <typename T>
+        void ScalarQuantizer<T>::SetEnableADC(bool enableADC)
+        {
+            m_EnableADC = enableADC;
+        }
+
+        template <typename T>
+        int ScalarQuantizer<T>::GetBits() const
+        {
+            return m_Bits;
+        }
+
+        template <typename T>
+        float* ScalarQuantizer<T>::GetL2DistanceTables()
+        {
+            return nullptr;
+        }
+
+        template <typename T>
+        void ScalarQuantizer<T>::InitializeDistanceFunctions()
+        {
+            m_fL2 = SQDistanceCalcSelector(DistCalcMethod::L2, m_Bits);
+            m_fDot = SQDistanceCalcSelector(DistCalcMethod::Cosine, m_Bits);
+        }
+    }
+}
+
+#endif // _SPTAG_COMMON_SCALARQUANTIZER_H_
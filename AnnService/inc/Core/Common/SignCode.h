@@ -0,0 +1,81 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_COMMON_SIGNCODE_H_
+#define _SPTAG_COMMON_SIGNCODE_H_
+
+#include "inc/Core/Common.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace SPTAG
+{
+    namespace COMMON
+    {
+        // 1-bit sign code of a vector's residual to its posting head: bit j is set when vec[j] > head[j].
+        // The Hamming distance between the codes of a query and a posting entry approximates the angle
+        // between their residuals and is used to skip full-precision distances for far candidates.
+        class SignCode
+        {
+        public:
+            static inline int CodeSize(DimensionType p_dim)
+            {
+                return (p_dim + 7) >> 3;
+            }
+
+            template <typename T>
+            static inline void Encode(const T* p_vec, const T* p_head, DimensionType p_dim, std::uint8_t* p_code)
+            {
+                memset(p_code, 0, CodeSize(p_dim));
+                for (DimensionType i = 0; i < p_dim; i++)
+                {
+                    if (p_vec[i] > p_head[i]) p_code[i >> 3] |= (std::uint8_t)(1 << (i & 7));
+                }
+            }
+
+            static inline int Popcount(std::uint64_t p_value)
+            {
+#ifdef _MSC_VER
+                return (int)__popcnt64(p_value);
+#else
+                return __builtin_popcountll(p_value);
+#endif
+            }
+
+            static inline int Hamming(const std::uint8_t* p_a, const std::uint8_t* p_b, int p_size)
+            {
+                int dist = 0, i = 0;
+                for (; i + 8 <= p_size; i += 8)
+                {
+                    std::uint64_t a, b;
+                    memcpy(&a, p_a + i, sizeof(a));
+                    memcpy(&b, p_b + i, sizeof(b));
+                    dist += Popcount(a ^ b);
+                }
+                for (; i < p_size; i++) dist += Popcount((std::uint64_t)(p_a[i] ^ p_b[i]));
+                return dist;
+            }
+
+            // Hamming threshold that keeps about p_keepRatio of the scored candidates of one posting.
+            // Ties at the threshold are all kept, so the cut adapts to how spread out the posting is.
+            static inline int Threshold(std::vector<int>& p_dists, int p_count, float p_keepRatio)
+            {
+                if (p_count == 0 || p_keepRatio >= 1.0f) return (std::numeric_limits<int>::max)();
+                int keep = (std::max)(1, (int)(p_count * p_keepRatio + 0.5f));
+                if (keep >= p_count) return (std::numeric_limits<int>::max)();
+                std::nth_element(p_dists.begin(), p_dists.begin() + (keep - 1), p_dists.begin() + p_count);
+                return p_dists[keep - 1];
+            }
+        };
+    }
+}
+
+#endif // _SPTAG_COMMON_SIGNCODE_H_
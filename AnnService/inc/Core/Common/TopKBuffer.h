@@ -0,0 +1,92 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_COMMON_TOPKBUFFER_H_
+#define _SPTAG_COMMON_TOPKBUFFER_H_
+
+#include "inc/Core/Common.h"
+#include "QueryResultSet.h"
+#include "SIMDUtils.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace SPTAG
+{
+    namespace COMMON
+    {
+        // Bounded top-k selection for posting scans. Candidates that are not worse than the current bound are
+        // appended to an unsorted buffer; when it fills, a SIMD filter and an nth_element selection cut it back
+        // to about k entries and tighten the bound. Flush merges the survivors into a QueryResultSet, which ends
+        // up with exactly the results that adding every candidate through AddPoint would give.
+        class TopKBuffer
+        {
+        private:
+            int m_k = 0;
+            int m_capacity = 0;
+            int m_size = 0;
+            float m_bound = MaxDist;
+            std::vector<float> m_dists;
+            std::vector<SizeType> m_vids;
+            std::vector<float> m_scratch;
+
+        public:
+            static const int c_minCapacity = 256;
+
+            // A buffer of p_capacity entries (at least 4k) collects candidates better than p_bound.
+            void Reset(int p_k, float p_bound, int p_capacity = 0)
+            {
+                m_k = (std::max)(1, p_k);
+                m_capacity = (std::max)((std::max)(p_capacity, c_minCapacity), 4 * m_k);
+                if ((int)m_dists.size() < m_capacity) {
+                    m_dists.resize(m_capacity);
+                    m_vids.resize(m_capacity);
+                }
+                m_size = 0;
+                m_bound = p_bound;
+            }
+
+            inline float Bound() const { return m_bound; }
+
+            inline int Size() const { return m_size; }
+
+            inline bool Add(SizeType p_vid, float p_dist)
+            {
+                if (p_dist > m_bound) return false;
+                m_dists[m_size] = p_dist;
+                m_vids[m_size] = p_vid;
+                if (++m_size == m_capacity) Select();
+                return true;
+            }
+
+            // Cuts the buffer back to the entries within the k-th best distance.
+            void Select()
+            {
+                m_size = SIMDUtils::FilterByBound(m_dists.data(), m_vids.data(), m_size, m_bound);
+                if (m_size > m_k) {
+                    m_scratch.assign(m_dists.begin(), m_dists.begin() + m_size);
+                    std::nth_element(m_scratch.begin(), m_scratch.begin() + (m_k - 1), m_scratch.end());
+                    m_bound = (std::min)(m_bound, m_scratch[m_k - 1]);
+                    m_size = SIMDUtils::FilterByBound(m_dists.data(), m_vids.data(), m_size, m_bound);
+                }
+                // Ties at the bound can keep the buffer full, so make room rather than reselecting on every add
+                if (m_size > m_capacity / 2) {
+                    m_capacity *= 2;
+                    m_dists.resize(m_capacity);
+                    m_vids.resize(m_capacity);
+                }
+            }
+
+            template <typename T>
+            void Flush(QueryResultSet<T>& p_results)
+            {
+                if (m_size > m_k) Select();
+                for (int i = 0; i < m_size; i++) p_results.AddPoint(m_vids[i], m_dists[i]);
+                m_size = 0;
+                m_bound = (std::min)(m_bound, p_results.worstDist());
+            }
+        };
+    }
+}
+
+#endif // _SPTAG_COMMON_TOPKBUFFER_H_
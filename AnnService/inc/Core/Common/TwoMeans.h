@@ -0,0 +1,148 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_COMMON_TWOMEANS_H_
+#define _SPTAG_COMMON_TWOMEANS_H_
+
+#include "inc/Core/Common.h"
+#include "CommonUtils.h"
+#include "DistanceUtils.h"
+
+#include <random>
+#include <vector>
+
+namespace SPTAG
+{
+    namespace COMMON
+    {
+        // 2-means for posting splits: trained on a sample of the posting for a fixed number of iterations, so
+        // its cost does not grow with the posting. The vectors are read in place through pointers, and the
+        // trained centers assign any vector with two SIMD distance computations.
+        template <typename T>
+        class TwoMeans
+        {
+        private:
+            DimensionType m_dim;
+            DistCalcMethod m_distMethod;
+            DistanceCalcReturn<T> m_fComputeDistance;
+            T* m_centers;
+            std::vector<float> m_sums;
+
+        public:
+            TwoMeans(DimensionType p_dim, DistCalcMethod p_distMethod)
+                : m_dim(p_dim), m_distMethod(p_distMethod), m_fComputeDistance(DistanceCalcSelector<T>(p_distMethod)), m_sums(2 * (size_t)p_dim)
+            {
+                m_centers = (T*)ALIGN_ALLOC(sizeof(T) * 2 * p_dim);
+            }
+
+            ~TwoMeans() { ALIGN_FREE(m_centers); }
+
+            inline const T* Center(int p_k) const { return m_centers + (size_t)p_k * m_dim; }
+
+            // Index of the closer center
+            inline int Assign(const T* p_vector, float* p_dist = nullptr) const
+            {
+                float d0 = m_fComputeDistance(p_vector, m_centers, m_dim);
+                float d1 = m_fComputeDistance(p_vector, m_centers + m_dim, m_dim);
+                if (p_dist != nullptr) *p_dist = (std::min)(d0, d1);
+                return (d1 < d0) ? 1 : 0;
+            }
+
+            // Labels every vector with its closer center, or 2 for the nullptr entries standing for stale ones,
+            // and counts the vectors of each center; p_numClusters is what Train returned. With fewer than 2
+            // clusters nothing can be split off, so every vector stays with center 0, except the copies of
+            // that center beyond the first: a posting of one repeated vector shrinks to a single entry.
+            void Label(const std::vector<const T*>& p_vectors, int p_numClusters, std::vector<std::uint8_t>& p_labels, SizeType p_counts[2]) const
+            {
+                p_labels.assign(p_vectors.size(), 2);
+                p_counts[0] = p_counts[1] = 0;
+                for (size_t i = 0; i < p_vectors.size(); i++) {
+                    if (p_vectors[i] == nullptr) continue;
+                    int k = 0;
+                    if (p_numClusters > 1) k = Assign(p_vectors[i]);
+                    else if (p_counts[0] > 0 && m_fComputeDistance(p_vectors[i], m_centers, m_dim) <= Epsilon) continue;
+                    p_labels[i] = (std::uint8_t)k;
+                    p_counts[k]++;
+                }
+            }
+
+            // Trains on at most p_sampleSize of p_vectors. The first center is a random vector and the second the
+            // one farthest from it; then p_iterations rounds of assignment and averaging, stopping early once no
+            // label changes. Unless p_virtualCenter is set, each center ends as its closest sample vector.
+            // Returns the number of distinct centers, 1 when every sampled vector is the same.
+            int Train(const std::vector<const T*>& p_vectors, int p_sampleSize, int p_iterations, bool p_virtualCenter, std::mt19937& p_rng)
+            {
+                std::vector<const T*> sample(p_vectors);
+                if (sample.empty()) return 0;
+                if (p_sampleSize > 0 && (size_t)p_sampleSize < sample.size()) {
+                    for (int i = 0; i < p_sampleSize; i++) {
+                        std::swap(sample[i], sample[i + p_rng() % (sample.size() - i)]);
+                    }
+                    sample.resize(p_sampleSize);
+                }
+
+                const T* first = sample[p_rng() % sample.size()];
+                const T* second = first;
+                float farthest = 0;
+                for (const T* v : sample) {
+                    float dist = m_fComputeDistance(v, first, m_dim);
+                    if (dist > farthest) {
+                        farthest = dist;
+                        second = v;
+                    }
+                }
+                if (farthest <= Epsilon) {
+                    std::memcpy(m_centers, first, sizeof(T) * m_dim);
+                    std::memcpy(m_centers + m_dim, first, sizeof(T) * m_dim);
+                    return 1;
+                }
+                std::memcpy(m_centers, first, sizeof(T) * m_dim);
+                std::memcpy(m_centers + m_dim, second, sizeof(T) * m_dim);
+
+                std::vector<std::uint8_t> labels(sample.size(), 2);
+                SizeType counts[2];
+                const T* closest[2];
+                float closestDist[2];
+                for (int iter = 0; iter < (std::max)(1, p_iterations); iter++) {
+                    bool changed = false;
+                    counts[0] = counts[1] = 0;
+                    closest[0] = closest[1] = nullptr;
+                    closestDist[0] = closestDist[1] = MaxDist;
+                    std::fill(m_sums.begin(), m_sums.end(), 0.0f);
+                    for (size_t i = 0; i < sample.size(); i++) {
+                        float dist;
+                        int k = Assign(sample[i], &dist);
+                        if (labels[i] != k) {
+                            labels[i] = (std::uint8_t)k;
+                            changed = true;
+                        }
+                        counts[k]++;
+                        if (dist < closestDist[k]) {
+                            closestDist[k] = dist;
+                            closest[k] = sample[i];
+                        }
+                        float* sum = m_sums.data() + (size_t)k * m_dim;
+                        for (DimensionType j = 0; j < m_dim; j++) sum[j] += (float)sample[i][j];
+                    }
+                    if (!changed) break;
+                    for (int k = 0; k < 2; k++) {
+                        if (counts[k] == 0) continue;
+                        float* sum = m_sums.data() + (size_t)k * m_dim;
+                        for (DimensionType j = 0; j < m_dim; j++) sum[j] /= counts[k];
+                        if (m_distMethod == DistCalcMethod::Cosine) Utils::Normalize(sum, m_dim, Utils::GetBase<T>());
+                        T* center = m_centers + (size_t)k * m_dim;
+                        for (DimensionType j = 0; j < m_dim; j++) center[j] = (T)sum[j];
+                    }
+                }
+                if (!p_virtualCenter) {
+                    for (int k = 0; k < 2; k++) {
+                        if (closest[k] != nullptr) std::memcpy(m_centers + (size_t)k * m_dim, closest[k], sizeof(T) * m_dim);
+                    }
+                }
+                return (counts[0] > 0 && counts[1] > 0) ? 2 : 1;
+            }
+        };
+    }
+}
+
+#endif // _SPTAG_COMMON_TWOMEANS_H_
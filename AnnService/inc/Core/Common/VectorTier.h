@@ -0,0 +1,123 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_COMMON_VECTORTIER_H_
+#define _SPTAG_COMMON_VECTORTIER_H_
+
+#include "inc/Core/Common.h"
+
+#include <vector>
+
+#ifndef _MSC_VER
+#include <fcntl.h>
+#endif
+
+namespace SPTAG
+{
+    namespace COMMON
+    {
+        // Full precision vectors addressed by row, for reranking candidates found on compressed codes. The rows
+        // are kept in memory or read on demand with positioned reads, so that concurrent queries share one handle.
+        // The file uses the head vector layout: SizeType count, DimensionType dimension, then the rows.
+        template <typename T>
+        class VectorTier
+        {
+        private:
+            SizeType m_count = 0;
+            DimensionType m_dim = 0;
+            std::vector<T> m_data;
+#ifndef _MSC_VER
+            int m_handle = -1;
+#else
+            HANDLE m_handle = INVALID_HANDLE_VALUE;
+#endif
+            static const std::uint64_t c_headerSize = sizeof(SizeType) + sizeof(DimensionType);
+
+            bool ReadAt(std::uint64_t p_offset, std::uint64_t p_size, char* p_buffer) const
+            {
+#ifndef _MSC_VER
+                while (p_size > 0) {
+                    ssize_t ret = pread(m_handle, p_buffer, p_size, p_offset);
+                    if (ret <= 0) return false;
+                    p_buffer += ret; p_offset += ret; p_size -= ret;
+                }
+                return true;
+#else
+                OVERLAPPED overlapped = {};
+                overlapped.Offset = (DWORD)(p_offset & 0xffffffff);
+                overlapped.OffsetHigh = (DWORD)(p_offset >> 32);
+                DWORD read = 0;
+                return ReadFile(m_handle, p_buffer, (DWORD)p_size, &read, &overlapped) && read == p_size;
+#endif
+            }
+
+            void Close()
+            {
+#ifndef _MSC_VER
+                if (m_handle >= 0) close(m_handle);
+                m_handle = -1;
+#else
+                if (m_handle != INVALID_HANDLE_VALUE) CloseHandle(m_handle);
+                m_handle = INVALID_HANDLE_VALUE;
+#endif
+            }
+
+        public:
+            VectorTier() = default;
+
+            VectorTier(const VectorTier&) = delete;
+            VectorTier& operator=(const VectorTier&) = delete;
+
+            ~VectorTier() { Close(); }
+
+            ErrorCode Load(const std::string& p_file, bool p_inMemory)
+            {
+                Close();
+                m_data.clear();
+                m_count = 0;
+#ifndef _MSC_VER
+                m_handle = open(p_file.c_str(), O_RDONLY);
+                if (m_handle < 0) return ErrorCode::FailedOpenFile;
+#else
+                m_handle = CreateFileA(p_file.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+                if (m_handle == INVALID_HANDLE_VALUE) return ErrorCode::FailedOpenFile;
+#endif
+                SizeType count;
+                if (!ReadAt(0, sizeof(count), (char*)&count) || !ReadAt(sizeof(count), sizeof(m_dim), (char*)&m_dim)) {
+                    Close();
+                    return ErrorCode::DiskIOFail;
+                }
+                if (p_inMemory) {
+                    m_data.resize(((std::size_t)count) * m_dim);
+                    if (!ReadAt(c_headerSize, sizeof(T) * m_data.size(), (char*)m_data.data())) {
+                        m_data.clear();
+                        Close();
+                        return ErrorCode::DiskIOFail;
+                    }
+                    Close();
+                }
+                m_count = count;
+                LOG(Helper::LogLevel::LL_Info, "Load vector tier (%d,%d) %s.\n", m_count, m_dim, p_inMemory ? "in memory" : "on disk");
+                return ErrorCode::Success;
+            }
+
+            inline bool Available() const { return m_count > 0; }
+
+            inline SizeType R() const { return m_count; }
+
+            inline DimensionType C() const { return m_dim; }
+
+            // Returns row p_id, reading it into p_buffer (C() values) when the rows stay on disk.
+            const T* Get(SizeType p_id, T* p_buffer) const
+            {
+                if (p_id < 0 || p_id >= m_count) return nullptr;
+                if (!m_data.empty()) return m_data.data() + ((std::size_t)p_id) * m_dim;
+                std::uint64_t rowSize = sizeof(T) * m_dim;
+                if (!ReadAt(c_headerSize + rowSize * p_id, rowSize, (char*)p_buffer)) return nullptr;
+                return p_buffer;
+            }
+        };
+    }
+}
+
+#endif // _SPTAG_COMMON_VECTORTIER_H_
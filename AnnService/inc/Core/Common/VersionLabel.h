@@ -5,59 +5,97 @@
 #define _SPTAG_COMMON_VERSIONLABEL_H_
 
 #include <atomic>
-#include "Dataset.h"
+#include <memory>
+#include <string>
+#include <vector>
+#include "PackedBitmap.h"
 
 namespace SPTAG
 {
     namespace COMMON
     {
+        // Per-vector version byte plus a packed deleted bitmap. Versions live in dense per-block arrays
+        // allocated alongside the bitmap blocks, so a posting scan touches one bit per candidate for the
+        // deletion check and the version byte only for survivors. The file layout is the original one,
+        // a byte per vector with 0xfe meaning deleted.
         class VersionLabel
         {
         private:
             std::atomic<SizeType> m_deleted;
-            Dataset<std::uint8_t> m_data;
-            
+            PackedBitmap m_deletedBits;
+            std::vector<std::unique_ptr<std::atomic<std::uint8_t>[]>> m_versions;
+            std::string m_name;
+
+            inline std::atomic<std::uint8_t>& Version(SizeType key) const
+            {
+                SizeType ex = m_deletedBits.RowsInBlockEx();
+                return m_versions[key >> ex][key & ((1 << ex) - 1)];
+            }
+
+            // Version blocks are created with the bitmap blocks; rows start at version 0xff like the
+            // memset(-1) of Dataset.
+            inline void ReserveVersions(SizeType rows, SizeType from)
+            {
+                SizeType ex = m_deletedBits.RowsInBlockEx();
+                while ((((std::int64_t)m_versions.size()) << ex) < rows) {
+                    m_versions.emplace_back(new std::atomic<std::uint8_t>[((size_t)1) << ex]);
+                    for (SizeType i = 0; i < (1 << ex); i++) m_versions.back()[i].store(0xff, std::memory_order_relaxed);
+                }
+                for (SizeType i = from; i < rows; i++) Version(i).store(0xff, std::memory_order_relaxed);
+            }
+
         public:
             VersionLabel() 
             {
                 m_deleted = 0;
-                m_data.SetName("versionLabelID");
+                m_name = "versionLabelID";
             }
 
             void Initialize(SizeType size, SizeType blockSize, SizeType capacity)
             {
-                m_data.Initialize(size, 1, blockSize, capacity);
+                m_deleted = 0;
+                m_deletedBits.Initialize(size, blockSize, capacity);
+                m_versions.clear();
+                m_versions.reserve((static_cast<std::int64_t>((std::max)(size, capacity)) >> m_deletedBits.RowsInBlockEx()) + 1);
+                ReserveVersions(size, size);
             }
 
-            inline size_t Count() const { return m_data.R() - m_deleted.load(); }
+            inline size_t Count() const { return m_deletedBits.R() - m_deleted.load(); }
 
             inline size_t GetDeleteCount() const { return m_deleted.load();}
 
             inline bool Deleted(const SizeType& key) const
             {
-                return *m_data[key] == 0xfe;
+                return m_deletedBits.Test(key);
+            }
+
+            // out_mask[i] = 1 when vids[i] is not deleted.
+            inline void FilterDeleted(const SizeType* vids, int n, std::uint8_t* out_mask) const
+            {
+                m_deletedBits.Filter(vids, n, out_mask);
             }
 
             inline bool Delete(const SizeType& key)
             {
-                uint8_t oldvalue = (uint8_t)InterlockedExchange8((char*)(m_data[key]), (char)0xfe);
-                if (oldvalue == 0xfe) return false;
+                if (!m_deletedBits.Set(key)) return false;
                 m_deleted++;
                 return true;
             }
 
-            inline uint8_t GetVersion(const SizeType& key)
+            inline uint8_t GetVersion(const SizeType& key) const
             {
-                return *m_data[key];
+                if (Deleted(key)) return 0xfe;
+                return Version(key).load(std::memory_order_relaxed);
             }
 
             inline bool IncVersion(const SizeType& key, uint8_t* newVersion)
             {
+                std::atomic<std::uint8_t>& version = Version(key);
                 while (true) {
                     if (Deleted(key)) return false;
-                    uint8_t oldVersion = GetVersion(key);
+                    uint8_t oldVersion = version.load();
                     *newVersion = (oldVersion+1) & 0x7f;
-                    if (((uint8_t)InterlockedCompareExchange((char*)m_data[key], (char)*newVersion, (char)oldVersion)) == oldVersion) {
+                    if (version.compare_exchange_weak(oldVersion, *newVersion)) {
                         return true;
                     }
                 }
@@ -65,19 +103,31 @@ namespace SPTAG
 
             inline SizeType GetVectorNum()
             {
-                return m_data.R();
+                return m_deletedBits.R();
             }
 
             inline ErrorCode Save(std::shared_ptr<Helper::DiskIO> output)
             {
                 SizeType deleted = m_deleted.load();
                 IOBINARY(output, WriteBinary, sizeof(SizeType), (char*)&deleted);
-                return m_data.Save(output);
+
+                SizeType rows = m_deletedBits.R();
+                DimensionType cols = 1;
+                IOBINARY(output, WriteBinary, sizeof(SizeType), (char*)&rows);
+                IOBINARY(output, WriteBinary, sizeof(DimensionType), (char*)&cols);
+                std::vector<std::uint8_t> buffer((std::min)(rows, (SizeType)(1 << 20)));
+                for (SizeType begin = 0; begin < rows; begin += (SizeType)buffer.size()) {
+                    SizeType num = (std::min)((SizeType)buffer.size(), rows - begin);
+                    for (SizeType i = 0; i < num; i++) buffer[i] = GetVersion(begin + i);
+                    IOBINARY(output, WriteBinary, num, (char*)buffer.data());
+                }
+                LOG(Helper::LogLevel::LL_Info, "Save %s (%d,%d) Finish!\n", m_name.c_str(), rows, cols);
+                return ErrorCode::Success;
             }
 
             inline ErrorCode Save(const std::string& filename)
             {
-                LOG(Helper::LogLevel::LL_Info, "Save %s To %s\n", m_data.Name().c_str(), filename.c_str());
+                LOG(Helper::LogLevel::LL_Info, "Save %s To %s\n", m_name.c_str(), filename.c_str());
                 auto ptr = f_createIO();
                 if (ptr == nullptr || !ptr->Initialize(filename.c_str(), std::ios::binary | std::ios::out)) return ErrorCode::FailedCreateFile;
                 return Save(ptr);
@@ -85,15 +135,27 @@ namespace SPTAG
 
             inline ErrorCode Load(std::shared_ptr<Helper::DiskIO> input, SizeType blockSize, SizeType capacity)
             {
-                SizeType deleted;
+                SizeType deleted, rows;
+                DimensionType cols;
                 IOBINARY(input, ReadBinary, sizeof(SizeType), (char*)&deleted);
+                IOBINARY(input, ReadBinary, sizeof(SizeType), (char*)&rows);
+                IOBINARY(input, ReadBinary, sizeof(DimensionType), (char*)&cols);
+
+                Initialize(rows, blockSize, capacity);
+                std::vector<std::uint8_t> buffer((std::min)(rows, (SizeType)(1 << 20)));
+                for (SizeType begin = 0; begin < rows; begin += (SizeType)buffer.size()) {
+                    SizeType num = (std::min)((SizeType)buffer.size(), rows - begin);
+                    IOBINARY(input, ReadBinary, num, (char*)buffer.data());
+                    LoadRows(begin, num, buffer.data());
+                }
                 m_deleted = deleted;
-                return m_data.Load(input, blockSize, capacity);
+                LOG(Helper::LogLevel::LL_Info, "Load %s (%d,%d) Finish!\n", m_name.c_str(), rows, cols);
+                return ErrorCode::Success;
             }
 
             inline ErrorCode Load(const std::string& filename, SizeType blockSize, SizeType capacity)
             {
-                LOG(Helper::LogLevel::LL_Info, "Load %s From %s\n", m_data.Name().c_str(), filename.c_str());
+                LOG(Helper::LogLevel::LL_Info, "Load %s From %s\n", m_name.c_str(), filename.c_str());
                 auto ptr = f_createIO();
                 if (ptr == nullptr || !ptr->Initialize(filename.c_str(), std::ios::binary | std::ios::in)) return ErrorCode::FailedOpenFile;
                 return Load(ptr, blockSize, capacity);
@@ -101,26 +163,44 @@ namespace SPTAG
 
             inline ErrorCode Load(char* pmemoryFile, SizeType blockSize, SizeType capacity)
             {
-                m_deleted = *((SizeType*)pmemoryFile);
-                return m_data.Load(pmemoryFile + sizeof(SizeType), blockSize, capacity);
+                SizeType deleted = *((SizeType*)pmemoryFile);
+                SizeType rows = *((SizeType*)(pmemoryFile + sizeof(SizeType)));
+                Initialize(rows, blockSize, capacity);
+                LoadRows(0, rows, (const std::uint8_t*)(pmemoryFile + 2 * sizeof(SizeType) + sizeof(DimensionType)));
+                m_deleted = deleted;
+                return ErrorCode::Success;
+            }
+
+            inline void LoadRows(SizeType begin, SizeType num, const std::uint8_t* values)
+            {
+                for (SizeType i = 0; i < num; i++) {
+                    Version(begin + i).store(values[i], std::memory_order_relaxed);
+                    if (values[i] == 0xfe) m_deletedBits.Set(begin + i);
+                }
             }
 
             inline ErrorCode AddBatch(SizeType num)
             {
-                return m_data.AddBatch(num);
+                SizeType begin = m_deletedBits.R();
+                ErrorCode ret = m_deletedBits.AddBatch(num);
+                if (ret != ErrorCode::Success) return ret;
+                ReserveVersions(begin + num, begin);
+                return ErrorCode::Success;
             }
 
             inline std::uint64_t BufferSize() const 
             {
-                return m_data.BufferSize() + sizeof(SizeType);
+                return sizeof(SizeType) + sizeof(SizeType) + sizeof(DimensionType) + sizeof(std::uint8_t) * m_deletedBits.R();
             }
 
             inline void SetR(SizeType num)
             {
-                m_data.SetR(num);
+                SizeType begin = m_deletedBits.R();
+                m_deletedBits.SetR(num);
+                if (num > begin) ReserveVersions(num, begin);
             }
         };
     }
 }
 
-#endif // _SPTAG_COMMON_LABELSET_H_
+#endif // _SPTAG_COMMON_VERSIONLABEL_H_
@@ -138,6 +138,36 @@ namespace SPTAG
             }
         };
 
+        // Visited set indexed directly by node ID. Each node keeps the epoch of the last query that visited it,
+        // so clear() is an epoch bump and a lookup is a single load, at 2 bytes per node of memory.
+        class EpochVisitedSet
+        {
+        private:
+            std::vector<std::uint16_t> m_epochs;
+            std::uint16_t m_epoch = 0;
+
+        public:
+            inline size_t Size() const { return m_epochs.size(); }
+
+            void clear(SizeType size)
+            {
+                if ((size_t)size > m_epochs.size()) m_epochs.resize(size, 0);
+                if (++m_epoch == 0) {
+                    std::fill(m_epochs.begin(), m_epochs.end(), (std::uint16_t)0);
+                    m_epoch = 1;
+                }
+            }
+
+            inline bool CheckAndSet(SizeType idx)
+            {
+                // Nodes added after the query started grow the array on demand
+                if ((size_t)idx >= m_epochs.size()) m_epochs.resize((size_t)idx + 1 + (m_epochs.size() >> 3), 0);
+                if (m_epochs[idx] == m_epoch) return true;
+                m_epochs[idx] = m_epoch;
+                return false;
+            }
+        };
+
         class DistPriorityQueue {
             int m_size;
             std::unique_ptr<float[]> m_data;
@@ -229,9 +259,13 @@ namespace SPTAG
                 Initialize(maxCheck, hashExp);
             }
 
-            void Reset(int maxCheck, int resultNum)
+            // A positive p_visitedSize switches this query to the epoch visited set sized to the index,
+            // otherwise the hash table is used.
+            void Reset(int maxCheck, int resultNum, SizeType p_visitedSize = 0)
             {
-                nodeCheckStatus.clear();
+                m_useEpochVisited = p_visitedSize > 0;
+                if (m_useEpochVisited) epochCheckStatus.clear(p_visitedSize);
+                else nodeCheckStatus.clear();
                 m_SPTQueue.clear();
                 m_NGQueue.clear();
                 m_Results.clear(max(maxCheck / 16, resultNum));
@@ -245,7 +279,7 @@ namespace SPTAG
 
             inline bool CheckAndSet(SizeType idx)
             {
-                return nodeCheckStatus.CheckAndSet(idx);
+                return m_useEpochVisited ? epochCheckStatus.CheckAndSet(idx) : nodeCheckStatus.CheckAndSet(idx);
             }
 
             inline int HashTableExponent() const 
@@ -256,6 +290,8 @@ namespace SPTAG
             static void Reset() {}
 
             OptHashPosVector nodeCheckStatus;
+            EpochVisitedSet epochCheckStatus;
+            bool m_useEpochVisited = false;
 
             // counter for dynamic pivoting
             int m_iNumOfContinuousNoBetterPropagation;
@@ -7,9 +7,14 @@
 #include "WorkSpace.h"
 #include "inc/Helper/ConcurrentSet.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <stdarg.h>
+#include <thread>
 
 namespace SPTAG
 {
@@ -70,6 +75,157 @@ namespace SPTAG
             T m_workSpace;
         };
 
+        // Fixed-size pool of workspaces with one lock-free free list per NUMA node. A slot is homed on node
+        // (slot % nodes) and its workspace is built by the first thread that rents it from that node, so the
+        // buffers are first touched there. Rent prefers the caller's node, steals from the others when it is
+        // empty and, when every slot is in use, hands out an unpooled workspace or waits for a slot if the
+        // workspaces carry per-slot resources (SetWaitForSlot).
+        template<typename T>
+        class BoundedWorkSpacePool
+        {
+        private:
+            static const std::uint32_t c_empty = 0xffffffff;
+
+            // Free list head: low 32 bits hold the top slot, the high 32 bits a tag bumped on every update (ABA)
+            struct alignas(64) FreeList
+            {
+                std::atomic<std::uint64_t> m_head{ c_empty };
+            };
+
+        public:
+            class Lease
+            {
+            public:
+                Lease() {}
+
+                Lease(BoundedWorkSpacePool* p_pool, std::uint32_t p_slot, T* p_workSpace) : m_pool(p_pool), m_slot(p_slot), m_workSpace(p_workSpace) {}
+
+                explicit Lease(std::unique_ptr<T> p_transient) : m_workSpace(p_transient.get()), m_transient(std::move(p_transient)) {}
+
+                Lease(Lease&& p_other) noexcept { *this = std::move(p_other); }
+
+                Lease& operator=(Lease&& p_other) noexcept
+                {
+                    if (this != &p_other) {
+                        Release();
+                        m_pool = p_other.m_pool;
+                        m_slot = p_other.m_slot;
+                        m_workSpace = p_other.m_workSpace;
+                        m_transient = std::move(p_other.m_transient);
+                        p_other.m_pool = nullptr;
+                        p_other.m_workSpace = nullptr;
+                    }
+                    return *this;
+                }
+
+                Lease(const Lease&) = delete;
+                Lease& operator=(const Lease&) = delete;
+
+                ~Lease() { Release(); }
+
+                inline T* get() const { return m_workSpace; }
+                inline T* operator->() const { return m_workSpace; }
+                inline bool Pooled() const { return m_pool != nullptr; }
+
+                // Index of the pooled slot, stable for the pool's lifetime; meaningless for a transient workspace
+                inline std::uint32_t Slot() const { return m_slot; }
+
+            private:
+                void Release()
+                {
+                    if (m_pool != nullptr) m_pool->Return(m_slot);
+                    m_transient.reset();
+                    m_pool = nullptr;
+                    m_workSpace = nullptr;
+                }
+
+                BoundedWorkSpacePool* m_pool = nullptr;
+                std::uint32_t m_slot = 0;
+                T* m_workSpace = nullptr;
+                std::unique_ptr<T> m_transient;
+            };
+
+            BoundedWorkSpacePool() {}
+
+            void Init(int p_size, int p_nodes, ...)
+            {
+                va_list args;
+                va_start(args, p_nodes);
+                m_workSpace.Initialize(args);
+                va_end(args);
+
+                m_size = (std::uint32_t)(std::max)(1, p_size);
+                m_nodes = (std::max)(1, p_nodes);
+                m_slots.reset(new std::unique_ptr<T>[m_size]);
+                m_next.reset(new std::atomic<std::uint32_t>[m_size]);
+                m_freeLists.reset(new FreeList[m_nodes]);
+                for (std::uint32_t i = m_size; i-- > 0;) Return(i);
+            }
+
+            inline bool Available() const { return m_size > 0; }
+
+            // Set before the first Rent: a rent that finds every slot in use spins until one is returned
+            // instead of building a transient workspace.
+            inline void SetWaitForSlot(bool p_wait) { m_waitForSlot = p_wait; }
+
+            Lease Rent(int p_node)
+            {
+                int home = (p_node < 0) ? 0 : p_node % m_nodes;
+                bool waited = false;
+                while (true) {
+                    for (int n = 0; n < m_nodes; n++) {
+                        std::uint32_t slot = Pop((home + n) % m_nodes);
+                        if (slot == c_empty) continue;
+                        // Only the lease holder touches the slot, so the lazy build needs no lock
+                        if (m_slots[slot] == nullptr) m_slots[slot].reset(new T(m_workSpace));
+                        return Lease(this, slot, m_slots[slot].get());
+                    }
+                    if (!waited) m_overflow++;
+                    if (!m_waitForSlot) return Lease(std::unique_ptr<T>(new T(m_workSpace)));
+                    waited = true;
+                    std::this_thread::yield();
+                }
+            }
+
+            inline std::uint32_t Size() const { return m_size; }
+
+            // Rents that found every slot in use and fell back to a transient workspace or waited for a slot
+            inline std::uint64_t GetOverflowCount() const { return m_overflow.load(); }
+
+        private:
+            std::uint32_t Pop(int p_node)
+            {
+                std::atomic<std::uint64_t>& head = m_freeLists[p_node].m_head;
+                std::uint64_t current = head.load(std::memory_order_acquire);
+                while (true) {
+                    std::uint32_t slot = (std::uint32_t)current;
+                    if (slot == c_empty) return c_empty;
+                    std::uint64_t next = ((current >> 32) + 1) << 32 | m_next[slot].load(std::memory_order_relaxed);
+                    if (head.compare_exchange_weak(current, next, std::memory_order_acq_rel, std::memory_order_acquire)) return slot;
+                }
+            }
+
+            void Return(std::uint32_t p_slot)
+            {
+                std::atomic<std::uint64_t>& head = m_freeLists[p_slot % m_nodes].m_head;
+                std::uint64_t current = head.load(std::memory_order_relaxed);
+                while (true) {
+                    m_next[p_slot].store((std::uint32_t)current, std::memory_order_relaxed);
+                    std::uint64_t next = ((current >> 32) + 1) << 32 | p_slot;
+                    if (head.compare_exchange_weak(current, next, std::memory_order_release, std::memory_order_relaxed)) return;
+                }
+            }
+
+            std::uint32_t m_size = 0;
+            int m_nodes = 1;
+            std::unique_ptr<std::unique_ptr<T>[]> m_slots;
+            std::unique_ptr<std::atomic<std::uint32_t>[]> m_next;
+            std::unique_ptr<FreeList[]> m_freeLists;
+            std::atomic<std::uint64_t> m_overflow{ 0 };
+            bool m_waitForSlot = false;
+            T m_workSpace;
+        };
+
     }
 }
 
@@ -44,6 +44,7 @@ DefineDistCalcMethod(InnerProduct)
 DefineQuantizerType(None, std::shared_ptr<void>)
 DefineQuantizerType(PQQuantizer, std::shared_ptr<SPTAG::COMMON::PQQuantizer>)
 DefineQuantizerType(OPQQuantizer, std::shared_ptr<SPTAG::COMMON::OPQQuantizer>)
+DefineQuantizerType(ScalarQuantizer, std::shared_ptr<SPTAG::COMMON::ScalarQuantizer>)
 
 #endif // DefineQuantizerType
 
@@ -70,6 +71,7 @@ DefineErrorCode(DiskIOFail, 0x0020)
 // 0x1000 ~ 0x1FFF  Index Build Status
 
 // 0x2000 ~ 0x2FFF  Index Serve Status
+DefineErrorCode(InsertQueueFull, 0x2000)
 
 // 0x3000 ~ 0x3FFF  Helper Function Status
 DefineErrorCode(ReadIni_FailedParseSection, 0x3000)
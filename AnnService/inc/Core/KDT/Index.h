@@ -82,10 +82,16 @@ namespace SPTAG
             int m_iNumberOfInitialDynamicPivots;
             int m_iNumberOfOtherDynamicPivots;
             int m_iHashTableExp;
+            int m_iEpochVisitedLimit;
+            int m_iHugePageMode;
+            int m_iNumaPlacement;
 
         public:
             static thread_local std::shared_ptr<COMMON::WorkSpace> m_workspace;
 
+            // Visited set size passed to WorkSpace::Reset: the sample count for small enough indexes, else 0 (hash table)
+            inline SizeType VisitedSize() const { return (m_iEpochVisitedLimit > 0 && m_pSamples.R() <= m_iEpochVisitedLimit) ? m_pSamples.R() : 0; }
+
         public:
             Index()
             {
@@ -45,6 +45,9 @@ DefineKDTParameter(m_iThresholdOfNumberOfContinuousNoBetterPropagation, int, 3L,
 DefineKDTParameter(m_iNumberOfInitialDynamicPivots, int, 50L, "NumberOfInitialDynamicPivots")
 DefineKDTParameter(m_iNumberOfOtherDynamicPivots, int, 4L, "NumberOfOtherDynamicPivots")
 DefineKDTParameter(m_iHashTableExp, int, 2L, "HashTableExponent")
+DefineKDTParameter(m_iEpochVisitedLimit, int, 0L, "EpochVisitedLimit") // Indexes up to this many vectors track visited nodes in a per-thread epoch array instead of the hash table, 0 (default) keeps the hash table
+DefineKDTParameter(m_iHugePageMode, int, 0L, "HugePageMode") // Page size for the vector and graph blocks of this index: 0 default, 1 transparent huge pages, 2 2MB hugetlb, 3 1GB hugetlb
+DefineKDTParameter(m_iNumaPlacement, int, 0L, "NumaPlacement") // NUMA placement of data blocks: 0 first touch, 1 interleave over all nodes, 2 bind to the allocating thread's node
 DefineKDTParameter(m_iDataBlockSize, int, 1024 * 1024, "DataBlockSize")
 DefineKDTParameter(m_iDataCapacity, int, MaxSize, "DataCapacity")
 DefineKDTParameter(m_iMetaRecordSize, int, 10, "MetaRecordSize")
@@ -0,0 +1,135 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_SPANN_ADMISSIONCONTROLLER_H_
+#define _SPTAG_SPANN_ADMISSIONCONTROLLER_H_
+
+#include "inc/Core/Common.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace SPTAG
+{
+    namespace SPANN
+    {
+        struct AdmissionState
+        {
+            bool m_enabled = false;
+            // Maintenance debt at the last admission: queued maintenance jobs plus oversized postings
+            double m_debt = 0;
+            // Vectors per second currently let through, negative while inserts are not throttled
+            double m_rate = -1;
+            double m_tokens = 0;
+            std::uint64_t m_admitted = 0;
+            std::uint64_t m_delayed = 0;
+            std::uint64_t m_delayMs = 0;
+            // Callers let through after waiting the longest allowed delay
+            std::uint64_t m_timeouts = 0;
+        };
+
+        // Token bucket in front of inserts. While the maintenance debt stays at or below the target, inserts
+        // pass untouched. Above it the bucket refills at a rate that falls linearly from the configured rate
+        // to zero as the debt approaches its maximum, so inserters slow down gradually instead of hitting a
+        // wall; at the maximum they wait for the background workers to catch up. Unthrottled inserts do not
+        // drain the bucket, so it is full whenever throttling starts.
+        class AdmissionController
+        {
+        private:
+            std::function<double()> m_debt;
+            double m_targetDebt = 0;
+            double m_maxDebt = 0;
+            double m_rate = 0;
+            double m_burst = 0;
+            int m_maxDelayMs = 0;
+            std::atomic<bool> m_enabled{ false };
+
+            mutable std::mutex m_lock;
+            double m_tokens = 0;
+            std::chrono::steady_clock::time_point m_last;
+            AdmissionState m_state;
+
+            double RateAt(double p_debt) const
+            {
+                if (p_debt <= m_targetDebt) return -1;
+                if (p_debt >= m_maxDebt) return 0;
+                return m_rate * (m_maxDebt - p_debt) / (m_maxDebt - m_targetDebt);
+            }
+
+        public:
+            // p_targetDebt <= 0 disables the controller. p_rate is in vectors per second, p_burst in vectors, and
+            // p_maxDelayMs <= 0 lets a caller wait as long as the debt stays at its maximum.
+            void Configure(std::function<double()> p_debt, double p_targetDebt, double p_maxDebt, double p_rate, double p_burst, int p_maxDelayMs)
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_debt = std::move(p_debt);
+                m_targetDebt = p_targetDebt;
+                m_maxDebt = (std::max)(p_maxDebt, p_targetDebt + 1);
+                m_rate = (std::max)(p_rate, 1.0);
+                m_burst = (std::max)(p_burst, 1.0);
+                m_maxDelayMs = p_maxDelayMs;
+                m_tokens = m_burst;
+                m_last = std::chrono::steady_clock::now();
+                m_enabled = (m_debt != nullptr && p_targetDebt > 0);
+                m_state.m_enabled = m_enabled;
+            }
+
+            // Blocks the caller until p_count vectors may be inserted. A batch larger than the bucket goes
+            // through once the bucket is full and leaves it in debt.
+            void Admit(SizeType p_count)
+            {
+                if (!m_enabled.load() || p_count <= 0) return;
+                double need = (std::min)((double)p_count, m_burst);
+                auto start = std::chrono::steady_clock::now();
+                bool delayed = false;
+                while (true) {
+                    double waitSec;
+                    {
+                        std::lock_guard<std::mutex> lock(m_lock);
+                        auto now = std::chrono::steady_clock::now();
+                        double debt = m_debt();
+                        double rate = RateAt(debt);
+                        if (rate < 0) m_tokens = m_burst;
+                        else m_tokens = (std::min)(m_burst, m_tokens + rate * std::chrono::duration<double>(now - m_last).count());
+                        m_last = now;
+                        m_state.m_debt = debt;
+                        m_state.m_rate = rate;
+
+                        std::uint64_t waitedMs = (std::uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count();
+                        bool timeout = m_maxDelayMs > 0 && waitedMs >= (std::uint64_t)m_maxDelayMs;
+                        // At the maximum debt even a full bucket waits
+                        bool enough = rate != 0 && m_tokens >= need;
+                        if (enough || timeout) {
+                            if (rate > 0) m_tokens -= p_count;
+                            m_state.m_tokens = m_tokens;
+                            m_state.m_admitted += p_count;
+                            if (delayed) {
+                                m_state.m_delayed++;
+                                m_state.m_delayMs += waitedMs;
+                            }
+                            if (!enough) m_state.m_timeouts++;
+                            return;
+                        }
+                        m_state.m_tokens = m_tokens;
+                        // Wake up at least every 10ms to see whether the debt went down
+                        waitSec = (rate > 0) ? (std::min)((need - m_tokens) / rate, 0.01) : 0.01;
+                    }
+                    delayed = true;
+                    std::this_thread::sleep_for(std::chrono::duration<double>(waitSec));
+                }
+            }
+
+            AdmissionState GetState() const
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                return m_state;
+            }
+        };
+    }
+}
+
+#endif // _SPTAG_SPANN_ADMISSIONCONTROLLER_H_
@@ -8,12 +8,18 @@
 #include "inc/Helper/AsyncFileReader.h"
 #include "IExtraSearcher.h"
 #include "ExtraStaticSearcher.h"
+#include "HeadReplicas.h"
 #include "inc/Core/Common/TruthSet.h"
 #include "inc/Helper/KeyValueIO.h"
 #include "inc/Core/Common/FineGrainedLock.h"
 #include "PersistentBuffer.h"
 #include "inc/Core/Common/PostingSizeRecord.h"
+#include "inc/Core/Common/SignCode.h"
+#include "inc/Core/Common/ResidualCode.h"
+#include "inc/Core/Common/TwoMeans.h"
 #include "ExtraSPDKController.h"
+#include "inc/Helper/PriorityScheduler.h"
+#include "inc/Helper/LockFree.h"
 #include <chrono>
 #include <map>
 #include <cmath>
@@ -22,6 +28,8 @@
 #include <numeric>
 #include <utility>
 #include <random>
+#include <unordered_map>
+#include <deque>
 #include <tbb/concurrent_hash_map.h>
 
 #ifdef ROCKSDB
@@ -35,19 +43,22 @@ namespace SPTAG::SPANN {
     template <typename ValueType>
     class ExtraDynamicSearcher : public IExtraSearcher
     {
-        class MergeAsyncJob : public Helper::ThreadPool::Job
+        // Background jobs come from per-type JobPools and go back there once run
+        class MergeAsyncJob : public Helper::PooledJob<MergeAsyncJob>
         {
         private:
-            VectorIndex* m_index;
-            ExtraDynamicSearcher<ValueType>* m_extraIndex;
-            SizeType headID;
-            bool disableReassign;
+            VectorIndex* m_index = nullptr;
+            ExtraDynamicSearcher<ValueType>* m_extraIndex = nullptr;
+            SizeType headID = 0;
+            bool disableReassign = false;
             std::function<void()> m_callback;
         public:
-            MergeAsyncJob(VectorIndex* headIndex, ExtraDynamicSearcher<ValueType>* extraIndex, SizeType headID, bool disableReassign, std::function<void()> p_callback)
-                : m_index(headIndex), m_extraIndex(extraIndex), headID(headID), disableReassign(disableReassign), m_callback(std::move(p_callback)) {}
+            void Set(VectorIndex* headIndex, ExtraDynamicSearcher<ValueType>* extraIndex, SizeType headID, bool disableReassign, std::function<void()> p_callback)
+            {
+                m_index = headIndex; m_extraIndex = extraIndex; this->headID = headID; this->disableReassign = disableReassign; m_callback = std::move(p_callback);
+            }
 
-            ~MergeAsyncJob() {}
+            void Clear() { m_callback = nullptr; }
 
             inline void exec(IAbortOperation* p_abort) override {
                 m_extraIndex->MergePostings(m_index, headID, !disableReassign);
@@ -57,19 +68,21 @@ namespace SPTAG::SPANN {
             }
         };
 
-        class SplitAsyncJob : public Helper::ThreadPool::Job
+        class SplitAsyncJob : public Helper::PooledJob<SplitAsyncJob>
         {
         private:
-            VectorIndex* m_index;
-            ExtraDynamicSearcher<ValueType>* m_extraIndex;
-            SizeType headID;
-            bool disableReassign;
+            VectorIndex* m_index = nullptr;
+            ExtraDynamicSearcher<ValueType>* m_extraIndex = nullptr;
+            SizeType headID = 0;
+            bool disableReassign = false;
             std::function<void()> m_callback;
         public:
-            SplitAsyncJob(VectorIndex* headIndex, ExtraDynamicSearcher<ValueType>* extraIndex, SizeType headID, bool disableReassign, std::function<void()> p_callback)
-                : m_index(headIndex), m_extraIndex(extraIndex), headID(headID), disableReassign(disableReassign), m_callback(std::move(p_callback)) {}
+            void Set(VectorIndex* headIndex, ExtraDynamicSearcher<ValueType>* extraIndex, SizeType headID, bool disableReassign, std::function<void()> p_callback)
+            {
+                m_index = headIndex; m_extraIndex = extraIndex; this->headID = headID; this->disableReassign = disableReassign; m_callback = std::move(p_callback);
+            }
 
-            ~SplitAsyncJob() {}
+            void Clear() { m_callback = nullptr; }
 
             inline void exec(IAbortOperation* p_abort) override {
                 m_extraIndex->Split(m_index, headID, !disableReassign);
@@ -79,20 +92,22 @@ namespace SPTAG::SPANN {
             }
         };
 
-        class ReassignAsyncJob : public Helper::ThreadPool::Job
+        class ReassignAsyncJob : public Helper::PooledJob<ReassignAsyncJob>
         {
         private:
-            VectorIndex* m_index;
-            ExtraDynamicSearcher<ValueType>* m_extraIndex;
+            VectorIndex* m_index = nullptr;
+            ExtraDynamicSearcher<ValueType>* m_extraIndex = nullptr;
             std::shared_ptr<std::string> vectorInfo;
-            SizeType HeadPrev;
+            SizeType HeadPrev = 0;
             std::function<void()> m_callback;
         public:
-            ReassignAsyncJob(VectorIndex* headIndex, ExtraDynamicSearcher<ValueType>* extraIndex,
+            void Set(VectorIndex* headIndex, ExtraDynamicSearcher<ValueType>* extraIndex,
                 std::shared_ptr<std::string> vectorInfo, SizeType HeadPrev, std::function<void()> p_callback)
-                : m_index(headIndex), m_extraIndex(extraIndex), vectorInfo(std::move(vectorInfo)), HeadPrev(HeadPrev), m_callback(std::move(p_callback)) {}
+            {
+                m_index = headIndex; m_extraIndex = extraIndex; this->vectorInfo = std::move(vectorInfo); this->HeadPrev = HeadPrev; m_callback = std::move(p_callback);
+            }
 
-            ~ReassignAsyncJob() {}
+            void Clear() { vectorInfo.reset(); m_callback = nullptr; }
 
             void exec(IAbortOperation* p_abort) override {
                 m_extraIndex->Reassign(m_index, vectorInfo, HeadPrev);
@@ -102,37 +117,61 @@ namespace SPTAG::SPANN {
             }
         };
 
-        class SPDKThreadPool : public Helper::ThreadPool
+        // Entries of one split that belong to other heads, reassigned together
+        class ReassignBatchJob : public Helper::PooledJob<ReassignBatchJob>
         {
+        private:
+            VectorIndex* m_index = nullptr;
+            ExtraDynamicSearcher<ValueType>* m_extraIndex = nullptr;
+            std::string m_entries;
+            std::vector<SizeType> m_headPrevs;
         public:
-            void initSPDK(int numberOfThreads, ExtraDynamicSearcher<ValueType>* extraIndex) 
+            void Set(VectorIndex* headIndex, ExtraDynamicSearcher<ValueType>* extraIndex)
             {
-                m_abort.SetAbort(false);
-                for (int i = 0; i < numberOfThreads; i++)
-                {
-                    m_threads.emplace_back([this, extraIndex] {
-                        extraIndex->Initialize();
-                        Job *j;
-                        while (get(j))
-                        {
-                            try 
-                            {
-                                currentJobs++;
-                                j->exec(&m_abort);
-                                currentJobs--;
-                            }
-                            catch (std::exception& e) {
-                                LOG(Helper::LogLevel::LL_Error, "ThreadPool: exception in %s %s\n", typeid(*j).name(), e.what());
-                            }
-                            
-                            delete j;
-                        }
-                        extraIndex->ExitBlockController();
-                    });
-                }
+                m_index = headIndex; m_extraIndex = extraIndex;
+            }
+
+            void Add(const char* p_entry, size_t p_entrySize, SizeType p_headPrev)
+            {
+                m_entries.append(p_entry, p_entrySize);
+                m_headPrevs.push_back(p_headPrev);
+            }
+
+            inline size_t Size() const { return m_headPrevs.size(); }
+
+            // Keeps the buffers for the next batch
+            void Clear() { m_entries.clear(); m_headPrevs.clear(); }
+
+            void exec(IAbortOperation* p_abort) override {
+                m_extraIndex->ReassignBatch(m_index, m_entries, m_headPrevs);
+            }
+        };
+
+        // Rewrites one posting without its dead entries, for the background GC
+        class GarbageCollectJob : public Helper::PooledJob<GarbageCollectJob>
+        {
+        private:
+            VectorIndex* m_index = nullptr;
+            ExtraDynamicSearcher<ValueType>* m_extraIndex = nullptr;
+            SizeType headID = 0;
+        public:
+            void Set(VectorIndex* headIndex, ExtraDynamicSearcher<ValueType>* extraIndex, SizeType headID)
+            {
+                m_index = headIndex; m_extraIndex = extraIndex; this->headID = headID;
+            }
+
+            void Clear() {}
+
+            void exec(IAbortOperation* p_abort) override {
+                auto begin = std::chrono::high_resolution_clock::now();
+                m_extraIndex->GarbageCollect(m_index, headID);
+                m_extraIndex->GCJobDone(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - begin).count());
             }
         };
 
+        // Scheduler levels, most urgent first: splits of oversized postings hurt search latency the most
+        enum JobPriority : int { SplitPriority = 0, MergePriority = 1, ReassignPriority = 2, GCPriority = 3, PriorityLevels = 4 };
+
     private:
         std::shared_ptr<Helper::KeyValueIO> db;
 
@@ -147,8 +186,31 @@ namespace SPTAG::SPANN {
 
         COMMON::PostingSizeRecord m_postingSizes;
 
-        std::shared_ptr<SPDKThreadPool> m_splitThreadPool;
-        std::shared_ptr<SPDKThreadPool> m_reassignThreadPool;
+        Helper::JobPool<SplitAsyncJob> m_splitJobs;
+        Helper::JobPool<MergeAsyncJob> m_mergeJobs;
+        Helper::JobPool<ReassignAsyncJob> m_reassignJobs;
+        Helper::JobPool<ReassignBatchJob> m_reassignBatchJobs;
+        Helper::JobPool<GarbageCollectJob> m_gcJobs;
+
+        // Maintenance threads, started by the first insert or search that brings the head index along: the
+        // merge manager, fed by searches through a lock-free ring of merge hints, and the GC planner
+        std::once_flag m_maintenanceStarted;
+        std::thread m_mergeThread;
+        std::thread m_gcThread;
+        std::mutex m_maintenanceLock;
+        std::condition_variable m_maintenanceWake;
+        bool m_maintenanceStop = false;
+        std::atomic<int> m_gcInFlight{ 0 };
+        std::atomic<std::int64_t> m_gcJobMicros{ 0 };
+        std::unique_ptr<Helper::LockFree::BoundedRing<SizeType>> m_mergeHints;
+        std::atomic<std::uint64_t> m_mergeHintsDeduped{ 0 };
+        std::atomic<std::uint64_t> m_mergeHintsScheduled{ 0 };
+        // Runs splits, merges and reassigns; declared after the job pools so that it is gone before them
+        std::shared_ptr<Helper::PriorityScheduler> m_scheduler;
+
+        // Postings over the size limit waiting for or in a split
+        std::atomic<SizeType> m_oversizedPostings{ 0 };
+        AdmissionController m_admission;
 
         IndexStats m_stat;
 
@@ -159,6 +221,8 @@ namespace SPTAG::SPANN {
 
         tbb::concurrent_hash_map<SizeType, SizeType> m_mergeList;
 
+        std::shared_ptr<HeadReplicas> m_headReplicas;
+
     public:
         ExtraDynamicSearcher(const char* dbPath, int dim, int postingBlockLimit, bool useDirectIO, float searchLatencyHardLimit, int mergeThreshold, bool useSPDK = false, int batchSize = 64, int bufferLength = 3) {
             if (useSPDK) {
@@ -172,12 +236,22 @@ namespace SPTAG::SPANN {
             }
             m_metaDataSize = sizeof(int) + sizeof(uint8_t);
             m_vectorInfoSize = dim * sizeof(ValueType) + m_metaDataSize;
+            m_storedVectorInfoSize = m_vectorInfoSize;
             m_hardLatencyLimit = std::chrono::microseconds((int)searchLatencyHardLimit * 1000);
             m_mergeThreshold = mergeThreshold;
             LOG(Helper::LogLevel::LL_Info, "Posting size limit: %d, search limit: %f, merge threshold: %d\n", m_postingSizeLimit, searchLatencyHardLimit, m_mergeThreshold);
         }
 
-        ~ExtraDynamicSearcher() {}
+        ~ExtraDynamicSearcher()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_maintenanceLock);
+                m_maintenanceStop = true;
+            }
+            m_maintenanceWake.notify_all();
+            if (m_mergeThread.joinable()) m_mergeThread.join();
+            if (m_gcThread.joinable()) m_gcThread.join();
+        }
 
         //headCandidates: search data structrue for "vid" vector
         //headID: the head vector that stands for vid
@@ -310,7 +384,7 @@ namespace SPTAG::SPANN {
                     topk *= 2;
                 }
                 if (queryResults[i].VID == newHeads[0] || queryResults[i].VID == newHeads[1]) continue;
-                db->Get(queryResults[i].VID, &postingList);
+                GetPosting(p_index, queryResults[i].VID, &postingList);
                 vectorNum += postingList.size() / m_vectorInfoSize;
                 int tempNum = QuantifyAssumptionBroken(queryResults[i].VID, postingList, SplitHead, newHeads, brokenID, i, queryResults[i].Dist / queryResults[1].Dist);
                 assumptionBrokenNum += tempNum;
@@ -348,7 +422,100 @@ namespace SPTAG::SPANN {
         inline void Serialize(char* ptr, SizeType VID, std::uint8_t version, const void* vector) {
             memcpy(ptr, &VID, sizeof(VID));
             memcpy(ptr + sizeof(VID), &version, sizeof(version));
-            memcpy(ptr + m_metaDataSize, vector, m_vectorInfoSize - m_metaDataSize);
+            memcpy(ptr + m_metaDataSize, vector, m_vectorInfoSize - m_metaDataSize - m_signCodeSize);
+        }
+
+        // Sign codes are relative to the head of the posting that stores the entry,
+        // so entries must be re-encoded whenever they move to another head.
+        inline void EncodeSignCodes(char* ptr, int num, const ValueType* head) {
+            if (m_signCodeSize == 0) return;
+            for (int j = 0; j < num; j++, ptr += m_vectorInfoSize) {
+                COMMON::SignCode::Encode((const ValueType*)(ptr + m_metaDataSize), head, m_opt->m_dim, (std::uint8_t*)(ptr + m_vectorInfoSize - m_signCodeSize));
+            }
+        }
+
+        // Postings are handled in the in-memory layout [vid][version][vector][sign code]. With residual
+        // quantization the stored layout replaces the vector by its residual code to the posting head.
+        void InitEntrySizes(int p_vectorDataSize)
+        {
+            m_signCodeSize = m_opt->m_enableSignCode ? COMMON::SignCode::CodeSize(m_opt->m_dim) : 0;
+            m_residualBits = m_opt->m_residualQuantizationBits;
+            if (m_residualBits != 0 && m_residualBits != 4 && m_residualBits != 8) {
+                LOG(Helper::LogLevel::LL_Error, "ResidualQuantizationBits must be 0, 4 or 8, got %d, storing raw vectors\n", m_residualBits);
+                m_residualBits = 0;
+            }
+            m_vectorInfoSize = p_vectorDataSize + m_metaDataSize + m_signCodeSize;
+            m_storedVectorInfoSize = m_vectorInfoSize;
+            if (m_residualBits > 0) m_storedVectorInfoSize = COMMON::ResidualCode::CodeSize(m_opt->m_dim, m_residualBits) + m_metaDataSize + m_signCodeSize;
+        }
+
+        void EncodePosting(const std::string& p_posting, const ValueType* p_head, std::string& p_stored)
+        {
+            int num = (int)(p_posting.size() / m_vectorInfoSize);
+            p_stored.resize((size_t)num * m_storedVectorInfoSize);
+            const char* src = p_posting.data();
+            char* dst = p_stored.data();
+            for (int j = 0; j < num; j++, src += m_vectorInfoSize, dst += m_storedVectorInfoSize) {
+                memcpy(dst, src, m_metaDataSize);
+                COMMON::ResidualCode::Encode((const ValueType*)(src + m_metaDataSize), p_head, m_opt->m_dim, m_residualBits, (std::uint8_t*)(dst + m_metaDataSize));
+                memcpy(dst + m_storedVectorInfoSize - m_signCodeSize, src + m_vectorInfoSize - m_signCodeSize, m_signCodeSize);
+            }
+        }
+
+        void DecodePosting(std::string& p_posting, const ValueType* p_head)
+        {
+            if (m_residualBits == 0) return;
+            int num = (int)(p_posting.size() / m_storedVectorInfoSize);
+            std::string decoded((size_t)num * m_vectorInfoSize, '\0');
+            const char* src = p_posting.data();
+            char* dst = decoded.data();
+            for (int j = 0; j < num; j++, src += m_storedVectorInfoSize, dst += m_vectorInfoSize) {
+                memcpy(dst, src, m_metaDataSize);
+                COMMON::ResidualCode::Decode((const std::uint8_t*)(src + m_metaDataSize), p_head, m_opt->m_dim, m_residualBits, (ValueType*)(dst + m_metaDataSize));
+                memcpy(dst + m_vectorInfoSize - m_signCodeSize, src + m_storedVectorInfoSize - m_signCodeSize, m_signCodeSize);
+            }
+            p_posting.swap(decoded);
+        }
+
+        ErrorCode AddHead(VectorIndex* p_index, const ValueType* p_center, int& p_begin, int& p_end)
+        {
+            if (m_headReplicas && m_headReplicas->Mirrors(p_index)) return m_headReplicas->AddHead(p_center, m_opt->m_dim, p_begin, p_end);
+            return p_index->AddIndexId(p_center, 1, m_opt->m_dim, p_begin, p_end);
+        }
+
+        ErrorCode LinkHeads(VectorIndex* p_index, SizeType p_begin, SizeType p_end)
+        {
+            if (m_headReplicas && m_headReplicas->Mirrors(p_index)) return m_headReplicas->LinkHeads(p_begin, p_end);
+            return p_index->AddIndexIdx(p_begin, p_end);
+        }
+
+        ErrorCode DeleteHead(VectorIndex* p_index, SizeType p_headID)
+        {
+            if (m_headReplicas && m_headReplicas->Mirrors(p_index)) return m_headReplicas->DeleteHead(p_headID);
+            return p_index->DeleteIndex(p_headID);
+        }
+
+        ErrorCode GetPosting(VectorIndex* p_index, SizeType p_headID, std::string* p_posting)
+        {
+            ErrorCode ret = db->Get(p_headID, p_posting);
+            if (ret == ErrorCode::Success) DecodePosting(*p_posting, (const ValueType*)p_index->GetSample(p_headID));
+            return ret;
+        }
+
+        ErrorCode PutPosting(VectorIndex* p_index, SizeType p_headID, const std::string& p_posting)
+        {
+            if (m_residualBits == 0) return db->Put(p_headID, p_posting);
+            std::string stored;
+            EncodePosting(p_posting, (const ValueType*)p_index->GetSample(p_headID), stored);
+            return db->Put(p_headID, stored);
+        }
+
+        ErrorCode AppendPosting(VectorIndex* p_index, SizeType p_headID, const std::string& p_posting)
+        {
+            if (m_residualBits == 0) return db->Merge(p_headID, p_posting);
+            std::string stored;
+            EncodePosting(p_posting, (const ValueType*)p_index->GetSample(p_headID), stored);
+            return db->Merge(p_headID, stored);
         }
 
         void CalculatePostingDistribution(VectorIndex* p_index)
@@ -454,9 +621,14 @@ namespace SPTAG::SPANN {
                 // p_index->SaveIndex(m_opt->m_indexDirectory + FolderSep + m_opt->m_headIndexFolder);
                 LOG(Helper::LogLevel::LL_Info, "SPFresh: ReWriting SSD Info\n");
                 m_postingSizes.Save(m_opt->m_ssdInfoFile);
+                m_postingSizes.SaveRadius(PostingRadiusFile());
             }
         }
 
+        // Splits an oversized posting in two. The posting lock is held to read the posting, and to write it
+        // back when dropping stale entries is enough; otherwise 2-means is trained on a sample of the posting
+        // without the lock, and the lock is taken again to assign the current entries, including the ones
+        // appended meanwhile, to the two centers and swap in the new postings.
         ErrorCode Split(VectorIndex* p_index, const SizeType headID, bool reassign = false, bool preReassign = false)
         {
             auto splitBegin = std::chrono::high_resolution_clock::now();
@@ -464,12 +636,25 @@ namespace SPTAG::SPANN {
             std::vector<SizeType> newHeadsID;
             std::vector<std::string> newPostingLists;
             double elapsedMSeconds;
+            double lockMicroseconds = 0;
+            auto finish = [&]() {
+                {
+                    std::lock_guard<std::mutex> tmplock(m_runningLock);
+                    // LOG(Helper::LogLevel::LL_Info,"erase: %d\n", headID);
+                    if (m_splitList.erase(headID) > 0) m_oversizedPostings--;
+                }
+                m_stat.m_splitLockLatency.Record(lockMicroseconds);
+                m_stat.m_splitLatency.Record((double)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - splitBegin).count());
+            };
+
+            std::string postingList;
+            std::vector<const ValueType*> liveVectors;
             {
                 std::unique_lock<std::shared_timed_mutex> lock(m_rwLocks[headID]);
+                auto lockBegin = std::chrono::high_resolution_clock::now();
 
-                std::string postingList;
                 auto splitGetBegin = std::chrono::high_resolution_clock::now();
-                if (db->Get(headID, &postingList) != ErrorCode::Success) {
+                if (GetPosting(p_index, headID, &postingList) != ErrorCode::Success) {
                     LOG(Helper::LogLevel::LL_Info, "Split fail to get oversized postings\n");
                     exit(0);
                 }
@@ -479,11 +664,7 @@ namespace SPTAG::SPANN {
                 // reinterpret postingList to vectors and IDs
                 auto* postingP = reinterpret_cast<uint8_t*>(&postingList.front());
                 SizeType postVectorNum = (SizeType)(postingList.size() / m_vectorInfoSize);
-               
-                COMMON::Dataset<ValueType> smallSample(postVectorNum, m_opt->m_dim, p_index->m_iDataBlockSize, p_index->m_iDataCapacity, (const void*)postingP, true, nullptr, m_metaDataSize, m_vectorInfoSize);
-                //COMMON::Dataset<ValueType> smallSample(0, m_opt->m_dim, p_index->m_iDataBlockSize, p_index->m_iDataCapacity);  // smallSample[i] -> VID
-                //std::vector<int> localIndicesInsert(postVectorNum);  // smallSample[i] = j <-> localindices[j] = i
-                //std::vector<uint8_t> localIndicesInsertVersion(postVectorNum);
+
                 std::vector<int> localIndices(postVectorNum);
                 int index = 0;
                 uint8_t* vectorId = postingP;
@@ -494,9 +675,6 @@ namespace SPTAG::SPANN {
                     int VID = *((int*)(vectorId));
                     if (m_versionMap->Deleted(VID) || m_versionMap->GetVersion(VID) != version) continue;
 
-                    //localIndicesInsert[index] = VID;
-                    //localIndicesInsertVersion[index] = version;
-                    //smallSample.AddBatch(1, (ValueType*)(vectorId + m_metaDataSize));
                     localIndices[index] = j;
                     index++;
                 }
@@ -509,11 +687,11 @@ namespace SPTAG::SPANN {
                     {
                         if (j == localIndices[j]) continue;
                         memcpy(ptr, postingList.c_str() + localIndices[j] * m_vectorInfoSize, m_vectorInfoSize);
-                        //Serialize(ptr, localIndicesInsert[j], localIndicesInsertVersion[j], smallSample[j]);
                     }
                     postingList.resize(index * m_vectorInfoSize);
                     m_postingSizes.UpdateSize(headID, index);
-                    if (db->Put(headID, postingList) != ErrorCode::Success) {
+                    MarkClean(headID);
+                    if (PutPosting(p_index, headID, postingList) != ErrorCode::Success) {
                         LOG(Helper::LogLevel::LL_Info, "Split Fail to write back postings\n");
                         exit(0);
                     }
@@ -521,71 +699,93 @@ namespace SPTAG::SPANN {
                     auto GCEnd = std::chrono::high_resolution_clock::now();
                     elapsedMSeconds = std::chrono::duration_cast<std::chrono::microseconds>(GCEnd - splitBegin).count();
                     m_stat.m_garbageCost += elapsedMSeconds;
-                    {
-                        std::lock_guard<std::mutex> tmplock(m_runningLock);
-                        // LOG(Helper::LogLevel::LL_Info,"erase: %d\n", headID);
-                        m_splitList.erase(headID);
-                    }
+                    lockMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(GCEnd - lockBegin).count();
+                    finish();
                     // LOG(Helper::LogLevel::LL_Info, "GC triggered: %d, new length: %d\n", headID, index);
                     return ErrorCode::Success;
                 }
-                //LOG(Helper::LogLevel::LL_Info, "Resize\n");
-                localIndices.resize(index);
 
-                auto clusterBegin = std::chrono::high_resolution_clock::now();
-                // k = 2, maybe we can change the split number, now it is fixed
-                SPTAG::COMMON::KmeansArgs<ValueType> args(2, smallSample.C(), (SizeType)localIndices.size(), 1, p_index->GetDistCalcMethod());
-                std::shuffle(localIndices.begin(), localIndices.end(), std::mt19937(std::random_device()()));
+                // The captured posting outlives the lock, the sample points into it
+                liveVectors.resize(index);
+                for (int j = 0; j < index; j++) liveVectors[j] = (const ValueType*)(postingP + (size_t)localIndices[j] * m_vectorInfoSize + m_metaDataSize);
+                lockMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - lockBegin).count();
+            }
 
-                int numClusters = SPTAG::COMMON::KmeansClustering(smallSample, localIndices, 0, (SizeType)localIndices.size(), args, 1000, 100.0F, false, nullptr, m_opt->m_virtualHead);
+            auto clusterBegin = std::chrono::high_resolution_clock::now();
+            // k = 2, maybe we can change the split number, now it is fixed
+            static thread_local std::mt19937 rng(std::random_device{}());
+            COMMON::TwoMeans<ValueType> twoMeans(m_opt->m_dim, p_index->GetDistCalcMethod());
+            int numClusters = twoMeans.Train(liveVectors, m_opt->m_splitSampleSize, m_opt->m_splitIterations, m_opt->m_virtualHead, rng);
+            auto clusterEnd = std::chrono::high_resolution_clock::now();
+            elapsedMSeconds = std::chrono::duration_cast<std::chrono::microseconds>(clusterEnd - clusterBegin).count();
+            m_stat.m_clusteringCost += elapsedMSeconds;
+
+            {
+                std::unique_lock<std::shared_timed_mutex> lock(m_rwLocks[headID]);
+                auto lockBegin = std::chrono::high_resolution_clock::now();
+
+                // Merged into a neighbor while the centers were trained
+                if (!p_index->ContainSample(headID)) {
+                    lockMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - lockBegin).count();
+                    finish();
+                    return ErrorCode::Success;
+                }
+                if (GetPosting(p_index, headID, &postingList) != ErrorCode::Success) {
+                    LOG(Helper::LogLevel::LL_Info, "Split fail to get oversized postings\n");
+                    exit(0);
+                }
+                auto* postingP = reinterpret_cast<uint8_t*>(&postingList.front());
+                SizeType postVectorNum = (SizeType)(postingList.size() / m_vectorInfoSize);
+
+                // Stale entries are left out; when clustering failed all live entries stay in this posting
+                std::vector<const ValueType*> entries(postVectorNum, nullptr);
+                uint8_t* vectorId = postingP;
+                for (int j = 0; j < postVectorNum; j++, vectorId += m_vectorInfoSize)
+                {
+                    uint8_t version = *(vectorId + sizeof(int));
+                    int VID = *((int*)(vectorId));
+                    if (m_versionMap->Deleted(VID) || m_versionMap->GetVersion(VID) != version) continue;
+                    entries[j] = (const ValueType*)(vectorId + m_metaDataSize);
+                }
+                std::vector<uint8_t> labels;
+                SizeType counts[2];
+                twoMeans.Label(entries, numClusters, labels, counts);
+                newPostingLists.resize(2);
+                for (int k = 0; k < 2; k++) newPostingLists[k].resize((size_t)counts[k] * m_vectorInfoSize);
+                char* ptrs[2] = { (char*)(newPostingLists[0].c_str()), (char*)(newPostingLists[1].c_str()) };
+                for (int j = 0; j < postVectorNum; j++)
+                {
+                    if (labels[j] == 2) continue;
+                    memcpy(ptrs[labels[j]], postingList.c_str() + (size_t)j * m_vectorInfoSize, m_vectorInfoSize);
+                    ptrs[labels[j]] += m_vectorInfoSize;
+                }
 
-                auto clusterEnd = std::chrono::high_resolution_clock::now();
-                elapsedMSeconds = std::chrono::duration_cast<std::chrono::microseconds>(clusterEnd - clusterBegin).count();
-                m_stat.m_clusteringCost += elapsedMSeconds;
-                // int numClusters = ClusteringSPFresh(smallSample, localIndices, 0, localIndices.size(), args, 10, false, m_opt->m_virtualHead);
-                // exit(0);
                 if (numClusters <= 1)
                 {
-                    LOG(Helper::LogLevel::LL_Info, "Cluserting Failed (The same vector), Only Keep one\n");
-                    std::string newpostingList(1 * m_vectorInfoSize, '\0');
-                    char* ptr = (char*)(newpostingList.c_str());
-                    for (int j = 0; j < 1; j++, ptr += m_vectorInfoSize)
-                    {
-                        memcpy(ptr, postingList.c_str() + localIndices[j] * m_vectorInfoSize, m_vectorInfoSize);
-                        //Serialize(ptr, localIndicesInsert[j], localIndicesInsertVersion[j], smallSample[j]);
-                    }
-                    m_postingSizes.UpdateSize(headID, 1);
-                    if (db->Put(headID, newpostingList) != ErrorCode::Success) {
+                    LOG(Helper::LogLevel::LL_Info, "Clustering failed on posting %d, keeping its %d live entries without duplicates of the center\n", headID, counts[0]);
+                    m_postingSizes.UpdateSize(headID, counts[0]);
+                    MarkClean(headID);
+                    if (PutPosting(p_index, headID, newPostingLists[0]) != ErrorCode::Success) {
                         LOG(Helper::LogLevel::LL_Info, "Split fail to override postings cut to limit\n");
                         exit(0);
                     }
-                    {
-                        std::lock_guard<std::mutex> tmplock(m_runningLock);
-                        m_splitList.erase(headID);
-                    }
+                    lockMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - lockBegin).count();
+                    finish();
                     return ErrorCode::Success;
                 }
 
                 long long newHeadVID = -1;
-                int first = 0;
                 bool theSameHead = false;
-                newPostingLists.resize(2);
                 for (int k = 0; k < 2; k++) {
-                    if (args.counts[k] == 0)	continue;
-                    
-                    newPostingLists[k].resize(args.counts[k] * m_vectorInfoSize);
-                    char* ptr = (char*)(newPostingLists[k].c_str());
-                    for (int j = 0; j < args.counts[k]; j++, ptr += m_vectorInfoSize)
-                    {
-                        memcpy(ptr, postingList.c_str() + localIndices[first + j] * m_vectorInfoSize, m_vectorInfoSize);
-                        //Serialize(ptr, localIndicesInsert[localIndices[first + j]], localIndicesInsertVersion[localIndices[first + j]], smallSample[localIndices[first + j]]);
-                    }
-                    if (!theSameHead && p_index->ComputeDistance(args.centers + k * args._D, p_index->GetSample(headID)) < Epsilon) {
+                    if (counts[k] == 0)	continue;
+
+                    EncodeSignCodes((char*)(newPostingLists[k].c_str()), counts[k], twoMeans.Center(k));
+                    if (!theSameHead && p_index->ComputeDistance(twoMeans.Center(k), p_index->GetSample(headID)) < Epsilon) {
                         newHeadsID.push_back(headID);
                         newHeadVID = headID;
                         theSameHead = true;
                         auto splitPutBegin = std::chrono::high_resolution_clock::now();
-                        if (!preReassign && db->Put(newHeadVID, newPostingLists[k]) != ErrorCode::Success) {
+                        if (!preReassign && PutPosting(p_index, newHeadVID, newPostingLists[k]) != ErrorCode::Success) {
                             LOG(Helper::LogLevel::LL_Info, "Fail to override postings\n");
                             exit(0);
                         }
@@ -596,11 +796,11 @@ namespace SPTAG::SPANN {
                     }
                     else {
                         int begin, end = 0;
-                        p_index->AddIndexId(args.centers + k * args._D, 1, m_opt->m_dim, begin, end);
+                        AddHead(p_index, twoMeans.Center(k), begin, end);
                         newHeadVID = begin;
                         newHeadsID.push_back(begin);
                         auto splitPutBegin = std::chrono::high_resolution_clock::now();
-                        if (!preReassign && db->Put(newHeadVID, newPostingLists[k]) != ErrorCode::Success) {
+                        if (!preReassign && PutPosting(p_index, newHeadVID, newPostingLists[k]) != ErrorCode::Success) {
                             LOG(Helper::LogLevel::LL_Info, "Fail to add new postings\n");
                             exit(0);
                         }
@@ -608,7 +808,7 @@ namespace SPTAG::SPANN {
                         elapsedMSeconds = std::chrono::duration_cast<std::chrono::microseconds>(splitPutEnd - splitPutBegin).count();
                         m_stat.m_putCost += elapsedMSeconds;
                         auto updateHeadBegin = std::chrono::high_resolution_clock::now();
-                        p_index->AddIndexIdx(begin, end);
+                        LinkHeads(p_index, begin, end);
                         auto updateHeadEnd = std::chrono::high_resolution_clock::now();
                         elapsedMSeconds = std::chrono::duration_cast<std::chrono::milliseconds>(updateHeadEnd - updateHeadBegin).count();
                         m_stat.m_updateHeadCost += elapsedMSeconds;
@@ -619,20 +819,18 @@ namespace SPTAG::SPANN {
                             exit(1);
                         }
                     }
-                    // LOG(Helper::LogLevel::LL_Info, "Head id: %d split into : %d, length: %d\n", headID, newHeadVID, args.counts[k]);
-                    first += args.counts[k];
-                    m_postingSizes.UpdateSize(newHeadVID, args.counts[k]);
+                    // LOG(Helper::LogLevel::LL_Info, "Head id: %d split into : %d, length: %d\n", headID, newHeadVID, counts[k]);
+                    m_postingSizes.UpdateSize(newHeadVID, counts[k]);
+                    MarkClean(newHeadVID);
+                    m_postingSizes.UpdateRadius(newHeadVID, PostingRadius(p_index, newHeadVID, newPostingLists[k]));
                 }
                 if (!theSameHead) {
-                    p_index->DeleteIndex(headID);
+                    DeleteHead(p_index, headID);
                     m_postingSizes.UpdateSize(headID, 0);
                 }
+                lockMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - lockBegin).count();
             }
-            {
-                std::lock_guard<std::mutex> tmplock(m_runningLock);
-                // LOG(Helper::LogLevel::LL_Info,"erase: %d\n", headID);
-                m_splitList.erase(headID);
-            }
+            finish();
             m_stat.m_splitNum++;
             if (reassign) {
                 auto reassignScanBegin = std::chrono::high_resolution_clock::now();
@@ -654,8 +852,9 @@ namespace SPTAG::SPANN {
         {
             {
                 if (!m_mergeLock.try_lock()) {
-                    auto* curJob = new MergeAsyncJob(p_index, this, headID, reassign, nullptr);
-                    m_splitThreadPool->add(curJob);
+                    auto* curJob = m_mergeJobs.Get();
+                    curJob->Set(p_index, this, headID, reassign, nullptr);
+                    m_scheduler->add(curJob, MergePriority);
                     return ErrorCode::Success;
                 }
                 std::unique_lock<std::shared_timed_mutex> lock(m_rwLocks[headID]);
@@ -669,7 +868,7 @@ namespace SPTAG::SPANN {
                 std::set<SizeType> vectorIdSet;
 
                 std::string currentPostingList;
-                if (db->Get(headID, &currentPostingList) != ErrorCode::Success) {
+                if (GetPosting(p_index, headID, &currentPostingList) != ErrorCode::Success) {
                     LOG(Helper::LogLevel::LL_Info, "Fail to get to be merged postings: %d\n", headID);
                     exit(0);
                 }
@@ -692,7 +891,8 @@ namespace SPTAG::SPANN {
                 if (currentLength > m_mergeThreshold)
                 {
                     m_postingSizes.UpdateSize(headID, currentLength);
-                    if (db->Put(headID, mergedPostingList) != ErrorCode::Success) {
+                    MarkClean(headID);
+                    if (PutPosting(p_index, headID, mergedPostingList) != ErrorCode::Success) {
                         LOG(Helper::LogLevel::LL_Info, "Merge Fail to write back postings\n");
                         exit(0);
                     }
@@ -718,7 +918,7 @@ namespace SPTAG::SPANN {
                             // LOG(Helper::LogLevel::LL_Info,"Locked: %d, to be lock: %d\n", headID, queryResult->VID);
                             if (m_rwLocks.hash_func(queryResult->VID) != m_rwLocks.hash_func(headID)) anotherLock.lock();
                             if (!p_index->ContainSample(queryResult->VID)) continue;
-                            if (db->Get(queryResult->VID, &nextPostingList) != ErrorCode::Success) {
+                            if (GetPosting(p_index, queryResult->VID, &nextPostingList) != ErrorCode::Success) {
                                 LOG(Helper::LogLevel::LL_Info, "Fail to get to be merged postings: %d\n", queryResult->VID);
                                 exit(0);
                             }
@@ -740,22 +940,28 @@ namespace SPTAG::SPANN {
                             }
                             if (currentLength > nextLength) 
                             {
-                                p_index->DeleteIndex(queryResult->VID);
-                                if (db->Put(headID, mergedPostingList) != ErrorCode::Success) {
+                                DeleteHead(p_index, queryResult->VID);
+                                EncodeSignCodes((char*)(mergedPostingList.c_str()), totalLength, (const ValueType*)p_index->GetSample(headID));
+                                if (PutPosting(p_index, headID, mergedPostingList) != ErrorCode::Success) {
                                     LOG(Helper::LogLevel::LL_Info, "Split fail to override postings after merge\n");
                                     exit(0);
                                 }
                                 m_postingSizes.UpdateSize(queryResult->VID, 0);
                                 m_postingSizes.UpdateSize(headID, totalLength);
+                                MarkClean(headID);
+                                m_postingSizes.UpdateRadius(headID, PostingRadius(p_index, headID, mergedPostingList));
                             } else
                             {
-                                p_index->DeleteIndex(headID);
-                                if (db->Put(queryResult->VID, mergedPostingList) != ErrorCode::Success) {
+                                DeleteHead(p_index, headID);
+                                EncodeSignCodes((char*)(mergedPostingList.c_str()), totalLength, (const ValueType*)p_index->GetSample(queryResult->VID));
+                                if (PutPosting(p_index, queryResult->VID, mergedPostingList) != ErrorCode::Success) {
                                     LOG(Helper::LogLevel::LL_Info, "Split fail to override postings after merge\n");
                                     exit(0);
                                 }
                                 m_postingSizes.UpdateSize(queryResult->VID, totalLength);
+                                MarkClean(queryResult->VID);
                                 m_postingSizes.UpdateSize(headID, 0);
+                                m_postingSizes.UpdateRadius(queryResult->VID, PostingRadius(p_index, queryResult->VID, mergedPostingList));
                             }
                             if (m_rwLocks.hash_func(queryResult->VID) != m_rwLocks.hash_func(headID)) anotherLock.unlock();
                         }
@@ -803,7 +1009,8 @@ namespace SPTAG::SPANN {
                     }
                 }
                 m_postingSizes.UpdateSize(headID, currentLength);
-                if (db->Put(headID, mergedPostingList) != ErrorCode::Success) {
+                MarkClean(headID);
+                if (PutPosting(p_index, headID, mergedPostingList) != ErrorCode::Success) {
                     LOG(Helper::LogLevel::LL_Info, "Merge Fail to write back postings\n");
                     exit(0);
                 }
@@ -830,10 +1037,12 @@ namespace SPTAG::SPANN {
                     return;
                 }
                 m_splitList.insert(headID);
+                m_oversizedPostings++;
             }
 
-            auto* curJob = new SplitAsyncJob(p_index, this, headID, m_opt->m_disableReassign, p_callback);
-            m_splitThreadPool->add(curJob);
+            auto* curJob = m_splitJobs.Get();
+            curJob->Set(p_index, this, headID, m_opt->m_disableReassign, p_callback);
+            m_scheduler->add(curJob, SplitPriority);
             // LOG(Helper::LogLevel::LL_Info, "Add to thread pool\n");
         }
 
@@ -847,20 +1056,34 @@ namespace SPTAG::SPANN {
             tbb::concurrent_hash_map<SizeType, SizeType>::value_type workPair(headID, headID);
             m_mergeList.insert(workPair);
 
-            auto* curJob = new MergeAsyncJob(p_index, this, headID, m_opt->m_disableReassign, p_callback);
-            m_splitThreadPool->add(curJob);
+            auto* curJob = m_mergeJobs.Get();
+            curJob->Set(p_index, this, headID, m_opt->m_disableReassign, p_callback);
+            m_scheduler->add(curJob, MergePriority);
         }
 
         inline void ReassignAsync(VectorIndex* p_index, std::shared_ptr<std::string> vectorInfo, SizeType HeadPrev, std::function<void()> p_callback = nullptr)
         {
-            auto* curJob = new ReassignAsyncJob(p_index, this, std::move(vectorInfo), HeadPrev, p_callback);
-            m_splitThreadPool->add(curJob);
+            auto* curJob = m_reassignJobs.Get();
+            curJob->Set(p_index, this, std::move(vectorInfo), HeadPrev, p_callback);
+            m_scheduler->add(curJob, ReassignPriority);
         }
 
         ErrorCode CollectReAssign(VectorIndex* p_index, SizeType headID, std::vector<std::string>& postingLists, std::vector<SizeType>& newHeadsID) {
             auto headVector = reinterpret_cast<const ValueType*>(p_index->GetSample(headID));
             std::vector<float> newHeadsDist;
             std::set<SizeType> reAssignVectorsTopK;
+            ReassignBatchJob* batch = nullptr;
+            auto reassign = [&](const char* p_entry, SizeType p_headPrev) {
+                if (batch == nullptr) {
+                    batch = m_reassignBatchJobs.Get();
+                    batch->Set(p_index, this);
+                }
+                batch->Add(p_entry, m_vectorInfoSize, p_headPrev);
+                if (batch->Size() >= (size_t)(std::max)(1, m_opt->m_reassignBatchSize)) {
+                    m_scheduler->add(batch, ReassignPriority);
+                    batch = nullptr;
+                }
+            };
             newHeadsDist.push_back(p_index->ComputeDistance(p_index->GetSample(headID), p_index->GetSample(newHeadsID[0])));
             newHeadsDist.push_back(p_index->ComputeDistance(p_index->GetSample(headID), p_index->GetSample(newHeadsID[1])));
             for (int i = 0; i < postingLists.size(); i++) {
@@ -877,7 +1100,7 @@ namespace SPTAG::SPANN {
                         m_stat.m_reAssignScanNum++;
                         float dist = p_index->ComputeDistance(p_index->GetSample(newHeadsID[i]), vector);
                         if (CheckIsNeedReassign(p_index, newHeadsID, vector, headID, newHeadsDist[i], dist, true, newHeadsID[i])) {
-                            ReassignAsync(p_index, std::make_shared<std::string>((char*)vectorId, m_vectorInfoSize), newHeadsID[i]);
+                            reassign((const char*)vectorId, newHeadsID[i]);
                             reAssignVectorsTopK.insert(vid);
                         }
                     }
@@ -907,6 +1130,7 @@ namespace SPTAG::SPANN {
                     LOG(Helper::LogLevel::LL_Info, "ReAssign can't get all the near postings\n");
                     exit(0);
                 }
+                for (int i = 0; i < postingLists.size(); i++) DecodePosting(postingLists[i], (const ValueType*)p_index->GetSample(HeadPrevTopK[i]));
                 auto reassignScanIOEnd = std::chrono::high_resolution_clock::now();
                 auto elapsedMSeconds = std::chrono::duration_cast<std::chrono::microseconds>(reassignScanIOEnd - reassignScanIOBegin).count();
                 m_stat.m_reassignScanIOCost += elapsedMSeconds;
@@ -925,18 +1149,21 @@ namespace SPTAG::SPANN {
                             m_stat.m_reAssignScanNum++;
                             float dist = p_index->ComputeDistance(p_index->GetSample(HeadPrevTopK[i]), vector);
                             if (CheckIsNeedReassign(p_index, newHeadsID, vector, headID, newHeadsDist[i], dist, false, HeadPrevTopK[i])) {
-                                ReassignAsync(p_index, std::make_shared<std::string>((char*)vectorId, m_vectorInfoSize), HeadPrevTopK[i]);
+                                reassign((const char*)vectorId, HeadPrevTopK[i]);
                                 reAssignVectorsTopK.insert(vid);
                             }
                         }
                     }
                 }
             }
+            if (batch != nullptr) m_scheduler->add(batch, ReassignPriority);
             // exit(1);
             return ErrorCode::Success;
         }
 
-        bool RNGSelection(std::vector<Edge>& selections, ValueType* queryVector, VectorIndex* p_index, SizeType p_fullID, int& replicaCount, int checkHeadID = -1)
+        // p_headDistances, when given, keeps the head to head distances of the RNG checks for the next call
+        bool RNGSelection(std::vector<Edge>& selections, ValueType* queryVector, VectorIndex* p_index, SizeType p_fullID, int& replicaCount, int checkHeadID = -1,
+            std::unordered_map<std::uint64_t, float>* p_headDistances = nullptr)
         {
             QueryResult queryResults(queryVector, m_opt->m_internalResultNum, false);
             p_index->SearchIndex(queryResults);
@@ -952,8 +1179,20 @@ namespace SPTAG::SPANN {
                 bool rngAccpeted = true;
                 for (int j = 0; j < replicaCount; ++j)
                 {
-                    float nnDist = p_index->ComputeDistance(p_index->GetSample(queryResult->VID),
-                        p_index->GetSample(selections[j].node));
+                    float nnDist;
+                    if (p_headDistances != nullptr) {
+                        SizeType a = (std::min)(queryResult->VID, selections[j].node), b = (std::max)(queryResult->VID, selections[j].node);
+                        auto it = p_headDistances->find(((std::uint64_t)(std::uint32_t)a << 32) | (std::uint32_t)b);
+                        if (it != p_headDistances->end()) nnDist = it->second;
+                        else {
+                            nnDist = p_index->ComputeDistance(p_index->GetSample(a), p_index->GetSample(b));
+                            p_headDistances->emplace(((std::uint64_t)(std::uint32_t)a << 32) | (std::uint32_t)b, nnDist);
+                        }
+                    }
+                    else {
+                        nnDist = p_index->ComputeDistance(p_index->GetSample(queryResult->VID),
+                            p_index->GetSample(selections[j].node));
+                    }
                     if (m_opt->m_rngFactor * nnDist <= queryResult->Dist)
                     {
                         rngAccpeted = false;
@@ -1007,8 +1246,10 @@ namespace SPTAG::SPANN {
                 if (!p_index->ContainSample(headID)) {
                     goto checkDeleted;
                 }
+                EncodeSignCodes(&appendPosting.front(), appendNum, (const ValueType*)p_index->GetSample(headID));
+                m_postingSizes.ExtendRadius(headID, PostingRadius(p_index, headID, appendPosting));
                 auto appendIOBegin = std::chrono::high_resolution_clock::now();
-                if (db->Merge(headID, appendPosting) != ErrorCode::Success) {
+                if (AppendPosting(p_index, headID, appendPosting) != ErrorCode::Success) {
                     LOG(Helper::LogLevel::LL_Error, "Merge failed! Posting Size:%d, limit: %d\n", m_postingSizes.GetSize(headID), m_postingSizeLimit);
                     GetDBStats();
                     exit(1);
@@ -1088,24 +1329,87 @@ namespace SPTAG::SPANN {
             m_stat.m_reAssignCost += elapsedMSeconds;
         }
 
+        // Reassigns a batch of entries collected by one split. The RNG checks of the batch share their head to
+        // head distances, and the moved entries are appended with one Append per destination head. As in
+        // Reassign, an entry moves only if its version has not changed since it was collected, and a copy is
+        // appended only while the version it got stays current.
+        void ReassignBatch(VectorIndex* p_index, std::string& p_entries, const std::vector<SizeType>& p_headPrevs)
+        {
+            auto reassignBegin = std::chrono::high_resolution_clock::now();
+            std::unordered_map<std::uint64_t, float> headDistances;
+            std::vector<std::pair<SizeType, SizeType>> targets;
+            std::vector<Edge> selections(static_cast<size_t>(m_opt->m_replicaCount));
+            double selectCost = 0;
+            for (SizeType e = 0; e < (SizeType)p_headPrevs.size(); e++) {
+                char* entry = &p_entries[static_cast<size_t>(e) * m_vectorInfoSize];
+                SizeType VID = *((SizeType*)entry);
+                uint8_t version = *((uint8_t*)(entry + sizeof(VID)));
+                if (m_versionMap->Deleted(VID) || m_versionMap->GetVersion(VID) != version) continue;
+
+                m_stat.m_reAssignNum++;
+                auto selectBegin = std::chrono::high_resolution_clock::now();
+                int replicaCount;
+                bool isNeedReassign = RNGSelection(selections, (ValueType*)(entry + m_metaDataSize), p_index, VID, replicaCount, p_headPrevs[e], &headDistances);
+                selectCost += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - selectBegin).count();
+
+                if (!isNeedReassign || m_versionMap->GetVersion(VID) != version) continue;
+                if (!m_versionMap->IncVersion(VID, &version)) continue;
+                entry[sizeof(VID)] = version;
+                for (int i = 0; i < replicaCount; i++) targets.emplace_back(selections[i].node, e);
+            }
+            m_stat.m_selectCost += selectCost;
+
+            auto reassignAppendBegin = std::chrono::high_resolution_clock::now();
+            std::sort(targets.begin(), targets.end());
+            std::string appendPosting;
+            for (size_t first = 0, last; first < targets.size(); first = last) {
+                SizeType headID = targets[first].first;
+                for (last = first; last < targets.size() && targets[last].first == headID; last++);
+
+                appendPosting.clear();
+                int appendNum = 0;
+                for (size_t j = first; j < last; j++) {
+                    const char* entry = p_entries.c_str() + static_cast<size_t>(targets[j].second) * m_vectorInfoSize;
+                    if (m_versionMap->GetVersion(*((SizeType*)entry)) != *((uint8_t*)(entry + sizeof(SizeType)))) continue;
+                    appendPosting.append(entry, m_vectorInfoSize);
+                    appendNum++;
+                }
+                // A missing head hands its entries to ReassignAsync, which bumps their versions again
+                if (appendNum > 0) Append(p_index, headID, appendNum, appendPosting, 3);
+            }
+            auto reassignEnd = std::chrono::high_resolution_clock::now();
+            m_stat.m_reAssignAppendCost += std::chrono::duration_cast<std::chrono::microseconds>(reassignEnd - reassignAppendBegin).count();
+            m_stat.m_reAssignCost += std::chrono::duration_cast<std::chrono::microseconds>(reassignEnd - reassignBegin).count();
+        }
+
         bool LoadIndex(Options& p_opt, COMMON::VersionLabel& p_versionMap) override {
             m_versionMap = &p_versionMap;
             m_opt = &p_opt;
             LOG(Helper::LogLevel::LL_Info, "DataBlockSize: %d, Capacity: %d\n", m_opt->m_datasetRowsInBlock, m_opt->m_datasetCapacity);
 
+            InitEntrySizes(m_opt->m_dim * sizeof(ValueType));
+            if (m_signCodeSize > 0 || m_residualBits > 0) {
+                if (m_opt->m_useSPDK) m_postingSizeLimit = m_opt->m_postingPageLimit * PageSize / m_storedVectorInfoSize;
+                LOG(Helper::LogLevel::LL_Info, "Posting entry: %d bytes stored, %d in memory (sign code: %d bytes, residual bits: %d), posting size limit: %d\n", m_storedVectorInfoSize, m_vectorInfoSize, m_signCodeSize, m_residualBits, m_postingSizeLimit);
+            }
+
             if (!m_opt->m_useSPDK) {
                 m_versionMap->Load(m_opt->m_deleteIDFile, m_opt->m_datasetRowsInBlock, m_opt->m_datasetCapacity);
                 m_postingSizes.Load(m_opt->m_ssdInfoFile, m_opt->m_datasetRowsInBlock, m_opt->m_datasetCapacity);
+                if (fileexists(PostingRadiusFile().c_str())) m_postingSizes.LoadRadius(PostingRadiusFile(), m_opt->m_datasetRowsInBlock, m_opt->m_datasetCapacity);
                 LOG(Helper::LogLevel::LL_Info, "Current vector num: %d.\n", m_versionMap->GetVectorNum());
                 LOG(Helper::LogLevel::LL_Info, "Current posting num: %d.\n", m_postingSizes.GetPostingNum());
             }
 
             if (m_opt->m_update) {
-                LOG(Helper::LogLevel::LL_Info, "SPFresh: initialize thread pools, append: %d, reassign %d\n", m_opt->m_appendThreadNum, m_opt->m_reassignThreadNum);
-                m_splitThreadPool = std::make_shared<SPDKThreadPool>();
-                m_splitThreadPool->initSPDK(m_opt->m_appendThreadNum, this);
-                m_reassignThreadPool = std::make_shared<SPDKThreadPool>();
-                m_reassignThreadPool->initSPDK(m_opt->m_reassignThreadNum, this);
+                LOG(Helper::LogLevel::LL_Info, "SPFresh: initialize scheduler, append: %d, reassign %d\n", m_opt->m_appendThreadNum, m_opt->m_reassignThreadNum);
+                // One set of workers for all background jobs, as many as the former split and reassign pools had
+                m_scheduler = std::make_shared<Helper::PriorityScheduler>();
+                m_scheduler->init(m_opt->m_appendThreadNum + m_opt->m_reassignThreadNum, PriorityLevels,
+                    [this]() { Initialize(); }, [this]() { ExitBlockController(); });
+                m_mergeHints.reset(new Helper::LockFree::BoundedRing<SizeType>((std::max)(1, m_opt->m_mergeHintQueueSize)));
+                m_admission.Configure([this]() { return MaintenanceDebt(); }, m_opt->m_admissionTargetDebt, m_opt->m_admissionMaxDebt,
+                    m_opt->m_admissionRate, m_opt->m_admissionBurst, m_opt->m_admissionMaxDelay);
                 LOG(Helper::LogLevel::LL_Info, "SPFresh: finish initialization\n");
             }
             return true;
@@ -1120,8 +1424,6 @@ namespace SPTAG::SPANN {
 
             // const auto postingListCount = static_cast<uint32_t>(p_exWorkSpace->m_postingIDs.size());
 
-            p_exWorkSpace->m_deduper.clear();
-
             auto exSetUpEnd = std::chrono::high_resolution_clock::now();
 
             p_stats->m_exSetUpLatency = ((double)std::chrono::duration_cast<std::chrono::microseconds>(exSetUpEnd - exStart).count()) / 1000;
@@ -1134,58 +1436,111 @@ namespace SPTAG::SPANN {
 
             double compLatency = 0;
             double readLatency = 0;
+            int signSkipped = 0;
 
             std::vector<std::string> postingLists;
+            std::vector<SizeType> wave;
+            // Deleted entries met below become the dead counts the background GC plans with
+            StartMaintenance(p_index.get());
+            std::uint32_t deleteMark = (std::uint32_t)m_versionMap->GetDeleteCount();
+            auto& topK = p_exWorkSpace->m_topK;
+            topK.Reset(queryResults.GetResultNum(), queryResults.worstDist());
+
+            // Without a deadline all postings are read in one batch. With one they are read in waves, nearest
+            // head first, so running out of time only drops the farthest postings.
+            const auto& postingIDs = p_exWorkSpace->m_postingIDs;
+            bool hasDeadline = p_stats->m_deadline != std::chrono::steady_clock::time_point::max();
+            size_t waveSize = hasDeadline ? (size_t)(std::max)(1, m_opt->m_deadlinePostingBatch) : postingIDs.size();
+            for (size_t waveStart = 0; waveStart < postingIDs.size(); waveStart += waveSize) {
+                std::chrono::microseconds remainLimit = m_hardLatencyLimit - std::chrono::microseconds((int)p_stats->m_totalLatency);
+                if (hasDeadline) {
+                    auto left = std::chrono::duration_cast<std::chrono::microseconds>(p_stats->m_deadline - std::chrono::steady_clock::now());
+                    if (left.count() <= 0) {
+                        p_stats->m_degraded = true;
+                        p_stats->m_skippedPostingCount += (int)(postingIDs.size() - waveStart);
+                        break;
+                    }
+                    remainLimit = (std::min)(remainLimit, left);
+                }
+                wave.assign(postingIDs.begin() + waveStart, postingIDs.begin() + (std::min)(waveStart + waveSize, postingIDs.size()));
 
-            std::chrono::microseconds remainLimit = m_hardLatencyLimit - std::chrono::microseconds((int)p_stats->m_totalLatency);
+                auto readStart = std::chrono::high_resolution_clock::now();
+                db->MultiGet(wave, &postingLists, remainLimit);
+                auto readEnd = std::chrono::high_resolution_clock::now();
 
-            auto readStart = std::chrono::high_resolution_clock::now();
-            db->MultiGet(p_exWorkSpace->m_postingIDs, &postingLists, remainLimit);
-            auto readEnd = std::chrono::high_resolution_clock::now();
+                for (uint32_t pi = 0; pi < postingLists.size(); ++pi) {
+                    diskIO += ((postingLists[pi].size() + PageSize - 1) >> PageSizeEx);
+                }
 
-            for (uint32_t pi = 0; pi < postingLists.size(); ++pi) {
-                diskIO += ((postingLists[pi].size() + PageSize - 1) >> PageSizeEx);
-            }
+                readLatency += ((double)std::chrono::duration_cast<std::chrono::microseconds>(readEnd - readStart).count());
+                for (uint32_t pi = 0; pi < postingLists.size(); ++pi) {
+                    auto curPostingID = wave[pi];
+                    std::string& postingList = postingLists[pi];
 
-            readLatency += ((double)std::chrono::duration_cast<std::chrono::microseconds>(readEnd - readStart).count());
-            for (uint32_t pi = 0; pi < postingLists.size(); ++pi) {
-                auto curPostingID = p_exWorkSpace->m_postingIDs[pi];
-                std::string& postingList = postingLists[pi];
+                    int vectorNum = (int)(postingList.size() / m_storedVectorInfoSize);
 
-                int vectorNum = (int)(postingList.size() / m_vectorInfoSize);
+                    int realNum = vectorNum;
 
-                int realNum = vectorNum;
+                    diskRead += (int)(postingList.size());
+                    listElements += vectorNum;
 
-                diskRead += (int)(postingList.size());
-                listElements += vectorNum;
-
-                auto compStart = std::chrono::high_resolution_clock::now();
-                for (int i = 0; i < vectorNum; i++) {
-                    char* vectorInfo = postingList.data() + i * m_vectorInfoSize;
-                    int vectorID = *(reinterpret_cast<int*>(vectorInfo));
-                    if (m_versionMap->Deleted(vectorID)) {
-                        realNum--;
-                        listElements--;
-                        continue;
+                    auto compStart = std::chrono::high_resolution_clock::now();
+                    const ValueType* head = (const ValueType*)p_index->GetSample(curPostingID);
+                    int signThreshold = 0;
+                    bool signFilter = SignCodeThreshold(p_exWorkSpace, queryResults, head, postingList.data(), vectorNum, signThreshold);
+                    float residualBias = 0;
+                    if (m_residualBits > 0) {
+                        p_exWorkSpace->m_residualTable.resize(m_opt->m_dim);
+                        residualBias = COMMON::ResidualCode::PrepareQuery((const ValueType*)queryResults.GetQuantizedTarget(), head, m_opt->m_dim, m_opt->m_distCalcMethod, p_exWorkSpace->m_residualTable.data());
                     }
-                    if(p_exWorkSpace->m_deduper.CheckAndSet(vectorID)) {
-                        listElements--;
-                        continue;
+                    auto& vids = p_exWorkSpace->m_postingVIDs;
+                    auto& alive = p_exWorkSpace->m_aliveMask;
+                    if (vids.size() < (size_t)vectorNum) {
+                        vids.resize(vectorNum);
+                        alive.resize(vectorNum);
                     }
-                    auto distance2leaf = p_index->ComputeDistance(queryResults.GetQuantizedTarget(), vectorInfo + m_metaDataSize);
-                    queryResults.AddPoint(vectorID, distance2leaf);
-                }
-                auto compEnd = std::chrono::high_resolution_clock::now();
-                if (realNum <= m_mergeThreshold && !m_opt->m_inPlace) MergeAsync(p_index.get(), curPostingID);
-
-                compLatency += ((double)std::chrono::duration_cast<std::chrono::microseconds>(compEnd - compStart).count());
-
-                if (truth) {
-                    for (int i = 0; i < vectorNum; ++i) {
-                        char* vectorInfo = postingList.data() + i * m_vectorInfoSize;
-                        int vectorID = *(reinterpret_cast<int*>(vectorInfo));
-                        if (truth->count(vectorID) != 0)
-                            (*found)[curPostingID].insert(vectorID);
+                    for (int i = 0; i < vectorNum; i++) vids[i] = *(reinterpret_cast<int*>(postingList.data() + i * m_storedVectorInfoSize));
+                    m_versionMap->FilterDeleted(vids.data(), vectorNum, alive.data());
+                    for (int i = 0; i < vectorNum; i++) {
+                        char* vectorInfo = postingList.data() + i * m_storedVectorInfoSize;
+                        int vectorID = vids[i];
+                        if (!alive[i]) {
+                            realNum--;
+                            listElements--;
+                            continue;
+                        }
+                        if (p_exWorkSpace->m_filter != nullptr && !p_exWorkSpace->m_filter->Match(p_exWorkSpace->m_attributes->Row(vectorID))) continue;
+                        if (signFilter && p_exWorkSpace->m_signDists[i] > signThreshold) {
+                            signSkipped++;
+                            continue;
+                        }
+                        if(p_exWorkSpace->m_deduper.CheckAndSet(vectorID)) {
+                            listElements--;
+                            continue;
+                        }
+                        float distance2leaf;
+                        if (m_residualBits > 0) {
+                            distance2leaf = COMMON::ResidualCode::Distance(p_exWorkSpace->m_residualTable.data(), residualBias, (const std::uint8_t*)(vectorInfo + m_metaDataSize), m_opt->m_dim, m_residualBits, m_opt->m_distCalcMethod);
+                        }
+                        else {
+                            distance2leaf = p_index->ComputeDistance(queryResults.GetQuantizedTarget(), vectorInfo + m_metaDataSize);
+                        }
+                        if (!p_exWorkSpace->AddRangePoint(vectorID, distance2leaf)) topK.Add(vectorID, distance2leaf);
+                    }
+                    topK.Flush(queryResults);
+                    auto compEnd = std::chrono::high_resolution_clock::now();
+                    if (m_opt->m_update) m_postingSizes.UpdateDead(curPostingID, vectorNum - realNum, deleteMark);
+                    if (realNum <= m_mergeThreshold && !m_opt->m_inPlace) HintMerge(curPostingID);
+
+                    compLatency += ((double)std::chrono::duration_cast<std::chrono::microseconds>(compEnd - compStart).count());
+
+                    if (truth) {
+                        for (int i = 0; i < vectorNum; ++i) {
+                            char* vectorInfo = postingList.data() + i * m_storedVectorInfoSize;
+                            int vectorID = *(reinterpret_cast<int*>(vectorInfo));
+                            if (truth->count(vectorID) != 0)
+                                (*found)[curPostingID].insert(vectorID);
+                        }
                     }
                 }
             }
@@ -1197,9 +1552,49 @@ namespace SPTAG::SPANN {
                 p_stats->m_totalListElementsCount = listElements;
                 p_stats->m_diskIOCount = diskIO;
                 p_stats->m_diskAccessCount = diskRead / 1024;
+                p_stats->m_signCodeSkipCount = signSkipped;
             }
         }
 
+        // Largest head-to-entry distance of an in-memory posting. Paths that only drop entries keep the old
+        // radius, which stays a valid upper bound.
+        float PostingRadius(VectorIndex* p_index, SizeType headID, const std::string& posting)
+        {
+            const void* head = p_index->GetSample(headID);
+            float radius = 0;
+            for (size_t offset = 0; offset + m_vectorInfoSize <= posting.size(); offset += m_vectorInfoSize) {
+                radius = (std::max)(radius, p_index->ComputeDistance(head, posting.data() + offset + m_metaDataSize));
+            }
+            return radius;
+        }
+
+        std::string PostingRadiusFile() const
+        {
+            return m_opt->m_postingRadiusFile.empty() ? m_opt->m_ssdInfoFile + ".radius" : m_opt->m_postingRadiusFile;
+        }
+
+        // Hamming distances of the entries in one posting to the query sign code and the threshold above which
+        // entries skip the full distance. Returns false, leaving the distances unset, when nothing is to be
+        // skipped: sign codes off or the result set not yet full.
+        bool SignCodeThreshold(ExtraWorkSpace* p_exWorkSpace, COMMON::QueryResultSet<ValueType>& p_queryResults, const ValueType* p_head, const char* p_posting, int p_vectorNum, int& p_threshold)
+        {
+            if (m_signCodeSize == 0 || p_queryResults.worstDist() == MaxDist || m_opt->m_signCodeKeepRatio >= 1.0f) return false;
+
+            auto& dists = p_exWorkSpace->m_signDists;
+            if (dists.size() < (size_t)p_vectorNum) dists.resize(p_vectorNum);
+
+            auto& queryCode = p_exWorkSpace->m_signCode;
+            queryCode.resize(m_signCodeSize);
+            COMMON::SignCode::Encode((const ValueType*)p_queryResults.GetQuantizedTarget(), p_head, m_opt->m_dim, queryCode.data());
+            const char* code = p_posting + m_storedVectorInfoSize - m_signCodeSize;
+            for (int i = 0; i < p_vectorNum; i++, code += m_storedVectorInfoSize) {
+                dists[i] = COMMON::SignCode::Hamming(queryCode.data(), (const std::uint8_t*)code, m_signCodeSize);
+            }
+            p_exWorkSpace->m_signScratch.assign(dists.begin(), dists.begin() + p_vectorNum);
+            p_threshold = COMMON::SignCode::Threshold(p_exWorkSpace->m_signScratch, p_vectorNum, m_opt->m_signCodeKeepRatio);
+            return true;
+        }
+
         bool BuildIndex(std::shared_ptr<Helper::VectorSetReader>& p_reader, std::shared_ptr<VectorIndex> p_headIndex, Options& p_opt, COMMON::VersionLabel& p_versionMap, SizeType upperBound = -1) override {
             m_versionMap = &p_versionMap;
             m_opt = &p_opt;
@@ -1232,7 +1627,7 @@ namespace SPTAG::SPANN {
             {
                 auto fullVectors = p_reader->GetVectorSet();
                 fullCount = fullVectors->Count();
-                m_vectorInfoSize = fullVectors->PerVectorDataSize() + m_metaDataSize;
+                InitEntrySizes((int)fullVectors->PerVectorDataSize());
             }
             if (upperBound > 0) fullCount = upperBound;
 
@@ -1340,7 +1735,7 @@ namespace SPTAG::SPANN {
             auto postingSizeLimit = m_postingSizeLimit;
             if (m_opt->m_postingPageLimit > 0)
             {
-                postingSizeLimit = static_cast<int>(m_opt->m_postingPageLimit * PageSize / m_vectorInfoSize);
+                postingSizeLimit = static_cast<int>(m_opt->m_postingPageLimit * PageSize / m_storedVectorInfoSize);
             }
 
             LOG(Helper::LogLevel::LL_Info, "Posting size limit: %d\n", postingSizeLimit);
@@ -1434,14 +1829,16 @@ namespace SPTAG::SPANN {
 
             std::vector<int> postingListSize_int(postingListSize.begin(), postingListSize.end());
 
-            WriteDownAllPostingToDB(postingListSize_int, selections, fullVectors);
-
             m_postingSizes.Initialize((SizeType)(postingListSize.size()), p_headIndex->m_iDataBlockSize, p_headIndex->m_iDataCapacity);
             for (int i = 0; i < postingListSize.size(); i++) {
                 m_postingSizes.UpdateSize(i, postingListSize[i]);
             }
+
+            WriteDownAllPostingToDB(postingListSize_int, selections, fullVectors, p_headIndex.get());
+
             LOG(Helper::LogLevel::LL_Info, "SPFresh: Writing SSD Info\n");
             m_postingSizes.Save(m_opt->m_ssdInfoFile);
+            m_postingSizes.SaveRadius(PostingRadiusFile());
             LOG(Helper::LogLevel::LL_Info, "SPFresh: save versionMap\n");
             m_versionMap->Save(m_opt->m_deleteIDFile);
 
@@ -1451,7 +1848,7 @@ namespace SPTAG::SPANN {
             return true;
         }
 
-        void WriteDownAllPostingToDB(const std::vector<int>& p_postingListSizes, Selection& p_postingSelections, std::shared_ptr<VectorSet> p_fullVectors) {
+        void WriteDownAllPostingToDB(const std::vector<int>& p_postingListSizes, Selection& p_postingSelections, std::shared_ptr<VectorSet> p_fullVectors, VectorIndex* p_headIndex) {
     // #pragma omp parallel for num_threads(10)
             std::vector<std::thread> threads;
             std::atomic_size_t vectorsSent(0);
@@ -1478,7 +1875,9 @@ namespace SPTAG::SPANN {
                             Serialize(ptr, fullID, version, p_fullVectors->GetVector(fullID));
                             ptr += m_vectorInfoSize;
                         }
-                        db->Put(index, postinglist);
+                        EncodeSignCodes((char*)postinglist.c_str(), p_postingListSizes[index], (const ValueType*)p_headIndex->GetSample((SizeType)index));
+                        m_postingSizes.UpdateRadius((SizeType)index, PostingRadius(p_headIndex, (SizeType)index, postinglist));
+                        PutPosting(p_headIndex, (SizeType)index, postinglist);
                     }
                     else
                     {
@@ -1495,6 +1894,10 @@ namespace SPTAG::SPANN {
         ErrorCode AddIndex(std::shared_ptr<VectorSet>& p_vectorSet,
             std::shared_ptr<VectorIndex> p_index, SizeType begin) override {
 
+            StartMaintenance(p_index.get());
+            m_admission.Admit(p_vectorSet->Count());
+            if (p_vectorSet->Count() > 1) return AddIndexBatch(p_vectorSet, p_index.get(), begin);
+
             for (int v = 0; v < p_vectorSet->Count(); v++) {
                 SizeType VID = begin + v;
                 std::vector<Edge> selections(static_cast<size_t>(m_opt->m_replicaCount));
@@ -1513,6 +1916,43 @@ namespace SPTAG::SPANN {
             return ErrorCode::Success;
         }
 
+        // Selects the heads of the whole batch in parallel, then appends the entries of each head together,
+        // so that a head is locked, merged and checked for a split once per batch instead of once per vector.
+        ErrorCode AddIndexBatch(std::shared_ptr<VectorSet>& p_vectorSet, VectorIndex* p_index, SizeType begin)
+        {
+            SizeType count = p_vectorSet->Count();
+            std::vector<Edge> selections(static_cast<size_t>(count) * m_opt->m_replicaCount);
+            std::vector<int> replicaCounts(count);
+#pragma omp parallel for num_threads((std::max)(1, m_opt->m_insertBatchThreadNum)) schedule(dynamic, 4)
+            for (SizeType v = 0; v < count; v++) {
+                std::vector<Edge> vectorSelections(static_cast<size_t>(m_opt->m_replicaCount));
+                RNGSelection(vectorSelections, (ValueType*)(p_vectorSet->GetVector(v)), p_index, begin + v, replicaCounts[v]);
+                std::copy(vectorSelections.begin(), vectorSelections.begin() + replicaCounts[v], selections.begin() + static_cast<size_t>(v) * m_opt->m_replicaCount);
+            }
+
+            std::vector<std::pair<SizeType, SizeType>> targets;
+            for (SizeType v = 0; v < count; v++) {
+                for (int i = 0; i < replicaCounts[v]; i++) targets.emplace_back(selections[static_cast<size_t>(v) * m_opt->m_replicaCount + i].node, v);
+            }
+            std::sort(targets.begin(), targets.end());
+
+            std::string appendPosting;
+            for (size_t first = 0, last; first < targets.size(); first = last) {
+                SizeType headID = targets[first].first;
+                for (last = first; last < targets.size() && targets[last].first == headID; last++);
+
+                int appendNum = (int)(last - first);
+                appendPosting.assign(static_cast<size_t>(appendNum) * m_vectorInfoSize, '\0');
+                char* ptr = (char*)(appendPosting.c_str());
+                for (size_t j = first; j < last; j++, ptr += m_vectorInfoSize) {
+                    SizeType v = targets[j].second;
+                    Serialize(ptr, begin + v, m_versionMap->GetVersion(begin + v), p_vectorSet->GetVector(v));
+                }
+                Append(p_index, headID, appendNum, appendPosting);
+            }
+            return ErrorCode::Success;
+        }
+
         SizeType SearchVector(std::shared_ptr<VectorSet>& p_vectorSet,
             std::shared_ptr<VectorIndex> p_index, int testNum = 64, SizeType VID = -1) override {
             
@@ -1523,7 +1963,7 @@ namespace SPTAG::SPANN {
             std::string postingList;
             for (int i = 0; i < queryResults.GetResultNum(); ++i)
             {
-                db->Get(queryResults.GetResult(i)->VID, &postingList);
+                GetPosting(p_index.get(), queryResults.GetResult(i)->VID, &postingList);
                 int vectorNum = (int)(postingList.size() / m_vectorInfoSize);
 
                 for (int j = 0; j < vectorNum; j++) {
@@ -1548,11 +1988,226 @@ namespace SPTAG::SPANN {
             }
         }
 
-        bool AllFinished() { return m_splitThreadPool->allClear() && m_reassignThreadPool->allClear(); }
+        // A posting just written without dead entries
+        inline void MarkClean(SizeType headID)
+        {
+            m_postingSizes.UpdateDead(headID, 0, (std::uint32_t)m_versionMap->GetDeleteCount());
+        }
+
+        // Dead entries of a posting: those its last scan or rewrite saw, plus its share of the deletions made
+        // since; a posting never seen is assumed to hold its share of all deletions.
+        inline double EstimatedDead(SizeType headID, int size, std::uint32_t deleteMark, double vectorNum)
+        {
+            std::uint32_t mark;
+            int dead = m_postingSizes.GetDead(headID, mark);
+            std::uint32_t since = (dead < 0) ? deleteMark : deleteMark - mark;
+            return (std::min)((double)size, (std::max)(dead, 0) + (double)size * since / vectorNum);
+        }
+
+        // Rewrites a posting without its deleted and stale entries and accounts the space freed
+        ErrorCode GarbageCollect(VectorIndex* p_index, SizeType headID)
+        {
+            int remain;
+            std::uint64_t reclaimed = 0;
+            {
+                std::unique_lock<std::shared_timed_mutex> lock(m_rwLocks[headID]);
+                if (!p_index->ContainSample(headID)) return ErrorCode::Success;
+
+                // Deletions from here on are not filtered below and count as new dead entries
+                std::uint32_t deleteMark = (std::uint32_t)m_versionMap->GetDeleteCount();
+                std::string postingList;
+                if (GetPosting(p_index, headID, &postingList) != ErrorCode::Success) {
+                    LOG(Helper::LogLevel::LL_Error, "GC fail to get posting %d\n", headID);
+                    return ErrorCode::Fail;
+                }
+                int postVectorNum = (int)(postingList.size() / m_vectorInfoSize);
+                char* ptr = (char*)(postingList.c_str());
+                remain = 0;
+                for (int j = 0; j < postVectorNum; j++) {
+                    const char* vectorId = postingList.c_str() + (size_t)j * m_vectorInfoSize;
+                    int VID = *((int*)(vectorId));
+                    uint8_t version = *((uint8_t*)(vectorId + sizeof(int)));
+                    if (m_versionMap->Deleted(VID) || m_versionMap->GetVersion(VID) != version) continue;
+                    if (j != remain) memmove(ptr + (size_t)remain * m_vectorInfoSize, vectorId, m_vectorInfoSize);
+                    remain++;
+                }
+                if (remain < postVectorNum) {
+                    postingList.resize((size_t)remain * m_vectorInfoSize);
+                    if (PutPosting(p_index, headID, postingList) != ErrorCode::Success) {
+                        LOG(Helper::LogLevel::LL_Info, "GC fail to write back posting %d\n", headID);
+                        exit(0);
+                    }
+                    m_postingSizes.UpdateSize(headID, remain);
+                    reclaimed = (std::uint64_t)(postVectorNum - remain) * m_storedVectorInfoSize;
+                }
+                m_postingSizes.UpdateDead(headID, 0, deleteMark);
+            }
+            if (reclaimed > 0) {
+                m_stat.m_gcRewriteNum++;
+                m_stat.m_gcBytesReclaimed += reclaimed;
+                if (remain <= m_mergeThreshold && !m_opt->m_inPlace) MergeAsync(p_index, headID);
+            }
+            return ErrorCode::Success;
+        }
+
+        void GCJobDone(std::int64_t p_micros)
+        {
+            m_gcJobMicros += p_micros;
+            if (--m_gcInFlight == 0) {
+                std::lock_guard<std::mutex> lock(m_maintenanceLock);
+                m_maintenanceWake.notify_all();
+            }
+        }
+
+        inline void StartMaintenance(VectorIndex* p_index)
+        {
+            if (!m_opt->m_update) return;
+            std::call_once(m_maintenanceStarted, [this, p_index]() {
+                m_mergeThread = std::thread([this, p_index]() { MergeManager(p_index); });
+                if (m_opt->m_gcIOBudget > 0) m_gcThread = std::thread([this, p_index]() { GCPlanner(p_index); });
+            });
+        }
+
+        // Called by searches for postings that got small; a full ring drops the hint, the next search repeats it
+        inline void HintMerge(SizeType headID)
+        {
+            if (m_mergeHints) m_mergeHints->push(headID);
+        }
+
+        // Drains the merge hints every MergeHintInterval ms. A head hinted again while waiting, or within
+        // MergeCooldown ms of its last merge, is dropped, and at most MergeRate merges are scheduled per second;
+        // the heads over the rate wait for the next rounds in hint order.
+        void MergeManager(VectorIndex* p_index)
+        {
+            auto interval = std::chrono::milliseconds((std::max)(1, m_opt->m_mergeHintInterval));
+            auto cooldown = std::chrono::milliseconds((std::max)(0, m_opt->m_mergeCooldown));
+            double burst = (std::max)(1.0, (double)m_opt->m_mergeRate);
+            double tokens = burst;
+            auto last = std::chrono::steady_clock::now();
+            auto lastPrune = last;
+            std::deque<SizeType> pending;
+            std::unordered_set<SizeType> pendingSet;
+            std::unordered_map<SizeType, std::chrono::steady_clock::time_point> recent;
+
+            std::unique_lock<std::mutex> lock(m_maintenanceLock);
+            while (!m_maintenanceWake.wait_for(lock, interval, [this]() { return m_maintenanceStop; })) {
+                lock.unlock();
+
+                auto now = std::chrono::steady_clock::now();
+                SizeType headID;
+                while (m_mergeHints->pop(headID)) {
+                    auto it = recent.find(headID);
+                    if ((it != recent.end() && now - it->second < cooldown) || !pendingSet.insert(headID).second) {
+                        m_mergeHintsDeduped++;
+                        continue;
+                    }
+                    pending.push_back(headID);
+                }
+                if (m_opt->m_mergeRate > 0) tokens = (std::min)(burst, tokens + m_opt->m_mergeRate * std::chrono::duration<double>(now - last).count());
+                last = now;
+
+                while (!pending.empty() && (m_opt->m_mergeRate <= 0 || tokens >= 1)) {
+                    headID = pending.front();
+                    pending.pop_front();
+                    pendingSet.erase(headID);
+                    if (!p_index->ContainSample(headID)) continue;
+                    MergeAsync(p_index, headID);
+                    recent[headID] = now;
+                    tokens--;
+                    m_mergeHintsScheduled++;
+                }
+                if (now - lastPrune >= cooldown) {
+                    lastPrune = now;
+                    for (auto it = recent.begin(); it != recent.end();) {
+                        if (now - it->second >= cooldown) it = recent.erase(it);
+                        else ++it;
+                    }
+                }
+
+                lock.lock();
+            }
+        }
+
+        // Every GCInterval ms, rewrites the postings with the highest estimated dead ratio first, as long as the
+        // disk budget of the round allows; a round that overspends, in bytes or in CPU time measured on the
+        // jobs, is paid back by the following ones. The cost of a posting is reading it whole and writing back
+        // its live part.
+        void GCPlanner(VectorIndex* p_index)
+        {
+            auto interval = std::chrono::milliseconds((std::max)(1, m_opt->m_gcInterval));
+            // Budgets of one round, in bytes and microseconds
+            double ioPerRound = m_opt->m_gcIOBudget * 1024.0 * 1024.0 * interval.count() / 1000.0;
+            double cpuPerRound = (std::max)(1, m_opt->m_gcCPUBudget) * (double)interval.count();
+            double ioCredit = 0, cpuCredit = 0;
+            std::vector<std::pair<double, SizeType>> candidates;
+            LOG(Helper::LogLevel::LL_Info, "SPFresh: background GC, %d MB/s, %d ms/s, dead ratio %.2f\n", m_opt->m_gcIOBudget, m_opt->m_gcCPUBudget, m_opt->m_gcDeadRatio);
+
+            std::unique_lock<std::mutex> lock(m_maintenanceLock);
+            while (!m_maintenanceWake.wait_for(lock, interval, [this]() { return m_maintenanceStop; })) {
+                ioCredit = (std::min)(ioCredit + ioPerRound, ioPerRound);
+                cpuCredit = (std::min)(cpuCredit + cpuPerRound, cpuPerRound);
+                if (ioCredit <= 0 || cpuCredit <= 0) continue;
+                lock.unlock();
+
+                std::uint32_t deleteMark = (std::uint32_t)m_versionMap->GetDeleteCount();
+                double vectorNum = (std::max)(1, (int)m_versionMap->GetVectorNum());
+                candidates.clear();
+                SizeType postingNum = m_postingSizes.GetPostingNum();
+                for (SizeType i = 0; i < postingNum; i++) {
+                    int size = m_postingSizes.GetSize(i);
+                    if (size <= 0 || !p_index->ContainSample(i)) continue;
+                    double ratio = EstimatedDead(i, size, deleteMark, vectorNum) / size;
+                    if (ratio >= m_opt->m_gcDeadRatio) candidates.emplace_back(ratio, i);
+                }
+                std::sort(candidates.begin(), candidates.end(), std::greater<std::pair<double, SizeType>>());
+
+                for (size_t i = 0; i < candidates.size() && ioCredit > 0; i++) {
+                    SizeType headID = candidates[i].second;
+                    ioCredit -= (double)m_postingSizes.GetSize(headID) * m_storedVectorInfoSize * (2 - candidates[i].first);
+                    auto* curJob = m_gcJobs.Get();
+                    curJob->Set(p_index, this, headID);
+                    m_gcInFlight++;
+                    m_scheduler->add(curJob, GCPriority);
+                }
+
+                lock.lock();
+                m_maintenanceWake.wait(lock, [this]() { return m_maintenanceStop || m_gcInFlight.load() == 0; });
+                cpuCredit -= (double)m_gcJobMicros.exchange(0);
+            }
+        }
+
+        bool AllFinished() { return m_scheduler->allClear(); }
+
+        // Background work that inserts are waiting on: queued maintenance jobs and postings still over the limit
+        double MaintenanceDebt() const
+        {
+            return (double)(m_scheduler->jobsize(SplitPriority) + m_scheduler->jobsize(MergePriority) + m_scheduler->jobsize(ReassignPriority)) +
+                (double)m_oversizedPostings.load();
+        }
+
+        AdmissionState GetAdmissionState() override { return m_admission.GetState(); }
+
         void ForceCompaction() override { db->ForceCompaction(); }
         void GetDBStats() override { 
             db->GetStat();
-            LOG(Helper::LogLevel::LL_Info, "remain splitJobs: %d, reassignJobs: %d, running split: %d, running reassign: %d\n", m_splitThreadPool->jobsize(), m_reassignThreadPool->jobsize(), m_splitThreadPool->runningJobs(), m_reassignThreadPool->runningJobs());
+            Helper::PriorityScheduler::Stats stats = m_scheduler->GetStats();
+            LOG(Helper::LogLevel::LL_Info, "remain splitJobs: %llu, mergeJobs: %llu, reassignJobs: %llu, gcJobs: %llu, running: %llu, executed: %llu, stolen: %llu, max queued: %llu\n",
+                (unsigned long long)stats.m_queued[SplitPriority], (unsigned long long)stats.m_queued[MergePriority],
+                (unsigned long long)stats.m_queued[ReassignPriority], (unsigned long long)stats.m_queued[GCPriority],
+                (unsigned long long)stats.m_running, (unsigned long long)stats.m_executed, (unsigned long long)stats.m_stolen, (unsigned long long)stats.m_maxQueued);
+            AdmissionState admission = m_admission.GetState();
+            if (admission.m_enabled) {
+                LOG(Helper::LogLevel::LL_Info, "admission debt: %.0f, rate: %.0f/s, admitted: %llu, delayed: %llu (%llu ms), timeouts: %llu\n",
+                    admission.m_debt, admission.m_rate, (unsigned long long)admission.m_admitted, (unsigned long long)admission.m_delayed,
+                    (unsigned long long)admission.m_delayMs, (unsigned long long)admission.m_timeouts);
+            }
+            if (m_mergeHints) {
+                LOG(Helper::LogLevel::LL_Info, "merge hints scheduled: %llu, deduplicated: %llu, dropped: %llu\n", (unsigned long long)m_mergeHintsScheduled.load(),
+                    (unsigned long long)m_mergeHintsDeduped.load(), (unsigned long long)m_mergeHints->dropped());
+            }
+            if (m_opt->m_gcIOBudget > 0) {
+                LOG(Helper::LogLevel::LL_Info, "background GC rewrites: %u, bytes reclaimed: %llu\n", m_stat.m_gcRewriteNum.load(), (unsigned long long)m_stat.m_gcBytesReclaimed.load());
+            }
         }
 
         void GetIndexStats(int finishedInsert, bool cost, bool reset) override { m_stat.PrintStat(finishedInsert, cost, reset); }
@@ -1561,6 +2216,14 @@ namespace SPTAG::SPANN {
             return m_postingSizes.GetSize(postingID) > 0;
         }
 
+        int GetPostingSize(SizeType postingID) override { return m_postingSizes.GetSize(postingID); }
+
+        std::uint64_t GetGCBytesReclaimed() override { return m_stat.m_gcBytesReclaimed.load(); }
+
+        float GetPostingRadius(SizeType postingID) override {
+            return m_postingSizes.GetRadius(postingID);
+        }
+
         bool Initialize() override {
             return db->Initialize();
         }
@@ -1569,14 +2232,23 @@ namespace SPTAG::SPANN {
             return db->ExitBlockController();
         }
 
-        void GetWritePosting(SizeType pid, std::string& posting, bool write = false) override { 
+        // Postings are exchanged in the in-memory layout; the head index is required to convert them
+        // when residual quantization is enabled.
+        void GetWritePosting(SizeType pid, std::string& posting, bool write = false, VectorIndex* p_headIndex = nullptr) override { 
+            if (m_residualBits > 0 && p_headIndex == nullptr) {
+                LOG(Helper::LogLevel::LL_Error, "Residual quantized postings need the head index to be read or written\n");
+                exit(1);
+            }
             if (write) {
-                db->Put(pid, posting);
+                if (m_residualBits > 0) PutPosting(p_headIndex, pid, posting);
+                else db->Put(pid, posting);
                 m_postingSizes.UpdateSize(pid, posting.size() / m_vectorInfoSize);
+                if (p_headIndex != nullptr) m_postingSizes.UpdateRadius(pid, PostingRadius(p_headIndex, pid, posting));
                 // LOG(Helper::LogLevel::LL_Info, "PostingSize: %d\n", m_postingSizes.GetSize(pid));
                 // exit(1);
             } else {
-                db->Get(pid, &posting);
+                if (m_residualBits > 0) GetPosting(p_headIndex, pid, &posting);
+                else db->Get(pid, &posting);
             }
         }
 
@@ -1584,12 +2256,22 @@ namespace SPTAG::SPANN {
             m_postingSizes.Initialize((SizeType)(p_index->GetNumSamples()), p_index->m_iDataBlockSize, p_index->m_iDataCapacity);
         }
 
+        void SetHeadReplicas(std::shared_ptr<HeadReplicas> p_replicas) {
+            m_headReplicas = p_replicas;
+        }
+
     private:
 
         int m_metaDataSize = 0;
         
         int m_vectorInfoSize = 0;
 
+        int m_signCodeSize = 0;
+
+        int m_residualBits = 0;
+
+        int m_storedVectorInfoSize = 0;
+
         int m_postingSizeLimit = INT_MAX;
 
         std::chrono::microseconds m_hardLatencyLimit = std::chrono::microseconds(2000);
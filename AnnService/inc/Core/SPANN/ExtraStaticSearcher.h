@@ -8,6 +8,7 @@
 #include "inc/Helper/AsyncFileReader.h"
 #include "IExtraSearcher.h"
 #include "inc/Core/Common/TruthSet.h"
+#include "inc/Core/Common/SignCode.h"
 #include "Compressor.h"
 
 #include <map>
@@ -102,15 +103,24 @@ namespace SPTAG
 }\
 
 #define ProcessPosting() \
+        const std::uint8_t* p_fastScanBlocks = (const std::uint8_t*)p_postingListFullData; \
+        p_postingListFullData += listInfo->fastScanBytes; \
+        int signThreshold = 0; \
+        bool signFilter = SignCodeThreshold(p_exWorkSpace, queryResults, p_index, listInfo, p_postingListFullData, signThreshold); \
+        float fastScanBound = FastScanBounds(p_exWorkSpace, queryResults, p_index, listInfo, p_fastScanBlocks); \
         for (int i = 0; i < listInfo->listEleCount; i++) { \
             uint64_t offsetVectorID, offsetVector;\
             (this->*m_parsePosting)(offsetVectorID, offsetVector, i, listInfo->listEleCount);\
+            if (signFilter && p_exWorkSpace->m_signDists[i] > signThreshold) { p_exWorkSpace->m_signCodeSkipCount++; continue; } \
+            if (fastScanBound < MaxDist && p_exWorkSpace->m_fastScanDists[i] > fastScanBound) { p_exWorkSpace->m_fastScanSkipCount++; continue; } \
             int vectorID = *(reinterpret_cast<int*>(p_postingListFullData + offsetVectorID));\
+            if (p_exWorkSpace->m_filter != nullptr && !p_exWorkSpace->m_filter->Match(p_exWorkSpace->m_attributes->Row(vectorID))) continue; \
             if (p_exWorkSpace->m_deduper.CheckAndSet(vectorID)) continue; \
             (this->*m_parseEncoding)(p_index, listInfo, (ValueType*)(p_postingListFullData + offsetVector));\
             auto distance2leaf = p_index->ComputeDistance(queryResults.GetQuantizedTarget(), p_postingListFullData + offsetVector); \
-            queryResults.AddPoint(vectorID, distance2leaf); \
+            if (!p_exWorkSpace->AddRangePoint(vectorID, distance2leaf)) p_exWorkSpace->m_topK.Add(vectorID, distance2leaf); \
         } \
+        p_exWorkSpace->m_topK.Flush(queryResults); \
 
         template <typename ValueType>
         class ExtraStaticSearcher : public IExtraSearcher
@@ -122,6 +132,9 @@ namespace SPTAG
                 m_enablePostingListRearrange = false;
                 m_enableDataCompression = false;
                 m_enableDictTraining = true;
+                m_signCodeSize = 0;
+                m_signCodeKeepRatio = 1.0f;
+                m_enableFastScan = false;
             }
 
             virtual ~ExtraStaticSearcher()
@@ -130,13 +143,18 @@ namespace SPTAG
 
             virtual bool LoadIndex(Options& p_opt, COMMON::VersionLabel& p_versionMap) {
                 m_extraFullGraphFile = p_opt.m_indexDirectory + FolderSep + p_opt.m_ssdIndex;
+                m_signCodeSize = p_opt.m_enableSignCode ? COMMON::SignCode::CodeSize(p_opt.m_dim) : 0;
+                m_signCodeKeepRatio = p_opt.m_signCodeKeepRatio;
+                m_enableFastScan = p_opt.m_enableFastScan;
+                m_deadlinePostingBatch = p_opt.m_deadlinePostingBatch;
                 std::string curFile = m_extraFullGraphFile;
                 do {
                     auto curIndexFile = f_createAsyncIO();
                     if (curIndexFile == nullptr || !curIndexFile->Initialize(curFile.c_str(), std::ios::binary | std::ios::in, 
 #ifndef _MSC_VER
 #ifdef BATCH_READ
-                        p_opt.m_searchInternalResultNum, 2, 2, p_opt.m_iSSDNumberOfThreads
+                        // Batch reads wait on the context of their workspace slot, so every slot needs its own
+                        p_opt.m_searchInternalResultNum, 2, 2, (std::uint16_t)(std::max)(p_opt.m_iSSDNumberOfThreads, p_opt.WorkSpacePoolSize())
 #else
                         p_opt.m_searchInternalResultNum * p_opt.m_iSSDNumberOfThreads / p_opt.m_ioThreads + 1, 2, 2, p_opt.m_ioThreads
 #endif
@@ -200,43 +218,90 @@ namespace SPTAG
                 int diskRead = 0;
                 int diskIO = 0;
                 int listElements = 0;
+                p_exWorkSpace->m_signCodeSkipCount = 0;
+                p_exWorkSpace->m_fastScanSkipCount = 0;
+                PrepareFastScan(p_exWorkSpace, queryResults, p_index);
+                p_exWorkSpace->m_topK.Reset(queryResults.GetResultNum(), queryResults.worstDist());
 
 #if defined(ASYNC_READ) && !defined(BATCH_READ)
                 int unprocessed = 0;
 #endif
 
-                for (uint32_t pi = 0; pi < postingListCount; ++pi)
+                // Without a deadline all postings are read in one wave. With one they are read in waves of
+                // DeadlinePostingBatch, nearest head first, and the waves left when time runs out are skipped.
+                bool hasDeadline = p_stats != nullptr && p_stats->m_deadline != std::chrono::steady_clock::time_point::max();
+                uint32_t waveSize = hasDeadline ? (uint32_t)(std::max)(1, m_deadlinePostingBatch) : (std::max)(postingListCount, 1u);
+                uint32_t readCount = postingListCount;
+                for (uint32_t waveStart = 0; waveStart < postingListCount; waveStart += waveSize)
                 {
-                    auto curPostingID = p_exWorkSpace->m_postingIDs[pi];
-                    ListInfo* listInfo = &(m_listInfos[curPostingID]);
-                    int fileid = m_oneContext? 0: curPostingID / m_listPerFile;
+                    if (hasDeadline && std::chrono::steady_clock::now() >= p_stats->m_deadline) {
+                        p_stats->m_degraded = true;
+                        p_stats->m_skippedPostingCount += (int)(postingListCount - waveStart);
+                        readCount = waveStart;
+                        break;
+                    }
+                    uint32_t waveEnd = (std::min)(waveStart + waveSize, postingListCount);
+
+                    for (uint32_t pi = waveStart; pi < waveEnd; ++pi)
+                    {
+                        auto curPostingID = p_exWorkSpace->m_postingIDs[pi];
+                        ListInfo* listInfo = &(m_listInfos[curPostingID]);
+                        int fileid = m_oneContext? 0: curPostingID / m_listPerFile;
 
 #ifndef BATCH_READ
-                    Helper::DiskIO* indexFile = m_indexFiles[fileid].get();
+                        Helper::DiskIO* indexFile = m_indexFiles[fileid].get();
 #endif
 
-                    diskRead += listInfo->listPageCount;
-                    diskIO += 1;
-                    listElements += listInfo->listEleCount;
+                        diskRead += listInfo->listPageCount;
+                        diskIO += 1;
+                        listElements += listInfo->listEleCount;
 
-                    size_t totalBytes = (static_cast<size_t>(listInfo->listPageCount) << PageSizeEx);
-                    char* buffer = (char*)((p_exWorkSpace->m_pageBuffers[pi]).GetBuffer());
+                        size_t totalBytes = (static_cast<size_t>(listInfo->listPageCount) << PageSizeEx);
+                        char* buffer = (char*)((p_exWorkSpace->m_pageBuffers[pi]).GetBuffer());
 
 #ifdef ASYNC_READ       
-                    auto& request = p_exWorkSpace->m_diskRequests[pi];
-                    request.m_offset = listInfo->listOffset;
-                    request.m_readSize = totalBytes;
-                    request.m_buffer = buffer;
-                    request.m_status = (fileid << 16) | p_exWorkSpace->m_spaceID;
-                    request.m_payload = (void*)listInfo; 
-                    request.m_success = false;
+                        auto& request = p_exWorkSpace->m_diskRequests[pi];
+                        request.m_offset = listInfo->listOffset;
+                        request.m_readSize = totalBytes;
+                        request.m_buffer = buffer;
+                        request.m_status = (fileid << 16) | p_exWorkSpace->m_spaceID;
+                        request.m_payload = (void*)listInfo; 
+                        request.m_success = false;
 
 #ifdef BATCH_READ // async batch read
-                    request.m_callback = [&p_exWorkSpace, &queryResults, &p_index, &request, this](bool success)
-                    {
-                        char* buffer = request.m_buffer;
-                        ListInfo* listInfo = (ListInfo*)(request.m_payload);
+                        request.m_callback = [&p_exWorkSpace, &queryResults, &p_index, &request, this](bool success)
+                        {
+                            char* buffer = request.m_buffer;
+                            ListInfo* listInfo = (ListInfo*)(request.m_payload);
+
+                            // decompress posting list
+                            char* p_postingListFullData = buffer + listInfo->pageOffset;
+                            if (m_enableDataCompression)
+                            {
+                                DecompressPosting();
+                            }
 
+                            ProcessPosting();
+                        };
+#else // async read
+                        request.m_callback = [&p_exWorkSpace, &request](bool success)
+                        {
+                            p_exWorkSpace->m_processIocp.push(&request);
+                        };
+
+                        ++unprocessed;
+                        if (!(indexFile->ReadFileAsync(request)))
+                        {
+                            LOG(Helper::LogLevel::LL_Error, "Failed to read file!\n");
+                            unprocessed--;
+                        }
+#endif
+#else // sync read
+                        auto numRead = indexFile->ReadBinary(totalBytes, buffer, listInfo->listOffset);
+                        if (numRead != totalBytes) {
+                            LOG(Helper::LogLevel::LL_Error, "File %s read bytes, expected: %zu, acutal: %llu.\n", m_extraFullGraphFile.c_str(), totalBytes, numRead);
+                            throw std::runtime_error("File read mismatch");
+                        }
                         // decompress posting list
                         char* p_postingListFullData = buffer + listInfo->pageOffset;
                         if (m_enableDataCompression)
@@ -245,69 +310,43 @@ namespace SPTAG
                         }
 
                         ProcessPosting();
-                    };
-#else // async read
-                    request.m_callback = [&p_exWorkSpace, &request](bool success)
-                    {
-                        p_exWorkSpace->m_processIocp.push(&request);
-                    };
-
-                    ++unprocessed;
-                    if (!(indexFile->ReadFileAsync(request)))
-                    {
-                        LOG(Helper::LogLevel::LL_Error, "Failed to read file!\n");
-                        unprocessed--;
-                    }
 #endif
-#else // sync read
-                    auto numRead = indexFile->ReadBinary(totalBytes, buffer, listInfo->listOffset);
-                    if (numRead != totalBytes) {
-                        LOG(Helper::LogLevel::LL_Error, "File %s read bytes, expected: %zu, acutal: %llu.\n", m_extraFullGraphFile.c_str(), totalBytes, numRead);
-                        throw std::runtime_error("File read mismatch");
-                    }
-                    // decompress posting list
-                    char* p_postingListFullData = buffer + listInfo->pageOffset;
-                    if (m_enableDataCompression)
-                    {
-                        DecompressPosting();
                     }
 
-                    ProcessPosting();
-#endif
-                }
-
 #ifdef ASYNC_READ
 #ifdef BATCH_READ
-                BatchReadFileAsync(m_indexFiles, (p_exWorkSpace->m_diskRequests).data(), postingListCount);
+                    BatchReadFileAsync(m_indexFiles, (p_exWorkSpace->m_diskRequests).data() + waveStart, waveEnd - waveStart);
 #else
-                while (unprocessed > 0)
-                {
-                    Helper::AsyncReadRequest* request;
-                    if (!(p_exWorkSpace->m_processIocp.pop(request))) break;
-
-                    --unprocessed;
-                    char* buffer = request->m_buffer;
-                    ListInfo* listInfo = static_cast<ListInfo*>(request->m_payload);
-                    // decompress posting list
-                    char* p_postingListFullData = buffer + listInfo->pageOffset;
-                    if (m_enableDataCompression)
+                    while (unprocessed > 0)
                     {
-                        DecompressPosting();
-                    }
+                        Helper::AsyncReadRequest* request;
+                        if (!(p_exWorkSpace->m_processIocp.pop(request))) break;
 
-                    ProcessPosting();
-                }
+                        --unprocessed;
+                        char* buffer = request->m_buffer;
+                        ListInfo* listInfo = static_cast<ListInfo*>(request->m_payload);
+                        // decompress posting list
+                        char* p_postingListFullData = buffer + listInfo->pageOffset;
+                        if (m_enableDataCompression)
+                        {
+                            DecompressPosting();
+                        }
+
+                        ProcessPosting();
+                    }
 #endif
 #endif
+                }
+
                 if (truth) {
-                    for (uint32_t pi = 0; pi < postingListCount; ++pi)
+                    for (uint32_t pi = 0; pi < readCount; ++pi)
                     {
                         auto curPostingID = p_exWorkSpace->m_postingIDs[pi];
 
                         ListInfo* listInfo = &(m_listInfos[curPostingID]);
                         char* buffer = (char*)((p_exWorkSpace->m_pageBuffers[pi]).GetBuffer());
 
-                        char* p_postingListFullData = buffer + listInfo->pageOffset;
+                        char* p_postingListFullData = buffer + listInfo->pageOffset + listInfo->fastScanBytes;
                         if (m_enableDataCompression)
                         {
                             p_postingListFullData = (char*)p_exWorkSpace->m_decompressBuffer.GetBuffer();
@@ -336,6 +375,8 @@ namespace SPTAG
                     p_stats->m_totalListElementsCount = listElements;
                     p_stats->m_diskIOCount = diskIO;
                     p_stats->m_diskAccessCount = diskRead;
+                    p_stats->m_signCodeSkipCount = p_exWorkSpace->m_signCodeSkipCount;
+                    p_stats->m_fastScanSkipCount = p_exWorkSpace->m_fastScanSkipCount;
                 }
             }
 
@@ -346,7 +387,8 @@ namespace SPTAG
                 std::shared_ptr<VectorSet> p_fullVectors,
                 bool m_enableDeltaEncoding = false,
                 bool m_enablePostingListRearrange = false,
-                const ValueType *headVector = nullptr)
+                const ValueType *headVector = nullptr,
+                bool m_enableSignCode = false)
             {
                 std::string postingListFullData("");
                 std::string vectors("");
@@ -382,6 +424,14 @@ namespace SPTAG
                         vector.append(reinterpret_cast<char *>(p_vector), p_fullVectors->PerVectorDataSize());
                     }
 
+                    if (m_enableSignCode)
+                    {
+                        // sign code follows the vector so both layouts read it at the end of the vector part
+                        std::string code(COMMON::SignCode::CodeSize(p_fullVectors->Dimension()), '\0');
+                        COMMON::SignCode::Encode(p_vector, headVector, p_fullVectors->Dimension(), reinterpret_cast<std::uint8_t*>(&code[0]));
+                        vector += code;
+                    }
+
                     if (m_enablePostingListRearrange)
                     {
                         vectorIDs += vectorID;
@@ -437,6 +487,8 @@ namespace SPTAG
                     auto fullVectors = p_reader->GetVectorSet();
                     fullCount = fullVectors->Count();
                     vectorInfoSize = fullVectors->PerVectorDataSize() + sizeof(int);
+                    if (p_opt.m_enableSignCode) vectorInfoSize += COMMON::SignCode::CodeSize(fullVectors->Dimension());
+                    m_fastScanBlockSize = (p_opt.m_enableFastScan && p_headIndex->m_pQuantizer) ? COMMON::SIMDUtils::FastScanBlockSize(fullVectors->Dimension()) : 0;
                 }
                 if (upperBound > 0) fullCount = upperBound;
 
@@ -540,6 +592,8 @@ namespace SPTAG
                 if (p_opt.m_postingPageLimit > 0)
                 {
                     postingSizeLimit = static_cast<int>(p_opt.m_postingPageLimit * PageSize / vectorInfoSize);
+                    // the packed fast scan blocks share the posting's pages
+                    while (postingSizeLimit > 0 && postingSizeLimit * vectorInfoSize + FastScanBytes(postingSizeLimit) > static_cast<size_t>(p_opt.m_postingPageLimit) * PageSize) postingSizeLimit--;
                 }
 
                 LOG(Helper::LogLevel::LL_Info, "Posting size limit: %d\n", postingSizeLimit);
@@ -659,12 +713,12 @@ namespace SPTAG
                                     continue;
                                 }
                                 ValueType* headVector = nullptr;
-                                if (p_opt.m_enableDeltaEncoding)
+                                if (p_opt.m_enableDeltaEncoding || p_opt.m_enableSignCode)
                                 {
                                     headVector = (ValueType*)p_headIndex->GetSample(j);
                                 }
                                 std::string postingListFullData = GetPostingListFullData(
-                                    j, curPostingListSizes[j], selections, fullVectors, p_opt.m_enableDeltaEncoding, p_opt.m_enablePostingListRearrange, headVector);
+                                    j, curPostingListSizes[j], selections, fullVectors, p_opt.m_enableDeltaEncoding, p_opt.m_enablePostingListRearrange, headVector, p_opt.m_enableSignCode);
 
                                 samplesBuffer += postingListFullData;
                                 samplesSizes.push_back(postingListFullData.size());
@@ -688,12 +742,12 @@ namespace SPTAG
                                 continue;
                             }
                             ValueType* headVector = nullptr;
-                            if (p_opt.m_enableDeltaEncoding)
+                            if (p_opt.m_enableDeltaEncoding || p_opt.m_enableSignCode)
                             {
                                 headVector = (ValueType*)p_headIndex->GetSample(postingListId);
                             }
                             std::string postingListFullData = GetPostingListFullData(
-                                postingListId, postingListSize[postingListId], selections, fullVectors, p_opt.m_enableDeltaEncoding, p_opt.m_enablePostingListRearrange, headVector);
+                                postingListId, postingListSize[postingListId], selections, fullVectors, p_opt.m_enableDeltaEncoding, p_opt.m_enablePostingListRearrange, headVector, p_opt.m_enableSignCode);
                             size_t sizeToCompress = postingListSize[postingListId] * vectorInfoSize;
                             if (sizeToCompress != postingListFullData.size()) {
                                 LOG(Helper::LogLevel::LL_Error, "Size to compress NOT MATCH! PostingListFullData size: %zu sizeToCompress: %zu \n", postingListFullData.size(), sizeToCompress);
@@ -710,7 +764,7 @@ namespace SPTAG
                     else {
                         for (int j = 0; j < curPostingListSizes.size(); j++)
                         {
-                            curPostingListBytes[j] = curPostingListSizes[j] * vectorInfoSize;
+                            curPostingListBytes[j] = curPostingListSizes[j] * vectorInfoSize + FastScanBytes(curPostingListSizes[j]);
                         }
                     }
 
@@ -724,6 +778,7 @@ namespace SPTAG
                         p_opt.m_enablePostingListRearrange,
                         p_opt.m_enableDataCompression,
                         p_opt.m_enableDictTraining,
+                        p_opt.m_enableSignCode,
                         vectorInfoSize,
                         curPostingListSizes,
                         curPostingListBytes,
@@ -760,6 +815,9 @@ namespace SPTAG
                 std::uint64_t listOffset = 0;
 
                 std::uint16_t pageOffset = 0;
+
+                // Packed fast scan blocks of all the entries written, stored ahead of the entries
+                std::size_t fastScanBytes = 0;
             };
 
             int LoadingHeadInfo(const std::string& p_file, int p_postingPageLimit, std::vector<ListInfo>& m_listInfos)
@@ -792,8 +850,9 @@ namespace SPTAG
                     throw std::runtime_error("Failed read file in LoadingHeadInfo");
                 }
 
-                if (m_vectorInfoSize == 0) m_vectorInfoSize = m_iDataDimension * sizeof(ValueType) + sizeof(int);
-                else if (m_vectorInfoSize != m_iDataDimension * sizeof(ValueType) + sizeof(int)) {
+                m_fastScanBlockSize = m_enableFastScan ? COMMON::SIMDUtils::FastScanBlockSize(m_iDataDimension) : 0;
+                if (m_vectorInfoSize == 0) m_vectorInfoSize = m_iDataDimension * sizeof(ValueType) + sizeof(int) + m_signCodeSize;
+                else if (m_vectorInfoSize != m_iDataDimension * sizeof(ValueType) + sizeof(int) + m_signCodeSize) {
                     LOG(Helper::LogLevel::LL_Error, "Failed to read head info file! DataDimension and ValueType are not match!\n");
                     throw std::runtime_error("DataDimension and ValueType don't match in LoadingHeadInfo");
                 }
@@ -838,9 +897,11 @@ namespace SPTAG
                     listInfo->listOffset = (static_cast<uint64_t>(m_listPageOffset + pageNum) << PageSizeEx);
                     if (!m_enableDataCompression)
                     {
-                        listInfo->listTotalBytes = listInfo->listEleCount * m_vectorInfoSize;
-                        listInfo->listEleCount = min(listInfo->listEleCount, (min(static_cast<int>(listInfo->listPageCount), p_postingPageLimit) << PageSizeEx) / m_vectorInfoSize);
-                        listInfo->listPageCount = static_cast<std::uint16_t>(ceil((m_vectorInfoSize * listInfo->listEleCount + listInfo->pageOffset) * 1.0 / (1 << PageSizeEx)));
+                        listInfo->fastScanBytes = FastScanBytes(listInfo->listEleCount);
+                        listInfo->listTotalBytes = listInfo->listEleCount * m_vectorInfoSize + listInfo->fastScanBytes;
+                        int limitBytes = (min(static_cast<int>(listInfo->listPageCount), p_postingPageLimit) << PageSizeEx) - static_cast<int>(listInfo->fastScanBytes);
+                        listInfo->listEleCount = min(listInfo->listEleCount, (std::max)(limitBytes, 0) / m_vectorInfoSize);
+                        listInfo->listPageCount = static_cast<std::uint16_t>(ceil((listInfo->fastScanBytes + m_vectorInfoSize * listInfo->listEleCount + listInfo->pageOffset) * 1.0 / (1 << PageSizeEx)));
                     }
                     totalListElementCount += listInfo->listEleCount;
                     int pageCount = listInfo->listPageCount;
@@ -925,6 +986,83 @@ namespace SPTAG
 
             inline void ParseEncoding(std::shared_ptr<VectorIndex>& p_index, ListInfo* p_info, ValueType* vector) { }
 
+            // Hamming distances of the posting entries to the query sign code and the threshold above which
+            // entries skip the full distance. Returns false, leaving the distances unset, when nothing is to be
+            // skipped: sign codes off or the result set not yet full.
+            bool SignCodeThreshold(ExtraWorkSpace* p_exWorkSpace, COMMON::QueryResultSet<ValueType>& p_queryResults, std::shared_ptr<VectorIndex>& p_index, ListInfo* p_info, char* p_postingListFullData, int& p_threshold)
+            {
+                if (m_signCodeSize == 0 || p_queryResults.worstDist() == MaxDist || m_signCodeKeepRatio >= 1.0f) return false;
+
+                auto& dists = p_exWorkSpace->m_signDists;
+                int count = p_info->listEleCount;
+                if (dists.size() < (size_t)count) dists.resize(count);
+
+                auto& queryCode = p_exWorkSpace->m_signCode;
+                queryCode.resize(m_signCodeSize);
+                ValueType* headVector = (ValueType*)p_index->GetSample((SizeType)(p_info - m_listInfos.data()));
+                COMMON::SignCode::Encode((const ValueType*)p_queryResults.GetQuantizedTarget(), headVector, m_iDataDimension, queryCode.data());
+                uint64_t codeOffset = m_vectorInfoSize - sizeof(int) - m_signCodeSize;
+                for (int i = 0; i < count; i++) {
+                    uint64_t offsetVectorID, offsetVector;
+                    (this->*m_parsePosting)(offsetVectorID, offsetVector, i, count);
+                    dists[i] = COMMON::SignCode::Hamming(queryCode.data(), (const std::uint8_t*)(p_postingListFullData + offsetVector + codeOffset), m_signCodeSize);
+                }
+                p_exWorkSpace->m_signScratch.assign(dists.begin(), dists.begin() + count);
+                p_threshold = COMMON::SignCode::Threshold(p_exWorkSpace->m_signScratch, count, m_signCodeKeepRatio);
+                return true;
+            }
+
+            // Builds the per query fast scan table when the postings carry packed 4-bit PQ blocks, scale 0 disables the prefilter.
+            void PrepareFastScan(ExtraWorkSpace* p_exWorkSpace, COMMON::QueryResultSet<ValueType>& p_queryResults, std::shared_ptr<VectorIndex>& p_index)
+            {
+                p_exWorkSpace->m_fastScanScale = 0;
+                auto& quantizer = p_index->m_pQuantizer;
+                if (m_fastScanBlockSize == 0 || quantizer == nullptr || !quantizer->GetEnableFastScan() ||
+                    p_index->GetDistCalcMethod() != DistCalcMethod::L2) return;
+
+                p_exWorkSpace->m_fastScanTable.resize(quantizer->FastScanTableSize());
+                quantizer->ComputeFastScanTableFromTarget((const std::uint8_t*)p_queryResults.GetQuantizedTarget(), p_exWorkSpace->m_fastScanTable.data(),
+                    p_exWorkSpace->m_fastScanScale, p_exWorkSpace->m_fastScanBias);
+            }
+
+            // Fast scan distances of the posting entries, returns the bound above which an entry cannot enter the
+            // results, MaxDist when nothing can be skipped yet. Each table entry rounds by at most 0.5 / scale, so
+            // the bound carries that slack per subvector and no entry of the exact top k is ever skipped.
+            // The blocks are scored in place, as written ahead of the entries by the build.
+            float FastScanBounds(ExtraWorkSpace* p_exWorkSpace, COMMON::QueryResultSet<ValueType>& p_queryResults, std::shared_ptr<VectorIndex>& p_index, ListInfo* p_info, const std::uint8_t* p_blocks)
+            {
+                float scale = p_exWorkSpace->m_fastScanScale;
+                if (scale <= 0 || p_info->fastScanBytes == 0) return MaxDist;
+                float worst = (p_exWorkSpace->m_rangeResults != nullptr) ? p_exWorkSpace->m_rangeRadius : p_queryResults.worstDist();
+                if (worst == MaxDist) return MaxDist;
+
+                auto& quantizer = p_index->m_pQuantizer;
+                int count = p_info->listEleCount;
+                auto& dists = p_exWorkSpace->m_fastScanDists;
+                if (dists.size() < (size_t)count) dists.resize(count);
+                quantizer->FastScanDistances(p_blocks, count, p_exWorkSpace->m_fastScanTable.data(), scale, p_exWorkSpace->m_fastScanBias, dists.data());
+                return worst + (quantizer->GetNumSubvectors() * 0.5f + 1.0f) / scale;
+            }
+
+            inline size_t FastScanBytes(int p_count) const
+            {
+                return (size_t)((p_count + COMMON::SIMDUtils::FastScanBatch - 1) / COMMON::SIMDUtils::FastScanBatch) * m_fastScanBlockSize;
+            }
+
+            // Codes of a posting's entries packed into fast scan blocks of FastScanBatch entries each
+            std::string GetPostingFastScanBlocks(const std::string& p_postingListFullData, int p_count, size_t p_spacePerVector, bool p_rearrange, COMMON::IQuantizer* p_quantizer)
+            {
+                size_t codeSize = p_spacePerVector - sizeof(int);
+                std::vector<std::uint8_t> codes((size_t)p_count * codeSize);
+                for (int i = 0; i < p_count; i++) {
+                    size_t offset = p_rearrange ? codeSize * i : p_spacePerVector * i + sizeof(int);
+                    memcpy(codes.data() + codeSize * i, p_postingListFullData.data() + offset, codeSize);
+                }
+                std::string blocks(FastScanBytes(p_count), '\0');
+                p_quantizer->PackFastScanCodes(codes.data(), p_count, reinterpret_cast<std::uint8_t*>(&blocks[0]));
+                return blocks;
+            }
+
             void SelectPostingOffset(
                 const std::vector<size_t>& p_postingListBytes,
                 std::unique_ptr<int[]>& p_postPageNum,
@@ -1016,6 +1154,7 @@ namespace SPTAG
                 bool m_enablePostingListRearrange,
                 bool m_enableDataCompression,
                 bool m_enableDictTraining,
+                bool m_enableSignCode,
                 size_t p_spacePerVector,
                 const std::vector<int>& p_postingListSizes,
                 const std::vector<size_t>& p_postingListBytes,
@@ -1223,12 +1362,12 @@ namespace SPTAG
                     int postingListId = id + (int)p_postingListOffset;
                     // get posting list full content and write it at once
                     ValueType *headVector = nullptr;
-                    if (m_enableDeltaEncoding)
+                    if (m_enableDeltaEncoding || m_enableSignCode)
                     {
                         headVector = (ValueType *)p_headIndex->GetSample(postingListId);
                     }
                     std::string postingListFullData = GetPostingListFullData(
-                        postingListId, p_postingListSizes[id], p_postingSelections, p_fullVectors, m_enableDeltaEncoding, m_enablePostingListRearrange, headVector);
+                        postingListId, p_postingListSizes[id], p_postingSelections, p_fullVectors, m_enableDeltaEncoding, m_enablePostingListRearrange, headVector, m_enableSignCode);
                     size_t postingListFullSize = p_postingListSizes[id] * p_spacePerVector;
                     if (postingListFullSize != postingListFullData.size())
                     {
@@ -1253,6 +1392,16 @@ namespace SPTAG
                     }
                     else
                     {
+                        if (m_fastScanBlockSize > 0)
+                        {
+                            std::string blocks = GetPostingFastScanBlocks(postingListFullData, p_postingListSizes[id], p_spacePerVector, m_enablePostingListRearrange, p_headIndex->m_pQuantizer.get());
+                            if (ptr->WriteBinary(blocks.size(), blocks.data()) != blocks.size())
+                            {
+                                LOG(Helper::LogLevel::LL_Error, "Failed to write SSDIndex File!");
+                                throw std::runtime_error("Failed to write SSDIndex File");
+                            }
+                            listOffset += blocks.size();
+                        }
                         if (ptr->WriteBinary(postingListFullSize, postingListFullData.data()) != postingListFullSize)
                         {
                             LOG(Helper::LogLevel::LL_Error, "Failed to write SSDIndex File!");
@@ -1289,7 +1438,7 @@ namespace SPTAG
                 LOG(Helper::LogLevel::LL_Info, "Time to write results:%.2lf sec.\n", ((double)std::chrono::duration_cast<std::chrono::seconds>(t2 - t1).count()) + ((double)std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count()) / 1000);
             }
 
-            void GetWritePosting(SizeType pid, std::string& posting, bool write = false) override {
+            void GetWritePosting(SizeType pid, std::string& posting, bool write = false, VectorIndex* p_headIndex = nullptr) override {
                 if (write) {
                     LOG(Helper::LogLevel::LL_Error, "Unsupport write\n");
                     exit(1);
@@ -1306,7 +1455,7 @@ namespace SPTAG
                     throw std::runtime_error("File read mismatch");
                 }
                 char* ptr = (char*)(posting.c_str());
-                memcpy(ptr, posting.c_str() + listInfo->pageOffset, realBytes);
+                memcpy(ptr, posting.c_str() + listInfo->pageOffset + listInfo->fastScanBytes, realBytes);
                 posting.resize(realBytes);
             }
 
@@ -1323,6 +1472,12 @@ namespace SPTAG
             bool m_enablePostingListRearrange;
             bool m_enableDataCompression;
             bool m_enableDictTraining;
+            int m_signCodeSize;
+            float m_signCodeKeepRatio;
+            int m_deadlinePostingBatch = 8;
+            bool m_enableFastScan;
+            // Bytes of one packed fast scan block, 0 when the postings carry none
+            int m_fastScanBlockSize = 0;
 
             void (ExtraStaticSearcher<ValueType>::*m_parsePosting)(uint64_t&, uint64_t&, int, int);
             void (ExtraStaticSearcher<ValueType>::*m_parseEncoding)(std::shared_ptr<VectorIndex>&, ListInfo*, ValueType*);
@@ -0,0 +1,113 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_SPANN_HEADREPLICAS_H_
+#define _SPTAG_SPANN_HEADREPLICAS_H_
+
+#include "inc/Core/VectorIndex.h"
+#include "inc/Helper/AsyncFileReader.h"
+
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SPTAG
+{
+    namespace SPANN
+    {
+        // Copies of the head index, one per NUMA node, so that head searches walk trees, graph and samples in
+        // local memory. The primary stays on the node that loaded it and serves everything but head searches.
+        // Heads added or deleted by splits go to the primary and then to every replica in the same order, so
+        // a head has the same id in all copies; the graph links of a new head are searched in each copy.
+        class HeadReplicas
+        {
+        private:
+            std::shared_ptr<VectorIndex> m_primary;
+            // Indexed by node, the primary at its own node
+            std::vector<std::shared_ptr<VectorIndex>> m_replicas;
+            std::mutex m_addLock;
+
+        public:
+            // Loads a copy for every other node with p_load, on a thread bound to that node so that its pages
+            // are allocated there. Nodes whose copy fails to load or differs from the primary use the primary.
+            ErrorCode Build(std::shared_ptr<VectorIndex> p_primary, int p_primaryNode,
+                const std::function<ErrorCode(std::shared_ptr<VectorIndex>&)>& p_load)
+            {
+                int nodes = Helper::GetNumaNodeCount();
+                m_primary = p_primary;
+                m_replicas.assign(nodes, p_primary);
+                if (nodes <= 1) return ErrorCode::Success;
+
+                std::vector<std::thread> threads;
+                for (int node = 0; node < nodes; node++) {
+                    if (node == p_primaryNode) continue;
+                    threads.emplace_back([&, node]() {
+                        if (!Helper::BindThreadToNumaNode(node)) {
+                            LOG(Helper::LogLevel::LL_Warning, "Cannot bind to node %d, its head replica is not placed.\n", node);
+                        }
+                        std::shared_ptr<VectorIndex> replica;
+                        if (p_load(replica) != ErrorCode::Success || replica == nullptr ||
+                            replica->GetNumSamples() != p_primary->GetNumSamples()) {
+                            LOG(Helper::LogLevel::LL_Error, "Failed to load the head replica for node %d!\n", node);
+                            return;
+                        }
+                        m_replicas[node] = replica;
+                    });
+                }
+                for (auto& thread : threads) thread.join();
+
+                int loaded = 0;
+                for (auto& replica : m_replicas) if (replica != p_primary) loaded++;
+                LOG(Helper::LogLevel::LL_Info, "Head index replicated on %d of %d NUMA nodes.\n", loaded + 1, nodes);
+                return (loaded + 1 == nodes) ? ErrorCode::Success : ErrorCode::Fail;
+            }
+
+            inline bool Mirrors(const VectorIndex* p_index) const { return m_primary.get() == p_index; }
+
+            // The copy on the node of the calling thread
+            inline const std::shared_ptr<VectorIndex>& Local() const
+            {
+                if (m_replicas.size() <= 1) return m_primary;
+                return m_replicas[Helper::GetCurrentNumaNode() % m_replicas.size()];
+            }
+
+            ErrorCode AddHead(const void* p_vector, DimensionType p_dimension, int& p_begin, int& p_end)
+            {
+                std::lock_guard<std::mutex> lock(m_addLock);
+                ErrorCode ret = m_primary->AddIndexId(p_vector, 1, p_dimension, p_begin, p_end);
+                if (ret != ErrorCode::Success) return ret;
+                for (auto& replica : m_replicas) {
+                    if (replica == m_primary) continue;
+                    int begin, end;
+                    if ((ret = replica->AddIndexId(p_vector, 1, p_dimension, begin, end)) != ErrorCode::Success) return ret;
+                    if (begin != p_begin) {
+                        LOG(Helper::LogLevel::LL_Error, "Head replica added head %d instead of %d!\n", begin, p_begin);
+                        return ErrorCode::Fail;
+                    }
+                }
+                return ErrorCode::Success;
+            }
+
+            ErrorCode LinkHeads(SizeType p_begin, SizeType p_end)
+            {
+                ErrorCode ret = m_primary->AddIndexIdx(p_begin, p_end);
+                for (auto& replica : m_replicas) {
+                    if (replica != m_primary) replica->AddIndexIdx(p_begin, p_end);
+                }
+                return ret;
+            }
+
+            ErrorCode DeleteHead(SizeType p_id)
+            {
+                ErrorCode ret = m_primary->DeleteIndex(p_id);
+                for (auto& replica : m_replicas) {
+                    if (replica != m_primary) replica->DeleteIndex(p_id);
+                }
+                return ret;
+            }
+        };
+    }
+}
+
+#endif // _SPTAG_SPANN_HEADREPLICAS_H_
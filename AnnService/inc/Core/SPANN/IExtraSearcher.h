@@ -5,9 +5,12 @@
 #define _SPTAG_SPANN_IEXTRASEARCHER_H_
 
 #include "Options.h"
+#include "AdmissionController.h"
 
 #include "inc/Core/VectorIndex.h"
 #include "inc/Core/Common/VersionLabel.h"
+#include "inc/Core/Common/AttributeTable.h"
+#include "inc/Core/Common/TopKBuffer.h"
 #include "inc/Helper/AsyncFileReader.h"
 
 #include <memory>
@@ -34,7 +37,13 @@ namespace SPTAG {
                 m_asyncLatency1(0),
                 m_asyncLatency2(0),
                 m_queueLatency(0),
-                m_sleepLatency(0)
+                m_sleepLatency(0),
+                m_signCodeSkipCount(0),
+                m_fastScanSkipCount(0),
+                m_cacheHit(false),
+                m_degraded(false),
+                m_skippedPostingCount(0),
+                m_deadline(std::chrono::steady_clock::time_point::max())
             {
             }
 
@@ -70,11 +79,65 @@ namespace SPTAG {
 
             double m_exSetUpLatency;
 
+            int m_signCodeSkipCount;
+
+            int m_fastScanSkipCount;
+
+            bool m_cacheHit;
+
+            // Set when the deadline cut the head search short or left postings unread; the results are
+            // the best found within the budget.
+            bool m_degraded;
+
+            int m_skippedPostingCount;
+
+            // End-to-end deadline of the query, time_point::max() when unbounded
+            std::chrono::steady_clock::time_point m_deadline;
+
             std::chrono::steady_clock::time_point m_searchRequestTime;
 
             int m_threadID;
         };
 
+        // Counts in power of two buckets of microseconds, enough for percentiles of rare but costly operations
+        struct LatencyHistogram {
+            static const int c_buckets = 40;
+            std::atomic<std::uint64_t> m_counts[c_buckets];
+            std::atomic<std::uint64_t> m_max{ 0 };
+
+            LatencyHistogram() { Reset(); }
+
+            void Record(double p_us) {
+                int bucket = 0;
+                while (bucket < c_buckets - 1 && p_us >= (double)(1ULL << bucket)) bucket++;
+                m_counts[bucket]++;
+                std::uint64_t us = (std::uint64_t)p_us, max = m_max.load();
+                while (us > max && !m_max.compare_exchange_weak(max, us)) {}
+            }
+
+            std::uint64_t Count() const {
+                std::uint64_t count = 0;
+                for (int i = 0; i < c_buckets; i++) count += m_counts[i].load();
+                return count;
+            }
+
+            // Upper bound of the bucket holding the p_ratio quantile
+            double Percentile(double p_ratio) const {
+                std::uint64_t total = Count(), seen = 0;
+                if (total == 0) return 0;
+                for (int i = 0; i < c_buckets; i++) {
+                    seen += m_counts[i].load();
+                    if (seen >= p_ratio * total) return (std::min)((double)(1ULL << i), (double)m_max.load());
+                }
+                return (double)m_max.load();
+            }
+
+            void Reset() {
+                for (int i = 0; i < c_buckets; i++) m_counts[i] = 0;
+                m_max = 0;
+            }
+        };
+
         struct IndexStats {
             std::atomic_uint32_t m_headMiss{ 0 };
             uint32_t m_appendTaskNum{ 0 };
@@ -93,6 +156,9 @@ namespace SPTAG {
             double m_updateHeadCost{ 0 };
             double m_reassignScanCost{ 0 };
             double m_reassignScanIOCost{ 0 };
+            LatencyHistogram m_splitLatency;
+            // Time a split holds the posting lock
+            LatencyHistogram m_splitLockLatency;
 
             // Append
             double m_appendCost{ 0 };
@@ -105,10 +171,16 @@ namespace SPTAG {
 
             // GC
             double m_garbageCost{ 0 };
+            // Postings rewritten by the background GC and the bytes it freed
+            std::atomic_uint32_t m_gcRewriteNum{ 0 };
+            std::atomic_uint64_t m_gcBytesReclaimed{ 0 };
 
             void PrintStat(int finishedInsert, bool cost = false, bool reset = false) {
                 LOG(Helper::LogLevel::LL_Info, "After %d insertion, head vectors split %d times, head missing %d times, same head %d times, reassign %d times, reassign scan %ld times, garbage collection %d times, merge %d times\n",
                     finishedInsert, m_splitNum, m_headMiss.load(), m_theSameHeadNum, m_reAssignNum, m_reAssignScanNum, m_garbageNum, m_mergeNum);
+                if (m_gcRewriteNum.load() > 0) {
+                    LOG(Helper::LogLevel::LL_Info, "Background GC rewrote %u postings, reclaimed %llu bytes\n", m_gcRewriteNum.load(), (unsigned long long)m_gcBytesReclaimed.load());
+                }
 
                 if (cost) {
                     LOG(Helper::LogLevel::LL_Info, "AppendTaskNum: %d, TotalCost: %.3lf us, PerCost: %.3lf us\n", m_appendTaskNum, m_appendCost, m_appendCost / m_appendTaskNum);
@@ -120,6 +192,9 @@ namespace SPTAG {
                     LOG(Helper::LogLevel::LL_Info, "SplitNum: %d, Write TotalCost: %.3lf us, PerCost: %.3lf us\n", m_splitNum, m_putCost, m_putCost / m_splitNum);
                     LOG(Helper::LogLevel::LL_Info, "SplitNum: %d, ReassignScan TotalCost: %.3lf ms, PerCost: %.3lf ms\n", m_splitNum, m_reassignScanCost, m_reassignScanCost / m_splitNum);
                     LOG(Helper::LogLevel::LL_Info, "SplitNum: %d, ReassignScanIO TotalCost: %.3lf us, PerCost: %.3lf us\n", m_splitNum, m_reassignScanIOCost, m_reassignScanIOCost / m_splitNum);
+                    LOG(Helper::LogLevel::LL_Info, "Split latency p50: %.0lf us, p90: %.0lf us, p99: %.0lf us, max: %.0lf us; lock held p50: %.0lf us, p99: %.0lf us, max: %.0lf us\n",
+                        m_splitLatency.Percentile(0.5), m_splitLatency.Percentile(0.9), m_splitLatency.Percentile(0.99), m_splitLatency.Percentile(1.0),
+                        m_splitLockLatency.Percentile(0.5), m_splitLockLatency.Percentile(0.99), m_splitLockLatency.Percentile(1.0));
                     LOG(Helper::LogLevel::LL_Info, "GCNum: %d, TotalCost: %.3lf us, PerCost: %.3lf us\n", m_garbageNum, m_garbageCost, m_garbageCost / m_garbageNum);
                     LOG(Helper::LogLevel::LL_Info, "ReassignNum: %d, TotalCost: %.3lf us, PerCost: %.3lf us\n", m_reAssignNum, m_reAssignCost, m_reAssignCost / m_reAssignNum);
                     LOG(Helper::LogLevel::LL_Info, "ReassignNum: %d, Select TotalCost: %.3lf us, PerCost: %.3lf us\n", m_reAssignNum, m_selectCost, m_selectCost / m_reAssignNum);
@@ -138,6 +213,8 @@ namespace SPTAG {
                     m_splitCost = 0;
                     m_clusteringCost = 0;
                     m_garbageCost = 0;
+                    m_gcRewriteNum = 0;
+                    m_gcBytesReclaimed = 0;
                     m_updateHeadCost = 0;
                     m_getCost = 0;
                     m_putCost = 0;
@@ -148,6 +225,8 @@ namespace SPTAG {
                     m_reAssignCost = 0;
                     m_selectCost = 0;
                     m_reAssignAppendCost = 0;
+                    m_splitLatency.Reset();
+                    m_splitLockLatency.Reset();
                 }
             }
         };
@@ -193,8 +272,6 @@ namespace SPTAG {
         {
             ExtraWorkSpace() {}
 
-            ~ExtraWorkSpace() { g_spaceCount--; }
-
             ExtraWorkSpace(ExtraWorkSpace& other) {
                 Initialize(other.m_deduper.MaxCheck(), other.m_deduper.HashTableExponent(), (int)other.m_pageBuffers.size(), (int)(other.m_pageBuffers[0].GetPageSize()), other.m_enableDataCompression);
             }
@@ -215,7 +292,6 @@ namespace SPTAG {
                 if (enableDataCompression) {
                     m_decompressBuffer.ReservePageBuffer(p_maxPages);
                 }
-                m_spaceID = g_spaceCount++;
             }
 
             void Initialize(va_list& arg) {
@@ -227,7 +303,7 @@ namespace SPTAG {
                 Initialize(maxCheck, hashExp, internalResultNum, maxPages, enableDataCompression);
             }
 
-            static void Reset() { g_spaceCount = 0; }
+            static void Reset() {}
 
             std::vector<int> m_postingIDs;
 
@@ -242,11 +318,54 @@ namespace SPTAG {
 
             std::vector<Helper::AsyncReadRequest> m_diskRequests;
 
-            int m_spaceID;
+            // Sign code prefilter: query code per posting, Hamming distance per entry and selection scratch
+            std::vector<std::uint8_t> m_signCode;
+            std::vector<int> m_signDists;
+            std::vector<int> m_signScratch;
+            int m_signCodeSkipCount = 0;
+
+            // Fast scan prefilter on quantized postings: per query uint8 table and lower bounds of the
+            // entry distances of the current posting
+            std::vector<std::uint8_t> m_fastScanTable;
+            std::vector<float> m_fastScanDists;
+            float m_fastScanScale = 0;
+            float m_fastScanBias = 0;
+            int m_fastScanSkipCount = 0;
+
+            // Residual quantized postings: query table against the current posting head
+            std::vector<float> m_residualTable;
+
+            // VIDs of the current posting and their not-deleted mask from VersionLabel::FilterDeleted
+            std::vector<SizeType> m_postingVIDs;
+            std::vector<std::uint8_t> m_aliveMask;
+
+            // Attribute filter of the current query, evaluated on posting entries before any distance
+            const COMMON::AttributeFilter* m_filter = nullptr;
+            const COMMON::AttributeTable* m_attributes = nullptr;
+
+            // Candidates of the current posting scan, merged into the query result set after each posting
+            COMMON::TopKBuffer m_topK;
+
+            // Range search: when set, scanned entries within m_rangeRadius are appended here instead of
+            // entering the top-k result set
+            std::vector<BasicResult>* m_rangeResults = nullptr;
+            float m_rangeRadius = 0;
+            int m_rangeMaxResults = 0;
+
+            // Returns false for a top-k query so the caller adds the point to its result set instead.
+            inline bool AddRangePoint(SizeType p_vid, float p_dist)
+            {
+                if (m_rangeResults == nullptr) return false;
+                if (p_dist <= m_rangeRadius && (int)m_rangeResults->size() < m_rangeMaxResults) m_rangeResults->emplace_back(p_vid, p_dist);
+                return true;
+            }
 
-            static std::atomic_int g_spaceCount;
+            // AIO channel of the searcher's file handlers, fixed to the pool slot that owns this workspace
+            int m_spaceID = 0;
         };
 
+        class HeadReplicas;
+
         class IExtraSearcher
         {
         public:
@@ -278,20 +397,30 @@ namespace SPTAG {
             virtual bool AllFinished() { return false; }
             virtual void GetDBStats() { return; }
             virtual void GetIndexStats(int finishedInsert, bool cost, bool reset) { return; }
+            virtual AdmissionState GetAdmissionState() { return AdmissionState(); }
             virtual void ForceCompaction() { return; }
 
             virtual bool CheckValidPosting(SizeType postingID) = 0;
+            // Entries of a posting as recorded by an updatable searcher, 0 when not tracked.
+            virtual int GetPostingSize(SizeType postingID) { return 0; }
+            // Bytes freed so far by the background GC of an updatable searcher.
+            virtual std::uint64_t GetGCBytesReclaimed() { return 0; }
+            // Upper bound of the distance from a head to any vector in its posting, MaxDist when not tracked.
+            virtual float GetPostingRadius(SizeType postingID) { return MaxDist; }
             virtual SizeType SearchVector(std::shared_ptr<VectorSet>& p_vectorSet,
                 std::shared_ptr<VectorIndex> p_index, int testNum = 64, SizeType VID = -1) { return -1; }
             virtual void ForceGC(VectorIndex* p_index) { return; }
 
-            virtual void GetWritePosting(SizeType pid, std::string& posting, bool write = false) { return; }
+            virtual void GetWritePosting(SizeType pid, std::string& posting, bool write = false, VectorIndex* p_headIndex = nullptr) { return; }
 
             virtual bool Initialize() { return false; }
 
             virtual bool ExitBlockController() { return false; }
 
             virtual void InitPostingRecord(std::shared_ptr<VectorIndex> p_index) { return; }
+
+            // Head changes made through the primary head index are mirrored to these replicas
+            virtual void SetHeadReplicas(std::shared_ptr<HeadReplicas> p_replicas) { return; }
         };
     } // SPANN
 } // SPTAG
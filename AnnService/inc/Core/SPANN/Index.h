@@ -21,8 +21,14 @@
 #include "inc/Helper/ConcurrentSet.h"
 #include "inc/Helper/VectorSetReader.h"
 #include "inc/Core/Common/IQuantizer.h"
+#include "inc/Core/Common/SignCode.h"
+#include "inc/Core/Common/ResidualCode.h"
+#include "inc/Core/Common/QueryCache.h"
+#include "inc/Core/Common/VectorTier.h"
 
 #include "IExtraSearcher.h"
+#include "HeadReplicas.h"
+#include "InsertQueue.h"
 #include "Options.h"
 
 #include <functional>
@@ -55,9 +61,30 @@ namespace SPTAG
 
             std::mutex m_dataAddLock;
             COMMON::VersionLabel m_versionMap;
+            COMMON::AttributeTable m_attributes;
 
-        public:
-            static thread_local std::shared_ptr<ExtraWorkSpace> m_workspace;
+            // Bumped after every update so that cached query results from before it are never returned
+            std::atomic<std::uint64_t> m_updateEpoch{ 0 };
+            mutable COMMON::QueryCache<T> m_queryCache;
+            mutable std::once_flag m_queryCacheInit;
+
+            // Running estimate (us) of a head search at full MaxCheck, used to size it against a deadline
+            mutable std::atomic<float> m_headSearchCost{ 0 };
+            // Queries cut short by their deadline, for callers that search without SearchStats
+            mutable std::atomic<std::uint64_t> m_degradedQueryCount{ 0 };
+
+            // Posting scan workspaces borrowed per query, built on first use
+            mutable COMMON::BoundedWorkSpacePool<ExtraWorkSpace> m_workSpacePool;
+            mutable std::once_flag m_workSpacePoolInit;
+
+            // Full precision heads for reranking the head candidates of a quantized head index
+            COMMON::VectorTier<T> m_headRerankVectors;
+
+            // Per NUMA node copies of m_index for head searches, null unless NumaHeadReplicas is set
+            std::shared_ptr<HeadReplicas> m_headReplicas;
+
+            // Serves AddIndexAsync, started on its first call
+            InsertQueue m_insertQueue;
 
         public:
             Index()
@@ -66,9 +93,11 @@ namespace SPTAG
                 m_iBaseSquare = (m_options.m_distCalcMethod == DistCalcMethod::Cosine) ? COMMON::Utils::GetBase<T>() * COMMON::Utils::GetBase<T>() : 1;
             }
 
-            ~Index() {}
+            ~Index() { m_insertQueue.Stop(); }
 
             inline std::shared_ptr<VectorIndex> GetMemoryIndex() { return m_index; }
+            // The head index copy on the NUMA node of the calling thread, for searches only
+            inline const std::shared_ptr<VectorIndex>& GetLocalMemoryIndex() const { return m_headReplicas ? m_headReplicas->Local() : m_index; }
             inline std::shared_ptr<IExtraSearcher> GetDiskIndex() { return m_extraSearcher; }
             inline Options* GetOptions() { return &m_options; }
 
@@ -125,7 +154,14 @@ namespace SPTAG
             ErrorCode BuildIndex(const void* p_data, SizeType p_vectorNum, DimensionType p_dimension, bool p_normalized = false, bool p_shareOwnership = false);
             ErrorCode BuildIndex(bool p_normalized = false);
             ErrorCode SearchIndex(QueryResult &p_query, bool p_searchDeleted = false) const;
+            // SearchIndex that reports back through p_stats, including whether the query hit the cache or was
+            // cut short by its deadline (m_degraded). A deadline already set in p_stats is used instead of QueryDeadline.
+            ErrorCode SearchIndexWithStats(QueryResult& p_query, SearchStats& p_stats) const;
+            ErrorCode SearchHeadIndex(QueryResult& p_query, SearchStats* p_stats = nullptr) const;
             ErrorCode SearchDiskIndex(QueryResult& p_query, SearchStats* p_stats = nullptr) const;
+            // Search restricted to vectors whose attributes match p_filter; p_stats works as in SearchIndexWithStats.
+            ErrorCode SearchIndexWithFilter(QueryResult& p_query, const COMMON::AttributeFilter& p_filter, SearchStats* p_stats = nullptr) const;
+            ErrorCode RangeSearch(const void* p_vector, float p_radius, int p_maxResults, std::vector<BasicResult>& p_results) const;
             ErrorCode DebugSearchDiskIndex(QueryResult& p_query, int p_subInternalResultNum, int p_internalResultNum,
                 SearchStats* p_stats = nullptr, std::set<int>* truth = nullptr, std::map<int, std::set<int>>* found = nullptr) const;
             ErrorCode UpdateIndex();
@@ -135,10 +171,30 @@ namespace SPTAG
 
             inline const void* GetSample(const SizeType idx) const { return nullptr; }
             inline SizeType GetNumDeleted() const { return m_versionMap.GetDeleteCount(); }
+            inline const COMMON::AttributeTable& GetAttributes() const { return m_attributes; }
+            ErrorCode SetAttributes(SizeType p_begin, SizeType p_num, DimensionType p_columns, const std::int32_t* p_values);
+            inline std::uint64_t GetUpdateEpoch() const { return m_updateEpoch.load(); }
+            bool LookupQueryCache(QueryResult& p_query, std::uint64_t p_epoch, SearchStats* p_stats = nullptr) const;
+            void InsertQueryCache(QueryResult& p_query, std::uint64_t p_epoch) const;
+            inline double GetQueryCacheHitRate() const { return m_queryCache.HitRate(); }
+            inline std::uint64_t GetQueryCacheHitCount() const { return m_queryCache.GetHitCount(); }
+            inline std::uint64_t GetQueryCacheMissCount() const
+            {
+                // Hits are read first; a lookup is counted before its hit, so the difference cannot wrap
+                std::uint64_t hits = m_queryCache.GetHitCount();
+                return m_queryCache.GetLookupCount() - hits;
+            }
+            COMMON::BoundedWorkSpacePool<ExtraWorkSpace>::Lease RentWorkSpace() const;
+            inline std::uint64_t GetDegradedQueryCount() const { return m_degradedQueryCount.load(); }
+            inline std::uint64_t GetWorkSpaceOverflowCount() const { return m_workSpacePool.GetOverflowCount(); }
             inline bool NeedRefine() const { return false; }
             ErrorCode RefineSearchIndex(QueryResult &p_query, bool p_searchDeleted = false) const { return ErrorCode::Undefined; }
             ErrorCode SearchTree(QueryResult& p_query) const { return ErrorCode::Undefined; }
             ErrorCode AddIndex(const void* p_data, SizeType p_vectorNum, DimensionType p_dimension, std::shared_ptr<MetadataSet> p_metadataSet, bool p_withMetaIndex = false, bool p_normalized = false);
+            std::future<ErrorCode> AddIndexAsync(std::shared_ptr<VectorSet> p_vectorSet, std::shared_ptr<MetadataSet> p_metadataSet, bool p_withMetaIndex = false, bool p_normalized = false,
+                std::function<void(ErrorCode)> p_callback = nullptr);
+            // Vectors queued by AddIndexAsync that no worker has taken yet
+            inline SizeType GetInsertQueueDepth() const { return m_insertQueue.Depth(); }
             ErrorCode DeleteIndex(const SizeType& p_id);
 
             ErrorCode DeleteIndex(const void* p_vectors, SizeType p_vectorNum);
@@ -147,6 +203,13 @@ namespace SPTAG
             
         private:
             bool CheckHeadIndexType();
+            int SignCodeSize() const { return m_options.m_enableSignCode ? COMMON::SignCode::CodeSize(m_options.m_dim) : 0; }
+            int PostingEntrySize() const
+            {
+                int vectorSize = (m_options.m_residualQuantizationBits == 4 || m_options.m_residualQuantizationBits == 8) ?
+                    COMMON::ResidualCode::CodeSize(m_options.m_dim, m_options.m_residualQuantizationBits) : (int)(sizeof(T) * m_options.m_dim);
+                return vectorSize + sizeof(int) + sizeof(uint8_t) + SignCodeSize();
+            }
             void SelectHeadAdjustOptions(int p_vectorCount);
             int SelectHeadDynamicallyInternal(const std::shared_ptr<COMMON::BKTree> p_tree, int p_nodeID, const Options& p_opts, std::vector<int>& p_selected);
             void SelectHeadDynamically(const std::shared_ptr<COMMON::BKTree> p_tree, int p_vectorCount, std::vector<int>& p_selected);
@@ -156,6 +219,16 @@ namespace SPTAG
 
             ErrorCode BuildIndexInternal(std::shared_ptr<Helper::VectorSetReader>& p_reader);
 
+            ErrorCode ReorderHeadIndex();
+
+            ErrorCode BuildHeadRerankVectors();
+
+            ErrorCode LoadHeadRerankVectors();
+
+            ErrorCode BuildHeadReplicas();
+
+            ErrorCode SearchHeadCandidates(QueryResult& p_query, SearchStats* p_stats) const;
+
         public:
             bool AllFinished() { if (m_options.m_useKV || m_options.m_useSPDK) return m_extraSearcher->AllFinished(); return true; }
 
@@ -164,6 +237,9 @@ namespace SPTAG
                 LOG(Helper::LogLevel::LL_Info, "Current Vector Num: %d, Deleted: %d .\n", GetNumSamples(), GetNumDeleted());
             }
 
+            // Throttling of inserts by the background maintenance debt
+            AdmissionState GetAdmissionState() { return (m_extraSearcher != nullptr) ? m_extraSearcher->GetAdmissionState() : AdmissionState(); }
+
             void GetIndexStat(int finishedInsert, bool cost, bool reset) { if (m_options.m_useKV || m_options.m_useSPDK) m_extraSearcher->GetIndexStats(finishedInsert, cost, reset); }
             
             void ForceCompaction() { if (m_options.m_useKV) m_extraSearcher->ForceCompaction(); }
@@ -218,7 +294,9 @@ namespace SPTAG
                         GetEnumValueType<T>(), p_dimension, p_vectorNum));
                 }
 
-                return m_extraSearcher->AddIndex(vectorSet, m_index, begin);
+                ErrorCode ret = m_extraSearcher->AddIndex(vectorSet, m_index, begin);
+                m_updateEpoch++;
+                return ret;
             }
         };
     } // namespace SPANN
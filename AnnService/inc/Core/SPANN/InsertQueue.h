@@ -0,0 +1,168 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_SPANN_INSERTQUEUE_H_
+#define _SPTAG_SPANN_INSERTQUEUE_H_
+
+#include "inc/Core/Common.h"
+#include "inc/Core/VectorSet.h"
+#include "inc/Core/MetadataSet.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SPTAG
+{
+    namespace SPANN
+    {
+        // Bounded queue of insert batches served by a pool of worker threads. Capacity is counted in vectors;
+        // a submission that does not fit waits up to a timeout and is then rejected with InsertQueueFull, so
+        // callers see backpressure instead of an unbounded backlog. Stop serves what was queued before it.
+        class InsertQueue
+        {
+        public:
+            struct Request
+            {
+                std::shared_ptr<VectorSet> m_vectors;
+                std::shared_ptr<MetadataSet> m_metadata;
+                bool m_withMetaIndex = false;
+                bool m_normalized = false;
+                std::function<void(ErrorCode)> m_callback;
+                std::promise<ErrorCode> m_done;
+            };
+
+            // Adds the vectors of one request, on a worker thread
+            typedef std::function<ErrorCode(Request&)> Handler;
+
+        private:
+            std::deque<std::unique_ptr<Request>> m_requests;
+            SizeType m_queuedVectors = 0;
+            SizeType m_capacity = 0;
+            bool m_stopping = false;
+            std::uint64_t m_rejected = 0;
+
+            mutable std::mutex m_lock;
+            std::condition_variable m_notEmpty;
+            std::condition_variable m_notFull;
+            std::vector<std::thread> m_workers;
+            std::once_flag m_started;
+
+            static std::future<ErrorCode> Finish(Request& p_request, ErrorCode p_ret)
+            {
+                std::future<ErrorCode> done = p_request.m_done.get_future();
+                if (p_request.m_callback) p_request.m_callback(p_ret);
+                p_request.m_done.set_value(p_ret);
+                return done;
+            }
+
+            void Serve(const Handler& p_handler)
+            {
+                while (true) {
+                    std::unique_ptr<Request> request;
+                    {
+                        std::unique_lock<std::mutex> lock(m_lock);
+                        m_notEmpty.wait(lock, [this]() { return m_stopping || !m_requests.empty(); });
+                        if (m_requests.empty()) return;
+                        request = std::move(m_requests.front());
+                        m_requests.pop_front();
+                        m_queuedVectors -= request->m_vectors->Count();
+                    }
+                    m_notFull.notify_all();
+
+                    ErrorCode ret;
+                    try {
+                        ret = p_handler(*request);
+                    }
+                    catch (std::exception& e) {
+                        LOG(Helper::LogLevel::LL_Error, "InsertQueue: exception %s\n", e.what());
+                        ret = ErrorCode::Fail;
+                    }
+                    if (request->m_callback) request->m_callback(ret);
+                    request->m_done.set_value(ret);
+                }
+            }
+
+        public:
+            InsertQueue() = default;
+
+            ~InsertQueue() { Stop(); }
+
+            // Starts the workers on the first call, later calls are ignored. p_threadInit and p_threadExit run on
+            // every worker before the first and after the last request it serves.
+            void Start(int p_workers, SizeType p_capacity, Handler p_handler,
+                std::function<void()> p_threadInit = nullptr, std::function<void()> p_threadExit = nullptr)
+            {
+                std::call_once(m_started, [&]() {
+                    m_capacity = (std::max)((SizeType)1, p_capacity);
+                    for (int i = 0; i < (std::max)(1, p_workers); i++) {
+                        m_workers.emplace_back([this, p_handler, p_threadInit, p_threadExit]() {
+                            if (p_threadInit) p_threadInit();
+                            Serve(p_handler);
+                            if (p_threadExit) p_threadExit();
+                        });
+                    }
+                });
+            }
+
+            // p_timeoutMs < 0 waits until there is room; a batch larger than the capacity is taken when the queue is empty
+            std::future<ErrorCode> Submit(std::unique_ptr<Request> p_request, int p_timeoutMs)
+            {
+                SizeType count = p_request->m_vectors->Count();
+                std::unique_lock<std::mutex> lock(m_lock);
+                auto fits = [&]() { return m_stopping || m_queuedVectors == 0 || m_queuedVectors + count <= m_capacity; };
+                if (p_timeoutMs < 0) m_notFull.wait(lock, fits);
+                else m_notFull.wait_for(lock, std::chrono::milliseconds(p_timeoutMs), fits);
+
+                if (m_stopping || m_workers.empty()) {
+                    lock.unlock();
+                    return Finish(*p_request, ErrorCode::ExternalAbort);
+                }
+                if (!fits()) {
+                    m_rejected++;
+                    lock.unlock();
+                    return Finish(*p_request, ErrorCode::InsertQueueFull);
+                }
+                std::future<ErrorCode> done = p_request->m_done.get_future();
+                m_queuedVectors += count;
+                m_requests.push_back(std::move(p_request));
+                lock.unlock();
+                m_notEmpty.notify_one();
+                return done;
+            }
+
+            void Stop()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    m_stopping = true;
+                }
+                m_notEmpty.notify_all();
+                m_notFull.notify_all();
+                for (auto& worker : m_workers) worker.join();
+                m_workers.clear();
+            }
+
+            // Vectors waiting for a worker
+            SizeType Depth() const
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                return m_queuedVectors;
+            }
+
+            std::uint64_t Rejected() const
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                return m_rejected;
+            }
+        };
+    }
+}
+
+#endif // _SPTAG_SPANN_INSERTQUEUE_H_
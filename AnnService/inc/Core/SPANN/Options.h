@@ -39,6 +39,7 @@ namespace SPTAG {
             std::string m_headVectorFile;
             std::string m_headIndexFolder;
             std::string m_deleteIDFile;
+            std::string m_attributeFile;
             std::string m_ssdIndex;
             bool m_deleteHeadVectors;
             int m_ssdIndexFileNum;
@@ -85,6 +86,8 @@ namespace SPTAG {
             int m_minDictTraingBufferSize;
             int m_dictBufferCapacity;
             int m_zstdCompressLevel;
+            bool m_enableSignCode;
+            int m_residualQuantizationBits;
 
             // Building
             int m_replicaCount;
@@ -101,6 +104,7 @@ namespace SPTAG {
             std::string m_KVPath;
             std::string m_spdkMappingPath;
             std::string m_ssdInfoFile;
+            std::string m_postingRadiusFile;
             bool m_useDirectIO;
             bool m_preReassign;
             float m_preReassignRatio;
@@ -124,6 +128,25 @@ namespace SPTAG {
             int m_searchPostingPageLimit;
             int m_searchInternalResultNum;
             int m_rerank;
+            std::string m_rerankVectorPath;
+            float m_signCodeKeepRatio;
+            bool m_enableFastScan;
+            float m_filterMaxProbeRatio;
+            bool m_enableQueryCache;
+            int m_queryCacheCapacity;
+            int m_queryCacheTTL;
+            float m_queryCacheTolerance;
+            int m_queryCacheHashBits;
+            float m_rangeMaxProbeRatio;
+            float m_queryDeadline;
+            int m_deadlinePostingBatch;
+            float m_deadlineHeadRatio;
+            int m_workSpacePoolSize;
+            bool m_reorderHeadIndex;
+            std::string m_headRerankFile;
+            int m_headRerankRatio;
+            bool m_headRerankInMemory;
+            bool m_numaHeadReplicas;
             bool m_recall_analysis;
             int m_debugBuildInternalResultNum;
             bool m_enableADC;
@@ -147,6 +170,8 @@ namespace SPTAG {
             bool m_searchDuringUpdate;
             int m_reassignK;
             bool m_virtualHead;
+            int m_splitSampleSize;
+            int m_splitIterations;
 
             // Updating(SPFresh Update Test)
             bool m_update;
@@ -155,10 +180,29 @@ namespace SPTAG {
             float m_latencyLimit;
             int m_step;
             int m_insertThreadNum;
+            int m_insertBatchSize;
+            int m_insertBatchThreadNum;
+            int m_insertWorkerNum;
+            int m_insertQueueSize;
+            int m_insertQueueTimeout;
+            int m_admissionTargetDebt;
+            int m_admissionMaxDebt;
+            int m_admissionRate;
+            int m_admissionBurst;
+            int m_admissionMaxDelay;
             int m_endVectorNum;
             std::string m_persistentBufferPath;
             int m_appendThreadNum;
             int m_reassignThreadNum;
+            int m_reassignBatchSize;
+            int m_gcIOBudget;
+            int m_gcCPUBudget;
+            float m_gcDeadRatio;
+            int m_gcInterval;
+            int m_mergeHintQueueSize;
+            int m_mergeHintInterval;
+            int m_mergeRate;
+            int m_mergeCooldown;
             int m_batch;
             std::string m_fullVectorPath;
 
@@ -205,6 +249,9 @@ namespace SPTAG {
 
             ~Options() {}
 
+            // Slots of the search workspace pool; the disk searcher opens one AIO context per slot
+            inline int WorkSpacePoolSize() const { return (m_workSpacePoolSize > 0) ? m_workSpacePoolSize : 2 * (std::max)(1, m_searchThreadNum); }
+
             ErrorCode SetParameter(const char* p_section, const char* p_param, const char* p_value)
             {
                 if (nullptr == p_section || nullptr == p_param || nullptr == p_value) return ErrorCode::Fail;
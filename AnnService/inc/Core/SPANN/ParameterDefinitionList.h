@@ -26,6 +26,7 @@ DefineBasicParameter(m_generateTruth, bool, false, "GenerateTruth")
 DefineBasicParameter(m_indexDirectory, std::string, std::string("SPANN"), "IndexDirectory")
 DefineBasicParameter(m_headIDFile, std::string, std::string("SPTAGHeadVectorIDs.bin"), "HeadVectorIDs")
 DefineBasicParameter(m_deleteIDFile, std::string, std::string("DeletedIDs.bin"), "DeletedIDs")
+DefineBasicParameter(m_attributeFile, std::string, std::string("Attributes.bin"), "AttributeFile")
 DefineBasicParameter(m_headVectorFile, std::string, std::string("SPTAGHeadVectors.bin"), "HeadVectors")
 DefineBasicParameter(m_headIndexFolder, std::string, std::string("HeadIndex"), "HeadIndexFolder")
 DefineBasicParameter(m_ssdIndex, std::string, std::string("SPTAGFullList.bin"), "SSDIndex")
@@ -81,6 +82,10 @@ DefineSSDParameter(m_enableDictTraining, bool, true, "EnableDictTraining")
 DefineSSDParameter(m_minDictTraingBufferSize, int, 10240000, "MinDictTrainingBufferSize")
 DefineSSDParameter(m_dictBufferCapacity, int, 204800, "DictBufferCapacity")
 DefineSSDParameter(m_zstdCompressLevel, int, 0, "ZstdCompressLevel")
+// Store a 1-bit sign code of the residual to the head with each posting entry
+DefineSSDParameter(m_enableSignCode, bool, false, "EnableSignCode")
+// SPFresh postings: store vectors as 8 or 4 bit quantized residuals to the head, 0 keeps raw vectors
+DefineSSDParameter(m_residualQuantizationBits, int, 0, "ResidualQuantizationBits")
 
 // Building
 DefineSSDParameter(m_internalResultNum, int, 64, "InternalResultNum")
@@ -98,6 +103,8 @@ DefineSSDParameter(m_spdkBatchSize, int, 64, "SpdkBatchSize")
 DefineSSDParameter(m_KVPath, std::string, std::string(""), "KVPath")
 DefineSSDParameter(m_spdkMappingPath, std::string, std::string(""), "SpdkMappingPath")
 DefineSSDParameter(m_ssdInfoFile, std::string, std::string(""), "SsdInfoFile")
+// Per-posting radius bounds used by RangeSearch; defaults to SsdInfoFile with a .radius suffix
+DefineSSDParameter(m_postingRadiusFile, std::string, std::string(""), "PostingRadiusFile")
 DefineSSDParameter(m_useDirectIO, bool, false, "UseDirectIO")
 DefineSSDParameter(m_preReassign, bool, false, "PreReassign")
 DefineSSDParameter(m_preReassignRatio, float, 0.7f, "PreReassignRatio")
@@ -122,6 +129,44 @@ DefineSSDParameter(m_ioThreads, int, 4, "IOThreadsPerHandler")
 DefineSSDParameter(m_searchInternalResultNum, int, 64, "SearchInternalResultNum")
 DefineSSDParameter(m_searchPostingPageLimit, int, (std::numeric_limits<int>::max)() - 1, "SearchPostingPageLimit")
 DefineSSDParameter(m_rerank, int, 0, "Rerank")
+// Full precision vectors for Rerank when the index stores quantized codes
+DefineSSDParameter(m_rerankVectorPath, std::string, std::string(""), "RerankVectorPath")
+// Fraction of each posting (by sign code Hamming distance) that gets the full distance, 1 disables the prefilter
+DefineSSDParameter(m_signCodeKeepRatio, float, 0.3f, "SignCodeKeepRatio")
+// Quantized postings with 16 centroids per subvector: the build stores packed 4-bit fast scan blocks ahead of
+// each posting's entries, and search bounds every entry with them to skip the ADC distance of entries whose
+// bound cannot enter the results. Must match between build and search.
+DefineSSDParameter(m_enableFastScan, bool, false, "EnableFastScan")
+// Filtered search probes up to this many times SearchInternalResultNum postings for selective filters
+DefineSSDParameter(m_filterMaxProbeRatio, float, 8.0f, "FilterMaxProbeRatio")
+// Result cache for repeated queries: entries live QueryCacheTTL ms and until the next AddIndex/DeleteIndex
+DefineSSDParameter(m_enableQueryCache, bool, false, "EnableQueryCache")
+DefineSSDParameter(m_queryCacheCapacity, int, 100000, "QueryCacheCapacity")
+DefineSSDParameter(m_queryCacheTTL, int, 5000, "QueryCacheTTL")
+// A cached result is reused when the distance between the two queries is at most this, 0 means exact repeats only
+DefineSSDParameter(m_queryCacheTolerance, float, 0.0f, "QueryCacheTolerance")
+DefineSSDParameter(m_queryCacheHashBits, int, 16, "QueryCacheHashBits")
+// Range search takes up to this many times SearchInternalResultNum nearest heads as posting candidates
+DefineSSDParameter(m_rangeMaxProbeRatio, float, 4.0f, "RangeMaxProbeRatio")
+// End-to-end per-query deadline in ms, 0 disables. Near the deadline the head search scales MaxCheck down and
+// postings are read nearest first in waves of DeadlinePostingBatch until time runs out.
+DefineSSDParameter(m_queryDeadline, float, 0.0f, "QueryDeadline")
+DefineSSDParameter(m_deadlinePostingBatch, int, 8, "DeadlinePostingBatch")
+// Share of the remaining budget the head search may spend at full MaxCheck
+DefineSSDParameter(m_deadlineHeadRatio, float, 0.3f, "DeadlineHeadRatio")
+// Search workspaces shared by all query threads, 0 means twice SearchThreadNum. Queries beyond it get a transient one.
+DefineSSDParameter(m_workSpacePoolSize, int, 0, "WorkSpacePoolSize")
+// Renumber the head index in tree order before postings are built, so that nearby heads share cache lines and pages
+DefineSSDParameter(m_reorderHeadIndex, bool, false, "ReorderHeadIndex")
+// Full precision head vectors, in head id order under IndexDirectory, for reranking heads found on quantized codes.
+// Written at build from RerankVectorPath; the head search then fetches HeadRerankRatio times as many candidates.
+DefineSSDParameter(m_headRerankFile, std::string, std::string(""), "HeadRerankVectors")
+DefineSSDParameter(m_headRerankRatio, int, 2, "HeadRerankRatio")
+// Keep the rerank vectors in memory instead of reading the rows from disk per query
+DefineSSDParameter(m_headRerankInMemory, bool, false, "HeadRerankInMemory")
+// Load a copy of the head index on every NUMA node and bind the search threads to nodes round-robin, so that
+// head searches stay in local memory. Heads added or deleted by splits are applied to every copy.
+DefineSSDParameter(m_numaHeadReplicas, bool, false, "NumaHeadReplicas")
 DefineSSDParameter(m_enableADC, bool, false, "EnableADC")
 DefineSSDParameter(m_recall_analysis, bool, false, "RecallAnalysis")
 DefineSSDParameter(m_debugBuildInternalResultNum, int, 64, "DebugBuildInternalResultNum")
@@ -154,6 +199,23 @@ DefineSSDParameter(m_latencyLimit, float, 2.0, "LatencyLimit")
 DefineSSDParameter(m_step, int, 0, "Step")
 // Frontend update threadnum
 DefineSSDParameter(m_insertThreadNum, int, 16, "InsertThreadNum")
+// Vectors each frontend thread hands to one AddIndex call; a batch is appended with one merge per head
+DefineSSDParameter(m_insertBatchSize, int, 1, "InsertBatchSize")
+// Threads selecting the heads of one insert batch
+DefineSSDParameter(m_insertBatchThreadNum, int, 4, "InsertBatchThreadNum")
+// AddIndexAsync queue: worker threads, capacity in vectors, and how long (ms) a full queue makes a caller wait
+// before the batch is rejected with InsertQueueFull; -1 waits until there is room
+DefineSSDParameter(m_insertWorkerNum, int, 8, "InsertWorkerNum")
+DefineSSDParameter(m_insertQueueSize, int, 65536, "InsertQueueSize")
+DefineSSDParameter(m_insertQueueTimeout, int, 0, "InsertQueueTimeout")
+// Insert admission: maintenance debt (queued split, merge and reassign jobs plus oversized postings) above which
+// inserts are throttled, 0 to disable, and the debt at which they stop; the insert rate (vectors/s) just above the
+// target, the burst in vectors, and the longest delay (ms) of one AddIndex call, 0 to wait for the debt to drop
+DefineSSDParameter(m_admissionTargetDebt, int, 0, "AdmissionTargetDebt")
+DefineSSDParameter(m_admissionMaxDebt, int, 4096, "AdmissionMaxDebt")
+DefineSSDParameter(m_admissionRate, int, 10000, "AdmissionRate")
+DefineSSDParameter(m_admissionBurst, int, 1024, "AdmissionBurst")
+DefineSSDParameter(m_admissionMaxDelay, int, 1000, "AdmissionMaxDelay")
 // Update limit
 DefineSSDParameter(m_endVectorNum, int, -1, "EndVectorNum")
 // Persistent buffer path
@@ -162,6 +224,20 @@ DefineSSDParameter(m_persistentBufferPath, std::string, std::string(""), "Persis
 DefineSSDParameter(m_appendThreadNum, int, 16, "AppendThreadNum")
 // Background reassign threadnum
 DefineSSDParameter(m_reassignThreadNum, int, 16, "ReassignThreadNum")
+// Entries a split hands to one reassign job
+DefineSSDParameter(m_reassignBatchSize, int, 64, "ReassignBatchSize")
+// Background GC of deleted entries: disk bandwidth (MB/s) for rewriting postings, 0 to disable, CPU time (ms)
+// per second it may spend, the estimated dead ratio from which a posting is rewritten, and the interval (ms) of its rounds
+DefineSSDParameter(m_gcIOBudget, int, 0, "GCIOBudget")
+DefineSSDParameter(m_gcCPUBudget, int, 100, "GCCPUBudget")
+DefineSSDParameter(m_gcDeadRatio, float, 0.2f, "GCDeadRatio")
+DefineSSDParameter(m_gcInterval, int, 1000, "GCInterval")
+// Merge hints from searches: capacity of the hint ring, the interval (ms) at which they are drained, merges
+// scheduled per second, 0 for no limit, and how long (ms) a merged head is not merged again
+DefineSSDParameter(m_mergeHintQueueSize, int, 4096, "MergeHintQueueSize")
+DefineSSDParameter(m_mergeHintInterval, int, 10, "MergeHintInterval")
+DefineSSDParameter(m_mergeRate, int, 1000, "MergeRate")
+DefineSSDParameter(m_mergeCooldown, int, 1000, "MergeCooldown")
 // Background process batch size
 DefineSSDParameter(m_batch, int, 1000, "Batch")
 // Total Vector Path
@@ -193,4 +269,7 @@ DefineSSDParameter(m_disableReassign, bool, false, "DisableReassign")
 DefineSSDParameter(m_searchDuringUpdate, bool, false, "SearchDuringUpdate")
 DefineSSDParameter(m_reassignK, int, 0, "ReassignK")
 DefineSSDParameter(m_virtualHead, bool, false, "VirtualHead")
+// Posting split: vectors sampled to train the 2-means and its iterations
+DefineSSDParameter(m_splitSampleSize, int, 1000, "SplitSampleSize")
+DefineSSDParameter(m_splitIterations, int, 8, "SplitIterations")
 #endif
@@ -10,6 +10,8 @@
 #include "MetadataSet.h"
 #include "inc/Helper/SimpleIniReader.h"
 #include <unordered_set>
+#include <functional>
+#include <future>
 #include "inc/Core/Common/IQuantizer.h"
 
 namespace SPTAG
@@ -41,10 +43,19 @@ public:
     
     virtual ErrorCode RefineSearchIndex(QueryResult &p_query, bool p_searchDeleted = false) const = 0;
 
+    // Top-k search that evaluates at most p_maxCheck vectors, for callers working against a time budget.
+    virtual ErrorCode SearchIndexWithBudget(QueryResult& p_query, int p_maxCheck, bool p_searchDeleted = false) const { return SearchIndex(p_query, p_searchDeleted); }
+
     virtual ErrorCode SearchTree(QueryResult &p_query) const = 0;
 
+    // Appends up to p_maxResults non-deleted vectors within p_radius of p_vector to p_results, in discovery order.
+    virtual ErrorCode RangeSearch(const void* p_vector, float p_radius, int p_maxResults, std::vector<BasicResult>& p_results) const { return ErrorCode::Undefined; }
+
     virtual ErrorCode RefineIndex(std::shared_ptr<VectorIndex>& p_newIndex) = 0;
 
+    // Renumbers the vectors so that neighbors sit close in memory; p_newToOld[i] receives the old id of vector i.
+    virtual ErrorCode ReorderForLocality(std::vector<SizeType>& p_newToOld) { return ErrorCode::Undefined; }
+
     virtual float AccurateDistance(const void* pX, const void* pY) const = 0;
     virtual float ComputeDistance(const void* pX, const void* pY) const = 0;
     virtual const void* GetSample(const SizeType idx) const = 0;
@@ -80,6 +91,11 @@ public:
 
     virtual ErrorCode AddIndex(std::shared_ptr<VectorSet> p_vectorSet, std::shared_ptr<MetadataSet> p_metadataSet, bool p_withMetaIndex = false, bool p_normalized = false);
 
+    // Returns once the vectors are queued; the future resolves, after p_callback ran, when they are searchable.
+    // The sets must stay valid until then. Indexes without an insert queue add them before returning.
+    virtual std::future<ErrorCode> AddIndexAsync(std::shared_ptr<VectorSet> p_vectorSet, std::shared_ptr<MetadataSet> p_metadataSet, bool p_withMetaIndex = false, bool p_normalized = false,
+        std::function<void(ErrorCode)> p_callback = nullptr);
+
     virtual ErrorCode DeleteIndex(ByteArray p_meta);
 
     virtual ErrorCode MergeIndex(VectorIndex* p_addindex, int p_threadnum, IAbortOperation* p_abort);
@@ -37,6 +37,11 @@ namespace SPTAG
     namespace Helper
     {
         void SetThreadAffinity(int threadID, std::thread& thread, char socketStrategy = 0, char idStrategy = 0);
+        // NUMA node of the CPU the calling thread runs on, 0 when NUMA is unavailable
+        int GetCurrentNumaNode();
+        int GetNumaNodeCount();
+        // Restricts the calling thread to the CPUs of p_node and prefers its memory, false when that is not possible
+        bool BindThreadToNumaNode(int p_node);
 #ifdef _MSC_VER
         namespace DiskUtils
         {
@@ -4,7 +4,9 @@
 #ifndef _SPTAG_HELPER_LOCKFREE_H_
 #define _SPTAG_HELPER_LOCKFREE_H_
 
+#include <atomic>
 #include <cstdint>
+#include <memory>
 #include <vector>
 #include "DiskIO.h"
 #include "Concurrent.h"
@@ -138,6 +140,87 @@ namespace SPTAG
                     return true;
                 }
             };
+
+            // Bounded multi-producer ring. Every slot carries a sequence number telling whether it is free for
+            // the push of a given round or holds a value for the pop of that round, so pushes and pops only
+            // contend on one atomic each and never block; a push into a full ring fails and is counted instead.
+            template <typename T>
+            class BoundedRing
+            {
+            private:
+                struct Slot
+                {
+                    std::atomic<std::uint64_t> m_seq;
+                    T m_value;
+                };
+
+                std::unique_ptr<Slot[]> m_slots;
+                std::uint64_t m_mask = 0;
+                alignas(64) std::atomic<std::uint64_t> m_pushPos{ 0 };
+                alignas(64) std::atomic<std::uint64_t> m_popPos{ 0 };
+                std::atomic<std::uint64_t> m_dropped{ 0 };
+
+            public:
+                // The capacity is rounded up to a power of two
+                BoundedRing(std::uint64_t p_capacity)
+                {
+                    std::uint64_t capacity = 2;
+                    while (capacity < p_capacity) capacity <<= 1;
+                    m_mask = capacity - 1;
+                    m_slots.reset(new Slot[capacity]);
+                    for (std::uint64_t i = 0; i < capacity; i++) m_slots[i].m_seq.store(i, std::memory_order_relaxed);
+                }
+
+                bool push(const T& p_value)
+                {
+                    std::uint64_t pos = m_pushPos.load(std::memory_order_relaxed);
+                    while (true) {
+                        Slot& slot = m_slots[pos & m_mask];
+                        std::int64_t diff = (std::int64_t)(slot.m_seq.load(std::memory_order_acquire) - pos);
+                        if (diff == 0) {
+                            if (m_pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                                slot.m_value = p_value;
+                                slot.m_seq.store(pos + 1, std::memory_order_release);
+                                return true;
+                            }
+                        }
+                        else if (diff < 0) {
+                            m_dropped.fetch_add(1, std::memory_order_relaxed);
+                            return false;
+                        }
+                        else {
+                            pos = m_pushPos.load(std::memory_order_relaxed);
+                        }
+                    }
+                }
+
+                bool pop(T& p_value)
+                {
+                    std::uint64_t pos = m_popPos.load(std::memory_order_relaxed);
+                    while (true) {
+                        Slot& slot = m_slots[pos & m_mask];
+                        std::int64_t diff = (std::int64_t)(slot.m_seq.load(std::memory_order_acquire) - (pos + 1));
+                        if (diff == 0) {
+                            if (m_popPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                                p_value = slot.m_value;
+                                slot.m_seq.store(pos + m_mask + 1, std::memory_order_release);
+                                return true;
+                            }
+                        }
+                        else if (diff < 0) {
+                            return false;
+                        }
+                        else {
+                            pos = m_popPos.load(std::memory_order_relaxed);
+                        }
+                    }
+                }
+
+                inline std::uint64_t capacity() const { return m_mask + 1; }
+
+                // Pushes rejected because the ring was full
+                inline std::uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+            };
         }
     }
 }
@@ -0,0 +1,278 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_HELPER_PRIORITYSCHEDULER_H_
+#define _SPTAG_HELPER_PRIORITYSCHEDULER_H_
+
+#include "inc/Core/VectorIndex.h"
+#include "inc/Helper/ThreadPool.h"
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <typeinfo>
+
+namespace SPTAG
+{
+    namespace Helper
+    {
+        // Work-stealing pool with job priorities, 0 being the most urgent. Every worker owns one deque per
+        // priority; it runs the newest job of its own deque and steals the oldest of the others, and it only
+        // looks at a priority once no worker has anything more urgent queued. Jobs are handed back through
+        // Release when done, so that callers can recycle them with a JobPool.
+        class PriorityScheduler
+        {
+        public:
+            class Job : public ThreadPool::Job
+            {
+            public:
+                virtual void Release() { delete this; }
+            };
+
+            struct Stats
+            {
+                std::vector<std::uint64_t> m_queued;
+                std::uint64_t m_running = 0;
+                std::uint64_t m_executed = 0;
+                std::uint64_t m_stolen = 0;
+                std::uint64_t m_maxQueued = 0;
+            };
+
+        private:
+            struct Worker
+            {
+                std::mutex m_lock;
+                std::vector<std::deque<Job*>> m_jobs;
+            };
+
+            int m_levels = 1;
+            std::vector<std::unique_ptr<Worker>> m_workers;
+            std::vector<std::thread> m_threads;
+            std::unique_ptr<std::atomic<std::uint64_t>[]> m_queuedByLevel;
+            std::atomic<std::uint64_t> m_queued{ 0 };
+            std::atomic<std::uint64_t> m_running{ 0 };
+            std::atomic<std::uint64_t> m_executed{ 0 };
+            std::atomic<std::uint64_t> m_stolen{ 0 };
+            std::atomic<std::uint64_t> m_maxQueued{ 0 };
+            std::atomic<std::uint32_t> m_nextWorker{ 0 };
+
+            ThreadPool::Abort m_abort;
+            std::mutex m_sleepLock;
+            std::condition_variable m_wake;
+
+            static int& CurrentWorker(const PriorityScheduler* p_scheduler)
+            {
+                static thread_local const PriorityScheduler* t_scheduler = nullptr;
+                static thread_local int t_worker = -1;
+                if (t_scheduler != p_scheduler) {
+                    t_scheduler = p_scheduler;
+                    t_worker = -1;
+                }
+                return t_worker;
+            }
+
+            Job* Take(int p_worker, int p_level)
+            {
+                Worker& own = *m_workers[p_worker];
+                {
+                    std::lock_guard<std::mutex> lock(own.m_lock);
+                    auto& jobs = own.m_jobs[p_level];
+                    if (!jobs.empty()) {
+                        Job* j = jobs.back();
+                        jobs.pop_back();
+                        return j;
+                    }
+                }
+                for (size_t i = 1; i < m_workers.size(); i++) {
+                    Worker& victim = *m_workers[(p_worker + i) % m_workers.size()];
+                    std::lock_guard<std::mutex> lock(victim.m_lock);
+                    auto& jobs = victim.m_jobs[p_level];
+                    if (!jobs.empty()) {
+                        Job* j = jobs.front();
+                        jobs.pop_front();
+                        m_stolen++;
+                        return j;
+                    }
+                }
+                return nullptr;
+            }
+
+            void Run(int p_worker)
+            {
+                CurrentWorker(this) = p_worker;
+                while (!m_abort.ShouldAbort()) {
+                    Job* j = nullptr;
+                    for (int level = 0; level < m_levels && j == nullptr; level++) {
+                        if (m_queuedByLevel[level].load() > 0) j = Take(p_worker, level);
+                        if (j != nullptr) m_queuedByLevel[level]--;
+                    }
+                    if (j == nullptr) {
+                        std::unique_lock<std::mutex> lock(m_sleepLock);
+                        m_wake.wait(lock, [this]() { return m_abort.ShouldAbort() || m_queued.load() > 0; });
+                        continue;
+                    }
+                    m_running++;
+                    m_queued--;
+                    try {
+                        j->exec(&m_abort);
+                    }
+                    catch (std::exception& e) {
+                        LOG(Helper::LogLevel::LL_Error, "PriorityScheduler: exception in %s %s\n", typeid(*j).name(), e.what());
+                    }
+                    m_running--;
+                    m_executed++;
+                    j->Release();
+                }
+            }
+
+        public:
+            PriorityScheduler() {}
+
+            ~PriorityScheduler()
+            {
+                m_abort.SetAbort(true);
+                {
+                    std::lock_guard<std::mutex> lock(m_sleepLock);
+                }
+                m_wake.notify_all();
+                for (auto& t : m_threads) t.join();
+                m_threads.clear();
+                for (auto& worker : m_workers) {
+                    for (auto& jobs : worker->m_jobs) {
+                        for (Job* j : jobs) j->Release();
+                    }
+                }
+            }
+
+            // p_threadInit and p_threadExit run on every worker before its first and after its last job
+            void init(int p_numberOfThreads, int p_levels, std::function<void()> p_threadInit = nullptr, std::function<void()> p_threadExit = nullptr)
+            {
+                m_abort.SetAbort(false);
+                m_levels = (std::max)(1, p_levels);
+                m_queuedByLevel.reset(new std::atomic<std::uint64_t>[m_levels]);
+                for (int level = 0; level < m_levels; level++) m_queuedByLevel[level] = 0;
+                int threads = (std::max)(1, p_numberOfThreads);
+                for (int i = 0; i < threads; i++) {
+                    m_workers.emplace_back(new Worker());
+                    m_workers.back()->m_jobs.resize(m_levels);
+                }
+                for (int i = 0; i < threads; i++) {
+                    m_threads.emplace_back([this, i, p_threadInit, p_threadExit]() {
+                        if (p_threadInit) p_threadInit();
+                        Run(i);
+                        if (p_threadExit) p_threadExit();
+                    });
+                }
+            }
+
+            // Jobs added by a worker go to its own deque, others are spread round-robin
+            void add(Job* p_job, int p_level)
+            {
+                p_level = (std::min)((std::max)(p_level, 0), m_levels - 1);
+                int worker = CurrentWorker(this);
+                if (worker < 0) worker = (int)(m_nextWorker.fetch_add(1) % m_workers.size());
+                {
+                    std::lock_guard<std::mutex> lock(m_workers[worker]->m_lock);
+                    m_workers[worker]->m_jobs[p_level].push_back(p_job);
+                }
+                m_queuedByLevel[p_level]++;
+                std::uint64_t queued = ++m_queued;
+                std::uint64_t maxQueued = m_maxQueued.load();
+                while (queued > maxQueued && !m_maxQueued.compare_exchange_weak(maxQueued, queued)) {}
+                {
+                    std::lock_guard<std::mutex> lock(m_sleepLock);
+                }
+                m_wake.notify_one();
+            }
+
+            inline size_t jobsize() const { return (size_t)m_queued.load(); }
+
+            inline size_t jobsize(int p_level) const { return (size_t)m_queuedByLevel[p_level].load(); }
+
+            inline uint32_t runningJobs() const { return (uint32_t)m_running.load(); }
+
+            inline bool allClear() const { return m_running.load() == 0 && m_queued.load() == 0; }
+
+            Stats GetStats() const
+            {
+                Stats stats;
+                for (int level = 0; level < m_levels; level++) stats.m_queued.push_back(m_queuedByLevel[level].load());
+                stats.m_running = m_running.load();
+                stats.m_executed = m_executed.load();
+                stats.m_stolen = m_stolen.load();
+                stats.m_maxQueued = m_maxQueued.load();
+                return stats;
+            }
+        };
+
+        // Free list of finished jobs of one type. A job taken with Get returns here through Release, after
+        // Clear has dropped what it holds; at most p_capacity idle jobs are kept.
+        template <typename J>
+        class JobPool
+        {
+        private:
+            std::mutex m_lock;
+            std::vector<J*> m_free;
+            size_t m_capacity;
+
+        public:
+            JobPool(size_t p_capacity = 1024) : m_capacity(p_capacity) {}
+
+            ~JobPool()
+            {
+                for (J* j : m_free) delete j;
+            }
+
+            J* Get()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    if (!m_free.empty()) {
+                        J* j = m_free.back();
+                        m_free.pop_back();
+                        return j;
+                    }
+                }
+                J* j = new J();
+                j->m_pool = this;
+                return j;
+            }
+
+            void Put(J* p_job)
+            {
+                p_job->Clear();
+                {
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    if (m_free.size() < m_capacity) {
+                        m_free.push_back(p_job);
+                        return;
+                    }
+                }
+                delete p_job;
+            }
+
+            size_t Idle()
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                return m_free.size();
+            }
+        };
+
+        // Base for jobs recycled by a JobPool
+        template <typename J>
+        class PooledJob : public PriorityScheduler::Job
+        {
+        public:
+            JobPool<J>* m_pool = nullptr;
+
+            void Release() override
+            {
+                if (m_pool != nullptr) m_pool->Put(static_cast<J*>(this));
+                else delete this;
+            }
+        };
+    }
+}
+
+#endif // _SPTAG_HELPER_PRIORITYSCHEDULER_H_
@@ -2,6 +2,8 @@
 #include <inc/Core/Common/DistanceUtils.h>
 #include <inc/Core/Common/IQuantizer.h>
 #include <inc/Core/Common/PQQuantizer.h>
+#include <inc/Core/Common/OPQQuantizer.h>
+#include <inc/Core/Common/ScalarQuantizer.h>
 
 #include <memory>
 #include <inc/Core/VectorSet.h>
@@ -13,7 +15,7 @@ using namespace SPTAG;
 class QuantizerOptions : public Helper::ReaderOptions
 {
 public:
-    QuantizerOptions(SizeType trainingSamples, bool debug, float lambda, SPTAG::QuantizerType qtype, std::string qfile, DimensionType qdim, std::string fullvecs, std::string recvecs) : Helper::ReaderOptions(VectorValueType::Float, 0, VectorFileType::TXT, "|", 32), m_trainingSamples(trainingSamples), m_debug(debug), m_KmeansLambda(lambda), m_quantizerType(qtype), m_outputQuantizerFile(qfile), m_quantizedDim(qdim), m_outputFullVecFile(fullvecs), m_outputReconstructVecFile(recvecs)
+    QuantizerOptions(SizeType trainingSamples, bool debug, float lambda, SPTAG::QuantizerType qtype, std::string qfile, DimensionType qdim, std::string fullvecs, std::string recvecs) : Helper::ReaderOptions(VectorValueType::Float, 0, VectorFileType::TXT, "|", 32), m_trainingSamples(trainingSamples), m_debug(debug), m_KmeansLambda(lambda), m_quantizerType(qtype), m_outputQuantizerFile(qfile), m_quantizedDim(qdim), m_outputFullVecFile(fullvecs), m_outputReconstructVecFile(recvecs), m_KsPerSubvector(256), m_quantizedBits(8), m_opqIterations(10), m_opqSamples(65536)
     {
         AddRequiredOption(m_inputFiles, "-i", "--input", "Input raw data.");
         AddRequiredOption(m_outputFile, "-o", "--output", "Output quantized vectors.");
@@ -22,11 +24,15 @@ public:
         AddOptionalOption(m_outputQuantizerFile, "-oq", "--outputquantizer", "Output quantizer.");
         AddOptionalOption(m_quantizerType, "-qt", "--quantizer", "Quantizer type.");
         AddOptionalOption(m_quantizedDim, "-qd", "--quantizeddim", "Quantized Dimension.");
+        AddOptionalOption(m_quantizedBits, "-qb", "--quantizedbits", "Bits per dimension for scalar quantizer (8 or 4).");
+        AddOptionalOption(m_KsPerSubvector, "-ks", "--ks_per_subvector", "Number of centroids per subvector (256 or 16 for 4-bit fast scan).");
 
         // We also use this to determine batch size (max number of vectors to load at once)
         AddOptionalOption(m_trainingSamples, "-ts", "--train_samples", "Number of samples for training.");
         AddOptionalOption(m_debug, "-debug", "--debug", "Print debug information.");
         AddOptionalOption(m_KmeansLambda, "-kml", "--lambda", "Kmeans lambda parameter.");
+        AddOptionalOption(m_opqIterations, "-opqi", "--opq_iterations", "Number of alternating rotation and codebook updates for OPQ training.");
+        AddOptionalOption(m_opqSamples, "-opqs", "--opq_samples", "Number of training samples the OPQ rotation is learned on, 0 for all of them.");
         AddOptionalOption(m_outputFullVecFile, "-ofv", "--output_full", "Output Uncompressed vectors.");
         AddOptionalOption(m_outputFullVecFile, "-orv", "--output_reconstruct", "Output reconstructed vectors.");
     }
@@ -56,12 +62,24 @@ public:
     bool m_debug;
 
     float m_KmeansLambda;
+
+    SizeType m_KsPerSubvector;
+
+    int m_quantizedBits;
+
+    int m_opqIterations;
+
+    SizeType m_opqSamples;
 };
 
 template <typename T>
 std::unique_ptr<T[]> TrainPQQuantizer(std::shared_ptr<QuantizerOptions> options, std::shared_ptr<VectorSet> raw_vectors, std::shared_ptr<VectorSet> quantized_vectors)
 {
-    SizeType numCentroids = 256;
+    SizeType numCentroids = options->m_KsPerSubvector;
+    if (numCentroids <= 0 || numCentroids > 256) {
+        LOG(Helper::LogLevel::LL_Error, "KsPerSubvector must be in (0, 256].\n");
+        exit(1);
+    }
     if (raw_vectors->Dimension() % options->m_quantizedDim != 0) {
         LOG(Helper::LogLevel::LL_Error, "Only n_codebooks that divide dimension are supported.\n");
         exit(1);
@@ -121,3 +139,319 @@ std::unique_ptr<T[]> TrainPQQuantizer(std::shared_ptr<QuantizerOptions> options,
 
     return codebooks;
 }
+
+template <typename T>
+void TrainScalarQuantizer(std::shared_ptr<QuantizerOptions> options, std::shared_ptr<VectorSet> raw_vectors, std::unique_ptr<float[]>& mins, std::unique_ptr<float[]>& maxs)
+{
+    DimensionType dim = raw_vectors->Dimension();
+    mins = std::make_unique<float[]>(dim);
+    maxs = std::make_unique<float[]>(dim);
+    for (DimensionType j = 0; j < dim; j++) {
+        mins[j] = (std::numeric_limits<float>::max)();
+        maxs[j] = std::numeric_limits<float>::lowest();
+    }
+
+    LOG(Helper::LogLevel::LL_Info, "Begin Training Scalar Quantizer Ranges.\n");
+    for (SizeType vectorIdx = 0; vectorIdx < raw_vectors->Count(); vectorIdx++) {
+        T* vec = reinterpret_cast<T*>(raw_vectors->GetVector(vectorIdx));
+        for (DimensionType j = 0; j < dim; j++) {
+            mins[j] = min(mins[j], (float)vec[j]);
+            maxs[j] = max(maxs[j], (float)vec[j]);
+        }
+    }
+
+    if (options->m_debug) {
+        for (DimensionType j = 0; j < dim; j++) {
+            std::cout << mins[j] << ':' << maxs[j] << '\t';
+        }
+        std::cout << std::endl;
+    }
+}
+
+// out(n x d) = in(n x d) * rotation(d x d), blocked over rows so each block of the input stays in cache
+inline void OPQRotate(const float* in, const float* rotation, float* out, SizeType n, DimensionType d)
+{
+#pragma omp parallel for schedule(dynamic)
+    for (SizeType block = 0; block < n; block += 64) {
+        SizeType end = min(n, block + 64);
+        for (SizeType r = block; r < end; r++) {
+            float* y = out + (size_t)r * d;
+            const float* x = in + (size_t)r * d;
+            std::fill(y, y + d, 0.0f);
+            for (DimensionType k = 0; k < d; k++) {
+                const float xk = x[k];
+                const float* row = rotation + (size_t)k * d;
+                for (DimensionType j = 0; j < d; j++) y[j] += xk * row[j];
+            }
+        }
+    }
+}
+
+// correlation(d x d) = X^T * Yhat, where row r of Yhat is the concatenation of the centroids coded in labels.
+// Yhat is rebuilt one block of rows at a time, and the blocks are split by output rows across threads.
+inline void OPQCorrelation(const float* X, const float* codebooks, const std::uint8_t* labels, std::vector<double>& correlation,
+    SizeType n, DimensionType d, DimensionType numSubvectors, SizeType numCentroids)
+{
+    correlation.assign((size_t)d * d, 0);
+    const DimensionType rowsPerTask = 16;
+    DimensionType subdim = d / numSubvectors;
+    std::vector<float> partial((size_t)d * d), reconstructed((size_t)blockRows * d);
+    for (SizeType block = 0; block < n; block += blockRows) {
+        SizeType end = min(n, block + blockRows);
+#pragma omp parallel for
+        for (SizeType r = block; r < end; r++) {
+            for (DimensionType m = 0; m < numSubvectors; m++) {
+                const float* centroid = codebooks + ((size_t)m * numCentroids + labels[(size_t)r * numSubvectors + m]) * subdim;
+                std::copy(centroid, centroid + subdim, reconstructed.data() + (size_t)(r - block) * d + m * subdim);
+            }
+        }
+#pragma omp parallel for schedule(dynamic)
+        for (DimensionType i0 = 0; i0 < d; i0 += rowsPerTask) {
+            DimensionType i1 = min(d, i0 + rowsPerTask);
+            std::fill(partial.begin() + (size_t)i0 * d, partial.begin() + (size_t)i1 * d, 0.0f);
+            for (SizeType r = block; r < end; r++) {
+                const float* x = X + (size_t)r * d;
+                const float* y = reconstructed.data() + (size_t)(r - block) * d;
+                for (DimensionType i = i0; i < i1; i++) {
+                    const float xi = x[i];
+                    float* acc = partial.data() + (size_t)i * d;
+                    for (DimensionType j = 0; j < d; j++) acc[j] += xi * y[j];
+                }
+            }
+            for (size_t k = (size_t)i0 * d; k < (size_t)i1 * d; k++) correlation[k] += partial[k];
+        }
+    }
+}
+
+// Orthogonal Procrustes: rotation = U * V^T for correlation = U * S * V^T, computed with a
+// parallel one-sided Jacobi SVD (round-robin pair ordering so each round touches disjoint columns).
+inline void OPQProcrustes(const std::vector<double>& correlation, DimensionType d, float* rotation)
+{
+    // column j of W and V is stored contiguously at [j * d, (j + 1) * d)
+    std::vector<double> W((size_t)d * d), V((size_t)d * d, 0);
+    for (DimensionType i = 0; i < d; i++) {
+        for (DimensionType j = 0; j < d; j++) W[(size_t)j * d + i] = correlation[(size_t)i * d + j];
+        V[(size_t)i * d + i] = 1;
+    }
+
+    DimensionType players = d + (d & 1);
+    std::vector<DimensionType> order(players);
+    for (DimensionType i = 0; i < players; i++) order[i] = i;
+
+    for (int sweep = 0; sweep < 30; sweep++) {
+        double maxOff = 0;
+        for (DimensionType round = 0; round < players - 1; round++) {
+#pragma omp parallel for schedule(dynamic) reduction(max:maxOff)
+            for (DimensionType k = 0; k < players / 2; k++) {
+                DimensionType p = order[k], q = order[players - 1 - k];
+                if (p >= d || q >= d) continue;
+                double* wp = W.data() + (size_t)p * d;
+                double* wq = W.data() + (size_t)q * d;
+                double alpha = 0, beta = 0, gamma = 0;
+                for (DimensionType i = 0; i < d; i++) {
+                    alpha += wp[i] * wp[i];
+                    beta += wq[i] * wq[i];
+                    gamma += wp[i] * wq[i];
+                }
+                if (alpha == 0 || beta == 0) continue;
+                double off = std::abs(gamma) / std::sqrt(alpha * beta);
+                maxOff = max(maxOff, off);
+                if (off < 1e-12) continue;
+
+                double zeta = (beta - alpha) / (2 * gamma);
+                double t = ((zeta >= 0) ? 1.0 : -1.0) / (std::abs(zeta) + std::sqrt(1 + zeta * zeta));
+                double c = 1 / std::sqrt(1 + t * t), s = c * t;
+                double* vp = V.data() + (size_t)p * d;
+                double* vq = V.data() + (size_t)q * d;
+                for (DimensionType i = 0; i < d; i++) {
+                    double a = wp[i], b = wq[i];
+                    wp[i] = c * a - s * b;
+                    wq[i] = s * a + c * b;
+                    a = vp[i]; b = vq[i];
+                    vp[i] = c * a - s * b;
+                    vq[i] = s * a + c * b;
+                }
+            }
+            DimensionType last = order[players - 1];
+            for (DimensionType i = players - 1; i > 1; i--) order[i] = order[i - 1];
+            order[1] = last;
+        }
+        if (maxOff < 1e-10) break;
+    }
+
+    // normalize the columns of W into U; columns with vanishing singular values are completed by Gram-Schmidt
+    double maxNorm = 0;
+    std::vector<double> norms(d);
+    for (DimensionType j = 0; j < d; j++) {
+        double norm = 0;
+        for (DimensionType i = 0; i < d; i++) norm += W[(size_t)j * d + i] * W[(size_t)j * d + i];
+        norms[j] = std::sqrt(norm);
+        maxNorm = max(maxNorm, norms[j]);
+    }
+    DimensionType basis = 0;
+    for (DimensionType j = 0; j < d; j++) {
+        double* u = W.data() + (size_t)j * d;
+        if (norms[j] > 1e-9 * maxNorm) {
+            for (DimensionType i = 0; i < d; i++) u[i] /= norms[j];
+            continue;
+        }
+        while (true) {
+            std::fill(u, u + d, 0.0);
+            u[basis++ % d] = 1;
+            for (DimensionType k = 0; k < d; k++) {
+                if (k == j || (norms[k] <= 1e-9 * maxNorm && k > j)) continue;
+                const double* other = W.data() + (size_t)k * d;
+                double dot = 0;
+                for (DimensionType i = 0; i < d; i++) dot += u[i] * other[i];
+                for (DimensionType i = 0; i < d; i++) u[i] -= dot * other[i];
+            }
+            double norm = 0;
+            for (DimensionType i = 0; i < d; i++) norm += u[i] * u[i];
+            if (norm > 1e-6) {
+                norm = std::sqrt(norm);
+                for (DimensionType i = 0; i < d; i++) u[i] /= norm;
+                break;
+            }
+        }
+    }
+
+#pragma omp parallel for schedule(dynamic)
+    for (DimensionType i = 0; i < d; i++) {
+        for (DimensionType k = 0; k < d; k++) {
+            double sum = 0;
+            for (DimensionType j = 0; j < d; j++) sum += W[(size_t)j * d + i] * V[(size_t)j * d + k];
+            rotation[(size_t)i * d + k] = (float)sum;
+        }
+    }
+}
+
+// Lloyd iterations on one subspace of the rotated samples, warm started from the given centroids
+inline float OPQSubspaceKmeans(const float* Y, SizeType n, DimensionType d, DimensionType offset, DimensionType subdim, SizeType numCentroids, float* centroids, std::uint8_t* labels, int iterations, int codeStride, int codeIdx)
+{
+    auto distCalc = COMMON::DistanceCalcSelector<float>(DistCalcMethod::L2);
+    int threads = omp_get_max_threads();
+    std::vector<double> sums((size_t)threads * numCentroids * subdim);
+    std::vector<SizeType> counts((size_t)threads * numCentroids);
+    double distortion = 0;
+    for (int iter = 0; iter <= iterations; iter++) {
+        distortion = 0;
+#pragma omp parallel for schedule(dynamic, 1024) reduction(+:distortion)
+        for (SizeType r = 0; r < n; r++) {
+            const float* y = Y + (size_t)r * d + offset;
+            float best = (std::numeric_limits<float>::max)();
+            int bestIdx = 0;
+            for (SizeType c = 0; c < numCentroids; c++) {
+                float dist = distCalc(y, centroids + (size_t)c * subdim, subdim);
+                if (dist < best) {
+                    best = dist;
+                    bestIdx = (int)c;
+                }
+            }
+            labels[(size_t)r * codeStride + codeIdx] = (std::uint8_t)bestIdx;
+            distortion += best;
+        }
+        if (iter == iterations) break;
+
+        // each thread sums its share of the rows, then the per thread sums are folded per centroid
+        std::fill(sums.begin(), sums.end(), 0);
+        std::fill(counts.begin(), counts.end(), 0);
+#pragma omp parallel
+        {
+            int tid = omp_get_thread_num();
+            double* localSums = sums.data() + (size_t)tid * numCentroids * subdim;
+            SizeType* localCounts = counts.data() + (size_t)tid * numCentroids;
+#pragma omp for schedule(static)
+            for (SizeType r = 0; r < n; r++) {
+                int c = labels[(size_t)r * codeStride + codeIdx];
+                const float* y = Y + (size_t)r * d + offset;
+                for (DimensionType k = 0; k < subdim; k++) localSums[(size_t)c * subdim + k] += y[k];
+                localCounts[c]++;
+            }
+        }
+#pragma omp parallel for
+        for (SizeType c = 0; c < numCentroids; c++) {
+            for (int t = 1; t < threads; t++) {
+                const double* localSums = sums.data() + (size_t)t * numCentroids * subdim;
+                for (DimensionType k = 0; k < subdim; k++) sums[(size_t)c * subdim + k] += localSums[(size_t)c * subdim + k];
+                counts[c] += counts[(size_t)t * numCentroids + c];
+            }
+            if (counts[c] == 0) continue;
+            float* centroid = centroids + (size_t)c * subdim;
+            for (DimensionType k = 0; k < subdim; k++) centroid[k] = (float)(sums[(size_t)c * subdim + k] / counts[c]);
+        }
+        for (SizeType c = 0; c < numCentroids; c++) {
+            if (counts[c] != 0) continue;
+            // reseed empty clusters with a random sample
+            const float* y = Y + (size_t)COMMON::Utils::rand(n) * d + offset;
+            std::copy(y, y + subdim, centroids + (size_t)c * subdim);
+        }
+    }
+    return (float)(distortion / n);
+}
+
+template <typename T>
+std::unique_ptr<float[]> TrainOPQQuantizer(std::shared_ptr<QuantizerOptions> options, std::shared_ptr<VectorSet> raw_vectors, std::shared_ptr<VectorSet> quantized_vectors, std::unique_ptr<float[]>& rotation)
+{
+    SizeType numCentroids = options->m_KsPerSubvector;
+    if (numCentroids <= 0 || numCentroids > 256) {
+        LOG(Helper::LogLevel::LL_Error, "KsPerSubvector must be in (0, 256].\n");
+        exit(1);
+    }
+    DimensionType dim = raw_vectors->Dimension();
+    if (dim % options->m_quantizedDim != 0) {
+        LOG(Helper::LogLevel::LL_Error, "Only n_codebooks that divide dimension are supported.\n");
+        exit(1);
+    }
+    DimensionType subdim = dim / options->m_quantizedDim;
+    omp_set_num_threads(options->m_threadNum);
+
+    // The rotation and codebooks are learned on a random subset of at most m_opqSamples rows; X holds it as
+    // float and Y its rotation, so training memory is bounded by the subset rather than the training set
+    SizeType n = raw_vectors->Count();
+    std::vector<SizeType> rows(n);
+    for (SizeType r = 0; r < n; r++) rows[r] = r;
+    if (options->m_opqSamples > 0 && options->m_opqSamples < n) {
+        for (SizeType r = 0; r < options->m_opqSamples; r++) std::swap(rows[r], rows[r + COMMON::Utils::rand(n - r)]);
+        n = options->m_opqSamples;
+        rows.resize(n);
+        std::sort(rows.begin(), rows.end());
+    }
+
+    std::vector<float> X((size_t)n * dim), Y((size_t)n * dim);
+#pragma omp parallel for
+    for (SizeType r = 0; r < n; r++) {
+        T* vec = reinterpret_cast<T*>(raw_vectors->GetVector(rows[r]));
+        for (DimensionType j = 0; j < dim; j++) X[(size_t)r * dim + j] = (float)vec[j];
+    }
+
+    rotation = std::make_unique<float[]>((size_t)dim * dim);
+    for (DimensionType i = 0; i < dim; i++) rotation[(size_t)i * dim + i] = 1;
+    std::copy(X.begin(), X.end(), Y.begin());
+
+    auto codebooks = std::make_unique<float[]>((size_t)numCentroids * dim);
+    for (DimensionType m = 0; m < options->m_quantizedDim; m++) {
+        for (SizeType c = 0; c < numCentroids; c++) {
+            const float* y = Y.data() + (size_t)COMMON::Utils::rand(n) * dim + m * subdim;
+            std::copy(y, y + subdim, codebooks.get() + ((size_t)m * numCentroids + c) * subdim);
+        }
+    }
+
+    auto labels = reinterpret_cast<std::uint8_t*>(quantized_vectors->GetVector(0));
+    std::vector<double> correlation;
+    LOG(Helper::LogLevel::LL_Info, "Begin Training OPQ Quantizer: %d samples, %d subvectors, %d centroids.\n", n, options->m_quantizedDim, numCentroids);
+    for (int iter = 0; iter <= options->m_opqIterations; iter++) {
+        bool last = (iter == options->m_opqIterations);
+        float distortion = 0;
+        for (DimensionType m = 0; m < options->m_quantizedDim; m++) {
+            distortion += OPQSubspaceKmeans(Y.data(), n, dim, m * subdim, subdim, numCentroids,
+                codebooks.get() + (size_t)m * numCentroids * subdim, labels, last ? 25 : 4, options->m_quantizedDim, m);
+        }
+        LOG(Helper::LogLevel::LL_Info, "OPQ iteration %d: mean quantization distortion %f\n", iter, distortion);
+        if (last) break;
+
+        OPQCorrelation(X.data(), codebooks.get(), labels, correlation, n, dim, options->m_quantizedDim, numCentroids);
+        OPQProcrustes(correlation, dim, rotation.get());
+        OPQRotate(X.data(), rotation.get(), Y.data(), n, dim);
+    }
+    return codebooks;
+}
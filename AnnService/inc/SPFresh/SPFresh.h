@@ -268,8 +268,10 @@ namespace SPTAG {
 
                 StopWSPFresh sw;
 
-                auto func = [&]()
+                auto func = [&](int i)
                 {
+                    // Spread the threads over the nodes so each searches the head replica in its local memory
+                    if (p_index->GetOptions()->m_numaHeadReplicas) Helper::BindThreadToNumaNode(i % Helper::GetNumaNodeCount());
                     p_index->Initialize();
                     StopWSPFresh threadws;
                     size_t index = 0;
@@ -279,7 +281,7 @@ namespace SPTAG {
                         if (index < numQueries)
                         {
                             double startTime = threadws.getElapsedMs();
-                            p_index->GetMemoryIndex()->SearchIndex(p_results[index]);
+                            p_index->GetLocalMemoryIndex()->SearchIndex(p_results[index]);
                             double endTime = threadws.getElapsedMs();
 
                             p_stats[index].m_totalLatency = endTime - startTime;
@@ -297,7 +299,7 @@ namespace SPTAG {
                         }
                     }
                 };
-                for (int i = 0; i < p_numThreads; i++) { threads.emplace_back(func); }
+                for (int i = 0; i < p_numThreads; i++) { threads.emplace_back(func, i); }
                 for (auto& thread : threads) { thread.join(); }
 
                 auto sendingCost = sw.getElapsedSec();
@@ -735,39 +737,43 @@ namespace SPTAG {
                 std::vector<double> latency_vector(updateSize);
 
                 std::atomic_size_t vectorsSent(0);
+                size_t batchSize = (std::max)(1, p_opts.m_insertBatchSize);
 
                 auto func = [&]()
                 {
                     p_index->Initialize();
                     size_t index = 0;
+                    std::vector<ValueType> batch;
+                    std::vector<SizeType> batchVIDs;
                     while (true)
                     {
-                        index = vectorsSent.fetch_add(1);
+                        index = vectorsSent.fetch_add(batchSize);
                         if (index < updateSize)
                         {
-                            if ((index & ((1 << 14) - 1)) == 0 && p_opts.m_showUpdateProgress)
+                            if ((index & ((1 << 14) - 1)) < batchSize && p_opts.m_showUpdateProgress)
                             {
                                 LOG(Helper::LogLevel::LL_Info, "Insert: Sent %.2lf%%...\n", index * 100.0 / updateSize);
                             }
-                            // std::vector<char> meta;
-                            // std::vector<std::uint64_t> metaoffset;
-                            // std::string a = std::to_string(insertSet[index]);
-                            // metaoffset.push_back((std::uint64_t)meta.size());
-                            // for (size_t j = 0; j < a.length(); j++)
-                            //     meta.push_back(a[j]);
-                            // metaoffset.push_back((std::uint64_t)meta.size());
-                            // std::shared_ptr<SPTAG::MetadataSet> metaset(new SPTAG::MemMetadataSet(
-                            //     SPTAG::ByteArray((std::uint8_t*)meta.data(), meta.size() * sizeof(char), false),
-                            //     SPTAG::ByteArray((std::uint8_t*)metaoffset.data(), metaoffset.size() * sizeof(std::uint64_t), false),
-                            //     1));
-                            if (p_opts.m_stressTest) p_index->DeleteIndex(mapping[insertSet[index]]);
+                            size_t batchEnd = (std::min)(index + batchSize, (size_t)updateSize);
+                            SizeType batchNum = (SizeType)(batchEnd - index);
+                            if (p_opts.m_stressTest) {
+                                for (size_t i = index; i < batchEnd; i++) p_index->DeleteIndex(mapping[insertSet[i]]);
+                            }
+                            // Vectors of a batch are not contiguous in the set, so they are gathered first
+                            batch.resize(static_cast<size_t>(batchNum) * p_opts.m_dim);
+                            batchVIDs.resize(batchNum);
+                            for (size_t i = index; i < batchEnd; i++) {
+                                const void* vector = p_opts.m_loadAllVectors ? vectorSet->GetVector(insertSet[i]) : vectorSet->GetVector((SizeType)i);
+                                memcpy(batch.data() + (i - index) * p_opts.m_dim, vector, sizeof(ValueType) * p_opts.m_dim);
+                            }
                             auto insertBegin = std::chrono::high_resolution_clock::now();
-                            if (p_opts.m_loadAllVectors)
-                                p_index->AddIndexSPFresh(vectorSet->GetVector(insertSet[index]), 1, p_opts.m_dim, &mapping[insertSet[index]]);
-                            else
-                                p_index->AddIndexSPFresh(vectorSet->GetVector(index), 1, p_opts.m_dim, &mapping[insertSet[index]]);
+                            p_index->AddIndexSPFresh(batch.data(), batchNum, p_opts.m_dim, batchVIDs.data());
                             auto insertEnd = std::chrono::high_resolution_clock::now();
-                            latency_vector[index] = std::chrono::duration_cast<std::chrono::microseconds>(insertEnd - insertBegin).count();
+                            double latency = (double)std::chrono::duration_cast<std::chrono::microseconds>(insertEnd - insertBegin).count();
+                            for (size_t i = index; i < batchEnd; i++) {
+                                mapping[insertSet[i]] = batchVIDs[i - index];
+                                latency_vector[i] = latency;
+                            }
                         }
                         else
                         {
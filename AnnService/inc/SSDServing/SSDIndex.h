@@ -116,7 +116,8 @@ namespace SPTAG {
 
                 for (int i = 0; i < p_numThreads; i++) { threads.emplace_back([&, i]()
                     {
-                        // Helper::SetThreadAffinity( ((i+1) * 4), threads[i], 0, 0);
+                        // Spread the threads over the nodes so each searches the head replica in its local memory
+                        if (p_index->GetOptions()->m_numaHeadReplicas) Helper::BindThreadToNumaNode(i % Helper::GetNumaNodeCount());
 
                         p_index->Initialize();
 
@@ -133,9 +134,19 @@ namespace SPTAG {
                                 }
 
                                 double startTime = threadws.getElapsedMs();
-                                p_index->GetMemoryIndex()->SearchIndex(p_results[index]);
+                                if (p_index->GetOptions()->m_queryDeadline > 0)
+                                    p_stats[index].m_deadline = std::chrono::steady_clock::now() + std::chrono::microseconds((std::int64_t)(p_index->GetOptions()->m_queryDeadline * 1000));
+                                std::uint64_t epoch = p_index->GetUpdateEpoch();
+                                if (p_index->LookupQueryCache(p_results[index], epoch, &(p_stats[index])))
+                                {
+                                    p_stats[index].m_exLatency = 0;
+                                    p_stats[index].m_totalLatency = p_stats[index].m_totalSearchLatency = threadws.getElapsedMs() - startTime;
+                                    continue;
+                                }
+                                p_index->SearchHeadIndex(p_results[index], &(p_stats[index]));
                                 double endTime = threadws.getElapsedMs();
                                 p_index->SearchDiskIndex(p_results[index], &(p_stats[index]));
+                                if (!p_stats[index].m_degraded) p_index->InsertQueryCache(p_results[index], epoch);
                                 double exEndTime = threadws.getElapsedMs();
 
                                 p_stats[index].m_exLatency = exEndTime - endTime;
@@ -236,11 +247,12 @@ namespace SPTAG {
                 LOG(Helper::LogLevel::LL_Info, "\nFinish ANN Search...\n");
 
                 std::shared_ptr<VectorSet> vectorSet;
+                std::string fullVectorPath = p_opts.m_rerankVectorPath.empty() ? p_opts.m_vectorPath : p_opts.m_rerankVectorPath;
 
-                if (!p_opts.m_vectorPath.empty() && fileexists(p_opts.m_vectorPath.c_str())) {
+                if (!fullVectorPath.empty() && fileexists(fullVectorPath.c_str())) {
                     std::shared_ptr<Helper::ReaderOptions> vectorOptions(new Helper::ReaderOptions(p_opts.m_valueType, p_opts.m_dim, p_opts.m_vectorType, p_opts.m_vectorDelimiter));
                     auto vectorReader = Helper::VectorSetReader::CreateInstance(vectorOptions);
-                    if (ErrorCode::Success == vectorReader->LoadFile(p_opts.m_vectorPath))
+                    if (ErrorCode::Success == vectorReader->LoadFile(fullVectorPath))
                     {
                         vectorSet = vectorReader->GetVectorSet();
                         if (p_opts.m_distCalcMethod == DistCalcMethod::Cosine) vectorSet->Normalize(numThreads);
@@ -294,6 +306,47 @@ namespace SPTAG {
                     },
                     "%.3lf");
 
+                if (p_opts.m_enableQueryCache)
+                {
+                    size_t hits = std::count_if(stats.begin(), stats.end(), [](const SPANN::SearchStats& ss) { return ss.m_cacheHit; });
+                    LOG(Helper::LogLevel::LL_Info, "\nQuery Cache Hit Rate: %.3lf (%zu hits, %zu misses)\n", stats.empty() ? 0.0 : (double)hits / stats.size(), hits, stats.size() - hits);
+                }
+
+                if (p_opts.m_queryDeadline > 0)
+                {
+                    size_t degraded = std::count_if(stats.begin(), stats.end(), [](const SPANN::SearchStats& ss) { return ss.m_degraded; });
+                    LOG(Helper::LogLevel::LL_Info, "\nDeadline Degraded Queries: %zu of %zu\n", degraded, stats.size());
+                    LOG(Helper::LogLevel::LL_Info, "\nSkipped Postings:\n");
+                    PrintPercentiles<double, SPANN::SearchStats>(stats,
+                        [](const SPANN::SearchStats& ss) -> double
+                        {
+                            return ss.m_skippedPostingCount;
+                        },
+                        "%.3lf");
+                }
+
+                if (p_opts.m_enableSignCode)
+                {
+                    LOG(Helper::LogLevel::LL_Info, "\nSign Code Skipped Count:\n");
+                    PrintPercentiles<double, SPANN::SearchStats>(stats,
+                        [](const SPANN::SearchStats& ss) -> double
+                        {
+                            return ss.m_signCodeSkipCount;
+                        },
+                        "%.3lf");
+                }
+
+                if (p_opts.m_enableFastScan)
+                {
+                    LOG(Helper::LogLevel::LL_Info, "\nFast Scan Skipped Count:\n");
+                    PrintPercentiles<double, SPANN::SearchStats>(stats,
+                        [](const SPANN::SearchStats& ss) -> double
+                        {
+                            return ss.m_fastScanSkipCount;
+                        },
+                        "%.3lf");
+                }
+
                 LOG(Helper::LogLevel::LL_Info, "\nHead Latency Distribution:\n");
                 PrintPercentiles<double, SPANN::SearchStats>(stats,
                     [](const SPANN::SearchStats& ss) -> double
@@ -28,6 +28,9 @@ struct ServiceSettings
     SizeType m_threadNum;
 
     SizeType m_socketThreadNum;
+
+    // Bind the search threads to NUMA nodes round-robin
+    bool m_numaAffinity;
 };
 
 
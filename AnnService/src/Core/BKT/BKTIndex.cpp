@@ -3,6 +3,7 @@
 
 #include "inc/Core/BKT/Index.h"
 #include <chrono>
+#include <unordered_set>
 
 #pragma warning(disable:4242)  // '=' : conversion from 'int' to 'short', possible loss of data
 #pragma warning(disable:4244)  // '=' : conversion from 'int' to 'short', possible loss of data
@@ -86,6 +87,7 @@ namespace SPTAG
             if (p_indexStreams[3] == nullptr) m_deletedID.Initialize(m_pSamples.R(), m_iDataBlockSize, m_iDataCapacity);
             else if ((ret = m_deletedID.Load(p_indexStreams[3], m_iDataBlockSize, m_iDataCapacity)) != ErrorCode::Success) return ret;
 
+            if (m_iHugePageMode != 0 || m_iNumaPlacement != 0) COMMON::PageAllocator::LogStats();
             omp_set_num_threads(m_iNumberOfThreads);
             m_threadPool.init();
             return ret;
@@ -409,6 +411,12 @@ namespace SPTAG
 
         template<typename T>
         ErrorCode Index<T>::SearchIndex(QueryResult &p_query, bool p_searchDeleted) const
+        {
+            return SearchIndexWithBudget(p_query, m_iMaxCheck, p_searchDeleted);
+        }
+
+        template<typename T>
+        ErrorCode Index<T>::SearchIndexWithBudget(QueryResult& p_query, int p_maxCheck, bool p_searchDeleted) const
         {
             if (!m_bReady) return ErrorCode::EmptyIndex;
 
@@ -416,7 +424,7 @@ namespace SPTAG
                 m_workspace.reset(new COMMON::WorkSpace());
                 m_workspace->Initialize(max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp);
             }
-            m_workspace->Reset(m_iMaxCheck, p_query.GetResultNum());
+            m_workspace->Reset(min(p_maxCheck, max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph)), p_query.GetResultNum(), VisitedSize());
             SearchIndex(*((COMMON::QueryResultSet<T>*)&p_query), *m_workspace, p_searchDeleted, true);
 
             if (p_query.WithMeta() && nullptr != m_pMetadata)
@@ -437,12 +445,87 @@ namespace SPTAG
                 m_workspace.reset(new COMMON::WorkSpace());
                 m_workspace->Initialize(max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp);
             }
-            m_workspace->Reset(m_pGraph.m_iMaxCheckForRefineGraph, p_query.GetResultNum());
+            m_workspace->Reset(m_pGraph.m_iMaxCheckForRefineGraph, p_query.GetResultNum(), VisitedSize());
             SearchIndex(*((COMMON::QueryResultSet<T>*)&p_query), *m_workspace, p_searchDeleted, false);
 
             return ErrorCode::Success;
         }
 
+        template <typename T>
+        ErrorCode Index<T>::RangeSearch(const void* p_vector, float p_radius, int p_maxResults, std::vector<BasicResult>& p_results) const
+        {
+            if (!m_bReady) return ErrorCode::EmptyIndex;
+
+            if (m_workspace.get() == nullptr) {
+                m_workspace.reset(new COMMON::WorkSpace());
+                m_workspace->Initialize(max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp);
+            }
+            COMMON::WorkSpace& space = *m_workspace;
+            // The frontier keeps the best p_maxResults distances seen so far, so the walk is not cut off before enough in-radius nodes are reached
+            space.Reset(m_iMaxCheck, min(p_maxResults, m_iMaxCheck), VisitedSize());
+
+            // The query set only carries the (quantized) target; matches stream into p_results instead of a heap
+            COMMON::QueryResultSet<T> query((const T*)p_vector, 1);
+            if (m_pQuantizer) query.SetTarget((const T*)p_vector, m_pQuantizer);
+
+            std::shared_lock<std::shared_timed_mutex> lock(*(m_pTrees.m_lock));
+            m_pTrees.InitSearchTrees(m_pSamples, m_fComputeDistance, query, space);
+            m_pTrees.SearchTrees(m_pSamples, m_fComputeDistance, query, space, m_iNumberOfInitialDynamicPivots);
+            const DimensionType checkPos = m_pGraph.m_iNeighborhoodSize - 1;
+            std::unordered_set<SizeType> duplicates;
+
+            while (!space.m_NGQueue.empty() && (int)p_results.size() < p_maxResults) {
+                NodeDistPair gnode = space.m_NGQueue.pop();
+                SizeType tmpNode = gnode.node;
+                const SizeType* node = m_pGraph[tmpNode];
+
+                if (gnode.distance <= p_radius)
+                {
+                    SizeType checkNode = node[checkPos];
+                    if (checkNode < -1)
+                    {
+                        // Every member of a duplicate group sits at the same distance; emit the group once
+                        const COMMON::BKTNode& tnode = m_pTrees[-2 - checkNode];
+                        SizeType i = -tnode.childStart;
+                        do
+                        {
+                            if (!m_deletedID.Contains(tmpNode) && duplicates.insert(tmpNode).second)
+                                p_results.emplace_back(tmpNode, gnode.distance);
+                            tmpNode = m_pTrees[i].centerid;
+                        } while (i++ < tnode.childEnd && (int)p_results.size() < p_maxResults);
+                    }
+                    else if (!m_deletedID.Contains(tmpNode) && duplicates.insert(tmpNode).second)
+                    {
+                        p_results.emplace_back(tmpNode, gnode.distance);
+                    }
+                }
+                else if (gnode.distance > space.m_Results.worst() || space.m_iNumberOfCheckedLeaves > space.m_iMaxCheck)
+                {
+                    break;
+                }
+
+                for (DimensionType i = 0; i <= checkPos; i++)
+                {
+                    SizeType nn_index = node[i];
+                    if (nn_index < 0)
+                        break;
+                    if (space.CheckAndSet(nn_index)) continue;
+                    float distance2leaf = m_fComputeDistance(query.GetQuantizedTarget(), (m_pSamples)[nn_index], GetFeatureDim());
+                    space.m_iNumberOfCheckedLeaves++;
+                    // In-radius neighbors are always expanded; the rest compete for the bounded frontier as in Search
+                    if (space.m_Results.insert(distance2leaf) || distance2leaf <= p_radius)
+                    {
+                        space.m_NGQueue.insert(NodeDistPair(nn_index, distance2leaf));
+                    }
+                }
+                if (space.m_NGQueue.Top().distance > space.m_SPTQueue.Top().distance)
+                {
+                    m_pTrees.SearchTrees(m_pSamples, m_fComputeDistance, query, space, m_iNumberOfOtherDynamicPivots + space.m_iNumberOfCheckedLeaves);
+                }
+            }
+            return ErrorCode::Success;
+        }
+
         template <typename T>
         ErrorCode Index<T>::SearchTree(QueryResult& p_query) const
         {
@@ -450,7 +533,7 @@ namespace SPTAG
                 m_workspace.reset(new COMMON::WorkSpace());
                 m_workspace->Initialize(max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp);
             }
-            m_workspace->Reset(m_pGraph.m_iMaxCheckForRefineGraph, p_query.GetResultNum());
+            m_workspace->Reset(m_pGraph.m_iMaxCheckForRefineGraph, p_query.GetResultNum(), VisitedSize());
 
             COMMON::QueryResultSet<T>* p_results = (COMMON::QueryResultSet<T>*)&p_query;
             m_pTrees.InitSearchTrees(m_pSamples, m_fComputeDistance, *p_results, *m_workspace);
@@ -497,6 +580,7 @@ namespace SPTAG
             auto t3 = std::chrono::high_resolution_clock::now();
             LOG(Helper::LogLevel::LL_Info, "Build Graph time (s): %lld\n", std::chrono::duration_cast<std::chrono::seconds>(t3 - t2).count());
 
+            if (m_iHugePageMode != 0 || m_iNumaPlacement != 0) COMMON::PageAllocator::LogStats();
             m_bReady = true;
             return ErrorCode::Success;
         }
@@ -552,6 +636,34 @@ namespace SPTAG
             return ret;
         }
 
+        template <typename T>
+        ErrorCode Index<T>::ReorderForLocality(std::vector<SizeType>& p_newToOld)
+        {
+            std::lock_guard<std::mutex> lock(m_dataAddLock);
+            std::unique_lock<std::shared_timed_mutex> uniquelock(m_dataDeleteLock);
+
+            if (nullptr != m_pMetadata) {
+                LOG(Helper::LogLevel::LL_Warning, "Reorder skipped: the index has metadata bound to vector ids.\n");
+                return ErrorCode::Fail;
+            }
+
+            SizeType n = m_pSamples.R();
+            if (n == 0) return ErrorCode::EmptyIndex;
+
+            // Depth-first order of the first tree puts each leaf cluster in a contiguous id range
+            m_pTrees.LocalityOrder(n, p_newToOld);
+            std::vector<SizeType> oldToNew(n);
+            for (SizeType i = 0; i < n; i++) oldToNew[p_newToOld[i]] = i;
+
+            m_pSamples.Permute(p_newToOld);
+            m_pGraph.Permute(p_newToOld, oldToNew);
+            m_deletedID.Permute(p_newToOld);
+            m_pTrees.RemapIDs(oldToNew);
+
+            LOG(Helper::LogLevel::LL_Info, "Reordered %d vectors for locality.\n", n);
+            return ErrorCode::Success;
+        }
+
         template <typename T>
         ErrorCode Index<T>::RefineIndex(const std::vector<std::shared_ptr<Helper::DiskIO>>& p_indexStreams, IAbortOperation* p_abort)
         {
@@ -783,6 +895,13 @@ namespace SPTAG
                 auto base = m_pQuantizer ? m_pQuantizer->GetBase() : COMMON::Utils::GetBase<T>();
                 m_iBaseSquare = (m_iDistCalcMethod == DistCalcMethod::Cosine) ? base * base : 1;
             }
+            else if (SPTAG::Helper::StrUtils::StrEqualIgnoreCase(p_param, "HugePageMode") || SPTAG::Helper::StrUtils::StrEqualIgnoreCase(p_param, "NumaPlacement")) {
+                COMMON::PagePolicy policy;
+                policy.m_mode = (COMMON::HugePageMode)m_iHugePageMode;
+                policy.m_placement = (COMMON::NumaPlacement)m_iNumaPlacement;
+                m_pSamples.SetPagePolicy(policy);
+                m_pGraph.SetPagePolicy(policy);
+            }
             return ErrorCode::Success;
         }
 
@@ -1044,3 +1044,175 @@ float DistanceUtils::ComputeCosineDistance_AVX512(const float* pX, const float*
     while (pX < pEnd1) diff += (*pX++) * (*pY++);
     return 1 - diff;
 }
+
+inline float _mm256_hsum_ps(__m256 v)
+{
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+// expand 8 bytes of SQ4 codes into 16 bytes, one code per dimension
+inline __m128i _mm_unpack_sq4(const std::uint8_t* pCodes)
+{
+    __m128i packed = _mm_loadl_epi64((const __m128i*)pCodes);
+    __m128i mask = _mm_set1_epi8(0x0f);
+    return _mm_unpacklo_epi8(_mm_and_si128(packed, mask), _mm_and_si128(_mm_srli_epi16(packed, 4), mask));
+}
+
+#define SQ4CODE(pCodes, i) ((pCodes[(i) >> 1] >> (((i) & 1) << 2)) & 0x0f)
+
+float DistanceUtils::ComputeSQ8L2Distance(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length)
+{
+    float diff = 0;
+    for (DimensionType i = 0; i < length; i++) {
+        float c1 = pX[i] - pCodes[i] * pStep[i]; diff += c1 * c1;
+    }
+    return diff;
+}
+
+float DistanceUtils::ComputeSQ8L2Distance_AVX(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length)
+{
+    DimensionType end8 = ((length >> 3) << 3);
+    __m256 diff256 = _mm256_setzero_ps();
+    for (DimensionType i = 0; i < end8; i += 8) {
+        __m256 c = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(pCodes + i))));
+        __m256 d = _mm256_sub_ps(_mm256_loadu_ps(pX + i), _mm256_mul_ps(c, _mm256_loadu_ps(pStep + i)));
+        diff256 = _mm256_add_ps(diff256, _mm256_mul_ps(d, d));
+    }
+    float diff = _mm256_hsum_ps(diff256);
+    for (DimensionType i = end8; i < length; i++) {
+        float c1 = pX[i] - pCodes[i] * pStep[i]; diff += c1 * c1;
+    }
+    return diff;
+}
+
+float DistanceUtils::ComputeSQ8L2Distance_AVX512(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length)
+{
+    DimensionType end16 = ((length >> 4) << 4);
+    __m512 diff512 = _mm512_setzero_ps();
+    for (DimensionType i = 0; i < end16; i += 16) {
+        __m512 c = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)(pCodes + i))));
+        __m512 d = _mm512_sub_ps(_mm512_loadu_ps(pX + i), _mm512_mul_ps(c, _mm512_loadu_ps(pStep + i)));
+        diff512 = _mm512_fmadd_ps(d, d, diff512);
+    }
+    float diff = _mm512_reduce_add_ps(diff512);
+    for (DimensionType i = end16; i < length; i++) {
+        float c1 = pX[i] - pCodes[i] * pStep[i]; diff += c1 * c1;
+    }
+    return diff;
+}
+
+float DistanceUtils::ComputeSQ8DotProduct(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length)
+{
+    float diff = 0;
+    for (DimensionType i = 0; i < length; i++) diff += pX[i] * (pCodes[i] * pStep[i]);
+    return diff;
+}
+
+float DistanceUtils::ComputeSQ8DotProduct_AVX(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length)
+{
+    DimensionType end8 = ((length >> 3) << 3);
+    __m256 diff256 = _mm256_setzero_ps();
+    for (DimensionType i = 0; i < end8; i += 8) {
+        __m256 c = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(pCodes + i))));
+        diff256 = _mm256_add_ps(diff256, _mm256_mul_ps(_mm256_loadu_ps(pX + i), _mm256_mul_ps(c, _mm256_loadu_ps(pStep + i))));
+    }
+    float diff = _mm256_hsum_ps(diff256);
+    for (DimensionType i = end8; i < length; i++) diff += pX[i] * (pCodes[i] * pStep[i]);
+    return diff;
+}
+
+float DistanceUtils::ComputeSQ8DotProduct_AVX512(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length)
+{
+    DimensionType end16 = ((length >> 4) << 4);
+    __m512 diff512 = _mm512_setzero_ps();
+    for (DimensionType i = 0; i < end16; i += 16) {
+        __m512 c = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)(pCodes + i))));
+        diff512 = _mm512_fmadd_ps(_mm512_loadu_ps(pX + i), _mm512_mul_ps(c, _mm512_loadu_ps(pStep + i)), diff512);
+    }
+    float diff = _mm512_reduce_add_ps(diff512);
+    for (DimensionType i = end16; i < length; i++) diff += pX[i] * (pCodes[i] * pStep[i]);
+    return diff;
+}
+
+float DistanceUtils::ComputeSQ4L2Distance(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length)
+{
+    float diff = 0;
+    for (DimensionType i = 0; i < length; i++) {
+        float c1 = pX[i] - SQ4CODE(pCodes, i) * pStep[i]; diff += c1 * c1;
+    }
+    return diff;
+}
+
+float DistanceUtils::ComputeSQ4L2Distance_AVX(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length)
+{
+    DimensionType end16 = ((length >> 4) << 4);
+    __m256 diff256 = _mm256_setzero_ps();
+    for (DimensionType i = 0; i < end16; i += 16) {
+        __m128i codes = _mm_unpack_sq4(pCodes + (i >> 1));
+        __m256 c0 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(codes));
+        __m256 c1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(codes, 8)));
+        __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(pX + i), _mm256_mul_ps(c0, _mm256_loadu_ps(pStep + i)));
+        __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(pX + i + 8), _mm256_mul_ps(c1, _mm256_loadu_ps(pStep + i + 8)));
+        diff256 = _mm256_add_ps(diff256, _mm256_add_ps(_mm256_mul_ps(d0, d0), _mm256_mul_ps(d1, d1)));
+    }
+    float diff = _mm256_hsum_ps(diff256);
+    for (DimensionType i = end16; i < length; i++) {
+        float c1 = pX[i] - SQ4CODE(pCodes, i) * pStep[i]; diff += c1 * c1;
+    }
+    return diff;
+}
+
+float DistanceUtils::ComputeSQ4L2Distance_AVX512(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length)
+{
+    DimensionType end16 = ((length >> 4) << 4);
+    __m512 diff512 = _mm512_setzero_ps();
+    for (DimensionType i = 0; i < end16; i += 16) {
+        __m512 c = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_unpack_sq4(pCodes + (i >> 1))));
+        __m512 d = _mm512_sub_ps(_mm512_loadu_ps(pX + i), _mm512_mul_ps(c, _mm512_loadu_ps(pStep + i)));
+        diff512 = _mm512_fmadd_ps(d, d, diff512);
+    }
+    float diff = _mm512_reduce_add_ps(diff512);
+    for (DimensionType i = end16; i < length; i++) {
+        float c1 = pX[i] - SQ4CODE(pCodes, i) * pStep[i]; diff += c1 * c1;
+    }
+    return diff;
+}
+
+float DistanceUtils::ComputeSQ4DotProduct(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length)
+{
+    float diff = 0;
+    for (DimensionType i = 0; i < length; i++) diff += pX[i] * (SQ4CODE(pCodes, i) * pStep[i]);
+    return diff;
+}
+
+float DistanceUtils::ComputeSQ4DotProduct_AVX(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length)
+{
+    DimensionType end16 = ((length >> 4) << 4);
+    __m256 diff256 = _mm256_setzero_ps();
+    for (DimensionType i = 0; i < end16; i += 16) {
+        __m128i codes = _mm_unpack_sq4(pCodes + (i >> 1));
+        __m256 c0 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(codes));
+        __m256 c1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(codes, 8)));
+        diff256 = _mm256_add_ps(diff256, _mm256_mul_ps(_mm256_loadu_ps(pX + i), _mm256_mul_ps(c0, _mm256_loadu_ps(pStep + i))));
+        diff256 = _mm256_add_ps(diff256, _mm256_mul_ps(_mm256_loadu_ps(pX + i + 8), _mm256_mul_ps(c1, _mm256_loadu_ps(pStep + i + 8))));
+    }
+    float diff = _mm256_hsum_ps(diff256);
+    for (DimensionType i = end16; i < length; i++) diff += pX[i] * (SQ4CODE(pCodes, i) * pStep[i]);
+    return diff;
+}
+
+float DistanceUtils::ComputeSQ4DotProduct_AVX512(const float* pX, const std::uint8_t* pCodes, const float* pStep, DimensionType length)
+{
+    DimensionType end16 = ((length >> 4) << 4);
+    __m512 diff512 = _mm512_setzero_ps();
+    for (DimensionType i = 0; i < end16; i += 16) {
+        __m512 c = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_unpack_sq4(pCodes + (i >> 1))));
+        diff512 = _mm512_fmadd_ps(_mm512_loadu_ps(pX + i), _mm512_mul_ps(c, _mm512_loadu_ps(pStep + i)), diff512);
+    }
+    float diff = _mm512_reduce_add_ps(diff512);
+    for (DimensionType i = end16; i < length; i++) diff += pX[i] * (SQ4CODE(pCodes, i) * pStep[i]);
+    return diff;
+}
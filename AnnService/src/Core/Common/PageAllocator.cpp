@@ -0,0 +1,209 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "inc/Core/Common/PageAllocator.h"
+#include "inc/Core/Common.h"
+#include "inc/Helper/AsyncFileReader.h"
+
+#include <fstream>
+
+#ifndef _MSC_VER
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#endif
+
+namespace SPTAG
+{
+    namespace COMMON
+    {
+        namespace
+        {
+            enum AllocKind : int { Heap = 0, Mapped = 1, Transparent = 2, Huge2MB = 3, Huge1GB = 4, KindCount = 5 };
+
+            // Sits in front of every allocation; 64 bytes keeps the returned pointer aligned
+            struct AllocHeader
+            {
+                std::uint64_t m_magic;
+                std::uint64_t m_mapped;
+                std::int32_t m_kind;
+            };
+
+            const std::size_t c_headerSize = 64;
+            const std::uint64_t c_magic = 0x5350544147504147ULL;
+            const std::size_t c_2MB = ((std::size_t)1) << 21;
+            const std::size_t c_1GB = ((std::size_t)1) << 30;
+
+            std::atomic<std::uint64_t> g_bytes[KindCount];
+            std::atomic<std::uint64_t> g_fallbacks(0);
+
+            inline std::size_t RoundUp(std::size_t p_value, std::size_t p_align) { return (p_value + p_align - 1) / p_align * p_align; }
+
+#ifndef _MSC_VER
+            void* MapHuge(std::size_t p_size, int p_pageShift)
+            {
+                void* ptr = mmap(nullptr, p_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (p_pageShift << MAP_HUGE_SHIFT), -1, 0);
+                return (ptr == MAP_FAILED) ? nullptr : ptr;
+            }
+
+            // Maps p_size bytes at a 2MB boundary so that the kernel can back whole ranges with huge pages
+            void* MapAligned(std::size_t p_size, bool p_adviseHuge)
+            {
+                std::size_t length = p_size + c_2MB;
+                char* raw = (char*)mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (raw == (char*)MAP_FAILED) return nullptr;
+                char* aligned = (char*)RoundUp((std::size_t)raw, c_2MB);
+                if (aligned > raw) munmap(raw, aligned - raw);
+                if (raw + length > aligned + p_size) munmap(aligned + p_size, raw + length - (aligned + p_size));
+#ifdef MADV_HUGEPAGE
+                if (p_adviseHuge) madvise(aligned, p_size, MADV_HUGEPAGE);
+#endif
+                return aligned;
+            }
+
+            // Applies the placement before the pages are first touched
+            void Place(void* p_ptr, std::size_t p_size, NumaPlacement p_placement)
+            {
+                if (p_placement == NumaPlacement::Default) return;
+                int nodes = Helper::GetNumaNodeCount();
+                if (nodes <= 1) return;
+
+                const int bitsPerWord = 8 * sizeof(unsigned long);
+                std::vector<unsigned long> mask((nodes + bitsPerWord - 1) / bitsPerWord, 0);
+                int policy;
+                if (p_placement == NumaPlacement::Interleave) {
+                    for (int node = 0; node < nodes; node++) mask[node / bitsPerWord] |= 1UL << (node % bitsPerWord);
+                    policy = 3; // MPOL_INTERLEAVE
+                }
+                else {
+                    int node = Helper::GetCurrentNumaNode();
+                    mask[node / bitsPerWord] |= 1UL << (node % bitsPerWord);
+                    policy = 2; // MPOL_BIND
+                }
+                if (syscall(SYS_mbind, p_ptr, p_size, policy, mask.data(), mask.size() * bitsPerWord + 1, 0) != 0) {
+                    g_fallbacks.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+#endif
+        }
+
+        void* PageAllocator::Allocate(std::size_t p_size, const PagePolicy& p_policy)
+        {
+            std::size_t total = p_size + c_headerSize;
+            HugePageMode mode = p_policy.m_mode;
+            NumaPlacement placement = p_policy.m_placement;
+            void* base = nullptr;
+            std::size_t mapped = 0;
+            int kind = Heap;
+
+            // Below half a huge page the rounding would waste more than it saves
+            if ((mode != HugePageMode::None || placement != NumaPlacement::Default) && total >= c_2MB / 2) {
+#ifndef _MSC_VER
+                if (mode == HugePageMode::Huge1GB && total >= c_1GB / 2) {
+                    mapped = RoundUp(total, c_1GB);
+                    base = MapHuge(mapped, 30);
+                    kind = Huge1GB;
+                    if (base == nullptr) g_fallbacks.fetch_add(1, std::memory_order_relaxed);
+                }
+                if (base == nullptr && (mode == HugePageMode::Huge1GB || mode == HugePageMode::Huge2MB)) {
+                    mapped = RoundUp(total, c_2MB);
+                    base = MapHuge(mapped, 21);
+                    kind = Huge2MB;
+                    if (base == nullptr) g_fallbacks.fetch_add(1, std::memory_order_relaxed);
+                }
+                if (base == nullptr) {
+                    mapped = RoundUp(total, c_2MB);
+                    base = MapAligned(mapped, mode != HugePageMode::None);
+                    kind = (mode != HugePageMode::None) ? Transparent : Mapped;
+                }
+                if (base != nullptr) Place(base, mapped, placement);
+#else
+                DWORD flags = MEM_RESERVE | MEM_COMMIT;
+                SIZE_T largePage = GetLargePageMinimum();
+                if (mode != HugePageMode::None && largePage > 0) {
+                    mapped = RoundUp(total, largePage);
+                    base = (placement == NumaPlacement::Local) ?
+                        VirtualAllocExNuma(GetCurrentProcess(), nullptr, mapped, flags | MEM_LARGE_PAGES, PAGE_READWRITE, (DWORD)Helper::GetCurrentNumaNode()) :
+                        VirtualAlloc(nullptr, mapped, flags | MEM_LARGE_PAGES, PAGE_READWRITE);
+                    kind = Huge2MB;
+                    // Large pages need the lock pages privilege
+                    if (base == nullptr) g_fallbacks.fetch_add(1, std::memory_order_relaxed);
+                }
+                if (base == nullptr && placement == NumaPlacement::Local) {
+                    mapped = total;
+                    base = VirtualAllocExNuma(GetCurrentProcess(), nullptr, mapped, flags, PAGE_READWRITE, (DWORD)Helper::GetCurrentNumaNode());
+                    kind = Mapped;
+                }
+#endif
+            }
+            if (base == nullptr) {
+                mapped = total;
+                base = ALIGN_ALLOC(total);
+                kind = Heap;
+                if (base == nullptr) return nullptr;
+            }
+
+            AllocHeader* header = (AllocHeader*)base;
+            header->m_magic = c_magic;
+            header->m_mapped = mapped;
+            header->m_kind = kind;
+            g_bytes[kind].fetch_add(mapped, std::memory_order_relaxed);
+            return (char*)base + c_headerSize;
+        }
+
+        void PageAllocator::Free(void* p_ptr)
+        {
+            if (p_ptr == nullptr) return;
+            AllocHeader* header = (AllocHeader*)((char*)p_ptr - c_headerSize);
+            if (header->m_magic != c_magic) {
+                LOG(Helper::LogLevel::LL_Error, "PageAllocator::Free got a pointer it did not allocate!\n");
+                return;
+            }
+            header->m_magic = 0;
+            int kind = header->m_kind;
+            std::size_t mapped = header->m_mapped;
+            g_bytes[kind].fetch_sub(mapped, std::memory_order_relaxed);
+            if (kind == Heap) {
+                ALIGN_FREE((void*)header);
+                return;
+            }
+#ifndef _MSC_VER
+            munmap((void*)header, mapped);
+#else
+            VirtualFree((void*)header, 0, MEM_RELEASE);
+#endif
+        }
+
+        PageAllocator::Stats PageAllocator::GetStats()
+        {
+            Stats stats;
+            stats.m_heapBytes = g_bytes[Heap].load() + g_bytes[Mapped].load();
+            stats.m_transparentBytes = g_bytes[Transparent].load();
+            stats.m_huge2MBBytes = g_bytes[Huge2MB].load();
+            stats.m_huge1GBBytes = g_bytes[Huge1GB].load();
+            stats.m_fallbacks = g_fallbacks.load();
+            return stats;
+        }
+
+        void PageAllocator::LogStats()
+        {
+            Stats stats = GetStats();
+            const double MB = 1024.0 * 1024.0;
+            LOG(Helper::LogLevel::LL_Info, "Dataset pages: 4KB %.1fMB, transparent %.1fMB, 2MB %.1fMB, 1GB %.1fMB, fallbacks %llu\n",
+                stats.m_heapBytes / MB, stats.m_transparentBytes / MB, stats.m_huge2MBBytes / MB, stats.m_huge1GBBytes / MB,
+                (unsigned long long)stats.m_fallbacks);
+#ifndef _MSC_VER
+            std::ifstream smaps("/proc/self/smaps_rollup");
+            std::string line;
+            while (std::getline(smaps, line)) {
+                if (line.compare(0, 14, "AnonHugePages:") == 0) {
+                    LOG(Helper::LogLevel::LL_Info, "Process %s\n", line.c_str());
+                    break;
+                }
+            }
+#endif
+        }
+    }
+}
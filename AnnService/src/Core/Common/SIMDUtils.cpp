@@ -233,3 +233,229 @@ void SIMDUtils::ComputeSum_AVX512(float* pX, const float* pY, DimensionType leng
         *pX++ += *pY++;
     }
 }
+
+void SIMDUtils::ComputeFastScan_Naive(const std::uint8_t* pCodes, const std::uint8_t* pTable, DimensionType numPairs, std::uint16_t* pOut)
+{
+    for (int j = 0; j < FastScanBatch; j++) pOut[j] = 0;
+
+    const std::uint8_t* pEnd = pCodes + numPairs * FastScanBatch;
+    while (pCodes < pEnd) {
+        for (int j = 0; j < 16; j++) {
+            pOut[j] = (std::uint16_t)min(65535, pOut[j] + pTable[pCodes[j] & 0x0f]);
+            pOut[j + 16] = (std::uint16_t)min(65535, pOut[j + 16] + pTable[pCodes[j] >> 4]);
+        }
+        pCodes += 16;
+        pTable += 16;
+    }
+}
+
+void SIMDUtils::ComputeFastScan_AVX(const std::uint8_t* pCodes, const std::uint8_t* pTable, DimensionType numPairs, std::uint16_t* pOut)
+{
+    const __m256i mask = _mm256_set1_epi8(0x0f);
+    const __m256i zero = _mm256_setzero_si256();
+    // lane 0 accumulates the even subvector of every pair, lane 1 the odd one
+    __m256i acc0 = zero, acc1 = zero, acc2 = zero, acc3 = zero;
+
+    const std::uint8_t* pEnd = pCodes + numPairs * FastScanBatch;
+    while (pCodes < pEnd) {
+        __m256i codes = _mm256_loadu_si256((const __m256i*)pCodes);
+        __m256i table = _mm256_loadu_si256((const __m256i*)pTable);
+        __m256i dlo = _mm256_shuffle_epi8(table, _mm256_and_si256(codes, mask));
+        __m256i dhi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(codes, 4), mask));
+        acc0 = _mm256_adds_epu16(acc0, _mm256_unpacklo_epi8(dlo, zero));
+        acc1 = _mm256_adds_epu16(acc1, _mm256_unpackhi_epi8(dlo, zero));
+        acc2 = _mm256_adds_epu16(acc2, _mm256_unpacklo_epi8(dhi, zero));
+        acc3 = _mm256_adds_epu16(acc3, _mm256_unpackhi_epi8(dhi, zero));
+        pCodes += FastScanBatch;
+        pTable += FastScanBatch;
+    }
+
+    _mm_storeu_si128((__m128i*)pOut, _mm_adds_epu16(_mm256_castsi256_si128(acc0), _mm256_extracti128_si256(acc0, 1)));
+    _mm_storeu_si128((__m128i*)(pOut + 8), _mm_adds_epu16(_mm256_castsi256_si128(acc1), _mm256_extracti128_si256(acc1, 1)));
+    _mm_storeu_si128((__m128i*)(pOut + 16), _mm_adds_epu16(_mm256_castsi256_si128(acc2), _mm256_extracti128_si256(acc2, 1)));
+    _mm_storeu_si128((__m128i*)(pOut + 24), _mm_adds_epu16(_mm256_castsi256_si128(acc3), _mm256_extracti128_si256(acc3, 1)));
+}
+
+void SIMDUtils::ComputeFastScan_AVX512(const std::uint8_t* pCodes, const std::uint8_t* pTable, DimensionType numPairs, std::uint16_t* pOut)
+{
+    const __m512i mask = _mm512_set1_epi8(0x0f);
+    const __m512i zero = _mm512_setzero_si512();
+    // each 128-bit lane holds one subvector, so two pairs are resolved per iteration
+    __m512i acc0 = zero, acc1 = zero, acc2 = zero, acc3 = zero;
+
+    const std::uint8_t* pEnd64 = pCodes + (numPairs >> 1) * 2 * FastScanBatch;
+    const std::uint8_t* pEnd = pCodes + numPairs * FastScanBatch;
+    while (pCodes < pEnd64) {
+        __m512i codes = _mm512_loadu_si512((const void*)pCodes);
+        __m512i table = _mm512_loadu_si512((const void*)pTable);
+        __m512i dlo = _mm512_shuffle_epi8(table, _mm512_and_si512(codes, mask));
+        __m512i dhi = _mm512_shuffle_epi8(table, _mm512_and_si512(_mm512_srli_epi16(codes, 4), mask));
+        acc0 = _mm512_adds_epu16(acc0, _mm512_unpacklo_epi8(dlo, zero));
+        acc1 = _mm512_adds_epu16(acc1, _mm512_unpackhi_epi8(dlo, zero));
+        acc2 = _mm512_adds_epu16(acc2, _mm512_unpacklo_epi8(dhi, zero));
+        acc3 = _mm512_adds_epu16(acc3, _mm512_unpackhi_epi8(dhi, zero));
+        pCodes += 2 * FastScanBatch;
+        pTable += 2 * FastScanBatch;
+    }
+
+    __m256i half0 = _mm256_adds_epu16(_mm512_castsi512_si256(acc0), _mm512_extracti64x4_epi64(acc0, 1));
+    __m256i half1 = _mm256_adds_epu16(_mm512_castsi512_si256(acc1), _mm512_extracti64x4_epi64(acc1, 1));
+    __m256i half2 = _mm256_adds_epu16(_mm512_castsi512_si256(acc2), _mm512_extracti64x4_epi64(acc2, 1));
+    __m256i half3 = _mm256_adds_epu16(_mm512_castsi512_si256(acc3), _mm512_extracti64x4_epi64(acc3, 1));
+
+    if (pCodes < pEnd) {
+        const __m256i mask256 = _mm256_set1_epi8(0x0f);
+        const __m256i zero256 = _mm256_setzero_si256();
+        __m256i codes = _mm256_loadu_si256((const __m256i*)pCodes);
+        __m256i table = _mm256_loadu_si256((const __m256i*)pTable);
+        __m256i dlo = _mm256_shuffle_epi8(table, _mm256_and_si256(codes, mask256));
+        __m256i dhi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(codes, 4), mask256));
+        half0 = _mm256_adds_epu16(half0, _mm256_unpacklo_epi8(dlo, zero256));
+        half1 = _mm256_adds_epu16(half1, _mm256_unpackhi_epi8(dlo, zero256));
+        half2 = _mm256_adds_epu16(half2, _mm256_unpacklo_epi8(dhi, zero256));
+        half3 = _mm256_adds_epu16(half3, _mm256_unpackhi_epi8(dhi, zero256));
+    }
+
+    _mm_storeu_si128((__m128i*)pOut, _mm_adds_epu16(_mm256_castsi256_si128(half0), _mm256_extracti128_si256(half0, 1)));
+    _mm_storeu_si128((__m128i*)(pOut + 8), _mm_adds_epu16(_mm256_castsi256_si128(half1), _mm256_extracti128_si256(half1, 1)));
+    _mm_storeu_si128((__m128i*)(pOut + 16), _mm_adds_epu16(_mm256_castsi256_si128(half2), _mm256_extracti128_si256(half2, 1)));
+    _mm_storeu_si128((__m128i*)(pOut + 24), _mm_adds_epu16(_mm256_castsi256_si128(half3), _mm256_extracti128_si256(half3, 1)));
+}
+
+static inline int MaskCount(unsigned mask)
+{
+#ifdef _MSC_VER
+    return (int)__popcnt(mask);
+#else
+    return __builtin_popcount(mask);
+#endif
+}
+
+static inline int LowestBit(unsigned mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int)index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+int SIMDUtils::FilterByBound_Naive(float* pDists, SizeType* pIDs, int length, float bound)
+{
+    int kept = 0;
+    for (int i = 0; i < length; i++) {
+        if (pDists[i] <= bound) {
+            pDists[kept] = pDists[i];
+            pIDs[kept] = pIDs[i];
+            kept++;
+        }
+    }
+    return kept;
+}
+
+int SIMDUtils::FilterByBound_AVX(float* pDists, SizeType* pIDs, int length, float bound)
+{
+    const __m256 vbound = _mm256_set1_ps(bound);
+    int kept = 0, i = 0;
+    for (; i + 8 <= length; i += 8) {
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(pDists + i), vbound, _CMP_LE_OQ));
+        // The whole block survives, which is the common case once most candidates are rejected up front
+        if (mask == 0xff) {
+            if (kept != i) {
+                _mm256_storeu_ps(pDists + kept, _mm256_loadu_ps(pDists + i));
+                _mm256_storeu_si256((__m256i*)(pIDs + kept), _mm256_loadu_si256((const __m256i*)(pIDs + i)));
+            }
+            kept += 8;
+            continue;
+        }
+        while (mask != 0) {
+            int j = i + LowestBit((unsigned)mask);
+            pDists[kept] = pDists[j];
+            pIDs[kept] = pIDs[j];
+            kept++;
+            mask &= mask - 1;
+        }
+    }
+    for (; i < length; i++) {
+        if (pDists[i] <= bound) {
+            pDists[kept] = pDists[i];
+            pIDs[kept] = pIDs[i];
+            kept++;
+        }
+    }
+    return kept;
+}
+
+int SIMDUtils::FilterByBound_AVX512(float* pDists, SizeType* pIDs, int length, float bound)
+{
+    const __m512 vbound = _mm512_set1_ps(bound);
+    int kept = 0, i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m512 dists = _mm512_loadu_ps(pDists + i);
+        __m512i ids = _mm512_loadu_si512((const void*)(pIDs + i));
+        __mmask16 mask = _mm512_cmp_ps_mask(dists, vbound, _CMP_LE_OQ);
+        _mm512_mask_compressstoreu_ps(pDists + kept, mask, dists);
+        _mm512_mask_compressstoreu_epi32(pIDs + kept, mask, ids);
+        kept += MaskCount((unsigned)mask);
+    }
+    if (i < length) {
+        __mmask16 tail = (__mmask16)((1u << (length - i)) - 1);
+        __m512 dists = _mm512_maskz_loadu_ps(tail, pDists + i);
+        __m512i ids = _mm512_maskz_loadu_epi32(tail, pIDs + i);
+        __mmask16 mask = _mm512_mask_cmp_ps_mask(tail, dists, vbound, _CMP_LE_OQ);
+        _mm512_mask_compressstoreu_ps(pDists + kept, mask, dists);
+        _mm512_mask_compressstoreu_epi32(pIDs + kept, mask, ids);
+        kept += MaskCount((unsigned)mask);
+    }
+    return kept;
+}
+
+void SIMDUtils::FilterBits_Naive(const std::uint64_t* const* pBlocks, SizeType rowsInBlockEx, const SizeType* pKeys, int length, std::uint8_t* pMask)
+{
+    SizeType rowMask = (1 << rowsInBlockEx) - 1;
+    for (int i = 0; i < length; i++) {
+        SizeType key = pKeys[i];
+        pMask[i] = (std::uint8_t)(((~pBlocks[key >> rowsInBlockEx][(key & rowMask) >> 6]) >> (key & 63)) & 1);
+    }
+}
+
+void SIMDUtils::FilterBits_AVX(const std::uint64_t* const* pBlocks, SizeType rowsInBlockEx, const SizeType* pKeys, int length, std::uint8_t* pMask)
+{
+    const __m128i shiftEx = _mm_cvtsi32_si128(rowsInBlockEx);
+    const __m128i rowMask = _mm_set1_epi32((1 << rowsInBlockEx) - 1);
+    const __m128i bitMask = _mm_set1_epi32(63);
+    const __m256i one = _mm256_set1_epi64x(1);
+    int i = 0;
+    for (; i + 4 <= length; i += 4) {
+        __m128i keys = _mm_loadu_si128((const __m128i*)(pKeys + i));
+        // block base pointers first, then the word of each key as an absolute address
+        __m256i base = _mm256_i32gather_epi64((const long long*)pBlocks, _mm_srl_epi32(keys, shiftEx), 8);
+        __m256i offset = _mm256_slli_epi64(_mm256_cvtepu32_epi64(_mm_srli_epi32(_mm_and_si128(keys, rowMask), 6)), 3);
+        __m256i words = _mm256_i64gather_epi64((const long long*)0, _mm256_add_epi64(base, offset), 1);
+        __m256i bits = _mm256_srlv_epi64(words, _mm256_cvtepu32_epi64(_mm_and_si128(keys, bitMask)));
+        int deleted = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(bits, one), 63)));
+        for (int j = 0; j < 4; j++) pMask[i + j] = (std::uint8_t)(((deleted >> j) & 1) ^ 1);
+    }
+    FilterBits_Naive(pBlocks, rowsInBlockEx, pKeys + i, length - i, pMask + i);
+}
+
+void SIMDUtils::FilterBits_AVX512(const std::uint64_t* const* pBlocks, SizeType rowsInBlockEx, const SizeType* pKeys, int length, std::uint8_t* pMask)
+{
+    const __m256i shiftEx = _mm256_set1_epi32(rowsInBlockEx);
+    const __m256i rowMask = _mm256_set1_epi32((1 << rowsInBlockEx) - 1);
+    const __m256i bitMask = _mm256_set1_epi32(63);
+    const __m512i one = _mm512_set1_epi64(1);
+    int i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256i keys = _mm256_loadu_si256((const __m256i*)(pKeys + i));
+        __m512i base = _mm512_i32gather_epi64(_mm256_srlv_epi32(keys, shiftEx), (const void*)pBlocks, 8);
+        __m512i offset = _mm512_slli_epi64(_mm512_cvtepu32_epi64(_mm256_srli_epi32(_mm256_and_si256(keys, rowMask), 6)), 3);
+        __m512i words = _mm512_i64gather_epi64(_mm512_add_epi64(base, offset), (const void*)0, 1);
+        __m512i bits = _mm512_srlv_epi64(words, _mm512_cvtepu32_epi64(_mm256_and_si256(keys, bitMask)));
+        __mmask8 alive = _mm512_testn_epi64_mask(bits, one);
+        _mm_storel_epi64((__m128i*)(pMask + i), _mm512_cvtepi64_epi8(_mm512_maskz_mov_epi64(alive, one)));
+    }
+    FilterBits_Naive(pBlocks, rowsInBlockEx, pKeys + i, length - i, pMask + i);
+}
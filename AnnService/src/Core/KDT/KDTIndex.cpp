@@ -85,6 +85,7 @@ namespace SPTAG
             if (p_indexStreams[3] == nullptr) m_deletedID.Initialize(m_pSamples.R(), m_iDataBlockSize, m_iDataCapacity);
             else if ((ret = m_deletedID.Load(p_indexStreams[3], m_iDataBlockSize, m_iDataCapacity)) != ErrorCode::Success) return ret;
 
+            if (m_iHugePageMode != 0 || m_iNumaPlacement != 0) COMMON::PageAllocator::LogStats();
             omp_set_num_threads(m_iNumberOfThreads);
             m_threadPool.init();
             return ret;
@@ -186,7 +187,7 @@ namespace SPTAG
                 m_workspace.reset(new COMMON::WorkSpace());
                 m_workspace->Initialize(max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp);
             }
-            m_workspace->Reset(m_iMaxCheck, p_query.GetResultNum());
+            m_workspace->Reset(m_iMaxCheck, p_query.GetResultNum(), VisitedSize());
 
             COMMON::QueryResultSet<T>* p_results = (COMMON::QueryResultSet<T>*) & p_query;
 
@@ -231,7 +232,7 @@ case VectorValueType::Name: \
                 m_workspace.reset(new COMMON::WorkSpace());
                 m_workspace->Initialize(max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp);
             }
-            m_workspace->Reset(m_pGraph.m_iMaxCheckForRefineGraph, p_query.GetResultNum());
+            m_workspace->Reset(m_pGraph.m_iMaxCheckForRefineGraph, p_query.GetResultNum(), VisitedSize());
 
             COMMON::QueryResultSet<T>* p_results = (COMMON::QueryResultSet<T>*) & p_query;
 
@@ -268,7 +269,7 @@ case VectorValueType::Name: \
                 m_workspace.reset(new COMMON::WorkSpace());
                 m_workspace->Initialize(max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp);
             }
-            m_workspace->Reset(m_pGraph.m_iMaxCheckForRefineGraph, p_query.GetResultNum());
+            m_workspace->Reset(m_pGraph.m_iMaxCheckForRefineGraph, p_query.GetResultNum(), VisitedSize());
 
             COMMON::QueryResultSet<T>* p_results = (COMMON::QueryResultSet<T>*)&p_query;
 
@@ -339,6 +340,7 @@ case VectorValueType::Name: \
             auto t3 = std::chrono::high_resolution_clock::now();
             LOG(Helper::LogLevel::LL_Info, "Build Graph time (s): %lld\n", std::chrono::duration_cast<std::chrono::seconds>(t3 - t2).count());
 
+            if (m_iHugePageMode != 0 || m_iNumaPlacement != 0) COMMON::PageAllocator::LogStats();
             m_bReady = true;
             return ErrorCode::Success;
         }
@@ -583,6 +585,13 @@ case VectorValueType::Name: \
                 auto base = m_pQuantizer ? m_pQuantizer->GetBase() : COMMON::Utils::GetBase<T>();
                 m_iBaseSquare = (m_iDistCalcMethod == DistCalcMethod::Cosine) ? base * base : 1;
             }
+            else if (SPTAG::Helper::StrUtils::StrEqualIgnoreCase(p_param, "HugePageMode") || SPTAG::Helper::StrUtils::StrEqualIgnoreCase(p_param, "NumaPlacement")) {
+                COMMON::PagePolicy policy;
+                policy.m_mode = (COMMON::HugePageMode)m_iHugePageMode;
+                policy.m_placement = (COMMON::NumaPlacement)m_iNumaPlacement;
+                m_pSamples.SetPagePolicy(policy);
+                m_pGraph.SetPagePolicy(policy);
+            }
             return ErrorCode::Success;
         }
 
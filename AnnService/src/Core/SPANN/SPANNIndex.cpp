@@ -17,10 +17,7 @@ namespace SPTAG
 {
     namespace SPANN
     {
-        std::atomic_int ExtraWorkSpace::g_spaceCount(0);
         EdgeCompare Selection::g_edgeComparer;
-        template <typename T>
-        thread_local std::shared_ptr<ExtraWorkSpace> Index<T>::m_workspace;
 
         std::function<std::shared_ptr<Helper::DiskIO>(void)> f_createAsyncIO = []() -> std::shared_ptr<Helper::DiskIO> { return std::shared_ptr<Helper::DiskIO>(new Helper::AsyncFileIO()); };
 
@@ -92,8 +89,13 @@ namespace SPTAG
             m_index->UpdateIndex();
             m_index->SetReady(true);
 
+            // fast scan blocks pack 4-bit PQ codes and are written ahead of plain (not delta or compressed) entries
+            if (!m_pQuantizer || !m_pQuantizer->GetEnableFastScan() || m_options.m_enableDeltaEncoding || m_options.m_enableDataCompression) m_options.m_enableFastScan = false;
             if (m_pQuantizer)
             {
+                // sign codes and residual codes need full precision vectors in the postings
+                m_options.m_enableSignCode = false;
+                m_options.m_residualQuantizationBits = 0;
                 m_extraSearcher.reset(new ExtraStaticSearcher<std::uint8_t>());
             }
             else
@@ -103,7 +105,7 @@ namespace SPTAG
                         m_extraSearcher.reset(new ExtraDynamicSearcher<T>(m_options.m_KVPath.c_str(), m_options.m_dim, INT_MAX, m_options.m_useDirectIO, m_options.m_latencyLimit, m_options.m_mergeThreshold));
                     }
                     else {
-                        m_extraSearcher.reset(new ExtraDynamicSearcher<T>(m_options.m_KVPath.c_str(), m_options.m_dim, m_options.m_postingPageLimit * PageSize / (sizeof(T) * m_options.m_dim + sizeof(int) + sizeof(uint8_t)), m_options.m_useDirectIO, m_options.m_latencyLimit, m_options.m_mergeThreshold));
+                        m_extraSearcher.reset(new ExtraDynamicSearcher<T>(m_options.m_KVPath.c_str(), m_options.m_dim, m_options.m_postingPageLimit * PageSize / PostingEntrySize(), m_options.m_useDirectIO, m_options.m_latencyLimit, m_options.m_mergeThreshold));
                     }
                 }
                 else {
@@ -114,9 +116,10 @@ namespace SPTAG
             if (!m_extraSearcher->LoadIndex(m_options, m_versionMap)) return ErrorCode::Fail;
 
             if (m_options.m_excludehead) m_vectorTranslateMap.reset((std::uint64_t*)(p_indexBlobs.back().Data()), [=](std::uint64_t* ptr) {});
+            if (LoadHeadRerankVectors() != ErrorCode::Success) return ErrorCode::Fail;
 
             omp_set_num_threads(m_options.m_iSSDNumberOfThreads);
-            return ErrorCode::Success;
+            return BuildHeadReplicas();
         }
 
         template <typename T>
@@ -133,8 +136,13 @@ namespace SPTAG
 
             // TODO: Choose an extra searcher based on config
             // Not Ready
+            // fast scan blocks pack 4-bit PQ codes and are written ahead of plain (not delta or compressed) entries
+            if (!m_pQuantizer || !m_pQuantizer->GetEnableFastScan() || m_options.m_enableDeltaEncoding || m_options.m_enableDataCompression) m_options.m_enableFastScan = false;
             if (m_pQuantizer)
             {
+                // sign codes and residual codes need full precision vectors in the postings
+                m_options.m_enableSignCode = false;
+                m_options.m_residualQuantizationBits = 0;
                 m_extraSearcher.reset(new ExtraStaticSearcher<std::uint8_t>());
             }
             else
@@ -144,7 +152,7 @@ namespace SPTAG
                         m_extraSearcher.reset(new ExtraDynamicSearcher<T>(m_options.m_KVPath.c_str(), m_options.m_dim, INT_MAX, m_options.m_useDirectIO, m_options.m_latencyLimit, m_options.m_mergeThreshold));
                     }
                     else {
-                        m_extraSearcher.reset(new ExtraDynamicSearcher<T>(m_options.m_KVPath.c_str(), m_options.m_dim, m_options.m_postingPageLimit * PageSize / (sizeof(T) * m_options.m_dim + sizeof(int) + sizeof(uint8_t)), m_options.m_useDirectIO, m_options.m_latencyLimit, m_options.m_mergeThreshold));
+                        m_extraSearcher.reset(new ExtraDynamicSearcher<T>(m_options.m_KVPath.c_str(), m_options.m_dim, m_options.m_postingPageLimit * PageSize / PostingEntrySize(), m_options.m_useDirectIO, m_options.m_latencyLimit, m_options.m_mergeThreshold));
                     }
                 }
                 else if (m_options.m_useSPDK) {
@@ -160,13 +168,14 @@ namespace SPTAG
                 m_vectorTranslateMap.reset(new std::uint64_t[m_index->GetNumSamples()], std::default_delete<std::uint64_t[]>());
                 IOBINARY(p_indexStreams[m_index->GetIndexFiles()->size()], ReadBinary, sizeof(std::uint64_t) * m_index->GetNumSamples(), reinterpret_cast<char*>(m_vectorTranslateMap.get()));
             }
+            if (LoadHeadRerankVectors() != ErrorCode::Success) return ErrorCode::Fail;
 
             omp_set_num_threads(m_options.m_iSSDNumberOfThreads);
 
             if (m_options.m_useSPDK) {
-                int m_vectorLimit = m_options.m_postingPageLimit * PageSize / (sizeof(T) * m_options.m_dim + sizeof(int) + sizeof(uint8_t));
+                int m_vectorLimit = m_options.m_postingPageLimit * PageSize / PostingEntrySize();
                 m_versionMap.Initialize(m_options.m_vectorSize, m_index->m_iDataBlockSize, m_index->m_iDataCapacity);
-                int m_vectorInfoSize = sizeof(T) * m_options.m_dim + sizeof(int) + sizeof(uint8_t);
+                int m_vectorInfoSize = sizeof(T) * m_options.m_dim + sizeof(int) + sizeof(uint8_t) + SignCodeSize();
                 LOG(Helper::LogLevel::LL_Info, "Copying data from static to SPDK\n");
                 std::shared_ptr<IExtraSearcher> storeExtraSearcher;
                 storeExtraSearcher.reset(new ExtraStaticSearcher<T>());
@@ -219,11 +228,12 @@ namespace SPTAG
                                 char* ptr = (char*)(appendPosting.c_str());
                                 memcpy(ptr, &VIDTrans, sizeof(VIDTrans));
                                 memcpy(ptr + sizeof(VIDTrans), &version, sizeof(version));
-                                memcpy(ptr + sizeof(int) + sizeof(uint8_t), m_index->GetSample(index), m_vectorInfoSize - sizeof(int) + sizeof(uint8_t));
+                                // the head's own sign code is all zeros, which the zero-initialized string already holds
+                                memcpy(ptr + sizeof(int) + sizeof(uint8_t), m_index->GetSample(index), sizeof(T) * m_options.m_dim);
                                 newPosting = appendPosting + newPosting;
                             }
 
-                            m_extraSearcher->GetWritePosting(index, newPosting, true);
+                            m_extraSearcher->GetWritePosting(index, newPosting, true, m_index.get());
                         }
                         else
                         {
@@ -238,6 +248,12 @@ namespace SPTAG
                 m_versionMap.Load(m_options.m_deleteIDFile, m_index->m_iDataBlockSize, m_index->m_iDataCapacity);
             }
 
+            if (fileexists(m_options.m_attributeFile.c_str()) &&
+                m_attributes.Load(m_options.m_attributeFile, m_index->m_iDataBlockSize, m_index->m_iDataCapacity) != ErrorCode::Success) {
+                LOG(Helper::LogLevel::LL_Error, "Failed to load attributes from %s\n", m_options.m_attributeFile.c_str());
+                return ErrorCode::Fail;
+            }
+
             if ((m_options.m_useSPDK || m_options.m_useKV) && m_options.m_preReassign) {
                 std::shared_ptr<Helper::ReaderOptions> vectorOptions(new Helper::ReaderOptions(m_options.m_valueType, m_options.m_dim, m_options.m_vectorType, m_options.m_vectorDelimiter, m_options.m_iSSDNumberOfThreads));
                 auto vectorReader = Helper::VectorSetReader::CreateInstance(vectorOptions);
@@ -256,7 +272,7 @@ namespace SPTAG
                 m_extraSearcher->RefineIndex(vectorReader, m_index);
             }
 
-            return ErrorCode::Success;
+            return BuildHeadReplicas();
         }
 
         template <typename T>
@@ -307,6 +323,7 @@ namespace SPTAG
 
             if (m_options.m_excludehead) IOBINARY(p_indexStreams[m_index->GetIndexFiles()->size()], WriteBinary, sizeof(std::uint64_t) * m_index->GetNumSamples(), (char*)(m_vectorTranslateMap.get()));
             m_versionMap.Save(m_options.m_deleteIDFile);
+            if (m_attributes.Available()) m_attributes.Save(m_options.m_attributeFile);
             return ErrorCode::Success;
         }
 
@@ -314,54 +331,74 @@ namespace SPTAG
 
         template<typename T>
         ErrorCode Index<T>::SearchIndex(QueryResult &p_query, bool p_searchDeleted) const
+        {
+            SearchStats stats;
+            return SearchIndexWithStats(p_query, stats);
+        }
+
+        template<typename T>
+        ErrorCode Index<T>::SearchIndexWithStats(QueryResult& p_query, SearchStats& p_stats) const
         {
             if (!m_bReady) return ErrorCode::EmptyIndex;
 
-            COMMON::QueryResultSet<T>* p_queryResults;
-            if (p_query.GetResultNum() >= m_options.m_searchInternalResultNum)
-                p_queryResults = (COMMON::QueryResultSet<T>*) & p_query;
-            else
-                p_queryResults = new COMMON::QueryResultSet<T>((const T*)p_query.GetTarget(), m_options.m_searchInternalResultNum);
+            std::uint64_t epoch = m_updateEpoch.load();
+            if (!LookupQueryCache(p_query, epoch, &p_stats)) {
+                // A deadline set by the caller wins over QueryDeadline
+                if (m_options.m_queryDeadline > 0 && p_stats.m_deadline == std::chrono::steady_clock::time_point::max())
+                    p_stats.m_deadline = std::chrono::steady_clock::now() + std::chrono::microseconds((std::int64_t)(m_options.m_queryDeadline * 1000));
+
+                COMMON::QueryResultSet<T>* p_queryResults;
+                if (p_query.GetResultNum() >= m_options.m_searchInternalResultNum)
+                    p_queryResults = (COMMON::QueryResultSet<T>*) & p_query;
+                else
+                    p_queryResults = new COMMON::QueryResultSet<T>((const T*)p_query.GetTarget(), m_options.m_searchInternalResultNum);
 
-            m_index->SearchIndex(*p_queryResults);
+                SearchHeadIndex(*p_queryResults, &p_stats);
 
-            if (m_extraSearcher != nullptr) {
-                if (m_workspace.get() == nullptr) {
-                    m_workspace.reset(new ExtraWorkSpace());
-                    m_workspace->Initialize(m_options.m_maxCheck, m_options.m_hashExp, m_options.m_searchInternalResultNum, min(m_options.m_postingPageLimit, m_options.m_searchPostingPageLimit + 1) << PageSizeEx, m_options.m_enableDataCompression);
-                }
-                m_workspace->m_deduper.clear();
-                m_workspace->m_postingIDs.clear();
+                if (m_extraSearcher != nullptr) {
+                    auto workspace = RentWorkSpace();
+                    workspace->m_deduper.clear();
+                    workspace->m_postingIDs.clear();
 
-                float limitDist = p_queryResults->GetResult(0)->Dist * m_options.m_maxDistRatio;
-                for (int i = 0; i < p_queryResults->GetResultNum(); ++i)
-                {
-                    auto res = p_queryResults->GetResult(i);
-                    if (res->VID == -1) break;
+                    float limitDist = p_queryResults->GetResult(0)->Dist * m_options.m_maxDistRatio;
+                    for (int i = 0; i < p_queryResults->GetResultNum(); ++i)
+                    {
+                        auto res = p_queryResults->GetResult(i);
+                        if (res->VID == -1) break;
                     
-                    auto postingID = res->VID;
-                    if (m_vectorTranslateMap.get() != nullptr) res->VID = static_cast<SizeType>((m_vectorTranslateMap.get())[res->VID]);
-                    else {
-                        res->VID = -1;
-                        res->Dist = MaxDist;
+                        auto postingID = res->VID;
+                        if (m_vectorTranslateMap.get() != nullptr) res->VID = static_cast<SizeType>((m_vectorTranslateMap.get())[res->VID]);
+                        else {
+                            res->VID = -1;
+                            res->Dist = MaxDist;
+                        }
+
+                        // Don't do disk reads for irrelevant pages
+                        if (workspace->m_postingIDs.size() >= m_options.m_searchInternalResultNum ||
+                            (limitDist > 0.1 && res->Dist > limitDist) ||
+                            !m_extraSearcher->CheckValidPosting(postingID))
+                            continue;
+                        workspace->m_postingIDs.emplace_back(postingID);
                     }
 
-                    // Don't do disk reads for irrelevant pages
-                    if (m_workspace->m_postingIDs.size() >= m_options.m_searchInternalResultNum ||
-                        (limitDist > 0.1 && res->Dist > limitDist) ||
-                        !m_extraSearcher->CheckValidPosting(postingID))
-                        continue;
-                    m_workspace->m_postingIDs.emplace_back(postingID);
+                    if (m_vectorTranslateMap.get() != nullptr) p_queryResults->Reverse();
+                    // Postings were collected nearest head first; past the deadline only the heads are returned
+                    if (std::chrono::steady_clock::now() < p_stats.m_deadline) {
+                        m_extraSearcher->SearchIndex(workspace.get(), *p_queryResults, GetLocalMemoryIndex(), &p_stats);
+                    }
+                    else {
+                        p_stats.m_degraded = true;
+                        p_stats.m_skippedPostingCount = (int)workspace->m_postingIDs.size();
+                    }
+                    p_queryResults->SortResult();
                 }
 
-                if (m_vectorTranslateMap.get() != nullptr) p_queryResults->Reverse();
-                m_extraSearcher->SearchIndex(m_workspace.get(), *p_queryResults, m_index, nullptr);
-                p_queryResults->SortResult();
-            }
-
-            if (p_query.GetResultNum() < m_options.m_searchInternalResultNum) {
-                std::copy(p_queryResults->GetResults(), p_queryResults->GetResults() + p_query.GetResultNum(), p_query.GetResults());
-                delete p_queryResults;
+                if (p_query.GetResultNum() < m_options.m_searchInternalResultNum) {
+                    std::copy(p_queryResults->GetResults(), p_queryResults->GetResults() + p_query.GetResultNum(), p_query.GetResults());
+                    delete p_queryResults;
+                }
+                if (!p_stats.m_degraded) InsertQueryCache(p_query, epoch);
+                else m_degradedQueryCount++;
             }
 
             if (p_query.WithMeta() && nullptr != m_pMetadata)
@@ -375,6 +412,107 @@ namespace SPTAG
             return ErrorCode::Success;
         }
 
+        template <typename T>
+        bool Index<T>::LookupQueryCache(QueryResult& p_query, std::uint64_t p_epoch, SearchStats* p_stats) const
+        {
+            // Quantized indexes search on codes of a different type than the query, so they are not cached
+            if (!m_options.m_enableQueryCache || m_pQuantizer) return false;
+            std::call_once(m_queryCacheInit, [this]() {
+                m_queryCache.Initialize(m_options.m_dim, m_options.m_queryCacheHashBits, m_options.m_queryCacheCapacity,
+                    m_options.m_queryCacheTTL, m_options.m_queryCacheTolerance, m_options.m_distCalcMethod);
+            });
+            bool hit = m_queryCache.Lookup((const T*)p_query.GetTarget(), p_epoch, p_query.GetResultNum(), p_query.GetResults());
+            if (p_stats) p_stats->m_cacheHit = hit;
+            return hit;
+        }
+
+        template <typename T>
+        void Index<T>::InsertQueryCache(QueryResult& p_query, std::uint64_t p_epoch) const
+        {
+            if (!m_options.m_enableQueryCache || m_pQuantizer || !m_queryCache.Available()) return;
+            m_queryCache.Insert((const T*)p_query.GetTarget(), p_epoch, p_query.GetResultNum(), p_query.GetResults());
+        }
+
+        template <typename T>
+        COMMON::BoundedWorkSpacePool<ExtraWorkSpace>::Lease Index<T>::RentWorkSpace() const
+        {
+            std::call_once(m_workSpacePoolInit, [this]() {
+                // Each slot owns one AIO context of the disk searcher (see ExtraStaticSearcher::LoadIndex), so a rent
+                // waits for a free slot rather than sharing a context with a running query
+                m_workSpacePool.SetWaitForSlot(true);
+                m_workSpacePool.Init(m_options.WorkSpacePoolSize(), Helper::GetNumaNodeCount(), m_options.m_maxCheck, m_options.m_hashExp, m_options.m_searchInternalResultNum,
+                    min(m_options.m_postingPageLimit, m_options.m_searchPostingPageLimit + 1) << PageSizeEx, (int)m_options.m_enableDataCompression);
+            });
+            auto lease = m_workSpacePool.Rent(Helper::GetCurrentNumaNode());
+            lease->m_spaceID = (int)lease.Slot();
+            return lease;
+        }
+
+        template <typename T>
+        ErrorCode Index<T>::SearchHeadIndex(QueryResult& p_query, SearchStats* p_stats) const
+        {
+            if (!m_headRerankVectors.Available() || m_options.m_headRerankRatio <= 1) return SearchHeadCandidates(p_query, p_stats);
+
+            // Fetch more candidates on the codes and keep the nearest by full precision distance
+            const T* target = (const T*)p_query.GetTarget();
+            COMMON::QueryResultSet<T> candidates(target, p_query.GetResultNum() * m_options.m_headRerankRatio);
+            candidates.SetTarget(target, m_pQuantizer);
+            ErrorCode ret = SearchHeadCandidates(candidates, p_stats);
+            if (ret != ErrorCode::Success) return ret;
+
+            // Heads added by Split after the build have no full precision row; code and exact distances do not
+            // compare, so the candidates keep their code distances unless every one of them can be reranked
+            std::vector<T> buffer(m_headRerankVectors.C());
+            std::vector<float> dists;
+            dists.reserve(candidates.GetResultNum());
+            bool rerank = true;
+            for (int i = 0; i < candidates.GetResultNum(); ++i)
+            {
+                auto res = candidates.GetResult(i);
+                if (res->VID == -1) break;
+                const T* vec = m_headRerankVectors.Get(res->VID, buffer.data());
+                if (vec == nullptr) {
+                    rerank = false;
+                    break;
+                }
+                dists.push_back(COMMON::DistanceUtils::ComputeDistance(target, vec, m_options.m_dim, m_options.m_distCalcMethod));
+            }
+
+            COMMON::QueryResultSet<T>* p_queryResults = (COMMON::QueryResultSet<T>*) & p_query;
+            p_queryResults->Reset();
+            for (int i = 0; i < candidates.GetResultNum(); ++i)
+            {
+                auto res = candidates.GetResult(i);
+                if (res->VID == -1) break;
+                p_queryResults->AddPoint(res->VID, rerank ? dists[i] : res->Dist);
+            }
+            p_queryResults->SortResult();
+            return ErrorCode::Success;
+        }
+
+        template <typename T>
+        ErrorCode Index<T>::SearchHeadCandidates(QueryResult& p_query, SearchStats* p_stats) const
+        {
+            if (p_stats == nullptr || p_stats->m_deadline == std::chrono::steady_clock::time_point::max()) return GetLocalMemoryIndex()->SearchIndex(p_query);
+
+            // Scale MaxCheck down when a full head search would take more than DeadlineHeadRatio of the time left,
+            // keeping enough checks to fill the candidate list
+            auto start = std::chrono::steady_clock::now();
+            float remain = (std::max)(0.0f, std::chrono::duration<float, std::micro>(p_stats->m_deadline - start).count());
+            float estimate = m_headSearchCost.load();
+            int maxCheck = m_options.m_maxCheck;
+            if (estimate > remain * m_options.m_deadlineHeadRatio) {
+                int minCheck = (std::max)(p_query.GetResultNum(), m_options.m_maxCheck / 16);
+                maxCheck = (std::min)(m_options.m_maxCheck, (std::max)(minCheck, (int)(m_options.m_maxCheck * remain * m_options.m_deadlineHeadRatio / estimate)));
+                if (maxCheck < m_options.m_maxCheck) p_stats->m_degraded = true;
+            }
+            ErrorCode ret = GetLocalMemoryIndex()->SearchIndexWithBudget(p_query, maxCheck);
+
+            float cost = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count() * m_options.m_maxCheck / maxCheck;
+            m_headSearchCost.store((estimate == 0) ? cost : 0.9f * estimate + 0.1f * cost);
+            return ret;
+        }
+
         template <typename T>
         ErrorCode Index<T>::SearchDiskIndex(QueryResult& p_query, SearchStats* p_stats) const
         {
@@ -382,12 +520,9 @@ namespace SPTAG
 
             COMMON::QueryResultSet<T>* p_queryResults = (COMMON::QueryResultSet<T>*) & p_query;
 
-            if (m_workspace.get() == nullptr) {
-                m_workspace.reset(new ExtraWorkSpace());
-                m_workspace->Initialize(m_options.m_maxCheck, m_options.m_hashExp, m_options.m_searchInternalResultNum, min(m_options.m_postingPageLimit, m_options.m_searchPostingPageLimit + 1) << PageSizeEx, m_options.m_enableDataCompression);
-            }
-            m_workspace->m_deduper.clear();
-            m_workspace->m_postingIDs.clear();
+            auto workspace = RentWorkSpace();
+            workspace->m_deduper.clear();
+            workspace->m_postingIDs.clear();
 
             float limitDist = p_queryResults->GetResult(0)->Dist * m_options.m_maxDistRatio;
             int i = 0;
@@ -397,7 +532,7 @@ namespace SPTAG
                 if (res->VID == -1 || (limitDist > 0.1 && res->Dist > limitDist)) break;
                 if (m_extraSearcher->CheckValidPosting(res->VID))
                 {
-                    m_workspace->m_postingIDs.emplace_back(res->VID);
+                    workspace->m_postingIDs.emplace_back(res->VID);
                 }
                 if (m_vectorTranslateMap.get() != nullptr) res->VID = static_cast<SizeType>((m_vectorTranslateMap.get())[res->VID]);
                 else {
@@ -417,11 +552,144 @@ namespace SPTAG
                 }
             }
             if (m_vectorTranslateMap.get() != nullptr) p_queryResults->Reverse();
-            m_extraSearcher->SearchIndex(m_workspace.get(), *p_queryResults, m_index, p_stats);
+            if (p_stats != nullptr && std::chrono::steady_clock::now() >= p_stats->m_deadline) {
+                p_stats->m_degraded = true;
+                p_stats->m_skippedPostingCount = (int)workspace->m_postingIDs.size();
+            }
+            else {
+                m_extraSearcher->SearchIndex(workspace.get(), *p_queryResults, GetLocalMemoryIndex(), p_stats);
+            }
             p_queryResults->SortResult();
             return ErrorCode::Success;
         }
 
+        template <typename T>
+        ErrorCode Index<T>::SearchIndexWithFilter(QueryResult& p_query, const COMMON::AttributeFilter& p_filter, SearchStats* p_stats) const
+        {
+            if (!m_bReady) return ErrorCode::EmptyIndex;
+            SearchStats localStats;
+            SearchStats& stats = (p_stats != nullptr) ? *p_stats : localStats;
+            if (p_filter.Empty()) return SearchIndexWithStats(p_query, stats);
+            if (!m_attributes.Available() || m_extraSearcher == nullptr) {
+                LOG(Helper::LogLevel::LL_Error, "Filtered search needs attributes and a disk index\n");
+                return ErrorCode::Fail;
+            }
+
+            // A selective filter leaves few matching entries per posting, so probe proportionally more
+            // postings, in batches of SearchInternalResultNum, until the results are filled.
+            float selectivity = p_filter.Selectivity(m_attributes);
+            float probeRatio = (std::min)(m_options.m_filterMaxProbeRatio, 1.0f / (std::max)(selectivity, 1e-6f));
+            int batchNum = m_options.m_searchInternalResultNum;
+            int probeNum = (std::max)(batchNum, (int)std::ceil(batchNum * probeRatio));
+
+            if (m_options.m_queryDeadline > 0 && stats.m_deadline == std::chrono::steady_clock::time_point::max())
+                stats.m_deadline = std::chrono::steady_clock::now() + std::chrono::microseconds((std::int64_t)(m_options.m_queryDeadline * 1000));
+
+            COMMON::QueryResultSet<T> headResults((const T*)p_query.GetTarget(), probeNum);
+            SearchHeadCandidates(headResults, &stats);
+
+            COMMON::QueryResultSet<T>* p_queryResults = (COMMON::QueryResultSet<T>*) & p_query;
+            if (m_pQuantizer) p_queryResults->SetTarget(p_queryResults->GetTarget(), m_pQuantizer);
+
+            auto workspace = RentWorkSpace();
+            workspace->m_deduper.clear();
+            workspace->m_filter = &p_filter;
+            workspace->m_attributes = &m_attributes;
+
+            std::vector<int> postingIDs;
+            float limitDist = headResults.GetResult(0)->Dist * m_options.m_maxDistRatio;
+            for (int i = 0; i < headResults.GetResultNum(); ++i)
+            {
+                auto res = headResults.GetResult(i);
+                if (res->VID == -1 || (limitDist > 0.1 && res->Dist > limitDist)) break;
+                if (m_vectorTranslateMap.get() != nullptr) {
+                    SizeType vid = static_cast<SizeType>((m_vectorTranslateMap.get())[res->VID]);
+                    if (p_filter.Match(m_attributes.Row(vid))) p_queryResults->AddPoint(vid, res->Dist);
+                }
+                if (m_extraSearcher->CheckValidPosting(res->VID)) postingIDs.push_back(res->VID);
+            }
+
+            // The searchers report the counts of one call, so every batch is summed into the caller's stats
+            SearchStats batchStats;
+            batchStats.m_deadline = stats.m_deadline;
+            for (size_t start = 0; start < postingIDs.size(); start += batchNum)
+            {
+                if (start > 0 && p_queryResults->worstDist() < MaxDist) break;
+                workspace->m_postingIDs.assign(postingIDs.begin() + start, postingIDs.begin() + (std::min)(start + batchNum, postingIDs.size()));
+                m_extraSearcher->SearchIndex(workspace.get(), *p_queryResults, GetLocalMemoryIndex(), &batchStats);
+                stats.m_totalListElementsCount += batchStats.m_totalListElementsCount;
+                stats.m_diskIOCount += batchStats.m_diskIOCount;
+                stats.m_diskAccessCount += batchStats.m_diskAccessCount;
+                stats.m_signCodeSkipCount += batchStats.m_signCodeSkipCount;
+                stats.m_fastScanSkipCount += batchStats.m_fastScanSkipCount;
+            }
+            stats.m_degraded = stats.m_degraded || batchStats.m_degraded;
+            stats.m_skippedPostingCount += batchStats.m_skippedPostingCount;
+            if (stats.m_degraded) m_degradedQueryCount++;
+            workspace->m_filter = nullptr;
+            workspace->m_attributes = nullptr;
+            p_queryResults->SortResult();
+
+            if (p_query.WithMeta() && nullptr != m_pMetadata)
+            {
+                for (int i = 0; i < p_query.GetResultNum(); ++i)
+                {
+                    SizeType result = p_query.GetResult(i)->VID;
+                    p_query.SetMetadata(i, (result < 0) ? ByteArray::c_empty : m_pMetadata->GetMetadataCopy(result));
+                }
+            }
+            return ErrorCode::Success;
+        }
+
+        template <typename T>
+        ErrorCode Index<T>::RangeSearch(const void* p_vector, float p_radius, int p_maxResults, std::vector<BasicResult>& p_results) const
+        {
+            if (!m_bReady) return ErrorCode::EmptyIndex;
+            if (m_extraSearcher == nullptr) return m_index->RangeSearch(p_vector, p_radius, p_maxResults, p_results);
+
+            int batchNum = m_options.m_searchInternalResultNum;
+            COMMON::QueryResultSet<T> headResults((const T*)p_vector, (std::max)(batchNum, (int)std::ceil(batchNum * m_options.m_rangeMaxProbeRatio)));
+            GetLocalMemoryIndex()->SearchIndex(headResults);
+
+            // Postings are scanned against an empty one-slot set so the sign code prefilter never prunes
+            COMMON::QueryResultSet<T> scanResults((const T*)p_vector, 1);
+            if (m_pQuantizer) scanResults.SetTarget((const T*)p_vector, m_pQuantizer);
+
+            auto workspace = RentWorkSpace();
+            workspace->m_deduper.clear();
+
+            // Squared L2 and (scaled) cosine distances both have a metric square root, so by the triangle
+            // inequality a posting of radius R around head h can only hold matches when
+            // sqrt(d(q, h)) - sqrt(R) <= sqrt(radius).
+            float radiusRoot = std::sqrt((std::max)(p_radius, 0.0f));
+            std::vector<int> postingIDs;
+            for (int i = 0; i < headResults.GetResultNum(); ++i)
+            {
+                auto res = headResults.GetResult(i);
+                if (res->VID == -1) break;
+                if (res->Dist <= p_radius && m_vectorTranslateMap.get() != nullptr && (int)p_results.size() < p_maxResults) {
+                    SizeType vid = static_cast<SizeType>((m_vectorTranslateMap.get())[res->VID]);
+                    if (!workspace->m_deduper.CheckAndSet(vid)) p_results.emplace_back(vid, res->Dist);
+                }
+                if (!m_extraSearcher->CheckValidPosting(res->VID)) continue;
+                float postingRadius = m_extraSearcher->GetPostingRadius(res->VID);
+                if (postingRadius < MaxDist && std::sqrt((std::max)(res->Dist, 0.0f)) - std::sqrt(postingRadius) > radiusRoot) continue;
+                postingIDs.push_back(res->VID);
+            }
+
+            workspace->m_rangeResults = &p_results;
+            workspace->m_rangeRadius = p_radius;
+            workspace->m_rangeMaxResults = p_maxResults;
+            SearchStats stats;
+            for (size_t start = 0; start < postingIDs.size() && (int)p_results.size() < p_maxResults; start += batchNum)
+            {
+                workspace->m_postingIDs.assign(postingIDs.begin() + start, postingIDs.begin() + (std::min)(start + batchNum, postingIDs.size()));
+                m_extraSearcher->SearchIndex(workspace.get(), scanResults, GetLocalMemoryIndex(), &stats);
+            }
+            workspace->m_rangeResults = nullptr;
+            return ErrorCode::Success;
+        }
+
         template <typename T>
         ErrorCode Index<T>::DebugSearchDiskIndex(QueryResult& p_query, int p_subInternalResultNum, int p_internalResultNum,
             SearchStats* p_stats, std::set<int>* truth, std::map<int, std::set<int>>* found) const
@@ -446,28 +714,25 @@ namespace SPTAG
                 newResults.reset(new COMMON::QueryResultSet<T>((T*)p_query.GetTarget(), p_query.GetResultNum()));
             }
 
-            if (m_workspace.get() == nullptr) {
-                m_workspace.reset(new ExtraWorkSpace());
-                m_workspace->Initialize(m_options.m_maxCheck, m_options.m_hashExp, m_options.m_searchInternalResultNum, min(m_options.m_postingPageLimit, m_options.m_searchPostingPageLimit + 1) << PageSizeEx, m_options.m_enableDataCompression);
-            }
-            m_workspace->m_deduper.clear();
+            auto workspace = RentWorkSpace();
+            workspace->m_deduper.clear();
 
             int partitions = (p_internalResultNum + p_subInternalResultNum - 1) / p_subInternalResultNum;
             float limitDist = p_query.GetResult(0)->Dist * m_options.m_maxDistRatio;
             for (SizeType p = 0; p < partitions; p++) {
                 int subInternalResultNum = min(p_subInternalResultNum, p_internalResultNum - p_subInternalResultNum * p);
 
-                m_workspace->m_postingIDs.clear();
+                workspace->m_postingIDs.clear();
 
                 for (int i = p * p_subInternalResultNum; i < p * p_subInternalResultNum + subInternalResultNum; i++)
                 {
                     auto res = p_query.GetResult(i);
                     if (res->VID == -1 || (limitDist > 0.1 && res->Dist > limitDist)) break;
                     if (!m_extraSearcher->CheckValidPosting(res->VID)) continue;
-                    m_workspace->m_postingIDs.emplace_back(res->VID);
+                    workspace->m_postingIDs.emplace_back(res->VID);
                 }
 
-                m_extraSearcher->SearchIndex(m_workspace.get(), *newResults, m_index, p_stats, truth, found);
+                m_extraSearcher->SearchIndex(workspace.get(), *newResults, GetLocalMemoryIndex(), p_stats, truth, found);
             }
 
             newResults->SortResult();
@@ -758,6 +1023,168 @@ namespace SPTAG
             return true;
         }
 
+        template <typename T>
+        ErrorCode Index<T>::ReorderHeadIndex()
+        {
+            std::vector<SizeType> newToOld;
+            ErrorCode ret = m_index->ReorderForLocality(newToOld);
+            if (ret == ErrorCode::Undefined) {
+                LOG(Helper::LogLevel::LL_Warning, "Head index type does not support reordering, keep the original order.\n");
+                return ErrorCode::Success;
+            }
+            if (ret != ErrorCode::Success) return ret;
+
+            SizeType headCount = m_index->GetNumSamples();
+            std::string headIDFile = m_options.m_indexDirectory + FolderSep + m_options.m_headIDFile;
+            std::vector<std::uint64_t> headIDs(headCount);
+            {
+                auto ptr = SPTAG::f_createIO();
+                if (ptr == nullptr || !ptr->Initialize(headIDFile.c_str(), std::ios::binary | std::ios::in)) {
+                    LOG(Helper::LogLevel::LL_Error, "Failed to open headIDFile file:%s\n", headIDFile.c_str());
+                    return ErrorCode::FailedOpenFile;
+                }
+                IOBINARY(ptr, ReadBinary, sizeof(std::uint64_t) * headCount, (char*)headIDs.data());
+            }
+            {
+                auto ptr = SPTAG::f_createIO();
+                if (ptr == nullptr || !ptr->Initialize(headIDFile.c_str(), std::ios::binary | std::ios::out)) {
+                    LOG(Helper::LogLevel::LL_Error, "Failed to create headIDFile file:%s\n", headIDFile.c_str());
+                    return ErrorCode::FailedCreateFile;
+                }
+                for (SizeType i = 0; i < headCount; i++) {
+                    IOBINARY(ptr, WriteBinary, sizeof(std::uint64_t), (char*)(headIDs.data() + newToOld[i]));
+                }
+            }
+
+            std::string headVectorFile = m_options.m_indexDirectory + FolderSep + m_options.m_headVectorFile;
+            {
+                auto ptr = SPTAG::f_createIO();
+                if (ptr == nullptr || !ptr->Initialize(headVectorFile.c_str(), std::ios::binary | std::ios::out)) {
+                    LOG(Helper::LogLevel::LL_Error, "Failed to create head vector file:%s\n", headVectorFile.c_str());
+                    return ErrorCode::FailedCreateFile;
+                }
+                DimensionType dim = m_index->GetFeatureDim();
+                std::size_t rowSize = GetValueTypeSize(m_index->GetVectorValueType()) * dim;
+                IOBINARY(ptr, WriteBinary, sizeof(headCount), (char*)&headCount);
+                IOBINARY(ptr, WriteBinary, sizeof(dim), (char*)&dim);
+                for (SizeType i = 0; i < headCount; i++) {
+                    IOBINARY(ptr, WriteBinary, rowSize, (char*)m_index->GetSample(i));
+                }
+            }
+
+            if ((ret = m_index->SaveIndex(m_options.m_indexDirectory + FolderSep + m_options.m_headIndexFolder)) != ErrorCode::Success) {
+                LOG(Helper::LogLevel::LL_Error, "Failed to save reordered head index.\n");
+                return ret;
+            }
+            LOG(Helper::LogLevel::LL_Info, "Reordered %d heads.\n", headCount);
+            return ErrorCode::Success;
+        }
+
+        template <typename T>
+        ErrorCode Index<T>::BuildHeadRerankVectors()
+        {
+            if (m_options.m_rerankVectorPath.empty()) {
+                LOG(Helper::LogLevel::LL_Error, "HeadRerankVectors needs the full precision vectors in RerankVectorPath.\n");
+                return ErrorCode::Fail;
+            }
+            std::shared_ptr<Helper::ReaderOptions> vectorOptions(new Helper::ReaderOptions(m_options.m_valueType, m_options.m_dim, m_options.m_vectorType, m_options.m_vectorDelimiter));
+            auto vectorReader = Helper::VectorSetReader::CreateInstance(vectorOptions);
+            if (ErrorCode::Success != vectorReader->LoadFile(m_options.m_rerankVectorPath)) {
+                LOG(Helper::LogLevel::LL_Error, "Failed to read full precision vectors from %s.\n", m_options.m_rerankVectorPath.c_str());
+                return ErrorCode::Fail;
+            }
+            auto fullVectors = vectorReader->GetVectorSet();
+
+            SizeType headCount = m_index->GetNumSamples();
+            std::string headIDFile = m_options.m_indexDirectory + FolderSep + m_options.m_headIDFile;
+            std::vector<std::uint64_t> headIDs(headCount);
+            {
+                auto ptr = SPTAG::f_createIO();
+                if (ptr == nullptr || !ptr->Initialize(headIDFile.c_str(), std::ios::binary | std::ios::in)) {
+                    LOG(Helper::LogLevel::LL_Error, "Failed to open headIDFile file:%s\n", headIDFile.c_str());
+                    return ErrorCode::FailedOpenFile;
+                }
+                IOBINARY(ptr, ReadBinary, sizeof(std::uint64_t) * headCount, (char*)headIDs.data());
+            }
+
+            std::string outputFile = m_options.m_indexDirectory + FolderSep + m_options.m_headRerankFile;
+            auto ptr = SPTAG::f_createIO();
+            if (ptr == nullptr || !ptr->Initialize(outputFile.c_str(), std::ios::binary | std::ios::out)) {
+                LOG(Helper::LogLevel::LL_Error, "Failed to create head rerank file:%s\n", outputFile.c_str());
+                return ErrorCode::FailedCreateFile;
+            }
+            DimensionType dim = m_options.m_dim;
+            IOBINARY(ptr, WriteBinary, sizeof(headCount), (char*)&headCount);
+            IOBINARY(ptr, WriteBinary, sizeof(dim), (char*)&dim);
+            std::vector<T> row(dim);
+            for (SizeType i = 0; i < headCount; i++) {
+                if (headIDs[i] >= (std::uint64_t)fullVectors->Count()) {
+                    LOG(Helper::LogLevel::LL_Error, "Head %d maps to vector %llu beyond the full precision vectors.\n", i, headIDs[i]);
+                    return ErrorCode::Fail;
+                }
+                std::memcpy(row.data(), fullVectors->GetVector((SizeType)headIDs[i]), sizeof(T) * dim);
+                if (m_options.m_distCalcMethod == DistCalcMethod::Cosine) COMMON::Utils::Normalize(row.data(), dim, COMMON::Utils::GetBase<T>());
+                IOBINARY(ptr, WriteBinary, sizeof(T) * dim, (char*)row.data());
+            }
+            LOG(Helper::LogLevel::LL_Info, "Wrote %d full precision heads to %s.\n", headCount, outputFile.c_str());
+            return ErrorCode::Success;
+        }
+
+        template <typename T>
+        ErrorCode Index<T>::LoadHeadRerankVectors()
+        {
+            if (!m_pQuantizer || m_options.m_headRerankFile.empty()) return ErrorCode::Success;
+
+            ErrorCode ret = m_headRerankVectors.Load(m_options.m_indexDirectory + FolderSep + m_options.m_headRerankFile, m_options.m_headRerankInMemory);
+            if (ret != ErrorCode::Success) {
+                LOG(Helper::LogLevel::LL_Error, "Cannot load head rerank vectors from %s.\n", m_options.m_headRerankFile.c_str());
+                return ret;
+            }
+            // The rows cover the heads of the build; heads added by Split later on are searched without rerank
+            if (m_headRerankVectors.R() > m_index->GetNumSamples() || m_headRerankVectors.C() != m_options.m_dim) {
+                LOG(Helper::LogLevel::LL_Error, "Head rerank vectors (%d,%d) do not match the head index (%d,%d).\n",
+                    m_headRerankVectors.R(), m_headRerankVectors.C(), m_index->GetNumSamples(), m_options.m_dim);
+                return ErrorCode::Fail;
+            }
+            if (m_headRerankVectors.R() < m_index->GetNumSamples()) {
+                LOG(Helper::LogLevel::LL_Warning, "Head rerank vectors cover %d of %d heads, queries reaching the others keep code distances.\n",
+                    m_headRerankVectors.R(), m_index->GetNumSamples());
+            }
+            return ErrorCode::Success;
+        }
+
+        template <typename T>
+        ErrorCode Index<T>::BuildHeadReplicas()
+        {
+            m_headReplicas.reset();
+            if (!m_options.m_numaHeadReplicas) return ErrorCode::Success;
+            if (Helper::GetNumaNodeCount() <= 1) {
+                LOG(Helper::LogLevel::LL_Info, "Single NUMA node, the head index is not replicated.\n");
+                return ErrorCode::Success;
+            }
+
+            // Copies are loaded from the saved head index, which is current until the first split
+            std::string folder = m_options.m_indexDirectory + FolderSep + m_options.m_headIndexFolder;
+            std::shared_ptr<HeadReplicas> replicas(new HeadReplicas());
+            ErrorCode ret = replicas->Build(m_index, Helper::GetCurrentNumaNode(), [this, &folder](std::shared_ptr<VectorIndex>& p_replica) {
+                ErrorCode ret = LoadIndex(folder, p_replica);
+                if (ret != ErrorCode::Success) return ret;
+                p_replica->SetQuantizer(m_pQuantizer);
+                p_replica->SetParameter("NumberOfThreads", std::to_string(m_options.m_iSSDNumberOfThreads));
+                p_replica->SetParameter("MaxCheck", std::to_string(m_options.m_maxCheck));
+                p_replica->SetParameter("HashTableExponent", std::to_string(m_options.m_hashExp));
+                p_replica->UpdateIndex();
+                p_replica->SetReady(true);
+                return ErrorCode::Success;
+            });
+            if (ret != ErrorCode::Success) {
+                LOG(Helper::LogLevel::LL_Warning, "Some NUMA nodes search the primary head index.\n");
+            }
+            m_headReplicas = replicas;
+            if (m_extraSearcher != nullptr) m_extraSearcher->SetHeadReplicas(replicas);
+            return ErrorCode::Success;
+        }
+
         template <typename T>
         ErrorCode Index<T>::BuildIndexInternal(std::shared_ptr<Helper::VectorSetReader>& p_reader) {
             if (!m_options.m_indexDirectory.empty()) {
@@ -851,7 +1278,7 @@ namespace SPTAG
                         m_extraSearcher.reset(new ExtraDynamicSearcher<T>(m_options.m_KVPath.c_str(), m_options.m_dim, INT_MAX, m_options.m_useDirectIO, m_options.m_latencyLimit, m_options.m_mergeThreshold));
                     }
                     else {
-                        m_extraSearcher.reset(new ExtraDynamicSearcher<T>(m_options.m_KVPath.c_str(), m_options.m_dim, m_options.m_postingPageLimit * PageSize / (sizeof(T)*m_options.m_dim + sizeof(int) + sizeof(uint8_t)), m_options.m_useDirectIO, m_options.m_latencyLimit, m_options.m_mergeThreshold));
+                        m_extraSearcher.reset(new ExtraDynamicSearcher<T>(m_options.m_KVPath.c_str(), m_options.m_dim, m_options.m_postingPageLimit * PageSize / PostingEntrySize(), m_options.m_useDirectIO, m_options.m_latencyLimit, m_options.m_mergeThreshold));
                     }
                 } else if (m_options.m_useSPDK)
                 {
@@ -864,7 +1291,10 @@ namespace SPTAG
                     }  
                 }
                 else {
+                    if (!m_pQuantizer || !m_pQuantizer->GetEnableFastScan() || m_options.m_enableDeltaEncoding || m_options.m_enableDataCompression) m_options.m_enableFastScan = false;
                     if (m_pQuantizer) {
+                        m_options.m_enableSignCode = false;
+                        m_options.m_residualQuantizationBits = 0;
                         m_extraSearcher.reset(new ExtraStaticSearcher<std::uint8_t>());
                     }
                     else {
@@ -873,6 +1303,15 @@ namespace SPTAG
                 }
 
                 if (m_options.m_buildSsdIndex) {
+                    if (m_options.m_reorderHeadIndex && ReorderHeadIndex() != ErrorCode::Success) {
+                        LOG(Helper::LogLevel::LL_Error, "Failed to reorder head index!\n");
+                        return ErrorCode::Fail;
+                    }
+                    if (m_pQuantizer && !m_options.m_headRerankFile.empty() && BuildHeadRerankVectors() != ErrorCode::Success) {
+                        LOG(Helper::LogLevel::LL_Error, "Failed to write head rerank vectors!\n");
+                        return ErrorCode::Fail;
+                    }
+
                     if (!m_options.m_excludehead) {
                         LOG(Helper::LogLevel::LL_Info, "Include all vectors into SSD index...\n");
                         if (fileexists((m_options.m_indexDirectory + FolderSep + m_options.m_headIDFile).c_str()) &&
@@ -909,6 +1348,8 @@ namespace SPTAG
                     if ((m_options.m_useKV || m_options.m_useSPDK) && m_options.m_preReassign) {
                         m_extraSearcher->RefineIndex(p_reader, m_index);
                     }
+                    if (LoadHeadRerankVectors() != ErrorCode::Success) return ErrorCode::Fail;
+                    if (BuildHeadReplicas() != ErrorCode::Success) return ErrorCode::Fail;
                 }
             }
             
@@ -1092,13 +1533,55 @@ namespace SPTAG
                     GetEnumValueType<T>(), p_dimension, p_vectorNum));
             }
 
-            return m_extraSearcher->AddIndex(vectorSet, m_index, begin);
+            ErrorCode ret = m_extraSearcher->AddIndex(vectorSet, m_index, begin);
+            m_updateEpoch++;
+            return ret;
+        }
+
+        template <typename T>
+        std::future<ErrorCode> Index<T>::AddIndexAsync(std::shared_ptr<VectorSet> p_vectorSet, std::shared_ptr<MetadataSet> p_metadataSet, bool p_withMetaIndex, bool p_normalized,
+            std::function<void(ErrorCode)> p_callback)
+        {
+            // Rejected inputs fail at once instead of taking a queue slot
+            if (nullptr == p_vectorSet || p_vectorSet->Count() == 0 || p_vectorSet->GetValueType() != GetVectorValueType()) {
+                return VectorIndex::AddIndexAsync(p_vectorSet, p_metadataSet, p_withMetaIndex, p_normalized, p_callback);
+            }
+
+            m_insertQueue.Start(m_options.m_insertWorkerNum, m_options.m_insertQueueSize,
+                [this](InsertQueue::Request& p_request) {
+                    return VectorIndex::AddIndex(p_request.m_vectors, p_request.m_metadata, p_request.m_withMetaIndex, p_request.m_normalized);
+                },
+                [this]() { if (m_extraSearcher != nullptr) m_extraSearcher->Initialize(); },
+                [this]() { if (m_extraSearcher != nullptr) m_extraSearcher->ExitBlockController(); });
+
+            std::unique_ptr<InsertQueue::Request> request(new InsertQueue::Request());
+            request->m_vectors = p_vectorSet;
+            request->m_metadata = p_metadataSet;
+            request->m_withMetaIndex = p_withMetaIndex;
+            request->m_normalized = p_normalized;
+            request->m_callback = p_callback;
+            return m_insertQueue.Submit(std::move(request), m_options.m_insertQueueTimeout);
+        }
+
+        template <typename T>
+        ErrorCode Index<T>::SetAttributes(SizeType p_begin, SizeType p_num, DimensionType p_columns, const std::int32_t* p_values)
+        {
+            if (p_values == nullptr || p_num == 0 || p_columns == 0) return ErrorCode::EmptyData;
+            std::lock_guard<std::mutex> lock(m_dataAddLock);
+            if (!m_attributes.Available()) {
+                m_attributes.Initialize(0, p_columns, m_index->m_iDataBlockSize, m_index->m_iDataCapacity);
+            }
+            if (m_attributes.C() != p_columns) return ErrorCode::DimensionSizeMismatch;
+            return m_attributes.Set(p_begin, p_num, p_values);
         }
 
         template <typename T>
         ErrorCode Index<T>::DeleteIndex(const SizeType &p_id)
         {
-            if (m_versionMap.Delete(p_id)) return ErrorCode::Success;
+            if (m_versionMap.Delete(p_id)) {
+                m_updateEpoch++;
+                return ErrorCode::Success;
+            }
             return ErrorCode::VectorNotFound;
         }
 
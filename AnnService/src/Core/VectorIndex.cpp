@@ -450,6 +450,17 @@ VectorIndex::AddIndex(std::shared_ptr<VectorSet> p_vectorSet, std::shared_ptr<Me
 }
 
 
+std::future<ErrorCode>
+VectorIndex::AddIndexAsync(std::shared_ptr<VectorSet> p_vectorSet, std::shared_ptr<MetadataSet> p_metadataSet, bool p_withMetaIndex, bool p_normalized,
+    std::function<void(ErrorCode)> p_callback) {
+    std::promise<ErrorCode> done;
+    ErrorCode ret = AddIndex(p_vectorSet, p_metadataSet, p_withMetaIndex, p_normalized);
+    if (p_callback) p_callback(ret);
+    done.set_value(ret);
+    return done.get_future();
+}
+
+
 ErrorCode
 VectorIndex::DeleteIndex(ByteArray p_meta) {
     if (m_pMetaToVec == nullptr) return ErrorCode::VectorNotFound;
@@ -3,6 +3,10 @@
 
 #include "inc/Helper/AsyncFileReader.h"
 
+#ifndef _MSC_VER
+#include <sched.h>
+#endif
+
 namespace SPTAG {
     namespace Helper {
 #ifndef _MSC_VER
@@ -49,6 +53,36 @@ namespace SPTAG {
 #endif
         }
 
+        int GetNumaNodeCount()
+        {
+#ifdef NUMA
+            if (numa_available() >= 0) return (std::max)(1, numa_num_configured_nodes());
+#endif
+            return 1;
+        }
+
+        int GetCurrentNumaNode()
+        {
+#ifdef NUMA
+            if (numa_available() >= 0) {
+                int cpu = sched_getcpu();
+                if (cpu >= 0) return (std::max)(0, numa_node_of_cpu(cpu));
+            }
+#endif
+            return 0;
+        }
+
+        bool BindThreadToNumaNode(int p_node)
+        {
+#ifdef NUMA
+            if (numa_available() >= 0 && numa_run_on_node(p_node) == 0) {
+                numa_set_preferred(p_node);
+                return true;
+            }
+#endif
+            return false;
+        }
+
         struct timespec AIOTimeout {0, 30000};
         void BatchReadFileAsync(std::vector<std::shared_ptr<Helper::DiskIO>>& handlers, AsyncReadRequest* readRequests, int num)
         {
@@ -173,6 +207,30 @@ namespace SPTAG {
             YieldProcessor();
         }
 
+        int GetNumaNodeCount()
+        {
+            ULONG highest = 0;
+            if (!GetNumaHighestNodeNumber(&highest)) return 1;
+            return (int)highest + 1;
+        }
+
+        int GetCurrentNumaNode()
+        {
+            PROCESSOR_NUMBER pn;
+            USHORT node = 0;
+            GetCurrentProcessorNumberEx(&pn);
+            if (!GetNumaProcessorNodeEx(&pn, &node)) return 0;
+            return (int)node;
+        }
+
+        bool BindThreadToNumaNode(int p_node)
+        {
+            GROUP_AFFINITY ga;
+            memset(&ga, 0, sizeof(ga));
+            if (!GetNumaNodeProcessorMaskEx((USHORT)p_node, &ga)) return false;
+            return SetThreadGroupAffinity(GetCurrentThread(), &ga, NULL) != 0;
+        }
+
         void BatchReadFileAsync(std::vector<std::shared_ptr<Helper::DiskIO>>& handlers, AsyncReadRequest* readRequests, int num)
         {
             if (handlers.size() == 1) {
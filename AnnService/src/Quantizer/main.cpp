@@ -27,8 +27,8 @@ void QuantizeAndSave(std::shared_ptr<SPTAG::Helper::VectorSetReader>& vectorRead
             LOG(Helper::LogLevel::LL_Info, "Normalizing vectors.\n");
             set->Normalize(options->m_threadNum);
         }
-        ByteArray PQ_vector_array = ByteArray::Alloc(sizeof(std::uint8_t) * options->m_quantizedDim * set->Count());
-        quantized_vectors = std::make_shared<BasicVectorSet>(PQ_vector_array, VectorValueType::UInt8, options->m_quantizedDim, set->Count());
+        ByteArray PQ_vector_array = ByteArray::Alloc(sizeof(std::uint8_t) * quantizer->GetNumSubvectors() * set->Count());
+        quantized_vectors = std::make_shared<BasicVectorSet>(PQ_vector_array, VectorValueType::UInt8, quantizer->GetNumSubvectors(), set->Count());
 
 #pragma omp parallel for
         for (int i = 0; i < set->Count(); i++)
@@ -116,7 +116,7 @@ int main(int argc, char* argv[])
             {
 #define DefineVectorValueType(Name, Type) \
                     case VectorValueType::Name: \
-                        quantizer.reset(new COMMON::PQQuantizer<Type>(options->m_quantizedDim, 256, (DimensionType)(options->m_dimension/options->m_quantizedDim), false, TrainPQQuantizer<Type>(options, set, quantized_vectors))); \
+                        quantizer.reset(new COMMON::PQQuantizer<Type>(options->m_quantizedDim, options->m_KsPerSubvector, (DimensionType)(options->m_dimension/options->m_quantizedDim), false, TrainPQQuantizer<Type>(options, set, quantized_vectors))); \
                         break;
 
 #include "inc/Core/DefinitionList.h"
@@ -160,8 +160,39 @@ int main(int argc, char* argv[])
         auto fp_load = SPTAG::f_createIO();
         if (fp_load == nullptr || !fp_load->Initialize(options->m_outputQuantizerFile.c_str(), std::ios::binary | std::ios::in))
         {
-            LOG(Helper::LogLevel::LL_Info, "Quantizer Does not exist. Not supported for OPQ.\n");
-            exit(1);
+            auto set = vectorReader->GetVectorSet(0, options->m_trainingSamples);
+            ByteArray OPQ_vector_array = ByteArray::Alloc(sizeof(std::uint8_t) * options->m_quantizedDim * set->Count());
+            std::shared_ptr<VectorSet> quantized_vectors = std::make_shared<BasicVectorSet>(OPQ_vector_array, VectorValueType::UInt8, options->m_quantizedDim, set->Count());
+            LOG(Helper::LogLevel::LL_Info, "Quantizer Does not exist. Training a new one.\n");
+
+            std::unique_ptr<float[]> rotation;
+            switch (options->m_inputValueType)
+            {
+#define DefineVectorValueType(Name, Type) \
+                    case VectorValueType::Name: \
+                    { \
+                        auto codebooks = TrainOPQQuantizer<Type>(options, set, quantized_vectors, rotation); \
+                        quantizer.reset(new COMMON::OPQQuantizer<Type>(options->m_quantizedDim, options->m_KsPerSubvector, (DimensionType)(options->m_dimension/options->m_quantizedDim), false, std::move(codebooks), std::move(rotation))); \
+                        break; \
+                    }
+
+#include "inc/Core/DefinitionList.h"
+#undef DefineVectorValueType
+
+            default:
+                LOG(Helper::LogLevel::LL_Error, "OPQ quantizer does not support value type %s.\n", Helper::Convert::ConvertToString(options->m_inputValueType).c_str());
+                exit(1);
+            }
+
+            auto ptr = SPTAG::f_createIO();
+            if (ptr != nullptr && ptr->Initialize(options->m_outputQuantizerFile.c_str(), std::ios::binary | std::ios::out))
+            {
+                if (ErrorCode::Success != quantizer->SaveQuantizer(ptr))
+                {
+                    LOG(Helper::LogLevel::LL_Error, "Failed to write quantizer file.\n");
+                    exit(1);
+                }
+            }
         }
         else
         {
@@ -177,6 +208,68 @@ int main(int argc, char* argv[])
         QuantizeAndSave(vectorReader, options, quantizer);
 
 
+        auto metadataSet = vectorReader->GetMetadataSet();
+        if (metadataSet)
+        {
+            metadataSet->SaveMetadata(options->m_outputMetadataFile, options->m_outputMetadataIndexFile);
+        }
+
+        break;
+    }
+    case QuantizerType::ScalarQuantizer:
+    {
+        std::shared_ptr<COMMON::IQuantizer> quantizer;
+        auto fp_load = SPTAG::f_createIO();
+        if (fp_load == nullptr || !fp_load->Initialize(options->m_outputQuantizerFile.c_str(), std::ios::binary | std::ios::in))
+        {
+            if (options->m_quantizedBits != 8 && options->m_quantizedBits != 4)
+            {
+                LOG(Helper::LogLevel::LL_Error, "Scalar quantizer only supports 8 or 4 bits.\n");
+                exit(1);
+            }
+            auto set = vectorReader->GetVectorSet(0, options->m_trainingSamples);
+            LOG(Helper::LogLevel::LL_Info, "Quantizer Does not exist. Training a new one.\n");
+
+            std::unique_ptr<float[]> mins, maxs;
+            switch (options->m_inputValueType)
+            {
+#define DefineVectorValueType(Name, Type) \
+                    case VectorValueType::Name: \
+                        TrainScalarQuantizer<Type>(options, set, mins, maxs); \
+                        quantizer.reset(new COMMON::ScalarQuantizer<Type>(options->m_dimension, options->m_quantizedBits, false, std::move(mins), std::move(maxs))); \
+                        break;
+
+#include "inc/Core/DefinitionList.h"
+#undef DefineVectorValueType
+
+            default:
+                LOG(Helper::LogLevel::LL_Error, "Scalar quantizer does not support value type %s.\n", Helper::Convert::ConvertToString(options->m_inputValueType).c_str());
+                exit(1);
+            }
+
+            auto ptr = SPTAG::f_createIO();
+            if (ptr != nullptr && ptr->Initialize(options->m_outputQuantizerFile.c_str(), std::ios::binary | std::ios::out))
+            {
+                if (ErrorCode::Success != quantizer->SaveQuantizer(ptr))
+                {
+                    LOG(Helper::LogLevel::LL_Error, "Failed to write quantizer file.\n");
+                    exit(1);
+                }
+            }
+        }
+        else
+        {
+            quantizer = SPTAG::COMMON::IQuantizer::LoadIQuantizer(fp_load);
+            if (!quantizer)
+            {
+                LOG(Helper::LogLevel::LL_Error, "Failed to open existing quantizer file.\n");
+                exit(1);
+            }
+            quantizer->SetEnableADC(false);
+        }
+
+        QuantizeAndSave(vectorReader, options, quantizer);
+
         auto metadataSet = vectorReader->GetMetadataSet();
         if (metadataSet)
         {
@@ -6,6 +6,7 @@
 #include "inc/Socket/RemoteSearchQuery.h"
 #include "inc/Helper/CommonHelper.h"
 #include "inc/Helper/ArgumentsParser.h"
+#include "inc/Helper/AsyncFileReader.h"
 
 #include <iostream>
 
@@ -224,6 +225,19 @@ SearchService::SearchHanlder(Socket::ConnectionID p_localConnectionID, Socket::P
         p_packet.Header().m_connectionID = p_localConnectionID;
     }
 
+    if (m_serviceContext->GetServiceSettings()->m_numaAffinity)
+    {
+        // Pool threads are bound on their first query, spread over the nodes so that an index with
+        // per node head replicas is searched in local memory
+        static std::atomic<int> s_nextNode(0);
+        thread_local bool t_bound = false;
+        if (!t_bound)
+        {
+            Helper::BindThreadToNumaNode(s_nextNode.fetch_add(1) % Helper::GetNumaNodeCount());
+            t_bound = true;
+        }
+    }
+
     Socket::RemoteQuery remoteQuery;
     if(remoteQuery.Read(p_packet.Body()) == nullptr) {
         LOG(Helper::LogLevel::LL_Error, "majorVersion is not match!\n");
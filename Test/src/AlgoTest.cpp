@@ -4,10 +4,16 @@
 #include "inc/Test.h"
 #include "inc/Helper/SimpleIniReader.h"
 #include "inc/Core/VectorIndex.h"
+#include "inc/Core/SPANN/Index.h"
 #include "inc/Core/Common/CommonUtils.h"
+#include "inc/Core/Common/TwoMeans.h"
+#include "inc/Core/Common/PQQuantizer.h"
 
+#include <set>
 #include <unordered_set>
 #include <chrono>
+#include <thread>
+#include <atomic>
 
 template <typename T>
 void Build(SPTAG::IndexAlgoType algo, std::string distCalcMethod, std::shared_ptr<SPTAG::VectorSet>& vec, std::shared_ptr<SPTAG::MetadataSet>& meta, const std::string out)
@@ -225,6 +231,414 @@ void Test(SPTAG::IndexAlgoType algo, std::string distCalcMethod)
     }
 }
 
+template <typename T>
+void RangeSearch(SPTAG::IndexAlgoType algo, std::string distCalcMethod)
+{
+    SPTAG::SizeType n = 2000;
+    SPTAG::DimensionType m = 10;
+    std::vector<T> vec;
+    for (SPTAG::SizeType i = 0; i < n; i++) {
+        for (SPTAG::DimensionType j = 0; j < m; j++) {
+            vec.push_back((T)i);
+        }
+    }
+    std::vector<T> query(m, (T)100);
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(algo, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("DistCalcMethod", distCalcMethod);
+    vecIndex->SetParameter("NumberOfThreads", "16");
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vec.data(), n, m));
+
+    // Squared L2 between rows i and 100 is m * (i - 100)^2, so this radius covers rows 98 to 102
+    std::vector<SPTAG::BasicResult> results;
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->RangeSearch(query.data(), (float)(m * 4), 100, results));
+    std::set<SPTAG::SizeType> found;
+    for (auto& res : results) found.insert(res.VID);
+    BOOST_CHECK(found == std::set<SPTAG::SizeType>({ 98, 99, 100, 101, 102 }));
+    BOOST_CHECK_EQUAL(results.size(), found.size());
+
+    results.clear();
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->RangeSearch(query.data(), (float)(m * 4), 2, results));
+    BOOST_CHECK_EQUAL(results.size(), 2);
+    for (auto& res : results) BOOST_CHECK(res.Dist <= (float)(m * 4));
+
+    // A radius wider than the default frontier: rows 0 to 700 are all within m * 600^2 of row 100
+    results.clear();
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->RangeSearch(query.data(), (float)(m * 600 * 600), 1000, results));
+    found.clear();
+    for (auto& res : results) found.insert(res.VID);
+    BOOST_CHECK_EQUAL(results.size(), found.size());
+    BOOST_CHECK_EQUAL(found.size(), 701);
+}
+
+template <typename T>
+void BudgetSearch(SPTAG::IndexAlgoType algo, std::string distCalcMethod)
+{
+    SPTAG::SizeType n = 2000;
+    SPTAG::DimensionType m = 10;
+    int k = 3;
+    std::vector<T> vec;
+    for (SPTAG::SizeType i = 0; i < n; i++) {
+        for (SPTAG::DimensionType j = 0; j < m; j++) {
+            vec.push_back((T)i);
+        }
+    }
+    std::vector<T> query(m, (T)100);
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(algo, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("DistCalcMethod", distCalcMethod);
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vec.data(), n, m));
+
+    // A starved budget still fills the result set; a full one matches the regular search
+    SPTAG::QueryResult small(query.data(), k, false), full(query.data(), k, false);
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SearchIndexWithBudget(small, 8));
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SearchIndexWithBudget(full, 8192));
+    for (int i = 0; i < k; i++) BOOST_CHECK(small.GetResult(i)->VID >= 0);
+    BOOST_CHECK_EQUAL(full.GetResult(0)->VID, 100);
+}
+
+template <typename T>
+void DeadlineSearch(std::string distCalcMethod)
+{
+    SPTAG::SizeType n = 2000;
+    SPTAG::DimensionType m = 10;
+    int k = 3;
+    std::vector<T> vec;
+    for (SPTAG::SizeType i = 0; i < n; i++) {
+        for (SPTAG::DimensionType j = 0; j < m; j++) {
+            vec.push_back((T)i);
+        }
+    }
+    std::vector<T> query(m, (T)100);
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(SPTAG::IndexAlgoType::SPANN, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("IndexAlgoType", "BKT", "Base");
+    vecIndex->SetParameter("DistCalcMethod", distCalcMethod, "Base");
+    vecIndex->SetParameter("IndexDirectory", "deadlinetest", "Base");
+    vecIndex->SetParameter("isExecute", "true", "SelectHead");
+    vecIndex->SetParameter("NumberOfThreads", "4", "SelectHead");
+    vecIndex->SetParameter("Ratio", "0.2", "SelectHead");
+    vecIndex->SetParameter("isExecute", "true", "BuildHead");
+    vecIndex->SetParameter("NumberOfThreads", "4", "BuildHead");
+    vecIndex->SetParameter("isExecute", "true", "BuildSSDIndex");
+    vecIndex->SetParameter("BuildSsdIndex", "true", "BuildSSDIndex");
+    vecIndex->SetParameter("NumberOfThreads", "4", "BuildSSDIndex");
+    vecIndex->SetParameter("PostingPageLimit", "12", "BuildSSDIndex");
+    vecIndex->SetParameter("SearchPostingPageLimit", "12", "BuildSSDIndex");
+    vecIndex->SetParameter("InternalResultNum", "64", "BuildSSDIndex");
+    vecIndex->SetParameter("SearchInternalResultNum", "64", "BuildSSDIndex");
+    BOOST_REQUIRE(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vec.data(), n, m));
+    auto spann = (SPTAG::SPANN::Index<T>*)vecIndex.get();
+
+    // With time left the postings are read and the query is not degraded
+    SPTAG::QueryResult full(query.data(), k, false);
+    SPTAG::SPANN::SearchStats fullStats;
+    BOOST_CHECK(SPTAG::ErrorCode::Success == spann->SearchIndexWithStats(full, fullStats));
+    BOOST_CHECK(!fullStats.m_degraded);
+    BOOST_CHECK_EQUAL(full.GetResult(0)->VID, 100);
+
+    // A deadline already passed skips every posting, reports it and still returns the head results
+    SPTAG::QueryResult late(query.data(), k, false);
+    SPTAG::SPANN::SearchStats lateStats;
+    lateStats.m_deadline = std::chrono::steady_clock::now() - std::chrono::milliseconds(1);
+    BOOST_CHECK(SPTAG::ErrorCode::Success == spann->SearchIndexWithStats(late, lateStats));
+    BOOST_CHECK(lateStats.m_degraded);
+    BOOST_CHECK(lateStats.m_skippedPostingCount > 0);
+    BOOST_CHECK(late.GetResult(0)->VID >= 0);
+    BOOST_CHECK_EQUAL(spann->GetDegradedQueryCount(), 1);
+}
+
+template <typename T>
+void FilteredSearch(std::string distCalcMethod)
+{
+    SPTAG::SizeType n = 2000;
+    SPTAG::DimensionType m = 10;
+    int k = 10;
+    std::vector<T> vec;
+    std::vector<std::int32_t> attributes;
+    for (SPTAG::SizeType i = 0; i < n; i++) {
+        for (SPTAG::DimensionType j = 0; j < m; j++) {
+            vec.push_back((T)i);
+        }
+        attributes.push_back(i % 10);
+        attributes.push_back(i);
+    }
+    std::vector<T> query(m, (T)100);
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(SPTAG::IndexAlgoType::SPANN, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("IndexAlgoType", "BKT", "Base");
+    vecIndex->SetParameter("DistCalcMethod", distCalcMethod, "Base");
+    vecIndex->SetParameter("IndexDirectory", "filtertest", "Base");
+    vecIndex->SetParameter("isExecute", "true", "SelectHead");
+    vecIndex->SetParameter("NumberOfThreads", "4", "SelectHead");
+    vecIndex->SetParameter("Ratio", "0.2", "SelectHead");
+    vecIndex->SetParameter("isExecute", "true", "BuildHead");
+    vecIndex->SetParameter("NumberOfThreads", "4", "BuildHead");
+    vecIndex->SetParameter("isExecute", "true", "BuildSSDIndex");
+    vecIndex->SetParameter("BuildSsdIndex", "true", "BuildSSDIndex");
+    vecIndex->SetParameter("NumberOfThreads", "4", "BuildSSDIndex");
+    vecIndex->SetParameter("PostingPageLimit", "12", "BuildSSDIndex");
+    vecIndex->SetParameter("SearchPostingPageLimit", "12", "BuildSSDIndex");
+    vecIndex->SetParameter("InternalResultNum", "64", "BuildSSDIndex");
+    vecIndex->SetParameter("SearchInternalResultNum", "64", "BuildSSDIndex");
+    BOOST_REQUIRE(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vec.data(), n, m));
+    auto spann = (SPTAG::SPANN::Index<T>*)vecIndex.get();
+    BOOST_REQUIRE(SPTAG::ErrorCode::Success == spann->SetAttributes(0, n, 2, attributes.data()));
+
+    // One value out of ten: the results fill up with matching vectors only, nearest first
+    SPTAG::COMMON::AttributeFilter byValue;
+    byValue.AddValues(0, { 3 });
+    SPTAG::QueryResult result(query.data(), k, false);
+    SPTAG::SPANN::SearchStats stats;
+    BOOST_CHECK(SPTAG::ErrorCode::Success == spann->SearchIndexWithFilter(result, byValue, &stats));
+    for (int i = 0; i < k; i++) {
+        SPTAG::SizeType vid = result.GetResult(i)->VID;
+        BOOST_REQUIRE(vid >= 0 && vid < n);
+        BOOST_CHECK(byValue.Match(spann->GetAttributes().Row(vid)));
+    }
+    BOOST_CHECK(result.GetResult(0)->VID == 93 || result.GetResult(0)->VID == 103);
+    // The posting reads land in the caller's stats
+    BOOST_CHECK(stats.m_diskIOCount > 0);
+    BOOST_CHECK(stats.m_totalListElementsCount > 0);
+    BOOST_CHECK(!stats.m_degraded);
+
+    // Both columns: whatever comes back matches, far from the query as the matching vectors are
+    SPTAG::COMMON::AttributeFilter byRange;
+    byRange.AddValues(0, { 1, 2 });
+    byRange.AddRange(1, 150, 299);
+    SPTAG::QueryResult ranged(query.data(), k, false);
+    BOOST_CHECK(SPTAG::ErrorCode::Success == spann->SearchIndexWithFilter(ranged, byRange));
+    int found = 0;
+    for (int i = 0; i < k; i++) {
+        SPTAG::SizeType vid = ranged.GetResult(i)->VID;
+        if (vid < 0) continue;
+        BOOST_CHECK(byRange.Match(spann->GetAttributes().Row(vid)));
+        found++;
+    }
+    BOOST_CHECK(found > 0);
+}
+
+template <typename T>
+std::shared_ptr<SPTAG::VectorIndex> BuildQuantized(std::shared_ptr<SPTAG::COMMON::IQuantizer>& quantizer, std::vector<std::uint8_t>& codes, SPTAG::SizeType n, std::string distCalcMethod, const std::string folder, bool fastScan)
+{
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(SPTAG::IndexAlgoType::SPANN, SPTAG::VectorValueType::UInt8);
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetQuantizer(quantizer);
+    vecIndex->SetParameter("IndexAlgoType", "BKT", "Base");
+    vecIndex->SetParameter("DistCalcMethod", distCalcMethod, "Base");
+    vecIndex->SetParameter("IndexDirectory", folder, "Base");
+    vecIndex->SetParameter("QuantizerFilePath", "quantizer.bin", "Base");
+    vecIndex->SetParameter("isExecute", "true", "SelectHead");
+    vecIndex->SetParameter("NumberOfThreads", "4", "SelectHead");
+    vecIndex->SetParameter("Ratio", "0.2", "SelectHead");
+    vecIndex->SetParameter("isExecute", "true", "BuildHead");
+    vecIndex->SetParameter("NumberOfThreads", "4", "BuildHead");
+    vecIndex->SetParameter("isExecute", "true", "BuildSSDIndex");
+    vecIndex->SetParameter("BuildSsdIndex", "true", "BuildSSDIndex");
+    vecIndex->SetParameter("NumberOfThreads", "4", "BuildSSDIndex");
+    vecIndex->SetParameter("PostingPageLimit", "12", "BuildSSDIndex");
+    vecIndex->SetParameter("SearchPostingPageLimit", "12", "BuildSSDIndex");
+    vecIndex->SetParameter("InternalResultNum", "64", "BuildSSDIndex");
+    vecIndex->SetParameter("SearchInternalResultNum", "64", "BuildSSDIndex");
+    vecIndex->SetParameter("EnableFastScan", fastScan ? "true" : "false", "BuildSSDIndex");
+    BOOST_REQUIRE(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(codes.data(), n, quantizer->GetNumSubvectors()));
+    return vecIndex;
+}
+
+template <typename T>
+void FastScan(std::string distCalcMethod)
+{
+    SPTAG::SizeType n = 2000;
+    SPTAG::DimensionType numSub = 8, subDim = 2, m = numSub * subDim;
+    SPTAG::SizeType ks = 16;
+    int k = 10;
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> uniform(-10.0f, 10.0f);
+    std::vector<T> vec((size_t)n * m);
+    for (auto& v : vec) v = (T)uniform(rng);
+
+    // Codewords are subvectors of random data points
+    auto codebooks = std::make_unique<T[]>(numSub * ks * subDim);
+    for (SPTAG::DimensionType i = 0; i < numSub; i++) {
+        for (SPTAG::SizeType j = 0; j < ks; j++) {
+            SPTAG::SizeType row = (SPTAG::SizeType)(rng() % n);
+            for (SPTAG::DimensionType d = 0; d < subDim; d++) codebooks[(i * ks + j) * subDim + d] = vec[(size_t)row * m + i * subDim + d];
+        }
+    }
+    std::shared_ptr<SPTAG::COMMON::IQuantizer> quantizer = std::make_shared<SPTAG::COMMON::PQQuantizer<T>>(numSub, ks, subDim, false, std::move(codebooks));
+    BOOST_REQUIRE(quantizer->GetEnableFastScan());
+    std::vector<std::uint8_t> codes((size_t)n * numSub);
+    for (SPTAG::SizeType i = 0; i < n; i++) quantizer->QuantizeVector(vec.data() + (size_t)i * m, codes.data() + (size_t)i * numSub);
+
+    auto fast = BuildQuantized<T>(quantizer, codes, n, distCalcMethod, "fastscantest", true);
+    auto base = BuildQuantized<T>(quantizer, codes, n, distCalcMethod, "fastscanbase", false);
+    auto fastIndex = (SPTAG::SPANN::Index<std::uint8_t>*)fast.get();
+    auto baseIndex = (SPTAG::SPANN::Index<std::uint8_t>*)base.get();
+
+    // The stored blocks only skip entries that cannot enter the results, so both indexes return the same top k
+    int skipped = 0;
+    for (int q = 0; q < 20; q++) {
+        std::vector<T> query(m);
+        for (auto& v : query) v = (T)uniform(rng);
+        SPTAG::QueryResult fastResult(query.data(), k, false), baseResult(query.data(), k, false);
+        SPTAG::SPANN::SearchStats fastStats, baseStats;
+        BOOST_CHECK(SPTAG::ErrorCode::Success == fastIndex->SearchIndexWithStats(fastResult, fastStats));
+        BOOST_CHECK(SPTAG::ErrorCode::Success == baseIndex->SearchIndexWithStats(baseResult, baseStats));
+        BOOST_CHECK_EQUAL(baseStats.m_fastScanSkipCount, 0);
+        skipped += fastStats.m_fastScanSkipCount;
+        for (int i = 0; i < k; i++) {
+            BOOST_CHECK_EQUAL(fastResult.GetResult(i)->VID, baseResult.GetResult(i)->VID);
+            BOOST_CHECK_CLOSE_FRACTION(fastResult.GetResult(i)->Dist, baseResult.GetResult(i)->Dist, 1e-5);
+        }
+    }
+    BOOST_CHECK(skipped > 0);
+}
+
+template <typename T>
+void GarbageCollect(std::string distCalcMethod)
+{
+    SPTAG::SizeType n = 2000;
+    SPTAG::DimensionType m = 10;
+    std::vector<T> vec;
+    for (SPTAG::SizeType i = 0; i < n; i++) {
+        for (SPTAG::DimensionType j = 0; j < m; j++) {
+            vec.push_back((T)(i + j));
+        }
+    }
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(SPTAG::IndexAlgoType::SPANN, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("IndexAlgoType", "BKT", "Base");
+    vecIndex->SetParameter("DistCalcMethod", distCalcMethod, "Base");
+    vecIndex->SetParameter("IndexDirectory", "gctest", "Base");
+    vecIndex->SetParameter("isExecute", "true", "SelectHead");
+    vecIndex->SetParameter("NumberOfThreads", "4", "SelectHead");
+    vecIndex->SetParameter("Ratio", "0.2", "SelectHead");
+    vecIndex->SetParameter("isExecute", "true", "BuildHead");
+    vecIndex->SetParameter("NumberOfThreads", "4", "BuildHead");
+    vecIndex->SetParameter("isExecute", "true", "BuildSSDIndex");
+    vecIndex->SetParameter("BuildSsdIndex", "true", "BuildSSDIndex");
+    vecIndex->SetParameter("NumberOfThreads", "4", "BuildSSDIndex");
+    vecIndex->SetParameter("PostingPageLimit", "12", "BuildSSDIndex");
+    vecIndex->SetParameter("SearchPostingPageLimit", "12", "BuildSSDIndex");
+    vecIndex->SetParameter("InternalResultNum", "64", "BuildSSDIndex");
+    vecIndex->SetParameter("SearchInternalResultNum", "64", "BuildSSDIndex");
+    vecIndex->SetParameter("UseKV", "true", "BuildSSDIndex");
+    vecIndex->SetParameter("KVPath", "gctest_kv", "BuildSSDIndex");
+    vecIndex->SetParameter("Update", "true", "BuildSSDIndex");
+    // Merges drop dead entries of the postings they rewrite too, keep them out so the GC accounts for every
+    // entry freed, emptied postings included
+    vecIndex->SetParameter("MergeThreshold", "-1", "BuildSSDIndex");
+    // A small budget spreads the rewrites over many rounds that run alongside the deletes and searches
+    vecIndex->SetParameter("GCIOBudget", "1", "BuildSSDIndex");
+    vecIndex->SetParameter("GCInterval", "10", "BuildSSDIndex");
+    vecIndex->SetParameter("GCDeadRatio", "0.2", "BuildSSDIndex");
+    BOOST_REQUIRE(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vec.data(), n, m));
+    auto spann = (SPTAG::SPANN::Index<T>*)vecIndex.get();
+    auto disk = spann->GetDiskIndex();
+    auto head = spann->GetMemoryIndex();
+    const std::uint64_t entrySize = sizeof(T) * m + sizeof(int) + sizeof(std::uint8_t);
+
+    std::uint64_t sizeBefore = 0;
+    for (SPTAG::SizeType i = 0; i < head->GetNumSamples(); i++) {
+        if (head->ContainSample(i)) sizeBefore += disk->GetPostingSize(i);
+    }
+    BOOST_REQUIRE(sizeBefore > 0);
+
+    // Every other vector is deleted by several threads while others keep searching, which starts the planner
+    std::atomic_bool deleting(true);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t]() {
+            for (SPTAG::SizeType i = 2 * t; i < n; i += 8) BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->DeleteIndex(i));
+        });
+    }
+    threads.emplace_back([&]() {
+        std::vector<T> query(m);
+        for (int q = 0; deleting; q++) {
+            for (SPTAG::DimensionType j = 0; j < m; j++) query[j] = (T)((q * 37) % n + j);
+            SPTAG::QueryResult result(query.data(), 5, false);
+            vecIndex->SearchIndex(result);
+        }
+    });
+    for (int t = 0; t < 4; t++) threads[t].join();
+
+    // The planner rewrites every posting once its dead ratio passes GCDeadRatio, whatever the budget spreads
+    auto liveOnly = [&]() {
+        for (SPTAG::SizeType i = 0; i < head->GetNumSamples(); i++) {
+            if (!head->ContainSample(i)) continue;
+            std::string posting;
+            disk->GetWritePosting(i, posting);
+            for (size_t pos = 0; pos < posting.size(); pos += entrySize) {
+                if (*((int*)(posting.data() + pos)) % 2 == 0) return false;
+            }
+        }
+        return true;
+    };
+    auto start = std::chrono::steady_clock::now();
+    while (!liveOnly() && std::chrono::steady_clock::now() - start < std::chrono::seconds(30)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    deleting = false;
+    threads.back().join();
+    BOOST_REQUIRE(liveOnly());
+
+    std::uint64_t sizeAfter = 0;
+    for (SPTAG::SizeType i = 0; i < head->GetNumSamples(); i++) {
+        if (!head->ContainSample(i)) continue;
+        std::string posting;
+        disk->GetWritePosting(i, posting);
+        BOOST_CHECK_EQUAL(posting.size(), (size_t)disk->GetPostingSize(i) * entrySize);
+        sizeAfter += disk->GetPostingSize(i);
+    }
+    BOOST_CHECK(sizeAfter < sizeBefore);
+    BOOST_CHECK_EQUAL(disk->GetGCBytesReclaimed(), (sizeBefore - sizeAfter) * entrySize);
+}
+
+template <typename T>
+void Reorder(SPTAG::IndexAlgoType algo, std::string distCalcMethod)
+{
+    SPTAG::SizeType n = 2000;
+    SPTAG::DimensionType m = 10;
+    int k = 3;
+    std::vector<T> vec;
+    for (SPTAG::SizeType i = 0; i < n; i++) {
+        for (SPTAG::DimensionType j = 0; j < m; j++) {
+            vec.push_back((T)i);
+        }
+    }
+    std::vector<T> query(m, (T)100);
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(algo, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("DistCalcMethod", distCalcMethod);
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vec.data(), n, m));
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->DeleteIndex(5));
+
+    std::vector<SPTAG::SizeType> newToOld;
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->ReorderForLocality(newToOld));
+    BOOST_CHECK_EQUAL(newToOld.size(), n);
+    BOOST_CHECK_EQUAL(std::set<SPTAG::SizeType>(newToOld.begin(), newToOld.end()).size(), n);
+
+    // Every vector moved with its id, and search answers map back to the original rows
+    SPTAG::SizeType deletedRow = -1;
+    for (SPTAG::SizeType i = 0; i < n; i++) {
+        BOOST_CHECK(((const T*)vecIndex->GetSample(i))[0] == (T)newToOld[i]);
+        if (!vecIndex->ContainSample(i)) deletedRow = i;
+    }
+    BOOST_CHECK(deletedRow >= 0 && newToOld[deletedRow] == 5);
+
+    SPTAG::QueryResult res(query.data(), k, false);
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SearchIndex(res));
+    std::set<SPTAG::SizeType> found;
+    for (int i = 0; i < k; i++) found.insert(newToOld[res.GetResult(i)->VID]);
+    BOOST_CHECK(found == std::set<SPTAG::SizeType>({ 99, 100, 101 }));
+}
+
 BOOST_AUTO_TEST_SUITE (AlgoTest)
 
 BOOST_AUTO_TEST_CASE(KDTTest)
@@ -237,6 +651,91 @@ BOOST_AUTO_TEST_CASE(BKTTest)
     Test<float>(SPTAG::IndexAlgoType::BKT, "L2");
 }
 
+BOOST_AUTO_TEST_CASE(BKTRangeSearchTest)
+{
+    RangeSearch<float>(SPTAG::IndexAlgoType::BKT, "L2");
+}
+
+BOOST_AUTO_TEST_CASE(BKTBudgetSearchTest)
+{
+    BudgetSearch<float>(SPTAG::IndexAlgoType::BKT, "L2");
+}
+
+BOOST_AUTO_TEST_CASE(BKTReorderTest)
+{
+    Reorder<float>(SPTAG::IndexAlgoType::BKT, "L2");
+}
+
+BOOST_AUTO_TEST_CASE(TwoMeansTest)
+{
+    const SPTAG::DimensionType dim = 16;
+    std::mt19937 rng(7);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    std::vector<float> data(2000 * dim);
+    std::vector<const float*> vectors;
+    for (int i = 0; i < 2000; i++) {
+        for (SPTAG::DimensionType j = 0; j < dim; j++) data[i * dim + j] = noise(rng) + ((i % 2) ? 20.0f : -20.0f);
+        vectors.push_back(data.data() + i * dim);
+    }
+
+    SPTAG::COMMON::TwoMeans<float> twoMeans(dim, SPTAG::DistCalcMethod::L2);
+    BOOST_CHECK_EQUAL(twoMeans.Train(vectors, 200, 8, false, rng), 2);
+    // Every vector, sampled or not, lands with the other vectors of its cluster
+    int first = twoMeans.Assign(vectors[0]);
+    for (int i = 0; i < 2000; i++) BOOST_CHECK_EQUAL(twoMeans.Assign(vectors[i]), (i % 2) ? 1 - first : first);
+    // Real centers are vectors of the posting
+    for (int k = 0; k < 2; k++) {
+        bool found = false;
+        for (const float* v : vectors) found = found || std::memcmp(v, twoMeans.Center(k), sizeof(float) * dim) == 0;
+        BOOST_CHECK(found);
+    }
+
+    std::vector<const float*> same(100, vectors[0]);
+    BOOST_CHECK_EQUAL(twoMeans.Train(same, 50, 8, true, rng), 1);
+
+    // A sample of one repeated vector fails the clustering of a posting that holds other vectors too: those must
+    // all stay with center 0, and only the extra copies of the center go, as do the stale entries
+    std::vector<const float*> mixed(same.begin(), same.begin() + 10);
+    mixed.insert(mixed.end(), vectors.begin() + 1, vectors.begin() + 21);
+    mixed.push_back(nullptr);
+    BOOST_CHECK_EQUAL(twoMeans.Train(std::vector<const float*>(mixed.begin(), mixed.begin() + 10), 10, 8, false, rng), 1);
+    std::vector<std::uint8_t> labels;
+    SPTAG::SizeType counts[2];
+    twoMeans.Label(mixed, 1, labels, counts);
+    BOOST_CHECK_EQUAL(counts[0], 21);
+    BOOST_CHECK_EQUAL(counts[1], 0);
+    BOOST_CHECK_EQUAL(labels[0], 0);
+    for (int i = 1; i < 10; i++) BOOST_CHECK_EQUAL(labels[i], 2);
+    for (int i = 10; i < 30; i++) BOOST_CHECK_EQUAL(labels[i], 0);
+    BOOST_CHECK_EQUAL(labels[30], 2);
+
+    // With two clusters every live vector gets the closer center
+    BOOST_CHECK_EQUAL(twoMeans.Train(vectors, 200, 8, false, rng), 2);
+    twoMeans.Label(mixed, 2, labels, counts);
+    BOOST_CHECK_EQUAL(counts[0] + counts[1], 30);
+    BOOST_CHECK(counts[0] > 0 && counts[1] > 0);
+}
+
+BOOST_AUTO_TEST_CASE(SPANNDeadlineTest)
+{
+    DeadlineSearch<float>("L2");
+}
+
+BOOST_AUTO_TEST_CASE(SPANNFilterTest)
+{
+    FilteredSearch<float>("L2");
+}
+
+BOOST_AUTO_TEST_CASE(SPANNFastScanTest)
+{
+    FastScan<float>("L2");
+}
+
+BOOST_AUTO_TEST_CASE(SPANNGCTest)
+{
+    GarbageCollect<float>("L2");
+}
+
 BOOST_AUTO_TEST_CASE(SPANNTest)
 {
     Test<float>(SPTAG::IndexAlgoType::SPANN, "L2");
@@ -0,0 +1,54 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "inc/Test.h"
+#include "inc/Core/Common.h"
+#include "inc/Core/Common/AttributeTable.h"
+
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(AttributeFilterTest)
+
+BOOST_AUTO_TEST_CASE(ParseAndMatchTest)
+{
+    SPTAG::COMMON::AttributeFilter filter;
+    BOOST_CHECK(filter.Parse("0=17|3&2=5:9", 3) == SPTAG::ErrorCode::Success);
+
+    std::int32_t match[3] = { 3, 100, 5 };
+    std::int32_t wrongValue[3] = { 4, 100, 5 };
+    std::int32_t outOfRange[3] = { 17, 100, 10 };
+    BOOST_CHECK(filter.Match(match));
+    BOOST_CHECK(!filter.Match(wrongValue));
+    BOOST_CHECK(!filter.Match(outOfRange));
+    BOOST_CHECK(!filter.Match(nullptr));
+
+    BOOST_CHECK(filter.Parse("3=1", 3) != SPTAG::ErrorCode::Success);
+    BOOST_CHECK(filter.Parse("0", 3) != SPTAG::ErrorCode::Success);
+    BOOST_CHECK(filter.Parse("0=a", 3) != SPTAG::ErrorCode::Success);
+}
+
+BOOST_AUTO_TEST_CASE(TableSelectivityTest)
+{
+    SPTAG::COMMON::AttributeTable table;
+    BOOST_CHECK(!table.Available());
+    BOOST_CHECK(table.Row(0) == nullptr);
+
+    table.Initialize(0, 2, 1024, 1024 * 1024);
+    std::vector<std::int32_t> values;
+    for (int i = 0; i < 1000; i++) {
+        values.push_back(i % 10);
+        values.push_back(i);
+    }
+    BOOST_CHECK(table.Set(0, 1000, values.data()) == SPTAG::ErrorCode::Success);
+    BOOST_CHECK_EQUAL(table.R(), 1000);
+    BOOST_CHECK_EQUAL(table.Row(42)[1], 42);
+    BOOST_CHECK(table.Row(1000) == nullptr);
+
+    SPTAG::COMMON::AttributeFilter filter;
+    filter.AddValues(0, { 3 });
+    BOOST_CHECK_CLOSE(filter.Selectivity(table), 0.1f, 1e-3);
+    filter.AddRange(1, 0, 499);
+    BOOST_CHECK_CLOSE(filter.Selectivity(table), 0.05f, 1e-3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -5,6 +5,10 @@
 #include "inc/Helper/SimpleIniReader.h"
 #include "inc/Core/VectorIndex.h"
 #include "inc/Core/Common/CommonUtils.h"
+#include "inc/Core/SPANN/InsertQueue.h"
+#include "inc/Core/SPANN/AdmissionController.h"
+#include "inc/Helper/PriorityScheduler.h"
+#include "inc/Helper/LockFree.h"
 
 #include <thread>
 #include <unordered_set>
@@ -122,6 +126,16 @@ void CTest(SPTAG::IndexAlgoType algo, std::string distCalcMethod)
     ConcurrentAddSearchSave<T>(algo, distCalcMethod, vecset, metaset, "testindices");
 }
 
+class FunctionJob : public SPTAG::Helper::PooledJob<FunctionJob>
+{
+public:
+    std::function<void()> m_run;
+
+    void Clear() { m_run = nullptr; }
+
+    void exec(SPTAG::IAbortOperation* p_abort) override { m_run(); }
+};
+
 BOOST_AUTO_TEST_SUITE(ConcurrentTest)
 
 BOOST_AUTO_TEST_CASE(BKTTest)
@@ -134,4 +148,192 @@ BOOST_AUTO_TEST_CASE(KDTTest)
     CTest<float>(SPTAG::IndexAlgoType::KDT, "L2");
 }
 
+BOOST_AUTO_TEST_CASE(InsertQueueTest)
+{
+    std::vector<float> data(8, 1.0f);
+    std::shared_ptr<SPTAG::VectorSet> vectors(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)data.data(), sizeof(float) * data.size(), false), SPTAG::VectorValueType::Float, 4, 2));
+
+    std::mutex gate;
+    std::unique_lock<std::mutex> closed(gate);
+    std::atomic<int> added(0), callbacks(0);
+
+    SPTAG::SPANN::InsertQueue queue;
+    queue.Start(1, 4, [&](SPTAG::SPANN::InsertQueue::Request& p_request) {
+        std::lock_guard<std::mutex> lock(gate);
+        added += p_request.m_vectors->Count();
+        return SPTAG::ErrorCode::Success;
+    });
+
+    auto Submit = [&](int p_timeoutMs) {
+        std::unique_ptr<SPTAG::SPANN::InsertQueue::Request> request(new SPTAG::SPANN::InsertQueue::Request());
+        request->m_vectors = vectors;
+        request->m_callback = [&](SPTAG::ErrorCode) { callbacks++; };
+        return queue.Submit(std::move(request), p_timeoutMs);
+    };
+
+    // The worker holds the first batch at the gate, two more fill the queue
+    std::vector<std::future<SPTAG::ErrorCode>> pending;
+    pending.push_back(Submit(-1));
+    while (queue.Depth() > 0) std::this_thread::yield();
+    pending.push_back(Submit(0));
+    pending.push_back(Submit(0));
+    BOOST_CHECK_EQUAL(queue.Depth(), 4);
+
+    auto rejected = Submit(10);
+    BOOST_CHECK(rejected.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    BOOST_CHECK(rejected.get() == SPTAG::ErrorCode::InsertQueueFull);
+    BOOST_CHECK_EQUAL(queue.Rejected(), 1);
+
+    closed.unlock();
+    for (auto& done : pending) BOOST_CHECK(done.get() == SPTAG::ErrorCode::Success);
+    BOOST_CHECK_EQUAL(added.load(), 6);
+    BOOST_CHECK_EQUAL(callbacks.load(), 4);
+
+    queue.Stop();
+    BOOST_CHECK(Submit(-1).get() == SPTAG::ErrorCode::ExternalAbort);
+}
+
+BOOST_AUTO_TEST_CASE(AdmissionControllerTest)
+{
+    std::atomic<int> debt(5);
+    auto Elapsed = [](std::chrono::steady_clock::time_point p_start) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - p_start).count();
+    };
+
+    SPTAG::SPANN::AdmissionController admission;
+    BOOST_CHECK(!admission.GetState().m_enabled);
+    admission.Configure([&]() { return (double)debt.load(); }, 10, 20, 1000, 10, 50);
+
+    // Below the target nothing is delayed, however large the batch
+    admission.Admit(100);
+    admission.Admit(100);
+    BOOST_CHECK_EQUAL(admission.GetState().m_delayed, 0);
+    BOOST_CHECK(admission.GetState().m_rate < 0);
+
+    // Halfway to the maximum the bucket refills at half the rate: 10 vectors take about 20ms
+    debt = 15;
+    admission.Admit(10);
+    auto start = std::chrono::steady_clock::now();
+    admission.Admit(10);
+    BOOST_CHECK(Elapsed(start) >= 15);
+    BOOST_CHECK_EQUAL(admission.GetState().m_delayed, 1);
+    BOOST_CHECK_CLOSE(admission.GetState().m_rate, 500.0, 1e-3);
+
+    // At the maximum nothing refills and the caller goes through after the longest delay
+    debt = 20;
+    start = std::chrono::steady_clock::now();
+    admission.Admit(1);
+    BOOST_CHECK(Elapsed(start) >= 50);
+    BOOST_CHECK_EQUAL(admission.GetState().m_timeouts, 1);
+
+    // Without a delay limit the caller waits until the debt drops
+    admission.Configure([&]() { return (double)debt.load(); }, 10, 20, 1000, 10, 0);
+    debt = 25;
+    std::thread drain([&]() { std::this_thread::sleep_for(std::chrono::milliseconds(30)); debt = 0; });
+    start = std::chrono::steady_clock::now();
+    admission.Admit(20);
+    BOOST_CHECK(Elapsed(start) >= 25);
+    drain.join();
+    BOOST_CHECK_EQUAL(admission.GetState().m_timeouts, 1);
+    BOOST_CHECK_EQUAL(admission.GetState().m_admitted, 241);
+}
+
+BOOST_AUTO_TEST_CASE(PrioritySchedulerTest)
+{
+    SPTAG::Helper::JobPool<FunctionJob> pool;
+    std::mutex gate;
+    std::unique_lock<std::mutex> closed(gate);
+    std::atomic<int> started(0);
+    std::mutex orderLock;
+    std::vector<int> order;
+
+    {
+        SPTAG::Helper::PriorityScheduler scheduler;
+        scheduler.init(1, 4);
+        auto Add = [&](int p_level, std::function<void()> p_run) {
+            FunctionJob* job = pool.Get();
+            job->m_run = std::move(p_run);
+            scheduler.add(job, p_level);
+        };
+
+        // The only worker waits at the gate while jobs of every level queue up behind it
+        Add(0, [&]() { started++; std::lock_guard<std::mutex> lock(gate); });
+        while (started.load() == 0) std::this_thread::yield();
+        for (int level : { 3, 2, 1, 2, 0, 3 }) {
+            Add(level, [&, level]() { std::lock_guard<std::mutex> lock(orderLock); order.push_back(level); });
+        }
+        BOOST_CHECK_EQUAL(scheduler.jobsize(), 6);
+        BOOST_CHECK_EQUAL(scheduler.jobsize(2), 2);
+        BOOST_CHECK_EQUAL(scheduler.runningJobs(), 1);
+
+        closed.unlock();
+        while (!scheduler.allClear()) std::this_thread::yield();
+        BOOST_CHECK((order == std::vector<int>{ 0, 1, 2, 2, 3, 3 }));
+        BOOST_CHECK_EQUAL(scheduler.GetStats().m_executed, 7);
+        BOOST_CHECK_EQUAL(scheduler.GetStats().m_maxQueued, 6);
+    }
+    // Finished jobs went back to the pool and are handed out again
+    BOOST_CHECK_EQUAL(pool.Idle(), 7);
+    pool.Get()->Release();
+    BOOST_CHECK_EQUAL(pool.Idle(), 7);
+
+    // Jobs spawned by one worker land in its own deque and are stolen by the idle ones
+    SPTAG::Helper::PriorityScheduler scheduler;
+    std::atomic<int> done(0);
+    scheduler.init(4, 4);
+    FunctionJob* spawner = pool.Get();
+    spawner->m_run = [&]() {
+        for (int i = 0; i < 64; i++) {
+            FunctionJob* job = pool.Get();
+            job->m_run = [&]() { std::this_thread::sleep_for(std::chrono::milliseconds(1)); done++; };
+            scheduler.add(job, 2);
+        }
+    };
+    scheduler.add(spawner, 0);
+    while (done.load() < 64) std::this_thread::yield();
+    BOOST_CHECK(scheduler.GetStats().m_stolen > 0);
+}
+
+BOOST_AUTO_TEST_CASE(BoundedRingTest)
+{
+    SPTAG::Helper::LockFree::BoundedRing<int> ring(5);
+    BOOST_CHECK_EQUAL(ring.capacity(), 8);
+    for (int i = 0; i < 8; i++) BOOST_CHECK(ring.push(i));
+    BOOST_CHECK(!ring.push(8));
+    BOOST_CHECK_EQUAL(ring.dropped(), 1);
+    int value;
+    for (int i = 0; i < 8; i++) {
+        BOOST_CHECK(ring.pop(value));
+        BOOST_CHECK_EQUAL(value, i);
+    }
+    BOOST_CHECK(!ring.pop(value));
+
+    // Concurrent producers against one consumer: every value pushed is popped exactly once
+    const int producers = 4, perProducer = 20000;
+    SPTAG::Helper::LockFree::BoundedRing<int> shared(64);
+    std::atomic<int> pushed(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < producers; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < perProducer; i++) {
+                while (!shared.push(t * perProducer + i)) std::this_thread::yield();
+                pushed++;
+            }
+        });
+    }
+    std::vector<int> seen(producers * perProducer, 0);
+    int popped = 0;
+    while (popped < producers * perProducer) {
+        if (shared.pop(value)) {
+            seen[value]++;
+            popped++;
+        }
+    }
+    for (auto& thread : threads) thread.join();
+    BOOST_CHECK_EQUAL(pushed.load(), producers * perProducer);
+    BOOST_CHECK(std::all_of(seen.begin(), seen.end(), [](int c) { return c == 1; }));
+    BOOST_CHECK(!shared.pop(value));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -7,6 +7,7 @@
 #include <vector>
 #include "inc/Test.h"
 #include "inc/Core/Common/DistanceUtils.h"
+#include "inc/Core/Common/SignCode.h"
 
 template<typename T>
 static float ComputeCosineDistance(const T *pX, const T *pY, SPTAG::DimensionType length) {
@@ -83,6 +84,28 @@ void test_dist_calc_performance(
     delete[] Y;
 }
 
+void TestSignCodeEncoding(SPTAG::DimensionType dimension)
+{
+    std::vector<float> head(dimension), x(dimension), y(dimension);
+    for (SPTAG::DimensionType i = 0; i < dimension; i++) {
+        head[i] = random<float>(1, -1);
+        x[i] = random<float>(1, -1);
+        y[i] = random<float>(1, -1);
+    }
+
+    int size = SPTAG::COMMON::SignCode::CodeSize(dimension);
+    std::vector<std::uint8_t> codeX(size), codeY(size);
+    SPTAG::COMMON::SignCode::Encode(x.data(), head.data(), dimension, codeX.data());
+    SPTAG::COMMON::SignCode::Encode(y.data(), head.data(), dimension, codeY.data());
+
+    int naive = 0;
+    for (SPTAG::DimensionType i = 0; i < dimension; i++) {
+        BOOST_CHECK_EQUAL(((codeX[i >> 3] >> (i & 7)) & 1) == 1, x[i] > head[i]);
+        if ((x[i] > head[i]) != (y[i] > head[i])) naive++;
+    }
+    BOOST_CHECK_EQUAL(naive, SPTAG::COMMON::SignCode::Hamming(codeX.data(), codeY.data(), size));
+}
+
 BOOST_AUTO_TEST_SUITE(DistanceTest)
 
 BOOST_AUTO_TEST_CASE(TestDistanceComputation)
@@ -92,6 +115,17 @@ BOOST_AUTO_TEST_CASE(TestDistanceComputation)
     test<std::int16_t>(32767);
 }
 
+BOOST_AUTO_TEST_CASE(TestSignCode)
+{
+    for (SPTAG::DimensionType dimension : {1, 7, 64, 100, 768}) TestSignCodeEncoding(dimension);
+
+    std::vector<int> dists(100);
+    for (int i = 0; i < 100; i++) dists[i] = (i * 37) % 100;
+    int threshold = SPTAG::COMMON::SignCode::Threshold(dists, 100, 0.3f);
+    BOOST_CHECK_EQUAL(threshold, 29);
+    BOOST_CHECK_EQUAL(SPTAG::COMMON::SignCode::Threshold(dists, 100, 1.0f), (std::numeric_limits<int>::max)());
+}
+
 BOOST_AUTO_TEST_CASE(TestDistanceComputationPerformance)
 {
     std::vector<SPTAG::DimensionType> dimensions{128, 256, 512, 1024};
@@ -7,6 +7,8 @@
 #include "inc/Core/Common/CommonUtils.h"
 #include "inc/Core/Common/QueryResultSet.h"
 #include "inc/Core/Common/DistanceUtils.h"
+#include "inc/Core/Common/PageAllocator.h"
+#include "inc/Core/Common/TopKBuffer.h"
 #include <thread>
 #include <unordered_set>
 #include <ctime>
@@ -216,6 +218,90 @@ void PTest(IndexAlgoType algo, std::string distCalcMethod)
     Search<T>(vecIndex, queryset, 10, truth);
 }
 
+template <typename T>
+float PerfSearchTime(IndexAlgoType algo, std::string distCalcMethod, std::shared_ptr<VectorSet>& vec, std::shared_ptr<MetadataSet>& meta, std::shared_ptr<VectorSet>& queryset, int k, std::string hugePageMode)
+{
+    std::shared_ptr<VectorIndex> vecIndex = VectorIndex::CreateInstance(algo, GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+
+    vecIndex->SetParameter("DistCalcMethod", distCalcMethod);
+    vecIndex->SetParameter("NumberOfThreads", "5");
+    vecIndex->SetParameter("MaxCheck", "4096");
+    vecIndex->SetParameter("HugePageMode", hugePageMode);
+    BOOST_CHECK(ErrorCode::Success == vecIndex->BuildIndex(vec, meta, true));
+
+    std::vector<QueryResult> res(queryset->Count(), QueryResult(nullptr, k, true));
+    float best = (std::numeric_limits<float>::max)();
+    for (int round = 0; round < 3; round++)
+    {
+        auto t1 = std::chrono::high_resolution_clock::now();
+        for (SizeType i = 0; i < queryset->Count(); i++)
+        {
+            res[i].SetTarget(queryset->GetVector(i));
+            vecIndex->SearchIndex(res[i]);
+        }
+        auto t2 = std::chrono::high_resolution_clock::now();
+        best = min(best, std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count() / (float)(queryset->Count()));
+    }
+    return best;
+}
+
+template <typename T>
+void HugePageTest(IndexAlgoType algo, std::string distCalcMethod)
+{
+    std::shared_ptr<VectorSet> vecset, queryset, truth;
+    std::shared_ptr<MetadataSet> metaset;
+    GenerateData<T>(vecset, metaset, queryset, truth, distCalcMethod, 10);
+
+    auto before = COMMON::PageAllocator::GetStats();
+    float baseTime = PerfSearchTime<T>(algo, distCalcMethod, vecset, metaset, queryset, 10, "0");
+    float hugeTime = PerfSearchTime<T>(algo, distCalcMethod, vecset, metaset, queryset, 10, "1");
+    auto after = COMMON::PageAllocator::GetStats();
+
+    BOOST_CHECK(baseTime > 0 && hugeTime > 0);
+    LOG(Helper::LogLevel::LL_Info, "Search time default pages: %.2fus, transparent huge pages: %.2fus, delta: %+.2f%%\n",
+        baseTime, hugeTime, (hugeTime - baseTime) * 100.0f / baseTime);
+    LOG(Helper::LogLevel::LL_Info, "Transparent huge page bytes allocated: %llu\n",
+        (unsigned long long)(after.m_transparentBytes - before.m_transparentBytes));
+}
+
+void TopKTest()
+{
+    const int count = 1 << 20, rounds = 20;
+    std::vector<float> dists(count);
+    for (auto& d : dists) d = std::rand() / (float)RAND_MAX;
+
+    for (int k : {10, 64, 256}) {
+        COMMON::QueryResultSet<float> heap(nullptr, k), buffered(nullptr, k);
+        COMMON::TopKBuffer topK;
+
+        auto t1 = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < rounds; r++) {
+            heap.Reset();
+            for (int i = 0; i < count; i++) heap.AddPoint(i, dists[i]);
+        }
+        auto t2 = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < rounds; r++) {
+            buffered.Reset();
+            topK.Reset(k, buffered.worstDist());
+            // Flush once per simulated posting of 256 candidates, as the posting scans do
+            for (int i = 0; i < count; i++) {
+                topK.Add(i, dists[i]);
+                if ((i & 255) == 255) topK.Flush(buffered);
+            }
+            topK.Flush(buffered);
+        }
+        auto t3 = std::chrono::high_resolution_clock::now();
+
+        heap.SortResult();
+        buffered.SortResult();
+        for (int i = 0; i < k; i++) BOOST_CHECK_EQUAL(heap.GetResult(i)->VID, buffered.GetResult(i)->VID);
+        LOG(Helper::LogLevel::LL_Info, "TopK %d over %d candidates, heap: %lldus, buffered: %lldus\n", k, count,
+            (long long)(std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count() / rounds),
+            (long long)(std::chrono::duration_cast<std::chrono::microseconds>(t3 - t2).count() / rounds));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE(PerfTest)
 
 BOOST_AUTO_TEST_CASE(BKTTest)
@@ -228,4 +314,17 @@ BOOST_AUTO_TEST_CASE(KDTTest)
     PTest<std::int8_t>(IndexAlgoType::KDT, "Cosine");
 }
 
+// Best-of-three search time of the same BKT index on default and on transparent huge pages.
+// The page policy is set per index, so nothing is left behind for the other tests.
+BOOST_AUTO_TEST_CASE(BKTHugePageTest)
+{
+    HugePageTest<std::int8_t>(IndexAlgoType::BKT, "Cosine");
+}
+
+// Result set insertion through the candidate buffer of the posting scans against plain heap insertion.
+BOOST_AUTO_TEST_CASE(TopKBufferTest)
+{
+    TopKTest();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
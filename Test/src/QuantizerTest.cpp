@@ -0,0 +1,264 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <fstream>
+#include "inc/Test.h"
+#include "inc/Core/Common/ScalarQuantizer.h"
+#include "inc/Core/Common/ResidualCode.h"
+#include "inc/Core/Common/VectorTier.h"
+#include "inc/Helper/VectorSetReader.h"
+#include "inc/Quantizer/Training.h"
+
+template<typename T>
+T random(int high = RAND_MAX, int low = 0)   // Generates a random value.
+{
+    return (T)(low + float(high - low)*(std::rand()/static_cast<float>(RAND_MAX + 1.0)));
+}
+
+void TestSQKernels(int bits)
+{
+    SPTAG::DimensionType dimension = random<SPTAG::DimensionType>(256, 2);
+    std::vector<float> query(dimension), step(dimension);
+    std::vector<std::uint8_t> codes(dimension);
+    for (SPTAG::DimensionType i = 0; i < dimension; i++) {
+        query[i] = random<float>(1, -1);
+        step[i] = random<float>(1, 0);
+        codes[i] = random<std::uint8_t>(256);
+    }
+
+    auto naiveL2 = (bits == 4) ? &SPTAG::COMMON::DistanceUtils::ComputeSQ4L2Distance : &SPTAG::COMMON::DistanceUtils::ComputeSQ8L2Distance;
+    auto naiveDot = (bits == 4) ? &SPTAG::COMMON::DistanceUtils::ComputeSQ4DotProduct : &SPTAG::COMMON::DistanceUtils::ComputeSQ8DotProduct;
+    auto simdL2 = SPTAG::COMMON::SQDistanceCalcSelector(SPTAG::DistCalcMethod::L2, bits);
+    auto simdDot = SPTAG::COMMON::SQDistanceCalcSelector(SPTAG::DistCalcMethod::Cosine, bits);
+
+    BOOST_CHECK_CLOSE_FRACTION(naiveL2(query.data(), codes.data(), step.data(), dimension), simdL2(query.data(), codes.data(), step.data(), dimension), 1e-4);
+    BOOST_CHECK_CLOSE_FRACTION(naiveDot(query.data(), codes.data(), step.data(), dimension), simdDot(query.data(), codes.data(), step.data(), dimension), 1e-4);
+}
+
+void TestSQDistance(int bits)
+{
+    SPTAG::DimensionType dimension = random<SPTAG::DimensionType>(256, 2);
+    auto mins = std::make_unique<float[]>(dimension);
+    auto maxs = std::make_unique<float[]>(dimension);
+    for (SPTAG::DimensionType i = 0; i < dimension; i++) {
+        mins[i] = -1;
+        maxs[i] = 1;
+    }
+    SPTAG::COMMON::ScalarQuantizer<float> quantizer(dimension, bits, false, std::move(mins), std::move(maxs));
+    BOOST_CHECK_EQUAL(quantizer.GetNumSubvectors(), (bits == 4) ? (dimension + 1) / 2 : dimension);
+
+    std::vector<float> vec(dimension), query(dimension), reconstructed(dimension);
+    for (SPTAG::DimensionType i = 0; i < dimension; i++) {
+        vec[i] = random<float>(1, -1);
+        query[i] = random<float>(1, -1);
+    }
+
+    std::vector<std::uint8_t> code(quantizer.QuantizeSize());
+    quantizer.QuantizeVector(vec.data(), code.data());
+    quantizer.ReconstructVector(code.data(), reconstructed.data());
+    float maxError = 1.0f / ((1 << bits) - 1);
+    for (SPTAG::DimensionType i = 0; i < dimension; i++) {
+        BOOST_CHECK_SMALL(vec[i] - reconstructed[i], maxError + 1e-5f);
+    }
+
+    quantizer.SetEnableADC(true);
+    std::vector<std::uint8_t> adcQuery(quantizer.QuantizeSize());
+    quantizer.QuantizeVector(query.data(), adcQuery.data());
+    BOOST_CHECK_CLOSE_FRACTION(SPTAG::COMMON::DistanceUtils::ComputeDistance(query.data(), reconstructed.data(), dimension, SPTAG::DistCalcMethod::L2),
+        quantizer.L2Distance(adcQuery.data(), code.data()), 1e-3);
+    BOOST_CHECK_CLOSE_FRACTION(SPTAG::COMMON::DistanceUtils::ComputeDistance(query.data(), reconstructed.data(), dimension, SPTAG::DistCalcMethod::Cosine),
+        quantizer.CosineDistance(adcQuery.data(), code.data()), 1e-3);
+}
+
+template<typename T>
+void TestResidualCode(int bits, int high)
+{
+    SPTAG::DimensionType dimension = random<SPTAG::DimensionType>(256, 2);
+    std::vector<T> head(dimension), vec(dimension), query(dimension), reconstructed(dimension);
+    for (SPTAG::DimensionType i = 0; i < dimension; i++) {
+        head[i] = random<T>(high / 2, -high / 2);
+        vec[i] = (T)(head[i] + random<T>(high / 4, -high / 4));
+        query[i] = random<T>(high, -high);
+    }
+
+    std::vector<std::uint8_t> code(SPTAG::COMMON::ResidualCode::CodeSize(dimension, bits));
+    SPTAG::COMMON::ResidualCode::Encode(vec.data(), head.data(), dimension, bits, code.data());
+    SPTAG::COMMON::ResidualCode::Decode(code.data(), head.data(), dimension, bits, reconstructed.data());
+    float scale;
+    memcpy(&scale, code.data(), sizeof(float));
+    for (SPTAG::DimensionType i = 0; i < dimension; i++) {
+        BOOST_CHECK_SMALL((float)vec[i] - (float)reconstructed[i], scale / 2 + 0.5f + 1e-5f);
+    }
+
+    // The table based distance must equal the exact distance to the reconstructed vector when the
+    // reconstruction is not rounded, which holds for float vectors.
+    if (SPTAG::GetEnumValueType<T>() != SPTAG::VectorValueType::Float) return;
+    std::vector<float> table(dimension);
+    for (SPTAG::DistCalcMethod method : { SPTAG::DistCalcMethod::L2, SPTAG::DistCalcMethod::Cosine }) {
+        float bias = SPTAG::COMMON::ResidualCode::PrepareQuery(query.data(), head.data(), dimension, method, table.data());
+        float approx = SPTAG::COMMON::ResidualCode::Distance(table.data(), bias, code.data(), dimension, bits, method);
+        float exact = SPTAG::COMMON::DistanceUtils::ComputeDistance(query.data(), reconstructed.data(), dimension, method);
+        BOOST_CHECK_CLOSE_FRACTION(exact, approx, 1e-3);
+    }
+}
+
+void TestVectorTier(bool inMemory)
+{
+    SPTAG::SizeType rows = 100;
+    SPTAG::DimensionType dimension = 17;
+    std::vector<float> data(rows * dimension);
+    for (auto& v : data) v = random<float>(100, -100);
+
+    std::string file = "vectortier.bin";
+    {
+        std::ofstream output(file, std::ios::binary);
+        output.write((char*)&rows, sizeof(rows));
+        output.write((char*)&dimension, sizeof(dimension));
+        output.write((char*)data.data(), sizeof(float) * data.size());
+    }
+
+    SPTAG::COMMON::VectorTier<float> tier;
+    BOOST_REQUIRE(SPTAG::ErrorCode::Success == tier.Load(file, inMemory));
+    BOOST_CHECK_EQUAL(tier.R(), rows);
+    BOOST_CHECK_EQUAL(tier.C(), dimension);
+    std::vector<float> buffer(dimension);
+    for (SPTAG::SizeType i = rows - 1; i >= 0; i -= 7) {
+        const float* row = tier.Get(i, buffer.data());
+        BOOST_REQUIRE(row != nullptr);
+        BOOST_CHECK(std::equal(row, row + dimension, data.begin() + i * dimension));
+    }
+    BOOST_CHECK(tier.Get(rows, buffer.data()) == nullptr);
+    std::remove(file.c_str());
+}
+
+// Mean squared reconstruction error of the data, and the share of queries whose exact nearest neighbor is
+// among the 10 nearest reconstructions
+void EvaluateOPQ(const SPTAG::COMMON::OPQQuantizer<float>& quantizer, const std::vector<float>& data, const std::vector<float>& queries,
+    SPTAG::SizeType n, SPTAG::SizeType q, SPTAG::DimensionType dim, float& error, float& recall)
+{
+    std::vector<float> reconstructed((size_t)n * dim);
+    std::vector<std::uint8_t> code(quantizer.GetNumSubvectors());
+    double sum = 0;
+    for (SPTAG::SizeType r = 0; r < n; r++) {
+        quantizer.QuantizeVector(data.data() + (size_t)r * dim, code.data());
+        quantizer.ReconstructVector(code.data(), reconstructed.data() + (size_t)r * dim);
+        for (SPTAG::DimensionType j = 0; j < dim; j++) {
+            float diff = data[(size_t)r * dim + j] - reconstructed[(size_t)r * dim + j];
+            sum += diff * diff;
+        }
+    }
+    error = (float)(sum / n);
+
+    int found = 0;
+    for (SPTAG::SizeType i = 0; i < q; i++) {
+        const float* query = queries.data() + (size_t)i * dim;
+        std::vector<std::pair<float, SPTAG::SizeType>> exact(n), approx(n);
+        for (SPTAG::SizeType r = 0; r < n; r++) {
+            exact[r] = { SPTAG::COMMON::DistanceUtils::ComputeL2Distance(query, data.data() + (size_t)r * dim, dim), r };
+            approx[r] = { SPTAG::COMMON::DistanceUtils::ComputeL2Distance(query, reconstructed.data() + (size_t)r * dim, dim), r };
+        }
+        std::partial_sort(approx.begin(), approx.begin() + 10, approx.end());
+        SPTAG::SizeType truth = std::min_element(exact.begin(), exact.end())->second;
+        for (int k = 0; k < 10; k++) if (approx[k].second == truth) found++;
+    }
+    recall = (float)found / q;
+}
+
+void TestOPQTraining()
+{
+    SPTAG::SizeType n = 4000, q = 100;
+    SPTAG::DimensionType dim = 16, numSubvectors = 4;
+
+    // Variance concentrated on a few directions that a random orthogonal basis spreads over every raw axis,
+    // so the subvectors of the raw data are strongly correlated and a learned rotation pays off
+    std::vector<float> basis((size_t)dim * dim);
+    for (SPTAG::DimensionType i = 0; i < dim; i++) {
+        float* b = basis.data() + (size_t)i * dim;
+        for (SPTAG::DimensionType j = 0; j < dim; j++) b[j] = random<float>(1, -1);
+        for (SPTAG::DimensionType k = 0; k < i; k++) {
+            const float* other = basis.data() + (size_t)k * dim;
+            float dot = 0;
+            for (SPTAG::DimensionType j = 0; j < dim; j++) dot += b[j] * other[j];
+            for (SPTAG::DimensionType j = 0; j < dim; j++) b[j] -= dot * other[j];
+        }
+        float norm = 0;
+        for (SPTAG::DimensionType j = 0; j < dim; j++) norm += b[j] * b[j];
+        for (SPTAG::DimensionType j = 0; j < dim; j++) b[j] /= std::sqrt(norm);
+    }
+    auto generate = [&](SPTAG::SizeType count) {
+        std::vector<float> out((size_t)count * dim, 0);
+        for (SPTAG::SizeType r = 0; r < count; r++) {
+            for (SPTAG::DimensionType k = 0; k < dim; k++) {
+                float z = random<float>(1, -1) * 16.0f / (1 + k * k);
+                for (SPTAG::DimensionType j = 0; j < dim; j++) out[(size_t)r * dim + j] += z * basis[(size_t)k * dim + j];
+            }
+        }
+        return out;
+    };
+    std::vector<float> data = generate(n), queries = generate(q);
+
+    auto options = std::make_shared<QuantizerOptions>(n, false, 0.0f, SPTAG::QuantizerType::OPQQuantizer, "", numSubvectors, "", "");
+    options->m_KsPerSubvector = 16;
+    options->m_threadNum = 2;
+    options->m_opqSamples = n / 2;
+
+    float error[2], recall[2];
+    for (int trained = 0; trained < 2; trained++) {
+        options->m_opqIterations = trained ? 10 : 0;
+        std::shared_ptr<SPTAG::VectorSet> set(new SPTAG::BasicVectorSet(SPTAG::ByteArray((std::uint8_t*)data.data(), sizeof(float) * data.size(), false), SPTAG::VectorValueType::Float, dim, n));
+        std::shared_ptr<SPTAG::VectorSet> codes(new SPTAG::BasicVectorSet(SPTAG::ByteArray::Alloc((size_t)n * numSubvectors), SPTAG::VectorValueType::UInt8, numSubvectors, n));
+        std::unique_ptr<float[]> rotation;
+        auto codebooks = TrainOPQQuantizer<float>(options, set, codes, rotation);
+
+        // The learned rotation stays orthogonal
+        for (SPTAG::DimensionType i = 0; i < dim; i++) {
+            for (SPTAG::DimensionType j = 0; j < dim; j++) {
+                float dot = 0;
+                for (SPTAG::DimensionType k = 0; k < dim; k++) dot += rotation[(size_t)i * dim + k] * rotation[(size_t)j * dim + k];
+                BOOST_CHECK_SMALL(dot - ((i == j) ? 1.0f : 0.0f), 1e-3f);
+            }
+        }
+
+        SPTAG::COMMON::OPQQuantizer<float> quantizer(numSubvectors, options->m_KsPerSubvector, dim / numSubvectors, false, std::move(codebooks), std::move(rotation));
+        EvaluateOPQ(quantizer, data, queries, n, q, dim, error[trained], recall[trained]);
+        BOOST_TEST_MESSAGE("OPQ iterations " << options->m_opqIterations << ": error " << error[trained] << ", recall " << recall[trained]);
+    }
+    BOOST_CHECK_LT(error[1], error[0] * 0.8f);
+    BOOST_CHECK_GT(recall[1], recall[0]);
+}
+
+BOOST_AUTO_TEST_SUITE(QuantizerTest)
+
+BOOST_AUTO_TEST_CASE(ScalarQuantizerKernelTest)
+{
+    TestSQKernels(8);
+    TestSQKernels(4);
+}
+
+BOOST_AUTO_TEST_CASE(ScalarQuantizerDistanceTest)
+{
+    TestSQDistance(8);
+    TestSQDistance(4);
+}
+
+BOOST_AUTO_TEST_CASE(ResidualCodeTest)
+{
+    TestResidualCode<float>(8, 8);
+    TestResidualCode<float>(4, 8);
+    TestResidualCode<std::int8_t>(8, 127);
+    TestResidualCode<std::int8_t>(4, 127);
+}
+
+BOOST_AUTO_TEST_CASE(VectorTierTest)
+{
+    TestVectorTier(true);
+    TestVectorTier(false);
+}
+
+BOOST_AUTO_TEST_CASE(OPQTrainingTest)
+{
+    TestOPQTraining();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,70 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "inc/Test.h"
+#include "inc/Core/Common.h"
+#include "inc/Core/Common/QueryCache.h"
+
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(QueryCacheTest)
+
+BOOST_AUTO_TEST_CASE(LookupInsertTest)
+{
+    const SPTAG::DimensionType dim = 32;
+    SPTAG::COMMON::QueryCache<float> cache;
+    cache.Initialize(dim, 8, 1024, 60000, 0.01f, SPTAG::DistCalcMethod::L2);
+
+    std::vector<float> query(dim), nearQuery(dim), farQuery(dim);
+    for (SPTAG::DimensionType i = 0; i < dim; i++) {
+        query[i] = (float)(i % 7) - 3.0f;
+        nearQuery[i] = query[i];
+        farQuery[i] = -query[i];
+    }
+    nearQuery[0] += 0.05f;
+
+    std::vector<SPTAG::BasicResult> results = { SPTAG::BasicResult(7, 1.0f), SPTAG::BasicResult(3, 2.0f) };
+    std::vector<SPTAG::BasicResult> out(2);
+    BOOST_CHECK(!cache.Lookup(query.data(), 0, 2, out.data()));
+
+    cache.Insert(query.data(), 0, 2, results.data());
+    BOOST_CHECK(cache.Lookup(query.data(), 0, 2, out.data()));
+    BOOST_CHECK_EQUAL(out[0].VID, 7);
+    BOOST_CHECK_EQUAL(out[1].Dist, 2.0f);
+
+    // A tiny perturbation keeps the signature and is within the tolerance
+    BOOST_CHECK_EQUAL(cache.Hash(nearQuery.data()), cache.Hash(query.data()));
+    BOOST_CHECK(cache.Lookup(nearQuery.data(), 0, 2, out.data()));
+    BOOST_CHECK(!cache.Lookup(farQuery.data(), 0, 2, out.data()));
+
+    // More results than cached, or a newer update epoch, miss
+    std::vector<SPTAG::BasicResult> more(3);
+    BOOST_CHECK(!cache.Lookup(query.data(), 0, 3, more.data()));
+    BOOST_CHECK(!cache.Lookup(query.data(), 1, 2, out.data()));
+
+    BOOST_CHECK_EQUAL(cache.GetLookupCount(), 6);
+    BOOST_CHECK_EQUAL(cache.GetHitCount(), 2);
+    BOOST_CHECK_CLOSE(cache.HitRate(), 2.0 / 6, 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(TTLAndCapacityTest)
+{
+    const SPTAG::DimensionType dim = 8;
+    SPTAG::COMMON::QueryCache<std::int8_t> cache;
+    cache.Initialize(dim, 16, 64, 20, 0.0f, SPTAG::DistCalcMethod::L2);
+
+    std::vector<SPTAG::BasicResult> results = { SPTAG::BasicResult(1, 0.5f) };
+    std::vector<SPTAG::BasicResult> out(1);
+    std::vector<std::int8_t> query(dim);
+    for (int q = 0; q < 1000; q++) {
+        for (SPTAG::DimensionType i = 0; i < dim; i++) query[i] = (std::int8_t)((q * 31 + i * 17) % 255 - 127);
+        cache.Insert(query.data(), 0, 1, results.data());
+    }
+    BOOST_CHECK(cache.Lookup(query.data(), 0, 1, out.data()));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    BOOST_CHECK(!cache.Lookup(query.data(), 0, 1, out.data()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
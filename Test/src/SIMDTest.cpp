@@ -5,6 +5,8 @@
 #include <vector>
 #include "inc/Test.h"
 #include "inc/Core/Common/SIMDUtils.h"
+#include "inc/Core/Common/PQQuantizer.h"
+#include "inc/Core/Common/TopKBuffer.h"
 
 
 template<typename T>
@@ -56,4 +58,192 @@ BOOST_AUTO_TEST_CASE(TestDistanceComputation)
 }
 
 
+BOOST_AUTO_TEST_CASE(TestFastScan)
+{
+    SPTAG::DimensionType numPairs = random<SPTAG::DimensionType>(64, 1);
+    std::vector<std::uint8_t> codes(numPairs * SPTAG::COMMON::SIMDUtils::FastScanBatch), table(numPairs * 32);
+    for (auto& c : codes) c = random<std::uint8_t>(256);
+    for (auto& t : table) t = random<std::uint8_t>(256);
+
+    std::uint16_t expected[SPTAG::COMMON::SIMDUtils::FastScanBatch], actual[SPTAG::COMMON::SIMDUtils::FastScanBatch];
+    SPTAG::COMMON::SIMDUtils::ComputeFastScan_Naive(codes.data(), table.data(), numPairs, expected);
+    SPTAG::COMMON::SIMDUtils::ComputeFastScan(codes.data(), table.data(), numPairs, actual);
+    for (int j = 0; j < SPTAG::COMMON::SIMDUtils::FastScanBatch; j++) {
+        BOOST_CHECK_EQUAL(expected[j], actual[j]);
+    }
+
+    SPTAG::DimensionType numSub = 7, subDim = 4;
+    SPTAG::SizeType ks = 16, count = 1000;
+    int k = 10, rerankNum = 4 * k;
+    auto codebooks = std::make_unique<float[]>(numSub * ks * subDim);
+    for (int i = 0; i < numSub * ks * subDim; i++) codebooks[i] = random<float>(1, -1);
+    SPTAG::COMMON::PQQuantizer<float> quantizer(numSub, ks, subDim, false, std::move(codebooks));
+    BOOST_CHECK(quantizer.GetEnableFastScan());
+
+    std::vector<float> vecs(count * numSub * subDim), query(numSub * subDim);
+    for (auto& v : vecs) v = random<float>(1, -1);
+    for (auto& v : query) v = random<float>(1, -1);
+    std::vector<std::uint8_t> pq(count * numSub);
+    for (int i = 0; i < count; i++) quantizer.QuantizeVector(vecs.data() + i * numSub * subDim, pq.data() + i * numSub);
+
+    std::vector<std::uint8_t> blocks(((count + 31) / 32) * quantizer.FastScanBlockSize());
+    quantizer.PackFastScanCodes(pq.data(), count, blocks.data());
+    std::vector<std::uint8_t> unpacked(numSub);
+    for (int i = 0; i < count; i++) {
+        quantizer.UnpackFastScanCode(blocks.data(), i, unpacked.data());
+        for (int j = 0; j < numSub; j++) BOOST_CHECK_EQUAL(unpacked[j], pq[i * numSub + j]);
+    }
+
+    // only rerankNum of the count candidates get the exact distance, the top k must still be exact
+    std::vector<SPTAG::BasicResult> results;
+    quantizer.FastScanSearch(query.data(), blocks.data(), count, k, rerankNum, results);
+    BOOST_CHECK_EQUAL(results.size(), k);
+
+    std::vector<float> reconstructed(numSub * subDim);
+    std::vector<float> dists(count);
+    for (int i = 0; i < count; i++) {
+        quantizer.ReconstructVector(pq.data() + i * numSub, reconstructed.data());
+        dists[i] = SPTAG::COMMON::DistanceUtils::ComputeDistance(query.data(), reconstructed.data(), numSub * subDim, SPTAG::DistCalcMethod::L2);
+    }
+    std::vector<float> sorted(dists);
+    std::sort(sorted.begin(), sorted.end());
+    for (int i = 0; i < k; i++) {
+        BOOST_CHECK_CLOSE_FRACTION(sorted[i], results[i].Dist, 1e-3);
+    }
+
+    // the table built from the quantized query bounds every ADC distance within the rounding slack
+    quantizer.SetEnableADC(true);
+    std::vector<std::uint8_t> target(quantizer.QuantizeSize()), queryTable(quantizer.FastScanTableSize());
+    quantizer.QuantizeVector(query.data(), target.data());
+    float scale, bias;
+    quantizer.ComputeFastScanTableFromTarget(target.data(), queryTable.data(), scale, bias);
+    std::vector<float> approx(count);
+    quantizer.FastScanDistances(blocks.data(), count, queryTable.data(), scale, bias, approx.data());
+    for (int i = 0; i < count; i++) {
+        float adc = quantizer.L2Distance(target.data(), pq.data() + i * numSub);
+        BOOST_CHECK_CLOSE_FRACTION(adc, dists[i], 1e-3);
+        BOOST_CHECK_LE(std::abs(approx[i] - adc), (numSub * 0.5f + 1.0f) / scale);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestFastScanNoOverflow)
+{
+    // many subvectors of equal range push the table sum to the uint16 limit
+    SPTAG::DimensionType numSub = 512, subDim = 1;
+    SPTAG::SizeType ks = 16, count = 64;
+    auto codebooks = std::make_unique<float[]>(numSub * ks * subDim);
+    for (int i = 0; i < numSub; i++) {
+        for (int j = 0; j < ks; j++) codebooks[i * ks + j] = (float)j;
+    }
+    SPTAG::COMMON::PQQuantizer<float> quantizer(numSub, ks, subDim, false, std::move(codebooks));
+
+    std::vector<float> query(numSub, 0.0f);
+    std::vector<std::uint8_t> pq(count * numSub);
+    for (int i = 0; i < count; i++) {
+        for (int j = 0; j < numSub; j++) pq[i * numSub + j] = (i == 0) ? 15 : (std::uint8_t)random<int>(16);
+    }
+    std::vector<std::uint8_t> blocks(((count + 31) / 32) * quantizer.FastScanBlockSize()), table(quantizer.FastScanTableSize());
+    quantizer.PackFastScanCodes(pq.data(), count, blocks.data());
+    float scale, bias;
+    quantizer.ComputeFastScanTable(query.data(), table.data(), scale, bias);
+    std::vector<float> approx(count);
+    quantizer.FastScanDistances(blocks.data(), count, table.data(), scale, bias, approx.data());
+    for (int i = 0; i < count; i++) {
+        float exact = 0;
+        int tableSum = 0;
+        for (int j = 0; j < numSub; j++) {
+            exact += (float)pq[i * numSub + j] * pq[i * numSub + j];
+            tableSum += table[j * 16 + pq[i * numSub + j]];
+        }
+        BOOST_CHECK_LT(tableSum, 65535);
+        BOOST_CHECK_CLOSE_FRACTION(approx[i], bias + tableSum / scale, 1e-5);
+        BOOST_CHECK_LE(std::abs(approx[i] - exact), (numSub * 0.5f + 1.0f) / scale);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestFilterByBound)
+{
+    for (int length : {0, 5, 16, 37, 1000}) {
+        std::vector<float> dists(length);
+        std::vector<SPTAG::SizeType> ids(length);
+        for (int i = 0; i < length; i++) {
+            dists[i] = random<float>(100);
+            ids[i] = i;
+        }
+        std::vector<float> expectedDists(dists), actualDists(dists);
+        std::vector<SPTAG::SizeType> expectedIDs(ids), actualIDs(ids);
+        int expected = SPTAG::COMMON::SIMDUtils::FilterByBound_Naive(expectedDists.data(), expectedIDs.data(), length, 30.0f);
+        int actual = SPTAG::COMMON::SIMDUtils::FilterByBound(actualDists.data(), actualIDs.data(), length, 30.0f);
+        BOOST_REQUIRE_EQUAL(expected, actual);
+        for (int i = 0; i < expected; i++) {
+            BOOST_CHECK_EQUAL(expectedIDs[i], actualIDs[i]);
+            BOOST_CHECK_EQUAL(expectedDists[i], actualDists[i]);
+        }
+        if (SPTAG::COMMON::InstructionSet::AVX2()) {
+            std::vector<float> avxDists(dists);
+            std::vector<SPTAG::SizeType> avxIDs(ids);
+            BOOST_CHECK_EQUAL(expected, SPTAG::COMMON::SIMDUtils::FilterByBound_AVX(avxDists.data(), avxIDs.data(), length, 30.0f));
+            BOOST_CHECK(std::equal(expectedIDs.begin(), expectedIDs.begin() + expected, avxIDs.begin()));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestFilterBits)
+{
+    const SPTAG::SizeType rowsInBlockEx = 10, rows = 5000;
+    std::vector<std::vector<std::uint64_t>> blocks(((rows - 1) >> rowsInBlockEx) + 1, std::vector<std::uint64_t>((1 << rowsInBlockEx) >> 6));
+    std::vector<const std::uint64_t*> blockWords;
+    for (auto& block : blocks) {
+        for (auto& word : block) word = ((std::uint64_t)random<int>(1 << 30) << 34) ^ (std::uint64_t)random<int>(1 << 30);
+        blockWords.push_back(block.data());
+    }
+    for (int length : {0, 3, 8, 13, 1000}) {
+        std::vector<SPTAG::SizeType> keys(length);
+        for (int i = 0; i < length; i++) keys[i] = random<int>(rows - 1);
+        std::vector<std::uint8_t> expected(length), actual(length);
+        SPTAG::COMMON::SIMDUtils::FilterBits_Naive(blockWords.data(), rowsInBlockEx, keys.data(), length, expected.data());
+        SPTAG::COMMON::SIMDUtils::FilterBits(blockWords.data(), rowsInBlockEx, keys.data(), length, actual.data());
+        BOOST_CHECK(expected == actual);
+        for (int i = 0; i < length; i++) {
+            BOOST_CHECK_EQUAL(expected[i], (std::uint8_t)(((~blocks[keys[i] >> rowsInBlockEx][(keys[i] & ((1 << rowsInBlockEx) - 1)) >> 6]) >> (keys[i] & 63)) & 1));
+        }
+        if (SPTAG::COMMON::InstructionSet::AVX2()) {
+            std::vector<std::uint8_t> avx(length);
+            SPTAG::COMMON::SIMDUtils::FilterBits_AVX(blockWords.data(), rowsInBlockEx, keys.data(), length, avx.data());
+            BOOST_CHECK(expected == avx);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestTopKBuffer)
+{
+    const int count = 20000;
+    std::vector<float> dists(count);
+    // Coarse values so that plenty of candidates tie at the boundary
+    for (auto& d : dists) d = (float)random<int>(500);
+
+    // Flushes every few thousand candidates and once per posting-sized run of 256, as the posting scans do
+    for (int k : {10, 64, 256}) {
+        for (int flushEvery : {3000, 256}) {
+            SPTAG::COMMON::QueryResultSet<float> heap(nullptr, k), buffered(nullptr, k);
+            heap.Reset();
+            buffered.Reset();
+            SPTAG::COMMON::TopKBuffer topK;
+            topK.Reset(k, buffered.worstDist());
+            for (int i = 0; i < count; i++) {
+                heap.AddPoint(i, dists[i]);
+                topK.Add(i, dists[i]);
+                if (i % flushEvery == flushEvery - 1) topK.Flush(buffered);
+            }
+            topK.Flush(buffered);
+            heap.SortResult();
+            buffered.SortResult();
+            for (int i = 0; i < k; i++) {
+                BOOST_CHECK_EQUAL(heap.GetResult(i)->VID, buffered.GetResult(i)->VID);
+                BOOST_CHECK_EQUAL(heap.GetResult(i)->Dist, buffered.GetResult(i)->Dist);
+            }
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,133 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "inc/Test.h"
+#include "inc/Core/Common.h"
+#include "inc/Helper/DiskIO.h"
+#include "inc/Core/Common/VersionLabel.h"
+#include "inc/Core/Common/Labelset.h"
+#include "inc/Core/Common/Dataset.h"
+#include "inc/Core/Common/PageAllocator.h"
+
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(VersionLabelTest)
+
+BOOST_AUTO_TEST_CASE(DeleteAndVersionTest)
+{
+    SPTAG::COMMON::VersionLabel versionMap;
+    versionMap.Initialize(100, 64, 1000);
+    BOOST_CHECK_EQUAL(versionMap.GetVectorNum(), 100);
+    BOOST_CHECK_EQUAL(versionMap.GetVersion(5), 0xff);
+
+    std::uint8_t version;
+    BOOST_CHECK(versionMap.IncVersion(5, &version));
+    BOOST_CHECK_EQUAL(version, 0);
+    BOOST_CHECK_EQUAL(versionMap.GetVersion(5), 0);
+
+    BOOST_CHECK(versionMap.Delete(70));
+    BOOST_CHECK(!versionMap.Delete(70));
+    BOOST_CHECK(versionMap.Deleted(70));
+    BOOST_CHECK_EQUAL(versionMap.GetVersion(70), 0xfe);
+    BOOST_CHECK(!versionMap.IncVersion(70, &version));
+    BOOST_CHECK_EQUAL(versionMap.Count(), 99);
+
+    BOOST_CHECK(versionMap.AddBatch(200) == SPTAG::ErrorCode::Success);
+    BOOST_CHECK_EQUAL(versionMap.GetVectorNum(), 300);
+    BOOST_CHECK(!versionMap.Deleted(299));
+    BOOST_CHECK_EQUAL(versionMap.GetVersion(299), 0xff);
+    BOOST_CHECK(versionMap.Delete(299));
+    BOOST_CHECK(versionMap.AddBatch(1000) == SPTAG::ErrorCode::MemoryOverFlow);
+
+    std::vector<SPTAG::SizeType> vids = { 299, 5, 70, 128 };
+    std::vector<std::uint8_t> mask(vids.size());
+    versionMap.FilterDeleted(vids.data(), (int)vids.size(), mask.data());
+    BOOST_CHECK(mask == std::vector<std::uint8_t>({ 0, 1, 0, 1 }));
+}
+
+BOOST_AUTO_TEST_CASE(SaveLoadTest)
+{
+    const std::string filename = "test_versionlabel.bin";
+    {
+        SPTAG::COMMON::VersionLabel versionMap;
+        versionMap.Initialize(1000, 128, 4096);
+        std::uint8_t version;
+        versionMap.IncVersion(3, &version);
+        versionMap.Delete(500);
+        versionMap.Delete(999);
+
+        auto ptr = std::make_shared<SPTAG::Helper::SimpleFileIO>();
+        BOOST_REQUIRE(ptr->Initialize(filename.c_str(), std::ios::binary | std::ios::out));
+        BOOST_CHECK(versionMap.Save(ptr) == SPTAG::ErrorCode::Success);
+        ptr->ShutDown();
+        BOOST_CHECK_EQUAL(versionMap.BufferSize(), sizeof(SPTAG::SizeType) * 2 + sizeof(SPTAG::DimensionType) + 1000);
+    }
+
+    SPTAG::COMMON::VersionLabel loaded;
+    auto ptr = std::make_shared<SPTAG::Helper::SimpleFileIO>();
+    BOOST_REQUIRE(ptr->Initialize(filename.c_str(), std::ios::binary | std::ios::in));
+    BOOST_CHECK(loaded.Load(ptr, 128, 4096) == SPTAG::ErrorCode::Success);
+    BOOST_CHECK_EQUAL(loaded.GetVectorNum(), 1000);
+    BOOST_CHECK_EQUAL(loaded.GetDeleteCount(), 2);
+    BOOST_CHECK_EQUAL(loaded.GetVersion(3), 0);
+    BOOST_CHECK(loaded.Deleted(500) && loaded.Deleted(999) && !loaded.Deleted(501));
+
+    std::ifstream input(filename, std::ios::binary);
+    std::vector<char> memoryFile((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    SPTAG::COMMON::VersionLabel mapped;
+    BOOST_CHECK(mapped.Load(memoryFile.data(), 128, 4096) == SPTAG::ErrorCode::Success);
+    BOOST_CHECK_EQUAL(mapped.GetDeleteCount(), 2);
+    BOOST_CHECK(mapped.Deleted(500) && !mapped.Deleted(3));
+}
+
+BOOST_AUTO_TEST_CASE(LabelsetTest)
+{
+    SPTAG::COMMON::Labelset deleted;
+    deleted.Initialize(10, 64, 1024);
+    BOOST_CHECK(deleted.Insert(3));
+    BOOST_CHECK(!deleted.Insert(3));
+    BOOST_CHECK(deleted.Contains(3) && !deleted.Contains(4));
+
+    BOOST_CHECK(deleted.AddBatch(100) == SPTAG::ErrorCode::Success);
+    BOOST_CHECK(deleted.Insert(100));
+    deleted.SetR(50);
+    BOOST_CHECK(deleted.AddBatch(60) == SPTAG::ErrorCode::Success);
+    BOOST_CHECK_EQUAL(deleted.R(), 110);
+    BOOST_CHECK(!deleted.Contains(100));
+    BOOST_CHECK_EQUAL(deleted.Count(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(HugePageDatasetTest)
+{
+    using namespace SPTAG::COMMON;
+    PageAllocator::Stats before = PageAllocator::GetStats();
+    {
+        // A 4MB base and 1MB blocks are mapped, the small label set stays on the heap
+        PagePolicy policy;
+        policy.m_mode = HugePageMode::Transparent;
+        policy.m_placement = NumaPlacement::Interleave;
+        Dataset<float> data;
+        data.SetPagePolicy(policy);
+        data.Initialize(1 << 16, 16, 1 << 14, 1 << 20);
+        BOOST_CHECK(SPTAG::ErrorCode::Success == data.AddBatch(1 << 14));
+
+        // A Dataset without a policy stays on the heap
+        PageAllocator::Stats withPolicy = PageAllocator::GetStats();
+        Dataset<float> plain(1 << 16, 16, 1 << 14, 1 << 20);
+        BOOST_CHECK_EQUAL(PageAllocator::GetStats().m_transparentBytes, withPolicy.m_transparentBytes);
+        BOOST_CHECK(PageAllocator::GetStats().m_heapBytes >= withPolicy.m_heapBytes + (4 << 20));
+        Labelset small;
+        small.Initialize(1000, 1024, 1 << 20);
+        for (SPTAG::SizeType i = 0; i < data.R(); i += 1000) data[i][15] = (float)i;
+        for (SPTAG::SizeType i = 0; i < data.R(); i += 1000) BOOST_CHECK_EQUAL(data[i][15], (float)i);
+
+        PageAllocator::Stats during = PageAllocator::GetStats();
+        BOOST_CHECK(during.m_transparentBytes >= before.m_transparentBytes + (5 << 20));
+        PageAllocator::LogStats();
+    }
+    BOOST_CHECK_EQUAL(PageAllocator::GetStats().m_transparentBytes, before.m_transparentBytes);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
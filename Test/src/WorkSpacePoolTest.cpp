@@ -0,0 +1,142 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "inc/Test.h"
+#include "inc/Core/Common.h"
+#include "inc/Core/Common/WorkSpacePool.h"
+
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct TestWorkSpace
+    {
+        TestWorkSpace() {}
+
+        TestWorkSpace(TestWorkSpace& other) : m_buffer(other.m_buffer.size()) {}
+
+        void Initialize(va_list& arg) { m_buffer.resize(va_arg(arg, int)); }
+
+        static void Reset() {}
+
+        std::vector<int> m_buffer;
+        std::atomic<int> m_users{ 0 };
+    };
+}
+
+BOOST_AUTO_TEST_SUITE(WorkSpacePoolTest)
+
+BOOST_AUTO_TEST_CASE(RentReturnTest)
+{
+    SPTAG::COMMON::BoundedWorkSpacePool<TestWorkSpace> pool;
+    pool.Init(4, 2, 128);
+    BOOST_CHECK_EQUAL(pool.Size(), 4);
+
+    std::set<TestWorkSpace*> rented;
+    {
+        std::vector<SPTAG::COMMON::BoundedWorkSpacePool<TestWorkSpace>::Lease> leases;
+        for (int i = 0; i < 4; i++) {
+            leases.emplace_back(pool.Rent(i % 3));
+            BOOST_CHECK(leases.back().Pooled());
+            BOOST_CHECK_EQUAL(leases.back()->m_buffer.size(), 128);
+            rented.insert(leases.back().get());
+        }
+        BOOST_CHECK_EQUAL(rented.size(), 4);
+
+        // Every slot is out, the next rent gets a transient workspace
+        auto extra = pool.Rent(0);
+        BOOST_CHECK(!extra.Pooled());
+        BOOST_CHECK_EQUAL(extra->m_buffer.size(), 128);
+        BOOST_CHECK_EQUAL(pool.GetOverflowCount(), 1);
+    }
+
+    // Returned slots are reused rather than rebuilt
+    for (int i = 0; i < 4; i++) {
+        auto lease = pool.Rent(1);
+        BOOST_CHECK(rented.count(lease.get()) == 1);
+    }
+    BOOST_CHECK_EQUAL(pool.GetOverflowCount(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentRentTest)
+{
+    SPTAG::COMMON::BoundedWorkSpacePool<TestWorkSpace> pool;
+    pool.Init(8, 2, 16);
+
+    std::atomic<int> conflicts(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < 20000; i++) {
+                auto lease = pool.Rent(t);
+                if (lease->m_users.fetch_add(1) != 0) conflicts++;
+                lease->m_buffer[i % 16] += 1;
+                lease->m_users.fetch_sub(1);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    BOOST_CHECK_EQUAL(conflicts.load(), 0);
+    BOOST_CHECK_EQUAL(pool.GetOverflowCount(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(WaitForSlotTest)
+{
+    // Three slots stand for three AIO contexts, one per slot; more renters than contexts must never share one
+    const int channels = 3;
+    SPTAG::COMMON::BoundedWorkSpacePool<TestWorkSpace> pool;
+    pool.SetWaitForSlot(true);
+    pool.Init(channels, 2, 16);
+
+    {
+        std::vector<SPTAG::COMMON::BoundedWorkSpacePool<TestWorkSpace>::Lease> leases;
+        for (int i = 0; i < channels; i++) leases.emplace_back(pool.Rent(i));
+
+        // Every slot is out, so the next rent blocks until one comes back and then takes that slot
+        std::atomic<bool> rented(false);
+        std::uint32_t slot = channels;
+        std::thread waiter([&]() {
+            auto lease = pool.Rent(0);
+            BOOST_CHECK(lease.Pooled());
+            slot = lease.Slot();
+            rented = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        BOOST_CHECK(!rented.load());
+        std::uint32_t returned = leases.back().Slot();
+        leases.pop_back();
+        waiter.join();
+        BOOST_CHECK(rented.load());
+        BOOST_CHECK_EQUAL(slot, returned);
+        BOOST_CHECK_EQUAL(pool.GetOverflowCount(), 1);
+    }
+
+    std::vector<std::atomic<int>> users(channels);
+    std::atomic<int> conflicts(0), transient(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < 5000; i++) {
+                auto lease = pool.Rent(t);
+                if (!lease.Pooled() || lease.Slot() >= (std::uint32_t)channels) {
+                    transient++;
+                    continue;
+                }
+                if (users[lease.Slot()].fetch_add(1) != 0) conflicts++;
+                lease->m_buffer[i % 16] += 1;
+                users[lease.Slot()].fetch_sub(1);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    BOOST_CHECK_EQUAL(conflicts.load(), 0);
+    BOOST_CHECK_EQUAL(transient.load(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,37 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "inc/Test.h"
+#include "inc/Core/Common.h"
+#include "inc/Core/Common/WorkSpace.h"
+
+BOOST_AUTO_TEST_SUITE(WorkSpaceTest)
+
+BOOST_AUTO_TEST_CASE(EpochVisitedSetTest)
+{
+    SPTAG::COMMON::WorkSpace space;
+    space.Initialize(1024, 2);
+
+    for (int mode = 0; mode < 2; mode++) {
+        SPTAG::SizeType visitedSize = (mode == 0) ? 0 : 100;
+        // Run the epoch array past a full uint16 wrap-around
+        int queries = (mode == 0) ? 1000 : 70000;
+        for (int query = 0; query < queries; query++) {
+            space.Reset(1024, 10, visitedSize);
+            SPTAG::SizeType node = query % 97;
+            BOOST_REQUIRE(!space.CheckAndSet(node));
+            BOOST_REQUIRE(space.CheckAndSet(node));
+            BOOST_REQUIRE(!space.CheckAndSet(node + 1));
+        }
+    }
+    BOOST_CHECK(space.m_useEpochVisited);
+    BOOST_CHECK_EQUAL(space.epochCheckStatus.Size(), 100);
+
+    // Nodes beyond the size given at Reset are still tracked
+    BOOST_CHECK(!space.CheckAndSet(5000));
+    BOOST_CHECK(space.CheckAndSet(5000));
+    space.Reset(1024, 10, 100);
+    BOOST_CHECK(!space.CheckAndSet(5000));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
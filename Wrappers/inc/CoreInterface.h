@@ -52,6 +52,13 @@ public:
 
     bool AddWithMetaData(ByteArray p_data, ByteArray p_meta, SizeType p_num, bool p_withMetaIndex, bool p_normalized);
 
+    // Queues a copy of the vectors and returns without waiting for them, false when they are rejected.
+    // Every other call on the index waits for the queued adds first.
+    bool AddAsync(ByteArray p_data, SizeType p_num, bool p_normalized);
+
+    // Waits for every queued add, true when all of them succeeded since the last wait
+    bool WaitForAdds();
+
     bool Delete(ByteArray p_data, SizeType p_num);
 
     bool DeleteByMetaData(ByteArray p_meta);
@@ -65,6 +72,17 @@ private:
     
     std::shared_ptr<SPTAG::VectorIndex> m_index;
 
+    // Adds queued by AddAsync, and whether one of those already collected failed
+    struct PendingAdds
+    {
+        std::vector<std::future<SPTAG::ErrorCode>> m_futures;
+        bool m_failed = false;
+    };
+
+    bool DrainAdds() const;
+
+    std::shared_ptr<PendingAdds> m_pendingAdds;
+
     size_t m_inputVectorSize;
     
     DimensionType m_dimension;
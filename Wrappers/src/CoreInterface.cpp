@@ -37,6 +37,7 @@ AnnIndex::AnnIndex(const std::shared_ptr<SPTAG::VectorIndex>& p_index)
 
 AnnIndex::~AnnIndex()
 {
+    DrainAdds();
 }
 
 
@@ -171,6 +172,7 @@ AnnIndex::SetQuantizerADC(bool p_adc)
 std::shared_ptr<QueryResult>
 AnnIndex::Search(ByteArray p_data, int p_resultNum)
 {
+    DrainAdds();
     std::shared_ptr<QueryResult> results = std::make_shared<QueryResult>(p_data.Data(), p_resultNum, false);
 
     if (nullptr != m_index)
@@ -183,6 +185,7 @@ AnnIndex::Search(ByteArray p_data, int p_resultNum)
 std::shared_ptr<QueryResult>
 AnnIndex::SearchWithMetaData(ByteArray p_data, int p_resultNum)
 {
+    DrainAdds();
     std::shared_ptr<QueryResult> results = std::make_shared<QueryResult>(p_data.Data(), p_resultNum, true);
 
     if (nullptr != m_index)
@@ -195,6 +198,7 @@ AnnIndex::SearchWithMetaData(ByteArray p_data, int p_resultNum)
 std::shared_ptr<QueryResult>
 AnnIndex::BatchSearch(ByteArray p_data, int p_vectorNum, int p_resultNum, bool p_withMetaData)
 {
+    DrainAdds();
     std::shared_ptr<QueryResult> results = std::make_shared<QueryResult>(p_data.Data(), p_vectorNum * p_resultNum, p_withMetaData);
     if (nullptr != m_index)
     {
@@ -213,6 +217,7 @@ AnnIndex::ReadyToServe() const
 void
 AnnIndex::UpdateIndex()
 {
+    DrainAdds();
     m_index->UpdateIndex();
 }
 
@@ -220,6 +225,7 @@ AnnIndex::UpdateIndex()
 bool
 AnnIndex::Save(const char* p_savefile) const
 {
+    DrainAdds();
     return SPTAG::ErrorCode::Success == m_index->SaveIndex(p_savefile);
 }
 
@@ -241,6 +247,7 @@ AnnIndex::Load(const char* p_loaderFile)
 bool 
 AnnIndex::Add(ByteArray p_data, SizeType p_num, bool p_normalized)
 {
+    DrainAdds();
     if (nullptr == m_index)
     {
         m_index = SPTAG::VectorIndex::CreateInstance(m_algoType, m_inputValueType);
@@ -257,6 +264,7 @@ AnnIndex::Add(ByteArray p_data, SizeType p_num, bool p_normalized)
 bool
 AnnIndex::AddWithMetaData(ByteArray p_data, ByteArray p_meta, SizeType p_num, bool p_withMetaIndex, bool p_normalized)
 {
+    DrainAdds();
     if (nullptr == m_index)
     {
         m_index = SPTAG::VectorIndex::CreateInstance(m_algoType, m_inputValueType);
@@ -278,9 +286,79 @@ AnnIndex::AddWithMetaData(ByteArray p_data, ByteArray p_meta, SizeType p_num, bo
 }
 
 
+bool
+AnnIndex::AddAsync(ByteArray p_data, SizeType p_num, bool p_normalized)
+{
+    if (nullptr == m_index)
+    {
+        m_index = SPTAG::VectorIndex::CreateInstance(m_algoType, m_inputValueType);
+    }
+    if (nullptr == m_index || p_num == 0 || m_dimension == 0 || p_data.Length() != p_num * m_inputVectorSize)
+    {
+        return false;
+    }
+
+    // The caller's buffer is only borrowed for the duration of the call
+    ByteArray data = ByteArray::Alloc(p_data.Length());
+    memcpy(data.Data(), p_data.Data(), p_data.Length());
+    std::shared_ptr<SPTAG::VectorSet> vectors(new SPTAG::BasicVectorSet(data,
+        m_inputValueType,
+        static_cast<SPTAG::DimensionType>(m_dimension),
+        static_cast<SPTAG::SizeType>(p_num)));
+
+    std::future<SPTAG::ErrorCode> done = m_index->AddIndexAsync(vectors, nullptr, false, p_normalized);
+    if (done.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        return (SPTAG::ErrorCode::Success == done.get());
+    }
+    if (nullptr == m_pendingAdds) m_pendingAdds.reset(new PendingAdds());
+
+    // Collect the adds already done so that the list only holds the ones still queued
+    auto& futures = m_pendingAdds->m_futures;
+    size_t remain = 0;
+    for (size_t i = 0; i < futures.size(); i++)
+    {
+        if (futures[i].wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            if (SPTAG::ErrorCode::Success != futures[i].get()) m_pendingAdds->m_failed = true;
+            continue;
+        }
+        if (i != remain) futures[remain] = std::move(futures[i]);
+        remain++;
+    }
+    futures.resize(remain);
+    futures.push_back(std::move(done));
+    return true;
+}
+
+
+bool
+AnnIndex::WaitForAdds()
+{
+    return DrainAdds();
+}
+
+
+bool
+AnnIndex::DrainAdds() const
+{
+    if (nullptr == m_pendingAdds) return true;
+
+    bool success = !m_pendingAdds->m_failed;
+    for (auto& done : m_pendingAdds->m_futures)
+    {
+        if (SPTAG::ErrorCode::Success != done.get()) success = false;
+    }
+    m_pendingAdds->m_futures.clear();
+    m_pendingAdds->m_failed = false;
+    return success;
+}
+
+
 bool
 AnnIndex::Delete(ByteArray p_data, SizeType p_num)
 {
+    DrainAdds();
     if (nullptr == m_index || p_num == 0 || m_dimension == 0 || p_data.Length() != p_num * m_inputVectorSize)
     {
         return false;
@@ -293,6 +371,7 @@ AnnIndex::Delete(ByteArray p_data, SizeType p_num)
 bool
 AnnIndex::DeleteByMetaData(ByteArray p_meta)
 {
+    DrainAdds();
     if (nullptr == m_index) return false;
     
     return (SPTAG::ErrorCode::Success == m_index->DeleteIndex(p_meta));